@@ -0,0 +1,173 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <atomic>
+#include <aws/store/common/logging.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace aws {
+namespace store {
+namespace logging {
+/**
+ * Delivers messages to another logger from a background thread, so that logging never waits for the other logger.
+ * Messages are put into a fixed size ring without taking a lock, and are only formatted on the background thread.
+ * When the ring is full, messages are dropped and counted instead of waiting for room.
+ *
+ * This logger starts out with the level of the logger it delivers to, and only its own level is checked when logging.
+ */
+class AsyncLogger : public Logger {
+  private:
+    struct Slot {
+        // The position this slot is next written at, or that position plus one once it holds a message
+        std::atomic<uint64_t> sequence{0U};
+        LogMessage message{LogLevel::Disabled};
+    };
+
+    std::shared_ptr<Logger> _target;
+    uint64_t _capacity;
+    std::unique_ptr<Slot[]> _slots;
+    mutable std::atomic<uint64_t> _enqueue_position{0U};
+    // Only used by the background thread
+    uint64_t _dequeue_position{0U};
+
+    mutable std::atomic<uint64_t> _accepted{0U};
+    mutable std::atomic<uint64_t> _dropped{0U};
+    std::atomic<uint64_t> _delivered{0U};
+
+    std::mutex _wake_lock{};
+    mutable std::condition_variable _wake{};
+    mutable std::atomic<bool> _waiting{false};
+    std::atomic<bool> _stopping{false};
+    std::thread _thread{};
+
+    static uint64_t roundUpToPowerOfTwo(const uint64_t n) {
+        uint64_t v = 1U;
+        while (v < n) {
+            v <<= 1U;
+        }
+        return v;
+    }
+
+    bool tryEnqueue(const LogMessage &message) const {
+        auto position = _enqueue_position.load(std::memory_order_relaxed);
+        Slot *slot = nullptr;
+        while (true) {
+            slot = &_slots[position & (_capacity - 1U)];
+            const auto sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<int64_t>(sequence - position);
+            if (diff == 0) {
+                if (_enqueue_position.compare_exchange_weak(position, position + 1U, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // The background thread has not taken the message a whole ring ago yet
+                return false;
+            } else {
+                position = _enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+        slot->message = message;
+        slot->sequence.store(position + 1U, std::memory_order_release);
+        return true;
+    }
+
+    bool tryDequeue(LogMessage &out) {
+        auto &slot = _slots[_dequeue_position & (_capacity - 1U)];
+        if (slot.sequence.load(std::memory_order_acquire) != (_dequeue_position + 1U)) {
+            return false;
+        }
+        out = slot.message;
+        slot.sequence.store(_dequeue_position + _capacity, std::memory_order_release);
+        ++_dequeue_position;
+        return true;
+    }
+
+    void run() {
+        LogMessage message{LogLevel::Disabled};
+        while (true) {
+            while (tryDequeue(message)) {
+                _target->log(message.level, message.format());
+                std::ignore = _delivered.fetch_add(1U, std::memory_order_release);
+            }
+            if (_stopping.load(std::memory_order_acquire)) {
+                // Anything logged before stopping was already queued, so one more pass takes all of it
+                while (tryDequeue(message)) {
+                    _target->log(message.level, message.format());
+                    std::ignore = _delivered.fetch_add(1U, std::memory_order_release);
+                }
+                return;
+            }
+            std::unique_lock<std::mutex> lock{_wake_lock};
+            _waiting.store(true, std::memory_order_seq_cst);
+            // Loggers do not take the lock to wake this thread, so a wake up can be missed. Waking up regularly
+            // bounds how long a message can wait for that.
+            std::ignore = _wake.wait_for(lock, std::chrono::milliseconds{10});
+            _waiting.store(false, std::memory_order_relaxed);
+        }
+    }
+
+  public:
+    explicit AsyncLogger(std::shared_ptr<Logger> target, const size_t capacity = 256U)
+        : _target(std::move(target)), _capacity(roundUpToPowerOfTwo(std::max<size_t>(capacity, 2U))),
+          // coverity[autosar_cpp14_a20_8_5_violation] cannot construct an array of slots with make_unique
+          _slots(new Slot[_capacity]) {
+        level = _target->level;
+        for (uint64_t i = 0U; i < _capacity; i++) {
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        _thread = std::thread{&AsyncLogger::run, this};
+    }
+
+    AsyncLogger(AsyncLogger &&) = delete;
+    AsyncLogger(const AsyncLogger &) = delete;
+    AsyncLogger &operator=(AsyncLogger &&) = delete;
+    AsyncLogger &operator=(const AsyncLogger &) = delete;
+
+    // Delivers everything which was logged before stopping the background thread
+    ~AsyncLogger() override {
+        _stopping.store(true, std::memory_order_release);
+        _wake.notify_one();
+        _thread.join();
+    }
+
+    void log(const LogLevel l, const std::string &message) const override {
+        record(LogMessage{l, message});
+    }
+
+    void record(const LogMessage &message) const override {
+        if (!tryEnqueue(message)) {
+            std::ignore = _dropped.fetch_add(1U, std::memory_order_relaxed);
+            return;
+        }
+        std::ignore = _accepted.fetch_add(1U, std::memory_order_release);
+        if (_waiting.load(std::memory_order_seq_cst)) {
+            _wake.notify_one();
+        }
+    }
+
+    /**
+     * Wait until every message logged so far has been delivered.
+     */
+    void flush() const {
+        const auto accepted = _accepted.load(std::memory_order_acquire);
+        while (_delivered.load(std::memory_order_acquire) < accepted) {
+            _wake.notify_one();
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    }
+
+    // Messages which were dropped because the ring was full
+    uint64_t dropped() const {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+};
+} // namespace logging
+} // namespace store
+} // namespace aws
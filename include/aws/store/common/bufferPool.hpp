@@ -0,0 +1,194 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace aws {
+namespace store {
+namespace common {
+struct BufferPoolOptions {
+    // Larger buffers are allocated and freed as usual
+    uint32_t max_buffer_size = 64U * 1024U;
+    // Free buffers kept for reuse, in total across all threads
+    uint64_t max_retained_bytes = 4U * 1024U * 1024U;
+    // Free buffers of each size which a thread keeps to itself before sharing them with other threads
+    uint32_t buffers_per_thread = 16U;
+};
+
+struct BufferPoolStats {
+    // Buffers which were reused
+    uint64_t hits;
+    // Buffers which had to be allocated, including those too large to be pooled
+    uint64_t misses;
+    // Free buffers currently kept for reuse
+    uint64_t retained_bytes;
+};
+
+/**
+ * Reuses the memory of record buffers once they are freed, so that reading many records does not allocate and free
+ * memory for each one, and so that memory is not fragmented by long running processes. Buffers are rounded up to a
+ * power of two of at least 64 bytes, and each size is kept in its own free list.
+ *
+ * Each thread frees buffers into and takes buffers from a cache of its own, sharing buffers through one common cache
+ * only once its own cache is full or empty. Caches are picked by thread, so a pool used by more threads than there
+ * are CPUs has threads sharing a cache. One pool can be shared by many streams.
+ */
+class BufferPool {
+  public:
+    static constexpr uint8_t NOT_POOLED = UINT8_MAX;
+
+  private:
+    static constexpr uint32_t MIN_BUFFER_SIZE = 64U;
+    static constexpr uint8_t MAX_SIZE_CLASSES = 27U;
+
+    struct Cache {
+        std::mutex lock{};
+        std::vector<uint8_t *> free[MAX_SIZE_CLASSES];
+    };
+
+    BufferPoolOptions _opts;
+    uint8_t _size_classes;
+    size_t _thread_cache_count;
+    std::unique_ptr<Cache[]> _thread_caches;
+    Cache _shared{};
+    std::atomic<uint64_t> _hits{0U};
+    std::atomic<uint64_t> _misses{0U};
+    std::atomic<uint64_t> _retained_bytes{0U};
+
+    static uint8_t sizeClassOf(const uint32_t size) noexcept {
+        if (size <= MIN_BUFFER_SIZE) {
+            return 0U;
+        }
+        // Number of bits needed to hold size - 1, which rounds size up to a power of two
+        const auto bits = static_cast<uint8_t>(32 - __builtin_clz(size - 1U));
+        return static_cast<uint8_t>(bits - 6U);
+    }
+
+    static uint32_t sizeOfClass(const uint8_t size_class) noexcept {
+        return MIN_BUFFER_SIZE << size_class;
+    }
+
+    Cache &threadCache() noexcept {
+        static std::atomic<uint32_t> next_thread{0U};
+        thread_local const uint32_t thread = next_thread.fetch_add(1U, std::memory_order_relaxed);
+        return _thread_caches[thread % _thread_cache_count];
+    }
+
+    static uint8_t *takeFrom(Cache &cache, const uint8_t size_class) {
+        std::lock_guard<std::mutex> lock{cache.lock};
+        auto &free = cache.free[size_class];
+        if (free.empty()) {
+            return nullptr;
+        }
+        auto *const buffer = free.back();
+        free.pop_back();
+        return buffer;
+    }
+
+    static bool giveTo(Cache &cache, uint8_t *buffer, const uint8_t size_class, const size_t limit) {
+        std::lock_guard<std::mutex> lock{cache.lock};
+        auto &free = cache.free[size_class];
+        if (free.size() >= limit) {
+            return false;
+        }
+        free.push_back(buffer);
+        return true;
+    }
+
+  public:
+    explicit BufferPool(const BufferPoolOptions &opts = BufferPoolOptions{})
+        : _opts(opts),
+          _size_classes(static_cast<uint8_t>(sizeClassOf(std::min(opts.max_buffer_size, 1U << 31U)) + 1U)),
+          _thread_cache_count(std::max(std::thread::hardware_concurrency(), 1U)),
+          // coverity[autosar_cpp14_a20_8_5_violation] cannot construct an array of caches with make_unique
+          _thread_caches(new Cache[_thread_cache_count]) {
+        for (size_t i = 0U; i < _thread_cache_count; i++) {
+            for (uint8_t c = 0U; c < _size_classes; c++) {
+                _thread_caches[i].free[c].reserve(_opts.buffers_per_thread);
+            }
+        }
+    }
+
+    BufferPool(BufferPool &&) = delete;
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(BufferPool &&) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    ~BufferPool() {
+        const auto free_all = [this](Cache &cache) {
+            for (uint8_t c = 0U; c < _size_classes; c++) {
+                for (auto *buffer : cache.free[c]) {
+                    delete[] buffer;
+                }
+            }
+        };
+        for (size_t i = 0U; i < _thread_cache_count; i++) {
+            free_all(_thread_caches[i]);
+        }
+        free_all(_shared);
+    }
+
+    /**
+     * Take a buffer of at least size bytes. size_class is set to what must be given back to give() with the buffer.
+     * Returns nullptr if memory could not be allocated.
+     */
+    uint8_t *take(const uint32_t size, uint8_t &size_class) noexcept {
+        if (size > sizeOfClass(static_cast<uint8_t>(_size_classes - 1U))) {
+            size_class = NOT_POOLED;
+            std::ignore = _misses.fetch_add(1U, std::memory_order_relaxed);
+            // coverity[misra_cpp_2008_rule_18_4_1_violation] cannot construct arbitrary size with make_unique
+            return new (std::nothrow) uint8_t[size];
+        }
+        size_class = sizeClassOf(size);
+        auto *buffer = takeFrom(threadCache(), size_class);
+        if (buffer == nullptr) {
+            buffer = takeFrom(_shared, size_class);
+        }
+        if (buffer != nullptr) {
+            std::ignore = _hits.fetch_add(1U, std::memory_order_relaxed);
+            std::ignore = _retained_bytes.fetch_sub(sizeOfClass(size_class), std::memory_order_relaxed);
+            return buffer;
+        }
+        std::ignore = _misses.fetch_add(1U, std::memory_order_relaxed);
+        // coverity[misra_cpp_2008_rule_18_4_1_violation] cannot construct arbitrary size with make_unique
+        return new (std::nothrow) uint8_t[sizeOfClass(size_class)];
+    }
+
+    /**
+     * Give back a buffer from take(), to be reused or freed.
+     */
+    void give(uint8_t *buffer, const uint8_t size_class) noexcept {
+        if (buffer == nullptr) {
+            return;
+        }
+        if (size_class == NOT_POOLED) {
+            delete[] buffer;
+            return;
+        }
+        const auto size = sizeOfClass(size_class);
+        if ((_retained_bytes.fetch_add(size, std::memory_order_relaxed) + size) <= _opts.max_retained_bytes) {
+            if (giveTo(threadCache(), buffer, size_class, _opts.buffers_per_thread) ||
+                giveTo(_shared, buffer, size_class, SIZE_MAX)) {
+                return;
+            }
+        }
+        std::ignore = _retained_bytes.fetch_sub(size, std::memory_order_relaxed);
+        delete[] buffer;
+    }
+
+    BufferPoolStats stats() const noexcept {
+        return BufferPoolStats{_hits.load(std::memory_order_relaxed), _misses.load(std::memory_order_relaxed),
+                               _retained_bytes.load(std::memory_order_relaxed)};
+    }
+};
+} // namespace common
+} // namespace store
+} // namespace aws
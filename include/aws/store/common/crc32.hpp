@@ -4,9 +4,20 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <tuple>
 
 #include <aws/store/common/slices.hpp>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
 namespace aws {
 namespace store {
 namespace common {
@@ -42,13 +53,244 @@ static constexpr uint32_t table[256] = {
     0x24B4A3A6U, 0xBAD03605U, 0xCDD70693U, 0x54DE5729U, 0x23D967BFU, 0xB3667A2EU, 0xC4614AB8U, 0x5D681B02U, 0x2A6F2B94U,
     0xB40BBE37U, 0xC30C8EA1U, 0x5A05DF1BU, 0x2D02EF8DU};
 
-static uint32_t update(const uint32_t initial_value, const void *buf, const size_t len) {
-    uint32_t c = initial_value ^ 0xFFFFFFFF;
-    const auto *u = static_cast<const uint8_t *>(buf);
+namespace detail {
+// Lookup tables for slicing-by-8, where slice[k][i] is the CRC of byte i followed by k zero bytes, and the powers
+// x^(2^k) modulo the CRC polynomial which are used to combine CRCs.
+struct Tables {
+    uint32_t slice[8][256];
+    uint32_t x2n[32];
+};
+
+constexpr uint32_t POLYNOMIAL = 0xEDB88320U; // IEEE 802.3, bit reversed
+
+// Multiply a and b modulo the CRC polynomial
+inline uint32_t multiplyModP(const uint32_t a, uint32_t b) {
+    uint32_t m = 1U << 31U;
+    uint32_t p = 0U;
+    while (true) {
+        if ((a & m) != 0U) {
+            p ^= b;
+            if ((a & (m - 1U)) == 0U) {
+                break;
+            }
+        }
+        m >>= 1U;
+        b = ((b & 1U) != 0U) ? ((b >> 1U) ^ POLYNOMIAL) : (b >> 1U);
+    }
+    return p;
+}
+
+inline Tables makeTables() {
+    Tables t{};
+    for (uint32_t i = 0U; i < 256U; i++) {
+        t.slice[0][i] = table[i];
+    }
+    for (size_t k = 1U; k < 8U; k++) {
+        for (size_t i = 0U; i < 256U; i++) {
+            const auto prev = t.slice[k - 1U][i];
+            t.slice[k][i] = (prev >> 8U) ^ table[prev & 0xFFU];
+        }
+    }
+    uint32_t p = 1U << 30U; // x^1
+    t.x2n[0] = p;
+    for (size_t n = 1U; n < 32U; n++) {
+        p = multiplyModP(p, p);
+        t.x2n[n] = p;
+    }
+    return t;
+}
+
+inline const Tables &tables() {
+    static const Tables t = makeTables();
+    return t;
+}
+
+// The kernels below work on the inverted CRC state
+
+inline uint32_t updateBytewise(uint32_t c, const uint8_t *u, size_t len) {
     for (size_t i = 0U; i < len; ++i) {
-        c = table[(c ^ u[i]) & 0xFFU] ^ (c >> 8);
+        c = table[(c ^ u[i]) & 0xFFU] ^ (c >> 8U);
+    }
+    return c;
+}
+
+inline uint32_t load32LittleEndian(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8U) | (static_cast<uint32_t>(p[2]) << 16U) |
+           (static_cast<uint32_t>(p[3]) << 24U);
+}
+
+inline uint32_t updateSlicingBy8(uint32_t c, const uint8_t *u, size_t len) {
+    const auto &t = tables().slice;
+    while (len >= 8U) {
+        const auto one = c ^ load32LittleEndian(u);
+        const auto two = load32LittleEndian(u + 4U);
+        c = t[7][one & 0xFFU] ^ t[6][(one >> 8U) & 0xFFU] ^ t[5][(one >> 16U) & 0xFFU] ^ t[4][one >> 24U] ^
+            t[3][two & 0xFFU] ^ t[2][(two >> 8U) & 0xFFU] ^ t[1][(two >> 16U) & 0xFFU] ^ t[0][two >> 24U];
+        u += 8U;
+        len -= 8U;
+    }
+    return updateBytewise(c, u, len);
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define STORE_CRC32_PCLMUL 1
+// Folds 64 bytes at a time using carry-less multiplication, following Intel's "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction" with the bit-reflected constants for the IEEE polynomial.
+// len must be at least 64 and a multiple of 16.
+#define STORE_CRC32_PCLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+STORE_CRC32_PCLMUL_TARGET inline __m128i pclmulLoad(const uint8_t *p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+// Fold 16 bytes of state forward by 16 bytes onto next
+STORE_CRC32_PCLMUL_TARGET inline __m128i pclmulFold16(const __m128i x, const __m128i next, const __m128i k) {
+    return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), next), _mm_clmulepi64_si128(x, k, 0x00));
+}
+
+STORE_CRC32_PCLMUL_TARGET inline uint32_t foldPclmul(const uint32_t c, const uint8_t *buf, size_t len) {
+    const auto k1k2 = _mm_set_epi64x(0x01C6E41596, 0x0154442BD4);
+    const auto k3k4 = _mm_set_epi64x(0x00CCAA009E, 0x01751997D0);
+    const auto k5k0 = _mm_set_epi64x(0x0000000000, 0x0163CD6124);
+    const auto poly = _mm_set_epi64x(0x01F7011641, 0x01DB710641);
+
+    auto x1 = _mm_xor_si128(pclmulLoad(buf), _mm_cvtsi32_si128(static_cast<int>(c)));
+    auto x2 = pclmulLoad(buf + 16U);
+    auto x3 = pclmulLoad(buf + 32U);
+    auto x4 = pclmulLoad(buf + 48U);
+    buf += 64U;
+    len -= 64U;
+
+    // Fold 4 lanes of 16 bytes in parallel
+    while (len >= 64U) {
+        const auto x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        const auto x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        const auto x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+        const auto x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k1k2, 0x11), x5), pclmulLoad(buf));
+        x2 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x2, k1k2, 0x11), x6), pclmulLoad(buf + 16U));
+        x3 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x3, k1k2, 0x11), x7), pclmulLoad(buf + 32U));
+        x4 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x4, k1k2, 0x11), x8), pclmulLoad(buf + 48U));
+        buf += 64U;
+        len -= 64U;
+    }
+
+    // Fold the lanes, then any remaining 16 byte blocks, into one
+    x1 = pclmulFold16(x1, x2, k3k4);
+    x1 = pclmulFold16(x1, x3, k3k4);
+    x1 = pclmulFold16(x1, x4, k3k4);
+    while (len >= 16U) {
+        x1 = pclmulFold16(x1, pclmulLoad(buf), k3k4);
+        buf += 16U;
+        len -= 16U;
+    }
+
+    // Fold 128 bits down to 64, then Barrett reduce to 32
+    const auto mask = _mm_setr_epi32(~0, 0, ~0, 0);
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask), k5k0, 0x00), x2);
+
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), poly, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+inline uint32_t updatePclmul(uint32_t c, const uint8_t *u, size_t len) {
+    constexpr size_t minimum_length = 64U;
+    if (len >= minimum_length) {
+        const auto chunk = len & ~static_cast<size_t>(15U);
+        c = foldPclmul(c, u, chunk);
+        u += chunk;
+        len -= chunk;
+    }
+    return updateSlicingBy8(c, u, len);
+}
+
+inline bool hasPclmul() {
+    __builtin_cpu_init();
+    return (__builtin_cpu_supports("pclmul") != 0) && (__builtin_cpu_supports("sse4.1") != 0);
+}
+#elif defined(__aarch64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#define STORE_CRC32_ARM 1
+#if defined(__clang__)
+#define STORE_CRC32_ARM_TARGET __attribute__((target("crc")))
+#else
+#define STORE_CRC32_ARM_TARGET __attribute__((target("+crc")))
+#endif
+// The ARMv8 CRC32 instructions use the same IEEE polynomial and process 8 bytes per instruction.
+STORE_CRC32_ARM_TARGET inline uint32_t updateArmCrc(uint32_t c, const uint8_t *u, size_t len) {
+    while ((len >= 8U) || ((len > 0U) && ((reinterpret_cast<uintptr_t>(u) & 7U) != 0U))) {
+        if ((reinterpret_cast<uintptr_t>(u) & 7U) != 0U) {
+            c = __crc32b(c, *u);
+            ++u;
+            --len;
+            continue;
+        }
+        uint64_t v = 0U;
+        std::ignore = memcpy(&v, u, sizeof(v));
+        c = __crc32d(c, v);
+        u += 8U;
+        len -= 8U;
+    }
+    while (len > 0U) {
+        c = __crc32b(c, *u);
+        ++u;
+        --len;
+    }
+    return c;
+}
+
+inline bool hasArmCrc() {
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0U;
+}
+#endif
+
+using UpdateFunction = uint32_t (*)(uint32_t, const uint8_t *, size_t);
+
+// Pick the fastest kernel which this CPU supports
+inline UpdateFunction selectUpdate() {
+#if defined(STORE_CRC32_PCLMUL)
+    if (hasPclmul()) {
+        return updatePclmul;
+    }
+#elif defined(STORE_CRC32_ARM)
+    if (hasArmCrc()) {
+        return updateArmCrc;
+    }
+#endif
+    return updateSlicingBy8;
+}
+} // namespace detail
+
+/**
+ * Continue the CRC-32 (IEEE 802.3) initial_value with len bytes at buf. Use 0 to start a new CRC.
+ * Uses carry-less multiplication or CRC instructions when the CPU has them, and slicing-by-8 otherwise. All give the
+ * same result.
+ */
+inline uint32_t update(const uint32_t initial_value, const void *buf, const size_t len) {
+    static const detail::UpdateFunction kernel = detail::selectUpdate();
+    return kernel(initial_value ^ 0xFFFFFFFFU, static_cast<const uint8_t *>(buf), len) ^ 0xFFFFFFFFU;
+}
+
+/**
+ * Combine crc1 of some data with crc2 of the len2 bytes which follow it into the CRC of both together, so that parts
+ * of a large buffer can be checksummed separately, such as in parallel.
+ */
+inline uint32_t crc32_combine(const uint32_t crc1, const uint32_t crc2, size_t len2) {
+    // Multiply crc1 by x^(8 * len2), built up from the precomputed powers x^(2^k)
+    const auto &x2n = detail::tables().x2n;
+    uint32_t p = 1U << 31U; // x^0
+    size_t k = 3U;          // 8 bits per byte
+    while (len2 != 0U) {
+        if ((len2 & 1U) != 0U) {
+            p = detail::multiplyModP(x2n[k & 31U], p);
+        }
+        len2 >>= 1U;
+        ++k;
     }
-    return c ^ 0xFFFFFFFF;
+    return detail::multiplyModP(p, crc1) ^ crc2;
 }
 
 inline uint32_t crc32_of(const std::initializer_list<BorrowedSlice> args) {
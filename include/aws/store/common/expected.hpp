@@ -2,58 +2,137 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #pragma once
+#include <cassert>
 #include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
 
 namespace aws {
 namespace store {
 namespace common {
+/**
+ * Either a value or an error. Only the one which is held is ever constructed, so returning a value does not also
+ * construct an error, and the other way around.
+ */
 template <class ExpectedT, class UnexpectedT> class Expected {
   private:
+    // Select which member a constructor makes live
+    struct ValueTag {};
+    struct ErrorTag {};
+
     bool _is_set{false};
-    ExpectedT _val{};
-    UnexpectedT _unexpected{};
+    union {
+        ExpectedT _val;
+        UnexpectedT _unexpected;
+    };
+
+    template <class T> Expected(ValueTag, T &&val) : _is_set(true), _val(std::forward<T>(val)) {
+    }
+    template <class T> Expected(ErrorTag, T &&unexpect) : _is_set(false), _unexpected(std::forward<T>(unexpect)) {
+    }
+
+    // Each branch names the member which it knows to be live, and the new state is only recorded once it has been
+    // constructed, so that the compiler never sees the inactive member being read
+    template <class Other> void assignFrom(Other &&other) {
+        if (_is_set) {
+            _val.~ExpectedT();
+        } else {
+            _unexpected.~UnexpectedT();
+        }
+        if (other._is_set) {
+            std::ignore = new (&_val) ExpectedT(std::forward<Other>(other)._val);
+        } else {
+            std::ignore = new (&_unexpected) UnexpectedT(std::forward<Other>(other)._unexpected);
+        }
+        _is_set = other._is_set;
+    }
 
   public:
-    Expected(ExpectedT &&val) : _is_set(true), _val(std::move(val)) {
+    Expected(ExpectedT &&val) : Expected(ValueTag{}, std::move(val)) {
     }
-    Expected(UnexpectedT &&unexpect) : _unexpected(std::move(unexpect)) {
+    Expected(UnexpectedT &&unexpect) : Expected(ErrorTag{}, std::move(unexpect)) {
     }
     // coverity[misra_cpp_2008_rule_14_7_1_violation] keep the more efficient method even if currently unused
-    Expected(const ExpectedT &val) : _is_set(true), _val(val) {
+    Expected(const ExpectedT &val) : Expected(ValueTag{}, val) {
+    }
+    Expected(const UnexpectedT &unexpect) : Expected(ErrorTag{}, unexpect) {
     }
-    Expected(const UnexpectedT &unexpect) : _unexpected(unexpect) {
+
+    Expected(const Expected &other) : _is_set(other._is_set) {
+        if (other._is_set) {
+            std::ignore = new (&_val) ExpectedT(other._val);
+        } else {
+            std::ignore = new (&_unexpected) UnexpectedT(other._unexpected);
+        }
+    }
+    Expected(Expected &&other) noexcept : _is_set(other._is_set) {
+        if (other._is_set) {
+            std::ignore = new (&_val) ExpectedT(std::move(other._val));
+        } else {
+            std::ignore = new (&_unexpected) UnexpectedT(std::move(other._unexpected));
+        }
+    }
+    Expected &operator=(const Expected &other) {
+        if (this != &other) {
+            assignFrom(other);
+        }
+        return *this;
+    }
+    Expected &operator=(Expected &&other) noexcept {
+        if (this != &other) {
+            assignFrom(std::move(other));
+        }
+        return *this;
     }
+
+    ~Expected() {
+        if (_is_set) {
+            _val.~ExpectedT();
+        } else {
+            _unexpected.~UnexpectedT();
+        }
+    }
+
     bool ok() const {
         return _is_set;
     }
 
     const ExpectedT &val() const & {
+        assert(_is_set);
         return _val;
     }
     ExpectedT &val() & {
+        assert(_is_set);
         return _val;
     }
     // coverity[misra_cpp_2008_rule_14_7_1_violation] keep the more efficient method even if currently unused
     const ExpectedT &&val() const && {
+        assert(_is_set);
         return std::move(_val);
     }
     // coverity[misra_cpp_2008_rule_14_7_1_violation] keep the more efficient method even if currently unused
     ExpectedT &&val() && {
+        assert(_is_set);
         return std::move(_val);
     }
 
     const UnexpectedT &err() const & {
+        assert(!_is_set);
         return _unexpected;
     }
     UnexpectedT &err() & {
+        assert(!_is_set);
         return _unexpected;
     }
     // coverity[misra_cpp_2008_rule_14_7_1_violation] keep the more efficient method even if currently unused
     const UnexpectedT &&err() const && {
+        assert(!_is_set);
         return std::move(_unexpected);
     }
     // coverity[misra_cpp_2008_rule_14_7_1_violation] keep the more efficient method even if currently unused
     UnexpectedT &&err() && {
+        assert(!_is_set);
         return std::move(_unexpected);
     }
 };
@@ -2,9 +2,15 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #pragma once
+#include <algorithm>
+#include <aws/store/common/util.hpp>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <tuple>
+#include <type_traits>
 
 namespace aws {
 namespace store {
@@ -51,6 +57,157 @@ inline std::ostream &operator<<(std::ostream &out, const LogLevel level) {
     return out;
 }
 
+/**
+ * The parts of a log message, recorded without formatting them so that recording a message is cheap and never
+ * allocates memory. Strings wrapped in common::Literal are kept as pointers, while other strings, including char
+ * arrays, are copied into the message, up to TEXT_BYTES in total. Integers are kept as they are. Parts which do not fit
+ * are left out, and the message then ends with "...".
+ */
+class LogMessage {
+  public:
+    static constexpr uint8_t MAX_PARTS = 16U;
+    static constexpr uint16_t TEXT_BYTES = 256U;
+
+  private:
+    enum class Kind : uint8_t {
+        Literal,
+        Text,
+        Signed,
+        Unsigned,
+    };
+
+    struct Part {
+        Kind kind;
+        uint16_t text_offset;
+        uint16_t text_length;
+        union {
+            const char *literal;
+            int64_t signed_value;
+            uint64_t unsigned_value;
+        };
+    };
+
+    Part _parts[MAX_PARTS];
+    char _text[TEXT_BYTES];
+    uint8_t _part_count{0U};
+    uint16_t _text_used{0U};
+    bool _truncated{false};
+
+    Part *next() {
+        if (_part_count == MAX_PARTS) {
+            _truncated = true;
+            return nullptr;
+        }
+        return &_parts[_part_count++];
+    }
+
+    void addText(const char *text, const size_t length) {
+        auto *const part = next();
+        if (part == nullptr) {
+            return;
+        }
+        const auto room = static_cast<size_t>(TEXT_BYTES - _text_used);
+        const auto copied = std::min(length, room);
+        _truncated = _truncated || (copied < length);
+        part->kind = Kind::Text;
+        part->text_offset = _text_used;
+        part->text_length = static_cast<uint16_t>(copied);
+        std::ignore = memcpy(_text + _text_used, text, copied);
+        _text_used = static_cast<uint16_t>(_text_used + copied);
+    }
+
+    // An array of char may be a buffer which is gone by the time the message is formatted, so it is copied
+    template <size_t N> void addPart(const char (&text)[N], std::true_type) {
+        addText(text, strnlen(text, N));
+    }
+
+    template <typename T> void addPart(const T &value, std::false_type) {
+        addValue(value);
+    }
+
+    void addValue(const common::Literal text) {
+        auto *const part = next();
+        if (part != nullptr) {
+            part->kind = Kind::Literal;
+            part->literal = text.c_str();
+        }
+    }
+
+    void addValue(const char *text) {
+        addText(text, strlen(text));
+    }
+
+    void addValue(const char c) {
+        addText(&c, 1U);
+    }
+
+    void addValue(const bool b) {
+        addValue(b ? common::Literal{"true"} : common::Literal{"false"});
+    }
+
+    void addValue(const std::string &text) {
+        addText(text.data(), text.size());
+    }
+
+    void addValue(const common::ErrorMessage &text) {
+        addValue(text.c_str());
+    }
+
+    template <typename T> typename std::enable_if<std::is_integral<T>::value>::type addValue(const T value) {
+        auto *const part = next();
+        if (part == nullptr) {
+            return;
+        }
+        if (std::is_signed<T>::value) {
+            part->kind = Kind::Signed;
+            part->signed_value = static_cast<int64_t>(value);
+        } else {
+            part->kind = Kind::Unsigned;
+            part->unsigned_value = static_cast<uint64_t>(value);
+        }
+    }
+
+    void addParts() {
+    }
+
+    template <typename T, typename... Rest> void addParts(const T &first, const Rest &...rest) {
+        addPart(first, std::is_array<T>{});
+        addParts(rest...);
+    }
+
+  public:
+    LogLevel level;
+
+    template <typename... Parts> explicit LogMessage(const LogLevel l, const Parts &...parts) : level(l) {
+        addParts(parts...);
+    }
+
+    std::string format() const {
+        std::string message{};
+        for (uint8_t i = 0U; i < _part_count; i++) {
+            const auto &part = _parts[i];
+            switch (part.kind) {
+            case Kind::Literal:
+                message += part.literal;
+                break;
+            case Kind::Text:
+                std::ignore = message.append(_text + part.text_offset, part.text_length);
+                break;
+            case Kind::Signed:
+                message += std::to_string(part.signed_value);
+                break;
+            case Kind::Unsigned:
+                message += std::to_string(part.unsigned_value);
+                break;
+            }
+        }
+        if (_truncated) {
+            message += "...";
+        }
+        return message;
+    }
+};
+
 class Logger {
   public:
     LogLevel level{LogLevel::Info};
@@ -59,7 +216,30 @@ class Logger {
     virtual ~Logger() = default;
 
     virtual void log(LogLevel, const std::string &) const = 0;
+
+    /**
+     * Log a message which has not been formatted yet. By default it is formatted and logged right away, while loggers
+     * which deliver messages later on can keep the message and format it then.
+     */
+    virtual void record(const LogMessage &message) const {
+        log(message.level, message.format());
+    }
+
+    bool enabled(const LogLevel l) const {
+        return level <= l;
+    }
 };
+
+/**
+ * Log the concatenation of parts if the logger is set and logs messages of this level. Nothing is formatted when the
+ * message is not logged, and a logger may format it later on, so this is cheap enough to use anywhere.
+ */
+template <typename... Parts>
+inline void log(const std::shared_ptr<Logger> &logger, const LogLevel level, const Parts &...parts) {
+    if (logger && logger->enabled(level)) {
+        logger->record(LogMessage{level, parts...});
+    }
+}
 } // namespace logging
 } // namespace store
 } // namespace aws
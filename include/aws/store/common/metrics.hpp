@@ -0,0 +1,165 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace aws {
+namespace store {
+namespace common {
+/**
+ * A count which many threads may add to at once.
+ */
+class Counter {
+  private:
+    std::atomic<uint64_t> _value{0U};
+
+  public:
+    void add(const uint64_t n = 1U) noexcept {
+        std::ignore = _value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const noexcept {
+        return _value.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * The values recorded by a Histogram up to some point in time.
+ */
+struct HistogramSnapshot {
+    uint64_t count{0U};
+    uint64_t sum{0U};
+    uint64_t max{0U};
+    // Number of values recorded in each bucket of Histogram
+    std::vector<uint64_t> buckets{};
+
+    uint64_t mean() const noexcept {
+        return (count == 0U) ? 0U : (sum / count);
+    }
+
+    /**
+     * The value which percent of the recorded values are at or below, rounded up to the end of its bucket so that it
+     * is at most 12.5% above the exact value.
+     */
+    uint64_t percentile(const double percent) const noexcept;
+};
+
+/**
+ * Counts values, such as latencies in nanoseconds, into buckets which are each at most 1/8th as wide as the values in
+ * them, in the manner of an HDR histogram. Recording a value is a few atomic additions without taking a lock, so it
+ * may be done from many threads at once. Values of 2^40 (about 18 minutes in nanoseconds) and more all share the last
+ * bucket, though the maximum is still kept exactly.
+ */
+class Histogram {
+  public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 3U;
+    static constexpr uint32_t SUB_BUCKETS = 1U << SUB_BUCKET_BITS;
+    static constexpr uint32_t MAX_EXPONENT = 40U;
+    static constexpr uint32_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 1U) * SUB_BUCKETS;
+
+  private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> _buckets{};
+    std::atomic<uint64_t> _sum{0U};
+    std::atomic<uint64_t> _max{0U};
+
+  public:
+    static uint32_t bucketOf(const uint64_t value) noexcept {
+        if (value < SUB_BUCKETS) {
+            return static_cast<uint32_t>(value);
+        }
+        const auto exponent = 63U - static_cast<uint32_t>(__builtin_clzll(value));
+        if (exponent >= MAX_EXPONENT) {
+            return BUCKET_COUNT - 1U;
+        }
+        // The highest bit picks the group of buckets and the next SUB_BUCKET_BITS bits pick the bucket within it
+        const auto sub_bucket = static_cast<uint32_t>(value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1U);
+        return ((exponent - SUB_BUCKET_BITS + 1U) * SUB_BUCKETS) + sub_bucket;
+    }
+
+    // The largest value which is counted in the bucket
+    static uint64_t bucketUpperBound(const uint32_t bucket) noexcept {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        if (bucket >= (BUCKET_COUNT - 1U)) {
+            return UINT64_MAX;
+        }
+        const auto shift = (bucket / SUB_BUCKETS) - 1U;
+        const auto lower = static_cast<uint64_t>(SUB_BUCKETS + (bucket % SUB_BUCKETS)) << shift;
+        return lower + (static_cast<uint64_t>(1U) << shift) - 1U;
+    }
+
+    void record(const uint64_t value) noexcept {
+        std::ignore = _buckets[bucketOf(value)].fetch_add(1U, std::memory_order_relaxed);
+        std::ignore = _sum.fetch_add(value, std::memory_order_relaxed);
+        auto max = _max.load(std::memory_order_relaxed);
+        while ((value > max) && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * Copy out the values recorded so far. Values which are recorded while taking the snapshot may only be partly
+     * included, such as in the count but not yet in the sum.
+     */
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot s{};
+        s.buckets.resize(BUCKET_COUNT);
+        for (uint32_t i = 0U; i < BUCKET_COUNT; i++) {
+            s.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+            s.count += s.buckets[i];
+        }
+        s.sum = _sum.load(std::memory_order_relaxed);
+        s.max = _max.load(std::memory_order_relaxed);
+        return s;
+    }
+};
+
+inline uint64_t HistogramSnapshot::percentile(const double percent) const noexcept {
+    if (count == 0U) {
+        return 0U;
+    }
+    const auto wanted = static_cast<double>(count) * percent / 100.0;
+    uint64_t seen = 0U;
+    for (uint32_t i = 0U; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if ((seen > 0U) && (static_cast<double>(seen) >= wanted)) {
+            const auto bound = Histogram::bucketUpperBound(i);
+            return (bound < max) ? bound : max;
+        }
+    }
+    return max;
+}
+
+/**
+ * Records the nanoseconds from its construction until it is destroyed.
+ */
+class ScopedTimer {
+  private:
+    Histogram &_histogram;
+    std::chrono::steady_clock::time_point _start;
+
+  public:
+    explicit ScopedTimer(Histogram &histogram) noexcept
+        : _histogram(histogram), _start(std::chrono::steady_clock::now()) {
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+    ScopedTimer(ScopedTimer &&) = delete;
+    ScopedTimer &operator=(ScopedTimer &&) = delete;
+
+    ~ScopedTimer() noexcept {
+        const auto elapsed = std::chrono::steady_clock::now() - _start;
+        _histogram.record(
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+};
+} // namespace common
+} // namespace store
+} // namespace aws
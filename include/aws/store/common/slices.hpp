@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #pragma once
+#include <aws/store/common/bufferPool.hpp>
 #include <cassert>
 #include <cstring>
 #include <memory> // for unique_ptr
@@ -47,7 +48,28 @@ class BorrowedSlice {
     static_assert(sizeof(uint8_t) == sizeof(char), "Char and uint8 must be the same size");
 };
 
-class OwnedSlice : private std::unique_ptr<uint8_t[]> {
+// Frees a slice's memory, giving it back to the pool it was taken from if there is one
+class SliceDeleter {
+  private:
+    std::shared_ptr<BufferPool> _pool{};
+    uint8_t _size_class{BufferPool::NOT_POOLED};
+
+  public:
+    SliceDeleter() = default;
+    SliceDeleter(std::shared_ptr<BufferPool> pool, const uint8_t size_class)
+        : _pool(std::move(pool)), _size_class(size_class) {
+    }
+
+    void operator()(uint8_t *d) const {
+        if (_pool) {
+            _pool->give(d, _size_class);
+        } else {
+            delete[] d;
+        }
+    }
+};
+
+class OwnedSlice : private std::unique_ptr<uint8_t[], SliceDeleter> {
   private:
     uint32_t _size{0U};
 
@@ -56,7 +78,7 @@ class OwnedSlice : private std::unique_ptr<uint8_t[]> {
     explicit OwnedSlice(const BorrowedSlice b) : _size(b.size()) {
         // coverity[autosar_cpp14_a20_8_5_violation] cannot construct arbitrary size with make_unique
         // coverity[misra_cpp_2008_rule_18_4_1_violation] cannot construct arbitrary size with make_unique
-        std::unique_ptr<uint8_t[]> mem{new (std::nothrow) uint8_t[_size]};
+        std::unique_ptr<uint8_t[], SliceDeleter> mem{new (std::nothrow) uint8_t[_size]};
         std::ignore = memcpy(mem.get(), b.data(), b.size());
         swap(mem);
     }
@@ -64,10 +86,29 @@ class OwnedSlice : private std::unique_ptr<uint8_t[]> {
     explicit OwnedSlice(const uint32_t size) : _size(size) {
         // coverity[autosar_cpp14_a20_8_5_violation] cannot construct arbitrary size with make_unique
         // coverity[misra_cpp_2008_rule_18_4_1_violation] cannot construct arbitrary size with make_unique
-        std::unique_ptr<uint8_t[]> mem{new (std::nothrow) uint8_t[_size]};
+        std::unique_ptr<uint8_t[], SliceDeleter> mem{new (std::nothrow) uint8_t[_size]};
+        swap(mem);
+    }
+
+    /**
+     * Allocate size bytes from the pool, or as usual if pool is null.
+     */
+    OwnedSlice(const uint32_t size, const std::shared_ptr<BufferPool> &pool) : _size(size) {
+        if (!pool) {
+            // coverity[misra_cpp_2008_rule_18_4_1_violation] cannot construct arbitrary size with make_unique
+            reset(new (std::nothrow) uint8_t[_size]);
+            return;
+        }
+        uint8_t size_class = BufferPool::NOT_POOLED;
+        auto *const d = pool->take(size, size_class);
+        std::unique_ptr<uint8_t[], SliceDeleter> mem{d, SliceDeleter{pool, size_class}};
         swap(mem);
     }
 
+    OwnedSlice(const BorrowedSlice b, const std::shared_ptr<BufferPool> &pool) : OwnedSlice(b.size(), pool) {
+        std::ignore = memcpy(get(), b.data(), b.size());
+    }
+
     OwnedSlice(uint8_t *d, const uint32_t size) : _size(size) {
         reset(d);
     }
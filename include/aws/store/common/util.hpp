@@ -3,15 +3,131 @@
 
 #pragma once
 
+#include <cstring>
+#include <memory>
+#include <ostream>
 #include <string>
+#include <utility>
 
 namespace aws {
 namespace store {
 namespace common {
+/**
+ * A string literal, or another string which lives as long as the program does. It is only ever referred to, never
+ * copied, so it must be wrapped explicitly.
+ */
+class Literal {
+  private:
+    const char *_text;
+
+  public:
+    template <size_t N> constexpr explicit Literal(const char (&text)[N]) : _text(text) {
+    }
+
+    constexpr const char *c_str() const {
+        return _text;
+    }
+};
+
+/**
+ * The message of an error. Literals are referred to without being copied, so that returning common errors, such as a
+ * record which is not found, does not allocate memory. Any other message, including one in a plain char array, is
+ * copied when the error happens and is then shared by all copies of the error.
+ */
+class ErrorMessage {
+  private:
+    const char *_text{nullptr};
+    std::shared_ptr<const std::string> _formatted{};
+
+  public:
+    ErrorMessage() = default;
+
+    // coverity[autosar_cpp14_a12_1_4_violation] implicit so that errors can be made from literals
+    ErrorMessage(const Literal text) : _text(text.c_str()) {
+    }
+
+    // coverity[autosar_cpp14_a12_1_4_violation] implicit so that errors can be made from char arrays, which are copied
+    ErrorMessage(const char *text) : ErrorMessage(std::string{text == nullptr ? "" : text}) {
+    }
+
+    // coverity[autosar_cpp14_a12_1_4_violation] implicit so that errors can be made from formatted strings
+    ErrorMessage(std::string text) {
+        if (!text.empty()) {
+            _formatted = std::make_shared<const std::string>(std::move(text));
+            _text = _formatted->c_str();
+        }
+    }
+
+    const char *c_str() const {
+        return _text == nullptr ? "" : _text;
+    }
+
+    bool empty() const {
+        return (_text == nullptr) || (_text[0] == '\0');
+    }
+
+    std::string str() const {
+        return std::string{c_str()};
+    }
+
+    // coverity[autosar_cpp14_a13_5_2_violation] implicit so that messages can be passed on where strings were before
+    operator std::string() const {
+        return str();
+    }
+
+    size_t size() const {
+        return strlen(c_str());
+    }
+
+    /**
+     * Find text in the message like std::string::find, without copying the message.
+     */
+    size_t find(const char *text, const size_t pos = 0U) const {
+        const auto *const message = c_str();
+        if (pos > strlen(message)) {
+            return std::string::npos;
+        }
+        const auto *const found = strstr(message + pos, text);
+        return (found == nullptr) ? std::string::npos : static_cast<size_t>(found - message);
+    }
+
+    size_t find(const std::string &text, const size_t pos = 0U) const {
+        return find(text.c_str(), pos);
+    }
+
+    bool operator==(const char *other) const {
+        return strcmp(c_str(), other) == 0;
+    }
+
+    bool operator!=(const char *other) const {
+        return !(*this == other);
+    }
+
+    bool operator==(const std::string &other) const {
+        return *this == other.c_str();
+    }
+
+    bool operator!=(const std::string &other) const {
+        return !(*this == other);
+    }
+};
+
+inline std::string operator+(std::string lhs, const ErrorMessage &rhs) {
+    return lhs.append(rhs.c_str());
+}
+
+inline std::string operator+(const char *lhs, const ErrorMessage &rhs) {
+    return std::string{lhs}.append(rhs.c_str());
+}
+
+inline std::ostream &operator<<(std::ostream &os, const ErrorMessage &msg) {
+    return os << msg.c_str();
+}
+
 // coverity[misra_cpp_2008_rule_3_2_2_violation] false positive. Templates do not violate ODR
 template <class E> struct GenericError {
     E code;
-    std::string msg;
+    ErrorMessage msg;
 
     bool ok() const {
         return code == E::NoError;
@@ -0,0 +1,282 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <algorithm>
+#include <aws/store/common/expected.hpp>
+#include <aws/store/filesystem/filesystem.hpp>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace aws {
+namespace store {
+namespace filesystem {
+class CachedFileLike;
+
+/**
+ * A budget of open files which is shared by every CachingFileSystem given the same cache, for example all the streams
+ * of a process. Once more than max_open files are open, the least recently used ones are closed, and they are opened
+ * again the next time they are used. Files which are being used at that moment are skipped, so the budget can be
+ * exceeded for a short while when many files are busy at once.
+ */
+class FileHandleCache {
+  private:
+    friend class CachedFileLike;
+    friend class CachingFileSystem;
+
+    std::mutex _lock{};
+    size_t _max_open;
+    // Open files, most recently used first
+    std::list<CachedFileLike *> _open{};
+
+    // Mark the file as open and most recently used, closing the least recently used files if there are too many.
+    inline void used(CachedFileLike *f);
+    inline void closed(CachedFileLike *f);
+
+  public:
+    explicit FileHandleCache(const size_t max_open) : _max_open(std::max<size_t>(max_open, 1U)){};
+
+    size_t maxOpen() const noexcept {
+        return _max_open;
+    }
+
+    size_t openFiles() {
+        std::lock_guard lock{_lock};
+        return _open.size();
+    }
+};
+
+/**
+ * A file of a CachingFileSystem. The underlying file may be closed by the cache whenever it is not in use, after
+ * flushing it, and is opened again by its identifier when it is next used.
+ *
+ * The underlying file can go away at any time, so async() is never available through this file.
+ */
+class CachedFileLike : public FileLike {
+  private:
+    friend class FileHandleCache;
+
+    std::shared_ptr<FileSystemInterface> _fs;
+    std::shared_ptr<FileHandleCache> _cache;
+    std::string _identifier;
+    // Held shared by every operation on the underlying file, and exclusively to open or close it
+    std::shared_mutex _lock{};
+    std::unique_ptr<FileLike> _f;
+    // Every reopened file comes from the same file system, so this is known from the first one
+    bool _can_write_at;
+    // Guarded by the cache's lock
+    std::list<CachedFileLike *>::iterator _position{};
+    bool _listed{false};
+
+    // Called by the cache with its lock held, so this must not wait for the file
+    bool tryClose() {
+        std::unique_lock lock{_lock, std::try_to_lock};
+        if (!lock.owns_lock()) {
+            return false;
+        }
+        // Anything still buffered has to be written now, or an error writing it could not be reported
+        if (_f && !_f->flush().ok()) {
+            return false;
+        }
+        _f.reset();
+        return true;
+    }
+
+    // Hold the underlying file open for an operation, opening it again if the cache closed it
+    FileError acquire(std::shared_lock<std::shared_mutex> &lock) {
+        lock = std::shared_lock{_lock};
+        while (!_f) {
+            lock.unlock();
+            {
+                std::unique_lock exclusive{_lock};
+                if (!_f) {
+                    auto f_or = _fs->open(_identifier);
+                    if (!f_or.ok()) {
+                        return f_or.err();
+                    }
+                    _f = std::move(f_or.val());
+                }
+            }
+            lock.lock();
+        }
+        _cache->used(this);
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+  public:
+    CachedFileLike(std::shared_ptr<FileSystemInterface> fs, std::shared_ptr<FileHandleCache> cache,
+                   std::string identifier, std::unique_ptr<FileLike> f)
+        : _fs(std::move(fs)), _cache(std::move(cache)), _identifier(std::move(identifier)), _f(std::move(f)),
+          _can_write_at(_f->canWriteAt()){};
+    CachedFileLike(CachedFileLike &&) = delete;
+    CachedFileLike(CachedFileLike &) = delete;
+    CachedFileLike &operator=(CachedFileLike &) = delete;
+    CachedFileLike &operator=(CachedFileLike &&) = delete;
+
+    virtual ~CachedFileLike() override {
+        _cache->closed(this);
+    }
+
+    virtual common::Expected<common::OwnedSlice, FileError> read(const uint32_t begin, const uint32_t end) override {
+        std::shared_lock<std::shared_mutex> lock{};
+        auto e = acquire(lock);
+        if (!e.ok()) {
+            return e;
+        }
+        return _f->read(begin, end);
+    }
+
+    virtual FileError readInto(const uint32_t begin, void *out, const uint32_t length) override {
+        std::shared_lock<std::shared_mutex> lock{};
+        auto e = acquire(lock);
+        if (!e.ok()) {
+            return e;
+        }
+        return _f->readInto(begin, out, length);
+    }
+
+    virtual FileError append(const common::BorrowedSlice data) override {
+        std::shared_lock<std::shared_mutex> lock{};
+        auto e = acquire(lock);
+        if (!e.ok()) {
+            return e;
+        }
+        return _f->append(data);
+    }
+
+    virtual FileError appendv(const common::BorrowedSlice *parts, const size_t part_count) override {
+        std::shared_lock<std::shared_mutex> lock{};
+        auto e = acquire(lock);
+        if (!e.ok()) {
+            return e;
+        }
+        return _f->appendv(parts, part_count);
+    }
+
+    virtual FileError flush() override {
+        std::shared_lock lock{_lock};
+        // A closed file was flushed when it was closed
+        if (!_f) {
+            return FileError{FileErrorCode::NoError, {}};
+        }
+        return _f->flush();
+    }
+
+    virtual void sync() override {
+        // Closing a file does not sync it, so it is opened again to be synced
+        std::shared_lock<std::shared_mutex> lock{};
+        if (acquire(lock).ok()) {
+            _f->sync();
+        }
+    }
+
+    virtual FileError truncate(const uint32_t max) override {
+        std::shared_lock<std::shared_mutex> lock{};
+        auto e = acquire(lock);
+        if (!e.ok()) {
+            return e;
+        }
+        return _f->truncate(max);
+    }
+
+    virtual FileError writeAt(const uint32_t offset, const common::BorrowedSlice data) override {
+        std::shared_lock<std::shared_mutex> lock{};
+        auto e = acquire(lock);
+        if (!e.ok()) {
+            return e;
+        }
+        return _f->writeAt(offset, data);
+    }
+
+    virtual bool canWriteAt() const noexcept override {
+        return _can_write_at;
+    }
+
+    virtual void advise(const AccessHint hint, const uint32_t offset, const uint32_t length) override {
+        // Not worth opening a file for
+        std::shared_lock lock{_lock};
+        if (_f) {
+            _f->advise(hint, offset, length);
+        }
+    }
+};
+
+void FileHandleCache::used(CachedFileLike *f) {
+    std::lock_guard lock{_lock};
+    if (!f->_listed) {
+        _open.push_front(f);
+        f->_position = _open.begin();
+        f->_listed = true;
+    } else if (f->_position != _open.begin()) {
+        _open.splice(_open.begin(), _open, f->_position);
+    }
+
+    // f is at the front, so it is never closed here
+    auto victim = _open.end();
+    while ((_open.size() > _max_open) && (victim != _open.begin())) {
+        --victim;
+        if ((*victim)->tryClose()) {
+            (*victim)->_listed = false;
+            victim = _open.erase(victim);
+        }
+    }
+}
+
+void FileHandleCache::closed(CachedFileLike *f) {
+    std::lock_guard lock{_lock};
+    if (f->_listed) {
+        std::ignore = _open.erase(f->_position);
+        f->_listed = false;
+    }
+}
+
+/**
+ * Opens files through another file system, keeping no more of them open than the FileHandleCache allows. A stream with
+ * many small segments, or many streams sharing one cache, then stays within the process' file descriptor limit and
+ * does not hold a buffer for every file. Sealed segments are closed when they fall out of the cache and are only opened
+ * again when they are read.
+ *
+ * Files are opened again by their identifier, so a file must not be renamed while it is open.
+ */
+class CachingFileSystem : public FileSystemInterface {
+  private:
+    std::shared_ptr<FileSystemInterface> _fs;
+    std::shared_ptr<FileHandleCache> _cache;
+
+  public:
+    CachingFileSystem(std::shared_ptr<FileSystemInterface> fs, std::shared_ptr<FileHandleCache> cache)
+        : _fs(std::move(fs)), _cache(std::move(cache)){};
+
+    virtual common::Expected<std::unique_ptr<FileLike>, FileError> open(const std::string &identifier) override {
+        auto f_or = _fs->open(identifier);
+        if (!f_or.ok()) {
+            return f_or.err();
+        }
+        auto f = std::make_unique<CachedFileLike>(_fs, _cache, identifier, std::move(f_or.val()));
+        _cache->used(f.get());
+        return {std::move(f)};
+    }
+
+    virtual bool exists(const std::string &identifier) override {
+        return _fs->exists(identifier);
+    }
+
+    virtual FileError rename(const std::string &old_id, const std::string &new_id) override {
+        return _fs->rename(old_id, new_id);
+    }
+
+    virtual FileError remove(const std::string &id) override {
+        return _fs->remove(id);
+    }
+
+    virtual common::Expected<std::vector<std::string>, FileError> list() override {
+        return _fs->list();
+    }
+};
+} // namespace filesystem
+} // namespace store
+} // namespace aws
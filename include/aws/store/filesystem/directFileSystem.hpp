@@ -0,0 +1,518 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <algorithm>
+#include <aws/store/common/expected.hpp>
+#include <aws/store/filesystem/filesystem.hpp>
+#include <aws/store/filesystem/posixFileSystem.hpp>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+namespace aws {
+namespace store {
+namespace filesystem {
+// Offsets, lengths and buffer addresses used with O_DIRECT must be multiples of this. 4KB covers the logical block size
+// of common devices.
+constexpr uint32_t DIRECT_IO_ALIGNMENT = 4096U;
+
+namespace detail {
+struct AlignedFree {
+    void operator()(uint8_t *p) const noexcept {
+        std::free(p);
+    }
+};
+
+using AlignedBuffer = std::unique_ptr<uint8_t, AlignedFree>;
+
+static AlignedBuffer allocateAligned(const size_t size) {
+    void *p = nullptr;
+    if (posix_memalign(&p, DIRECT_IO_ALIGNMENT, size) != 0) {
+        return AlignedBuffer{};
+    }
+    return AlignedBuffer{static_cast<uint8_t *>(p)};
+}
+
+static constexpr uint64_t alignDownDirect(const uint64_t v) {
+    return v & ~(static_cast<uint64_t>(DIRECT_IO_ALIGNMENT) - 1U);
+}
+
+static constexpr uint64_t alignUpDirect(const uint64_t v) {
+    return alignDownDirect(v + DIRECT_IO_ALIGNMENT - 1U);
+}
+} // namespace detail
+
+/**
+ * Aligned blocks of block_size bytes which are shared by every file of a DirectFileSystem, so that opening and closing
+ * segments does not keep allocating. Up to max_pooled free blocks are kept for reuse.
+ */
+class AlignedBufferPool {
+  private:
+    std::mutex _lock{};
+    std::vector<detail::AlignedBuffer> _free{};
+    uint32_t _block_size;
+    size_t _max_pooled;
+
+  public:
+    AlignedBufferPool(const uint32_t block_size, const size_t max_pooled)
+        : _block_size(static_cast<uint32_t>(
+              std::max<uint64_t>(detail::alignUpDirect(block_size), static_cast<uint64_t>(DIRECT_IO_ALIGNMENT)))),
+          _max_pooled(max_pooled){};
+
+    uint32_t blockSize() const noexcept {
+        return _block_size;
+    }
+
+    /**
+     * A block from the pool, or a new one when the pool is empty. Empty when out of memory.
+     */
+    detail::AlignedBuffer acquire() {
+        {
+            std::lock_guard lock{_lock};
+            if (!_free.empty()) {
+                auto b = std::move(_free.back());
+                _free.pop_back();
+                return b;
+            }
+        }
+        return detail::allocateAligned(_block_size);
+    }
+
+    void release(detail::AlignedBuffer &&b) {
+        if (!b) {
+            return;
+        }
+        std::lock_guard lock{_lock};
+        if (_free.size() < _max_pooled) {
+            _free.push_back(std::move(b));
+        }
+    }
+};
+
+/**
+ * A file opened with O_DIRECT, so that its data bypasses the page cache.
+ *
+ * Appends are collected in an aligned tail block which is written out whole with direct I/O once it fills. Flushing a
+ * partially filled tail writes only its new bytes through a second, buffered descriptor, since direct writes would have
+ * to be padded and the file truncated back after each one. The tail stays in memory so that later appends keep filling
+ * it, so at most one partial block per file is ever in the page cache. Reads are served from the tail or from a small
+ * cache of blocks read from the file.
+ *
+ * File systems which do not support O_DIRECT, such as tmpfs, get the same behaviour through the page cache.
+ */
+class DirectFileLike : public FileLike {
+  private:
+    struct CachedBlock {
+        uint64_t offset;
+        // Bytes of the block which were in the file, before the tail, when it was read
+        uint32_t valid;
+        uint64_t last_used;
+        detail::AlignedBuffer data;
+    };
+
+    std::filesystem::path _path;
+    std::shared_ptr<AlignedBufferPool> _pool;
+    size_t _cache_blocks;
+    uint32_t _block_size;
+    int _f{-1};
+    int _tail_f{-1};
+    bool _direct{true};
+    std::mutex _lock{};
+    // The end of the file, from _tail_offset on. _tail_offset is aligned so that the tail can be written in place.
+    detail::AlignedBuffer _tail{};
+    uint64_t _tail_offset{0U};
+    uint32_t _tail_size{0U};
+    // Leading bytes of the tail which are already in the file
+    uint32_t _tail_written{0U};
+    // Size of the file on disk, which never exceeds _tail_offset + _tail_size
+    uint64_t _disk_size{0U};
+    std::vector<CachedBlock> _cache{};
+    uint64_t _clock{0U};
+
+    FileError preadFully(uint8_t *out, const uint64_t offset, const uint32_t length, uint32_t &got) const {
+        got = 0U;
+        while (got < length) {
+            const auto did_read = ::pread(_f, out + got, length - got, static_cast<off_t>(offset + got));
+            if (did_read < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errnoToFileError(errno);
+            }
+            if (did_read == 0) {
+                break;
+            }
+            got += static_cast<uint32_t>(did_read);
+            // Direct reads are only short at the end of the file, and continuing would no longer be aligned
+            if (_direct && (got < length)) {
+                break;
+            }
+        }
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    static FileError pwriteFully(const int fileno, const uint8_t *data, const uint64_t offset, const uint32_t length) {
+        uint32_t done = 0U;
+        while (done < length) {
+            const auto did_write = ::pwrite(fileno, data + done, length - done, static_cast<off_t>(offset + done));
+            if (did_write <= 0) {
+                if ((did_write < 0) && (errno == EINTR)) {
+                    continue;
+                }
+                return errnoToFileError(errno);
+            }
+            done += static_cast<uint32_t>(did_write);
+        }
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    FileError truncateFile(const uint64_t size) {
+        if (ftruncate(_f, static_cast<off_t>(size)) != 0) {
+            return errnoToFileError(errno);
+        }
+        _disk_size = size;
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    // Write out the bytes of the tail which are not in the file yet. Lock must be held.
+    FileError writeTail() {
+        if (_tail_written == _tail_size) {
+            return FileError{FileErrorCode::NoError, {}};
+        }
+        auto e = (_tail_size == _block_size)
+                     ? pwriteFully(_f, _tail.get(), _tail_offset, _block_size)
+                     : pwriteFully(_tail_f, _tail.get() + _tail_written, _tail_offset + _tail_written,
+                                   _tail_size - _tail_written);
+        if (!e.ok()) {
+            return e;
+        }
+        _tail_written = _tail_size;
+        _disk_size = std::max<uint64_t>(_disk_size, _tail_offset + _tail_size);
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    // Make the tail the partial block at the end of a file of the given size. Lock must be held.
+    FileError loadTail(const uint64_t size) {
+        _tail_offset = detail::alignDownDirect(size);
+        _tail_size = static_cast<uint32_t>(size - _tail_offset);
+        _tail_written = _tail_size;
+        if (_tail_size == 0U) {
+            return FileError{FileErrorCode::NoError, {}};
+        }
+        uint32_t got = 0U;
+        auto e = preadFully(_tail.get(), _tail_offset, DIRECT_IO_ALIGNMENT, got);
+        if (e.ok() && (got < _tail_size)) {
+            e = FileError{FileErrorCode::IOError, "File is shorter than expected"};
+        }
+        return e;
+    }
+
+    void invalidateCache() {
+        for (auto &block : _cache) {
+            block.valid = 0U;
+        }
+    }
+
+    // The cached block starting at offset which holds position, reading it from the file if needed. Lock must be held.
+    common::Expected<CachedBlock *, FileError> cachedBlock(const uint64_t offset, const uint64_t position) {
+        ++_clock;
+        CachedBlock *victim = nullptr;
+        for (auto &block : _cache) {
+            if ((block.offset == offset) && (position < (block.offset + block.valid))) {
+                block.last_used = _clock;
+                return &block;
+            }
+            if ((victim == nullptr) || (block.last_used < victim->last_used)) {
+                victim = &block;
+            }
+        }
+        if (_cache.size() < _cache_blocks) {
+            auto data = _pool->acquire();
+            if (!data) {
+                return FileError{FileErrorCode::Unknown, "Unable to allocate aligned memory"};
+            }
+            _cache.push_back(CachedBlock{0U, 0U, 0U, std::move(data)});
+            victim = &_cache.back();
+        }
+
+        uint32_t got = 0U;
+        victim->valid = 0U;
+        auto e = preadFully(victim->data.get(), offset, _block_size, got);
+        if (!e.ok()) {
+            return e;
+        }
+        victim->offset = offset;
+        victim->valid = static_cast<uint32_t>(std::min<uint64_t>(got, _tail_offset - offset));
+        victim->last_used = _clock;
+        return victim;
+    }
+
+    // Lock must be held
+    FileError appendLocked(const common::BorrowedSlice data) {
+        const auto *p = static_cast<const uint8_t *>(data.data());
+        uint32_t remaining = data.size();
+        while (remaining > 0U) {
+            const auto n = std::min(remaining, _block_size - _tail_size);
+            std::ignore = memcpy(_tail.get() + _tail_size, p, n);
+            _tail_size += n;
+            p += n;
+            remaining -= n;
+            if (_tail_size == _block_size) {
+                auto e = writeTail();
+                if (!e.ok()) {
+                    return e;
+                }
+                _tail_offset += _block_size;
+                _tail_size = 0U;
+                _tail_written = 0U;
+            }
+        }
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+  public:
+    DirectFileLike(std::filesystem::path &&path, std::shared_ptr<AlignedBufferPool> pool, const size_t cache_blocks)
+        : _path(std::move(path)), _pool(std::move(pool)), _cache_blocks(std::max<size_t>(cache_blocks, 1U)),
+          _block_size(_pool->blockSize()){};
+    DirectFileLike(DirectFileLike &&) = delete;
+    DirectFileLike(DirectFileLike &) = delete;
+    DirectFileLike &operator=(DirectFileLike &) = delete;
+    DirectFileLike &operator=(DirectFileLike &&) = delete;
+
+    virtual ~DirectFileLike() override {
+        if (_f >= 0) {
+            std::ignore = flush();
+            std::ignore = ::close(_f);
+        }
+        if (_tail_f >= 0) {
+            std::ignore = ::close(_tail_f);
+        }
+        _pool->release(std::move(_tail));
+        for (auto &block : _cache) {
+            _pool->release(std::move(block.data));
+        }
+    }
+
+    virtual FileError open() noexcept {
+        // open file or create with permissions 660
+        _f = ::open(_path.c_str(), O_RDWR | O_CREAT | O_DIRECT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+        if ((_f < 0) && (errno == EINVAL)) {
+            _direct = false;
+            _f = ::open(_path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+        }
+        if (_f < 0) {
+            return errnoToFileError(errno);
+        }
+        _tail_f = ::open(_path.c_str(), O_WRONLY);
+        if (_tail_f < 0) {
+            return errnoToFileError(errno);
+        }
+        const auto size = lseek(_f, 0, SEEK_END);
+        if (size < 0) {
+            return errnoToFileError(errno);
+        }
+        _disk_size = static_cast<uint64_t>(size);
+        _tail = _pool->acquire();
+        if (!_tail) {
+            return FileError{FileErrorCode::Unknown, "Unable to allocate aligned memory"};
+        }
+        return loadTail(_disk_size);
+    }
+
+    /**
+     * Whether the file bypasses the page cache.
+     */
+    bool usesDirectIO() const noexcept {
+        return _direct;
+    }
+
+    virtual common::Expected<common::OwnedSlice, FileError> read(const uint32_t begin, const uint32_t end) override {
+        if (end < begin) {
+            return FileError{FileErrorCode::InvalidArguments, "End must be after the beginning"};
+        }
+        if (end == begin) {
+            return common::OwnedSlice{0U};
+        }
+
+        auto d = common::OwnedSlice{(end - begin)};
+        auto e = readInto(begin, d.data(), d.size());
+        if (!e.ok()) {
+            return e;
+        }
+        return d;
+    }
+
+    virtual FileError readInto(const uint32_t begin, void *into, const uint32_t length) override {
+        const auto end = static_cast<uint64_t>(begin) + length;
+        std::lock_guard lock{_lock};
+        if (end > (_tail_offset + _tail_size)) {
+            return FileError{FileErrorCode::EndOfFile, {}};
+        }
+        auto *const out = static_cast<uint8_t *>(into);
+        uint64_t position = begin;
+        while (position < end) {
+            if (position >= _tail_offset) {
+                std::ignore = memcpy(out + (position - begin), _tail.get() + (position - _tail_offset),
+                                     static_cast<size_t>(end - position));
+                break;
+            }
+            const auto block_offset = position - (position % _block_size);
+            auto block_or = cachedBlock(block_offset, position);
+            if (!block_or.ok()) {
+                return block_or.err();
+            }
+            const auto *const block = block_or.val();
+            const auto block_end = std::min<uint64_t>(block_offset + block->valid, end);
+            if (block_end <= position) {
+                return FileError{FileErrorCode::IOError, "File is shorter than expected"};
+            }
+            std::ignore = memcpy(out + (position - begin), block->data.get() + (position - block_offset),
+                                 static_cast<size_t>(block_end - position));
+            position = block_end;
+        }
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    virtual FileError append(const common::BorrowedSlice data) override {
+        std::lock_guard lock{_lock};
+        return appendLocked(data);
+    }
+
+    virtual FileError appendv(const common::BorrowedSlice *parts, const size_t part_count) override {
+        std::lock_guard lock{_lock};
+        for (size_t i = 0U; i < part_count; i++) {
+            auto e = appendLocked(parts[i]);
+            if (!e.ok()) {
+                return e;
+            }
+        }
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    virtual FileError flush() override {
+        std::lock_guard lock{_lock};
+        return writeTail();
+    }
+
+    virtual void sync() override {
+        std::ignore = flush();
+        aws::store::filesystem::sync(_f);
+    }
+
+    virtual FileError truncate(const uint32_t max) override {
+        std::lock_guard lock{_lock};
+        invalidateCache();
+        const auto end = _tail_offset + _tail_size;
+        if ((max >= _tail_offset) && (max <= end)) {
+            _tail_size = static_cast<uint32_t>(max - _tail_offset);
+            _tail_written = std::min(_tail_written, _tail_size);
+            if (_disk_size > max) {
+                return truncateFile(max);
+            }
+            return FileError{FileErrorCode::NoError, {}};
+        }
+        if (max > end) {
+            auto e = writeTail();
+            if (!e.ok()) {
+                return e;
+            }
+        }
+        auto e = truncateFile(max);
+        if (!e.ok()) {
+            return e;
+        }
+        return loadTail(max);
+    }
+
+    virtual FileError writeAt(const uint32_t offset, const common::BorrowedSlice data) override {
+        std::lock_guard lock{_lock};
+        const auto write_end = static_cast<uint64_t>(offset) + data.size();
+        if (data.size() == 0U) {
+            return FileError{FileErrorCode::NoError, {}};
+        }
+        if (write_end > (_tail_offset + _tail_size)) {
+            return FileError{FileErrorCode::InvalidArguments, "Cannot write past the end of the file"};
+        }
+        invalidateCache();
+        const auto *const in = static_cast<const uint8_t *>(data.data());
+
+        // The part in the tail is written with it on the next flush
+        if (write_end > _tail_offset) {
+            const auto from = std::max<uint64_t>(offset, _tail_offset);
+            std::ignore = memcpy(_tail.get() + (from - _tail_offset), in + (from - offset),
+                                 static_cast<size_t>(write_end - from));
+            _tail_written = std::min(_tail_written, static_cast<uint32_t>(from - _tail_offset));
+        }
+        if (offset >= _tail_offset) {
+            return FileError{FileErrorCode::NoError, {}};
+        }
+
+        // The rest is already in the file, so read the aligned blocks around it, change them, and write them back
+        const auto aligned_begin = detail::alignDownDirect(offset);
+        const auto aligned_end = detail::alignUpDirect(std::min(write_end, _tail_offset));
+        const auto length = static_cast<uint32_t>(aligned_end - aligned_begin);
+        auto scratch = detail::allocateAligned(length);
+        if (!scratch) {
+            return FileError{FileErrorCode::Unknown, "Unable to allocate aligned memory"};
+        }
+        uint32_t got = 0U;
+        auto e = preadFully(scratch.get(), aligned_begin, length, got);
+        if (!e.ok()) {
+            return e;
+        }
+        if (got != length) {
+            return FileError{FileErrorCode::IOError, "File is shorter than expected"};
+        }
+        std::ignore = memcpy(scratch.get() + (offset - aligned_begin), in,
+                             static_cast<size_t>(std::min(write_end, _tail_offset) - offset));
+        return pwriteFully(_f, scratch.get(), aligned_begin, length);
+    }
+
+    virtual bool canWriteAt() const noexcept override {
+        return true;
+    }
+};
+
+/**
+ * Opens files as DirectFileLike. Files share a pool of aligned blocks of block_size bytes, which is rounded up to a
+ * multiple of DIRECT_IO_ALIGNMENT, and each file caches up to cache_blocks blocks for reads.
+ */
+class DirectFileSystem : public PosixFileSystem {
+  private:
+    std::shared_ptr<AlignedBufferPool> _pool;
+    size_t _cache_blocks;
+
+  public:
+    explicit DirectFileSystem(std::filesystem::path base_path, const uint32_t block_size = 64U * 1024U,
+                              const size_t cache_blocks = 4U, const size_t max_pooled_blocks = 64U)
+        : PosixFileSystem(std::move(base_path)),
+          _pool(std::make_shared<AlignedBufferPool>(block_size, max_pooled_blocks)), _cache_blocks(cache_blocks){};
+
+    virtual common::Expected<std::unique_ptr<FileLike>, FileError> open(const std::string &identifier) override {
+        if (!_initialized) {
+            std::error_code ec;
+            std::filesystem::create_directories(_base_path, ec);
+            if (ec) {
+                return errnoToFileError(ec.value(), ec.message());
+            }
+            _initialized = true;
+        }
+
+        auto f = std::make_unique<DirectFileLike>(_base_path / identifier, _pool, _cache_blocks);
+        auto res = f->open();
+        if (res.ok()) {
+            return {std::move(f)};
+        }
+        return res;
+    };
+};
+} // namespace filesystem
+} // namespace store
+} // namespace aws
@@ -7,6 +7,8 @@
 #include <aws/store/common/slices.hpp>
 #include <aws/store/common/util.hpp>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -27,18 +29,142 @@ enum class FileErrorCode : std::uint8_t {
 
 using FileError = common::GenericError<FileErrorCode>;
 
+// How a range of a file is about to be used
+enum class AccessHint : std::uint8_t {
+    // Read from start to end
+    Sequential,
+    // Read soon
+    WillNeed,
+    // Not read again
+    DontNeed,
+};
+
+/**
+ * Completion based I/O for files which can keep several operations in flight at once.
+ *
+ * Operations are queued by the *Async methods and submitted to the kernel together. Their callbacks run on the thread
+ * which calls poll() or waitAll() once the operation has completed, and must not call back into the same file. Any
+ * data passed in must stay valid until its callback has run.
+ */
+class AsyncFileLike {
+  public:
+    using Completion = std::function<void(const FileError &)>;
+    // Called with the number of bytes read, which is less than requested at the end of the file
+    using ReadCompletion = std::function<void(const common::Expected<uint32_t, FileError> &)>;
+
+    /**
+     * Append parts to the end of the file in order, followed by a data sync when sync is true. The operations are
+     * linked so that each one only starts once the previous one has succeeded. done receives the first error, if
+     * any, once they have all finished.
+     */
+    virtual FileError appendAsync(const common::BorrowedSlice *parts, const size_t part_count, const bool sync,
+                                  Completion done) = 0;
+
+    /**
+     * Read length bytes starting at begin into out.
+     */
+    virtual FileError readAsync(const uint32_t begin, uint8_t *out, const uint32_t length, ReadCompletion done) = 0;
+
+    /**
+     * Sync the file's data once every operation queued before it has completed.
+     */
+    virtual FileError syncAsync(Completion done) = 0;
+
+    /**
+     * Submit queued operations and run the callbacks of those which have completed, without waiting.
+     *
+     * @return the number of callbacks which ran.
+     */
+    virtual uint32_t poll() = 0;
+
+    /**
+     * Submit queued operations and wait for every operation to complete, running their callbacks.
+     */
+    virtual void waitAll() = 0;
+
+    AsyncFileLike() = default;
+    AsyncFileLike(AsyncFileLike &) = delete;
+    AsyncFileLike &operator=(AsyncFileLike &) = delete;
+    AsyncFileLike(AsyncFileLike &&) = default;
+    AsyncFileLike &operator=(AsyncFileLike &&) = default;
+    virtual ~AsyncFileLike() = default;
+};
+
 class FileLike {
   public:
     virtual store::common::Expected<common::OwnedSlice, FileError> read(uint32_t begin, uint32_t end) = 0;
 
+    /**
+     * Read length bytes starting at begin into out, which must have room for them. Returns EndOfFile if the file ends
+     * first. Implementations override this to read without allocating, which makes reading small headers cheap.
+     */
+    virtual FileError readInto(const uint32_t begin, void *out, const uint32_t length) {
+        if (length == 0U) {
+            return FileError{FileErrorCode::NoError, {}};
+        }
+        auto data_or = read(begin, begin + length);
+        if (!data_or.ok()) {
+            return data_or.err();
+        }
+        std::ignore = memcpy(out, data_or.val().data(), length);
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
     virtual FileError append(common::BorrowedSlice data) = 0;
 
+    /**
+     * Append several slices in order. Implementations which can write them with a single call override this, so that
+     * the slices land together even when other appenders share the file. On error, part of the data may have been
+     * written; truncate back to the previous size to remove it.
+     */
+    virtual FileError appendv(const common::BorrowedSlice *parts, size_t part_count) {
+        for (size_t i = 0U; i < part_count; i++) {
+            if (parts[i].size() == 0U) {
+                continue;
+            }
+            auto e = append(parts[i]);
+            if (!e.ok()) {
+                return e;
+            }
+        }
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
     virtual FileError flush() = 0;
 
     virtual void sync() = 0;
 
     virtual FileError truncate(uint32_t) = 0;
 
+    /**
+     * Overwrite bytes of the file in place, starting at the given offset, without moving the end of the file.
+     * Implementations which can only append return InvalidArguments, and say so through canWriteAt().
+     */
+    virtual FileError writeAt(uint32_t, common::BorrowedSlice) {
+        return FileError{FileErrorCode::InvalidArguments, "Writing in place is not supported"};
+    }
+
+    /**
+     * Whether writeAt() is supported, so that callers can pick another way of writing before they start.
+     */
+    virtual bool canWriteAt() const noexcept {
+        return false;
+    }
+
+    /**
+     * Tell the file how length bytes from offset are about to be used, so that it can manage any cache they pass
+     * through. A length of 0 reaches to the end of the file. This is only a hint, which is ignored by default.
+     */
+    virtual void advise(AccessHint, uint32_t, uint32_t) {
+    }
+
+    /**
+     * The completion based interface to this file, or nullptr when it only supports blocking I/O.
+     */
+    virtual AsyncFileLike *async() noexcept {
+        return nullptr;
+    }
+
     FileLike(FileLike &) = delete;
 
     FileLike &operator=(FileLike &) = delete;
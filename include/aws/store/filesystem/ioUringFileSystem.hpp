@@ -0,0 +1,702 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <algorithm>
+#include <aws/store/common/expected.hpp>
+#include <aws/store/filesystem/filesystem.hpp>
+#include <aws/store/filesystem/posixFileSystem.hpp>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define STORE_HAVE_IO_URING 1
+#endif
+
+namespace aws {
+namespace store {
+namespace filesystem {
+namespace detail {
+enum class IoOperation : std::uint8_t {
+    Read,
+    Write,
+    DataSync,
+};
+
+struct IoRequest {
+    IoOperation operation;
+    uint64_t offset;
+    void *buffer;
+    uint32_t length;
+    // Wait for every earlier request to complete before starting this one
+    bool drain;
+    // Called with the number of bytes transferred, or a negative errno
+    std::function<void(int32_t)> on_result;
+};
+
+// Run a request with blocking system calls, returning what io_uring would have returned
+static int32_t runBlocking(const int fileno, const IoRequest &r) {
+    auto *pointer = static_cast<uint8_t *>(r.buffer);
+    auto position = static_cast<off_t>(r.offset);
+    uint32_t done = 0U;
+    switch (r.operation) {
+    case IoOperation::DataSync:
+#if _POSIX_SYNCHRONIZED_IO > 0
+        return (fdatasync(fileno) == 0) ? 0 : -errno;
+#else
+        return (fsync(fileno) == 0) ? 0 : -errno;
+#endif
+    case IoOperation::Read:
+        while (done < r.length) {
+            const auto did_read = ::pread(fileno, pointer + done, r.length - done, position + done);
+            if (did_read < 0) {
+                return -errno;
+            }
+            if (did_read == 0) {
+                break;
+            }
+            done += static_cast<uint32_t>(did_read);
+        }
+        return static_cast<int32_t>(done);
+    case IoOperation::Write:
+        while (done < r.length) {
+            const auto did_write = ::pwrite(fileno, pointer + done, r.length - done, position + done);
+            if (did_write <= 0) {
+                return -errno;
+            }
+            done += static_cast<uint32_t>(did_write);
+        }
+        return static_cast<int32_t>(done);
+    }
+    return -EINVAL;
+}
+
+#if defined(STORE_HAVE_IO_URING)
+// A minimal io_uring submission and completion queue pair which uses the system calls directly, so that liburing is
+// not needed.
+class IoUring {
+  private:
+    int _fd{-1};
+    void *_sq_ring{MAP_FAILED};
+    size_t _sq_ring_size{0U};
+    void *_cq_ring{MAP_FAILED};
+    size_t _cq_ring_size{0U};
+    void *_sqes{MAP_FAILED};
+    size_t _sqes_size{0U};
+    unsigned *_sq_head{nullptr};
+    unsigned *_sq_tail{nullptr};
+    unsigned *_sq_mask{nullptr};
+    unsigned *_sq_array{nullptr};
+    unsigned *_cq_head{nullptr};
+    unsigned *_cq_tail{nullptr};
+    unsigned *_cq_mask{nullptr};
+    io_uring_cqe *_cqes{nullptr};
+    unsigned _entries{0U};
+    // Entries which have been filled in but not yet handed to the kernel
+    unsigned _local_tail{0U};
+
+  public:
+    IoUring() = default;
+    IoUring(IoUring &) = delete;
+    IoUring(IoUring &&) = delete;
+    IoUring &operator=(IoUring &) = delete;
+    IoUring &operator=(IoUring &&) = delete;
+
+    ~IoUring() {
+        close();
+    }
+
+    bool init(const unsigned entries) {
+        io_uring_params p{};
+        _fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+        if (_fd < 0) {
+            return false;
+        }
+        // Read and write operations arrived in the same kernel release as this feature
+        if ((p.features & IORING_FEAT_RW_CUR_POS) == 0U) {
+            close();
+            return false;
+        }
+
+        _sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        _cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const auto single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0U;
+        if (single_mmap) {
+            _sq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+            _cq_ring_size = _sq_ring_size;
+        }
+        _sq_ring = mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd,
+                        IORING_OFF_SQ_RING);
+        if (_sq_ring == MAP_FAILED) {
+            close();
+            return false;
+        }
+        _cq_ring = single_mmap ? _sq_ring
+                               : mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd,
+                                      IORING_OFF_CQ_RING);
+        if (_cq_ring == MAP_FAILED) {
+            close();
+            return false;
+        }
+        _sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+        _sqes = mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+        if (_sqes == MAP_FAILED) {
+            close();
+            return false;
+        }
+
+        auto *const sq = static_cast<uint8_t *>(_sq_ring);
+        auto *const cq = static_cast<uint8_t *>(_cq_ring);
+        _sq_head = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+        _sq_tail = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+        _sq_mask = reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+        _sq_array = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+        _cq_head = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+        _cq_tail = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+        _cq_mask = reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+        _cqes = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+        _entries = p.sq_entries;
+        _local_tail = *_sq_tail;
+        return true;
+    }
+
+    void close() {
+        if (_sqes != MAP_FAILED) {
+            std::ignore = munmap(_sqes, _sqes_size);
+            _sqes = MAP_FAILED;
+        }
+        if ((_cq_ring != MAP_FAILED) && (_cq_ring != _sq_ring)) {
+            std::ignore = munmap(_cq_ring, _cq_ring_size);
+        }
+        _cq_ring = MAP_FAILED;
+        if (_sq_ring != MAP_FAILED) {
+            std::ignore = munmap(_sq_ring, _sq_ring_size);
+            _sq_ring = MAP_FAILED;
+        }
+        if (_fd >= 0) {
+            std::ignore = ::close(_fd);
+            _fd = -1;
+        }
+        _entries = 0U;
+    }
+
+    unsigned entries() const {
+        return _entries;
+    }
+
+    // Free submission queue entries
+    unsigned space() const {
+        return _entries - (_local_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE));
+    }
+
+    // The next submission queue entry to fill in, which is submitted by the next call to submit()
+    io_uring_sqe *next() {
+        if (space() == 0U) {
+            return nullptr;
+        }
+        const auto index = _local_tail & *_sq_mask;
+        _sq_array[index] = index;
+        ++_local_tail;
+        auto *const sqe = static_cast<io_uring_sqe *>(_sqes) + index;
+        std::ignore = memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // Submit every filled in entry, and wait until at least wait_for completions are available
+    int submit(const unsigned wait_for) {
+        __atomic_store_n(_sq_tail, _local_tail, __ATOMIC_RELEASE);
+        while (true) {
+            const auto to_submit = _local_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+            if ((to_submit == 0U) && (wait_for == 0U)) {
+                return 0;
+            }
+            const auto flags = (wait_for > 0U) ? IORING_ENTER_GETEVENTS : 0U;
+            const auto ret = syscall(__NR_io_uring_enter, _fd, to_submit, wait_for, flags, nullptr, 0);
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -errno;
+            }
+            if ((_local_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE)) == 0U) {
+                return 0;
+            }
+        }
+    }
+
+    // Hand every available completion to on_completion(user_data, result)
+    template <typename F> unsigned reap(F &&on_completion) {
+        auto head = *_cq_head;
+        const auto tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+        unsigned count = 0U;
+        while (head != tail) {
+            const auto &cqe = _cqes[head & *_cq_mask];
+            on_completion(cqe.user_data, cqe.res);
+            ++head;
+            ++count;
+        }
+        __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+        return count;
+    }
+};
+#endif
+} // namespace detail
+
+/**
+ * A file which submits its reads, appends and data syncs through io_uring, and which also implements AsyncFileLike so
+ * that many operations can be in flight at once.
+ *
+ * Appends are written at explicit offsets from the end of the file as this object knows it, so asynchronous appends
+ * land in the order they were queued even when they complete out of order. If an append fails, truncate the file
+ * back to a known size before appending again.
+ *
+ * When io_uring is not available, because of an old kernel, a seccomp filter, or missing headers, every operation runs
+ * with blocking system calls instead and completions are still delivered through poll() and waitAll().
+ */
+class IoUringFileLike : public FileLike, public AsyncFileLike {
+  private:
+    std::filesystem::path _path;
+    int _f{-1};
+    uint32_t _end{0U};
+    std::mutex _lock{};
+    unsigned _queue_depth;
+#if defined(STORE_HAVE_IO_URING)
+    detail::IoUring _ring{};
+#endif
+    bool _use_ring{false};
+    uint64_t _next_id{1U};
+    std::unordered_map<uint64_t, std::function<void(int32_t)>> _in_flight{};
+    // User callbacks of completed operations, which run without holding the lock
+    std::vector<std::function<void()>> _ready{};
+
+    // State shared by the requests of one chain
+    struct Chain {
+        size_t remaining;
+        FileError error;
+    };
+
+    static FileError resultToError(const int32_t result, const uint32_t expected) {
+        if (result < 0) {
+            return errnoToFileError(-result);
+        }
+        if (static_cast<uint32_t>(result) != expected) {
+            return FileError{FileErrorCode::IOError, "Short write"};
+        }
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    // Queue the requests as one chain where each only starts once the previous one has succeeded. Lock must be held.
+    void queue(std::vector<detail::IoRequest> &requests) {
+#if defined(STORE_HAVE_IO_URING)
+        if (_use_ring && (requests.size() <= _ring.entries())) {
+            // Make room in both queues, so that completions can never overflow
+            while ((_ring.space() < requests.size()) || ((_in_flight.size() + requests.size()) > _queue_depth)) {
+                reap(1U);
+            }
+            for (size_t i = 0U; i < requests.size(); i++) {
+                auto &r = requests[i];
+                auto *const sqe = _ring.next();
+                switch (r.operation) {
+                case detail::IoOperation::Read:
+                    sqe->opcode = IORING_OP_READ;
+                    break;
+                case detail::IoOperation::Write:
+                    sqe->opcode = IORING_OP_WRITE;
+                    break;
+                case detail::IoOperation::DataSync:
+                    sqe->opcode = IORING_OP_FSYNC;
+                    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+                    break;
+                }
+                sqe->fd = _f;
+                sqe->off = r.offset;
+                sqe->addr = reinterpret_cast<uint64_t>(r.buffer);
+                sqe->len = r.length;
+                if (r.drain) {
+                    sqe->flags |= IOSQE_IO_DRAIN;
+                }
+                if ((i + 1U) < requests.size()) {
+                    sqe->flags |= IOSQE_IO_LINK;
+                }
+                sqe->user_data = _next_id;
+                _in_flight.emplace(_next_id, std::move(r.on_result));
+                ++_next_id;
+            }
+            return;
+        }
+#endif
+        // Without a ring, or for chains too long to link, run each request now. Everything queued earlier must be done
+        // first so that the order is kept.
+        while (!_in_flight.empty()) {
+            reap(1U);
+        }
+        bool failed = false;
+        for (auto &r : requests) {
+            if (failed) {
+                r.on_result(-ECANCELED);
+                continue;
+            }
+            const auto result = detail::runBlocking(_f, r);
+            failed = (result < 0) || ((r.operation == detail::IoOperation::Write) &&
+                                      (static_cast<uint32_t>(result) != r.length));
+            r.on_result(result);
+        }
+    }
+
+    // Submit queued requests, wait for at least wait_for completions, and hand the completions to their requests.
+    // Lock must be held.
+    void reap(const unsigned wait_for) {
+#if defined(STORE_HAVE_IO_URING)
+        if (!_use_ring) {
+            return;
+        }
+        const auto waiting = static_cast<unsigned>(std::min<size_t>(wait_for, _in_flight.size()));
+        const auto err = _ring.submit(waiting);
+        if ((err < 0) && (err != -EBUSY) && (err != -EAGAIN)) {
+            // The ring is unusable, so fail everything which is still in flight
+            for (auto &op : _in_flight) {
+                op.second(err);
+            }
+            _in_flight.clear();
+            return;
+        }
+        std::ignore = _ring.reap([this](const uint64_t id, const int32_t result) {
+            const auto op = _in_flight.find(id);
+            if (op != _in_flight.end()) {
+                auto on_result = std::move(op->second);
+                std::ignore = _in_flight.erase(op);
+                on_result(result);
+            }
+        });
+#else
+        static_cast<void>(wait_for);
+#endif
+    }
+
+    // Queue a chain of writes, optionally followed by a data sync, which calls on_done once with the first error
+    void queueAppend(const common::BorrowedSlice *parts, const size_t part_count, const bool sync,
+                     std::function<void(const FileError &)> on_done) {
+        auto chain = std::make_shared<Chain>();
+        chain->error = FileError{FileErrorCode::NoError, {}};
+        const auto finish = [chain, on_done](const FileError &e) {
+            // Cancellations only follow another failure in the chain, which is the more useful error to report
+            if (!e.ok() && (chain->error.ok() || (chain->error.code == FileErrorCode::Unknown))) {
+                chain->error = e;
+            }
+            --chain->remaining;
+            if (chain->remaining == 0U) {
+                on_done(chain->error);
+            }
+        };
+
+        std::vector<detail::IoRequest> requests{};
+        requests.reserve(part_count + 1U);
+        for (size_t i = 0U; i < part_count; i++) {
+            if (parts[i].size() == 0U) {
+                continue;
+            }
+            const auto length = parts[i].size();
+            requests.push_back(detail::IoRequest{detail::IoOperation::Write, _end,
+                                                 const_cast<void *>(parts[i].data()), length, sync && requests.empty(),
+                                                 [finish, length](const int32_t result) {
+                                                     finish(resultToError(result, length));
+                                                 }});
+            _end += length;
+        }
+        if (sync) {
+            requests.push_back(detail::IoRequest{detail::IoOperation::DataSync, 0U, nullptr, 0U, requests.empty(),
+                                                 [finish](const int32_t result) {
+                                                     finish(resultToError(result, 0U));
+                                                 }});
+        }
+        chain->remaining = requests.size();
+        if (requests.empty()) {
+            on_done(chain->error);
+            return;
+        }
+        queue(requests);
+    }
+
+    // Wait until done is set by a request's on_result. Lock must be held.
+    void waitUntil(const bool &done) {
+        while (!done) {
+            reap(1U);
+        }
+    }
+
+    std::vector<std::function<void()>> takeReady() {
+        std::vector<std::function<void()>> ready{};
+        ready.swap(_ready);
+        return ready;
+    }
+
+  public:
+    explicit IoUringFileLike(std::filesystem::path &&path, const unsigned queue_depth = 64U,
+                             const bool use_io_uring = true)
+        : _path(std::move(path)), _queue_depth(queue_depth), _use_ring(use_io_uring){};
+    IoUringFileLike(IoUringFileLike &&) = delete;
+    IoUringFileLike(IoUringFileLike &) = delete;
+    IoUringFileLike &operator=(IoUringFileLike &) = delete;
+    IoUringFileLike &operator=(IoUringFileLike &&) = delete;
+
+    virtual ~IoUringFileLike() override {
+        // The kernel may still be using buffers which belong to in flight operations
+        waitAll();
+        if (_f >= 0) {
+            std::ignore = ::close(_f);
+        }
+    }
+
+    virtual FileError open() noexcept {
+        // open file or create with permissions 660
+        _f = ::open(_path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+        if (_f < 0) {
+            return errnoToFileError(errno);
+        }
+        const auto end = lseek(_f, 0, SEEK_END);
+        if (end < 0) {
+            return errnoToFileError(errno);
+        }
+        _end = static_cast<uint32_t>(end);
+#if defined(STORE_HAVE_IO_URING)
+        _use_ring = _use_ring && _ring.init(_queue_depth);
+        if (_use_ring) {
+            _queue_depth = _ring.entries();
+        }
+#else
+        _use_ring = false;
+#endif
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    /**
+     * Whether operations go through io_uring, rather than blocking system calls.
+     */
+    bool usesIoUring() const noexcept {
+        return _use_ring;
+    }
+
+    virtual common::Expected<common::OwnedSlice, FileError> read(const uint32_t begin, const uint32_t end) override {
+        if (end < begin) {
+            return FileError{FileErrorCode::InvalidArguments, "End must be after the beginning"};
+        }
+        if (end == begin) {
+            return common::OwnedSlice{0U};
+        }
+
+        auto d = common::OwnedSlice{(end - begin)};
+        auto e = readInto(begin, d.data(), d.size());
+        if (!e.ok()) {
+            return e;
+        }
+        return d;
+    }
+
+    virtual FileError readInto(const uint32_t begin, void *out, const uint32_t length) override {
+        if (length == 0U) {
+            return FileError{FileErrorCode::NoError, {}};
+        }
+        int32_t result = 0;
+        bool done = false;
+        std::vector<detail::IoRequest> requests{};
+        requests.push_back(detail::IoRequest{detail::IoOperation::Read, begin, out, length, false,
+                                             [&result, &done](const int32_t r) {
+                                                 result = r;
+                                                 done = true;
+                                             }});
+        {
+            std::lock_guard lock{_lock};
+            queue(requests);
+            waitUntil(done);
+        }
+        if (result < 0) {
+            return errnoToFileError(-result);
+        }
+        if (static_cast<uint32_t>(result) != length) {
+            return FileError{FileErrorCode::EndOfFile, {}};
+        }
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    virtual FileError append(const common::BorrowedSlice data) override {
+        auto e = FileError{FileErrorCode::NoError, {}};
+        bool done = false;
+        std::lock_guard lock{_lock};
+        queueAppend(&data, 1U, false, [&e, &done](const FileError &err) {
+            e = err;
+            done = true;
+        });
+        waitUntil(done);
+        return e;
+    }
+
+    virtual FileError appendv(const common::BorrowedSlice *parts, const size_t part_count) override {
+        return appendAll(parts, part_count, false);
+    }
+
+    /**
+     * Append the parts with one submission and wait for them, followed by a data sync when sync is true.
+     */
+    FileError appendAll(const common::BorrowedSlice *parts, const size_t part_count, const bool sync) {
+        auto e = FileError{FileErrorCode::NoError, {}};
+        bool done = false;
+        std::lock_guard lock{_lock};
+        queueAppend(parts, part_count, sync, [&e, &done](const FileError &err) {
+            e = err;
+            done = true;
+        });
+        waitUntil(done);
+        return e;
+    }
+
+    virtual FileError flush() override {
+        // Writes are not buffered, but asynchronous appends which are still in flight must finish
+        waitAll();
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    virtual void sync() override {
+        std::ignore = appendAll(nullptr, 0U, true);
+    }
+
+    virtual FileError truncate(const uint32_t max) override {
+        std::lock_guard lock{_lock};
+        while (!_in_flight.empty()) {
+            reap(1U);
+        }
+        if (ftruncate(_f, static_cast<off_t>(max)) != 0) {
+            return errnoToFileError(errno);
+        }
+        _end = max;
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    virtual FileError writeAt(const uint32_t offset, const common::BorrowedSlice data) override {
+        auto e = FileError{FileErrorCode::NoError, {}};
+        bool done = false;
+        std::vector<detail::IoRequest> requests{};
+        const auto length = data.size();
+        requests.push_back(detail::IoRequest{detail::IoOperation::Write, offset, const_cast<void *>(data.data()),
+                                             length, false, [&e, &done, length](const int32_t result) {
+                                                 e = resultToError(result, length);
+                                                 done = true;
+                                             }});
+        std::lock_guard lock{_lock};
+        queue(requests);
+        waitUntil(done);
+        return e;
+    }
+
+    virtual bool canWriteAt() const noexcept override {
+        return true;
+    }
+
+    virtual void advise(const AccessHint hint, const uint32_t offset, const uint32_t length) override {
+        adviseFile(_f, hint, offset, length);
+    }
+
+    virtual AsyncFileLike *async() noexcept override {
+        return this;
+    }
+
+    virtual FileError appendAsync(const common::BorrowedSlice *parts, const size_t part_count, const bool sync,
+                                  Completion done) override {
+        std::lock_guard lock{_lock};
+        queueAppend(parts, part_count, sync, [this, done](const FileError &err) {
+            _ready.emplace_back([done, err]() { done(err); });
+        });
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    virtual FileError readAsync(const uint32_t begin, uint8_t *out, const uint32_t length,
+                                ReadCompletion done) override {
+        std::vector<detail::IoRequest> requests{};
+        requests.push_back(detail::IoRequest{
+            detail::IoOperation::Read, begin, out, length, false, [this, done](const int32_t result) {
+                const auto value = (result < 0) ? common::Expected<uint32_t, FileError>{errnoToFileError(-result)}
+                                                : common::Expected<uint32_t, FileError>{static_cast<uint32_t>(result)};
+                _ready.emplace_back([done, value]() { done(value); });
+            }});
+        std::lock_guard lock{_lock};
+        queue(requests);
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    virtual FileError syncAsync(Completion done) override {
+        return appendAsync(nullptr, 0U, true, std::move(done));
+    }
+
+    virtual uint32_t poll() override {
+        std::vector<std::function<void()>> ready{};
+        {
+            std::lock_guard lock{_lock};
+            reap(0U);
+            ready = takeReady();
+        }
+        for (const auto &callback : ready) {
+            callback();
+        }
+        return static_cast<uint32_t>(ready.size());
+    }
+
+    virtual void waitAll() override {
+        std::vector<std::function<void()>> ready{};
+        {
+            std::lock_guard lock{_lock};
+            while (!_in_flight.empty()) {
+                reap(1U);
+            }
+            ready = takeReady();
+        }
+        for (const auto &callback : ready) {
+            callback();
+        }
+    }
+};
+
+/**
+ * Opens files as IoUringFileLike. Each file has its own ring of queue_depth entries.
+ */
+class IoUringFileSystem : public PosixFileSystem {
+  private:
+    unsigned _queue_depth;
+    bool _use_io_uring;
+
+  public:
+    explicit IoUringFileSystem(std::filesystem::path base_path, const unsigned queue_depth = 64U,
+                               const bool use_io_uring = true)
+        : PosixFileSystem(std::move(base_path)), _queue_depth(queue_depth), _use_io_uring(use_io_uring){};
+
+    virtual common::Expected<std::unique_ptr<FileLike>, FileError> open(const std::string &identifier) override {
+        if (!_initialized) {
+            std::error_code ec;
+            std::filesystem::create_directories(_base_path, ec);
+            if (ec) {
+                return errnoToFileError(ec.value(), ec.message());
+            }
+            _initialized = true;
+        }
+
+        auto f = std::make_unique<IoUringFileLike>(_base_path / identifier, _queue_depth, _use_io_uring);
+        auto res = f->open();
+        if (res.ok()) {
+            return {std::move(f)};
+        }
+        return res;
+    };
+};
+} // namespace filesystem
+} // namespace store
+} // namespace aws
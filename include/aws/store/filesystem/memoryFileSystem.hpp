@@ -0,0 +1,378 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <aws/store/common/expected.hpp>
+#include <aws/store/filesystem/filesystem.hpp>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace aws {
+namespace store {
+namespace filesystem {
+namespace detail {
+// Memory used by every file of a MemoryFileSystem. Files can outlive their file system, so they share it.
+class MemoryBudget {
+  private:
+    std::atomic<uint64_t> _used{0U};
+    uint64_t _max;
+
+  public:
+    explicit MemoryBudget(const uint64_t max) : _max(max){};
+
+    bool reserve(const uint64_t bytes) {
+        auto used = _used.load(std::memory_order_relaxed);
+        do {
+            if ((used + bytes) > _max) {
+                return false;
+            }
+        } while (!_used.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed));
+        return true;
+    }
+
+    void release(const uint64_t bytes) {
+        std::ignore = _used.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    uint64_t used() const {
+        return _used.load(std::memory_order_relaxed);
+    }
+};
+
+struct MemoryChunk {
+    std::unique_ptr<uint8_t[]> data;
+    // Offset of the first byte of the chunk in the file
+    uint32_t offset;
+    uint32_t capacity;
+};
+
+/**
+ * The contents of a file, shared by every open handle to it. The file is made of chunks which never move once they are
+ * allocated, so appending only ever copies the new bytes. Chunks start small and double in size up to max_chunk_size,
+ * so that small files such as KV stores stay small.
+ */
+class MemoryFileData {
+  private:
+    // Smallest chunk allocated for a file
+    static constexpr uint32_t MIN_CHUNK_SIZE = 4096U;
+
+    std::shared_ptr<MemoryBudget> _budget;
+    uint32_t _max_chunk_size;
+    std::vector<MemoryChunk> _chunks{};
+    uint32_t _size{0U};
+    uint64_t _capacity{0U};
+
+    // Index of the chunk holding offset, which must be less than the capacity
+    size_t chunkAt(const uint32_t offset) const {
+        // Appends and reads of recent data are usually in the last chunk
+        if (offset >= _chunks.back().offset) {
+            return _chunks.size() - 1U;
+        }
+        const auto it = std::upper_bound(_chunks.begin(), _chunks.end(), offset,
+                                         [](const uint32_t o, const MemoryChunk &c) { return o < c.offset; });
+        return static_cast<size_t>(std::distance(_chunks.begin(), it)) - 1U;
+    }
+
+    void releaseChunksFrom(const size_t first) {
+        for (auto i = first; i < _chunks.size(); i++) {
+            _capacity -= _chunks[i].capacity;
+            _budget->release(_chunks[i].capacity);
+        }
+        _chunks.resize(first);
+    }
+
+    // Calls f with each piece of [begin, end) in turn. The range must be within the file.
+    template <typename F> void eachPiece(const uint32_t begin, const uint32_t end, F &&f) const {
+        if (begin >= end) {
+            return;
+        }
+        auto chunk = chunkAt(begin);
+        auto offset = begin;
+        while (offset < end) {
+            const auto &c = _chunks[chunk];
+            const auto length = std::min(end, c.offset + c.capacity) - offset;
+            f(c.data.get() + (offset - c.offset), length);
+            offset += length;
+            ++chunk;
+        }
+    }
+
+  public:
+    // Reads share this, and anything which changes the file holds it exclusively
+    mutable std::shared_mutex lock{};
+
+    MemoryFileData(std::shared_ptr<MemoryBudget> budget, const uint32_t max_chunk_size)
+        : _budget(std::move(budget)), _max_chunk_size(std::max(max_chunk_size, MIN_CHUNK_SIZE)){};
+    MemoryFileData(MemoryFileData &&) = delete;
+    MemoryFileData(MemoryFileData &) = delete;
+    MemoryFileData &operator=(MemoryFileData &) = delete;
+    MemoryFileData &operator=(MemoryFileData &&) = delete;
+
+    ~MemoryFileData() {
+        releaseChunksFrom(0U);
+    }
+
+    uint32_t size() const {
+        return _size;
+    }
+
+    // Lock must be held exclusively. Either all of the parts are appended, or none of them.
+    FileError append(const common::BorrowedSlice *parts, const size_t part_count) {
+        uint64_t total = 0U;
+        for (size_t i = 0U; i < part_count; i++) {
+            total += parts[i].size();
+        }
+        if ((_size + total) > UINT32_MAX) {
+            return FileError{FileErrorCode::InvalidArguments, "File is too large"};
+        }
+
+        const auto first_new_chunk = _chunks.size();
+        while (_capacity < (_size + total)) {
+            const auto capacity = _chunks.empty() ? uint64_t{MIN_CHUNK_SIZE} : uint64_t{_chunks.back().capacity} * 2U;
+            // A chunk cannot reach past the largest offset of a file
+            const auto length =
+                static_cast<uint32_t>(std::min({capacity, uint64_t{_max_chunk_size}, UINT32_MAX - _capacity}));
+            std::unique_ptr<uint8_t[]> data{};
+            if (_budget->reserve(length)) {
+                // coverity[autosar_cpp14_a20_8_5_violation] cannot construct arbitrary size with make_unique
+                // coverity[misra_cpp_2008_rule_18_4_1_violation] cannot construct arbitrary size with make_unique
+                data.reset(new (std::nothrow) uint8_t[length]);
+                if (!data) {
+                    _budget->release(length);
+                }
+            }
+            if (!data) {
+                releaseChunksFrom(first_new_chunk);
+                return FileError{FileErrorCode::DiskFull, "Memory limit reached"};
+            }
+            _chunks.push_back(MemoryChunk{std::move(data), static_cast<uint32_t>(_capacity), length});
+            _capacity += length;
+        }
+
+        for (size_t i = 0U; i < part_count; i++) {
+            if (parts[i].size() == 0U) {
+                continue;
+            }
+            const auto *in = static_cast<const uint8_t *>(parts[i].data());
+            eachPiece(_size, _size + parts[i].size(), [&in](uint8_t *piece, const uint32_t length) {
+                std::ignore = memcpy(piece, in, length);
+                in += length;
+            });
+            _size += parts[i].size();
+        }
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    // Lock must be held, at least shared
+    FileError copyOut(const uint32_t begin, const uint32_t end, uint8_t *out) const {
+        if (end > _size) {
+            return FileError{FileErrorCode::EndOfFile, {}};
+        }
+        eachPiece(begin, end, [&out](const uint8_t *piece, const uint32_t length) {
+            std::ignore = memcpy(out, piece, length);
+            out += length;
+        });
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    // Lock must be held, at least shared
+    template <typename F> FileError visit(const uint32_t begin, const uint32_t end, F &&f) const {
+        if (end > _size) {
+            return FileError{FileErrorCode::EndOfFile, {}};
+        }
+        eachPiece(begin, end,
+                  [&f](const uint8_t *piece, const uint32_t length) { f(common::BorrowedSlice{piece, length}); });
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    // Lock must be held exclusively
+    FileError overwrite(const uint32_t offset, const common::BorrowedSlice data) {
+        if ((static_cast<uint64_t>(offset) + data.size()) > _size) {
+            return FileError{FileErrorCode::InvalidArguments, "Cannot write past the end of the file"};
+        }
+        const auto *in = static_cast<const uint8_t *>(data.data());
+        eachPiece(offset, offset + data.size(), [&in](uint8_t *piece, const uint32_t length) {
+            std::ignore = memcpy(piece, in, length);
+            in += length;
+        });
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    // Lock must be held exclusively
+    void truncate(const uint32_t max) {
+        if (max >= _size) {
+            return;
+        }
+        _size = max;
+        // Keep the chunk which now holds the end of the file, and free everything after it
+        auto keep = _chunks.size();
+        while ((keep > 0U) && (_chunks[keep - 1U].offset >= max)) {
+            --keep;
+        }
+        releaseChunksFrom(keep);
+    }
+};
+} // namespace detail
+
+/**
+ * A file held in memory by a MemoryFileSystem. Handles opened for the same identifier share the same contents.
+ */
+class MemoryFileLike : public FileLike {
+  private:
+    std::shared_ptr<detail::MemoryFileData> _data;
+
+  public:
+    explicit MemoryFileLike(std::shared_ptr<detail::MemoryFileData> data) : _data(std::move(data)){};
+
+    virtual common::Expected<common::OwnedSlice, FileError> read(const uint32_t begin, const uint32_t end) override {
+        if (end < begin) {
+            return FileError{FileErrorCode::InvalidArguments, "End must be after the beginning"};
+        }
+        if (end == begin) {
+            return common::OwnedSlice{0U};
+        }
+        auto d = common::OwnedSlice{end - begin};
+        if (d.data() == nullptr) {
+            return FileError{FileErrorCode::Unknown, "Unable to allocate memory for the read"};
+        }
+        std::shared_lock lock{_data->lock};
+        auto e = _data->copyOut(begin, end, static_cast<uint8_t *>(d.data()));
+        if (!e.ok()) {
+            return e;
+        }
+        return d;
+    }
+
+    virtual FileError readInto(const uint32_t begin, void *out, const uint32_t length) override {
+        if ((static_cast<uint64_t>(begin) + length) > UINT32_MAX) {
+            return FileError{FileErrorCode::EndOfFile, {}};
+        }
+        std::shared_lock lock{_data->lock};
+        return _data->copyOut(begin, begin + length, static_cast<uint8_t *>(out));
+    }
+
+    /**
+     * Read without copying, by calling f with a BorrowedSlice of each piece of [begin, end) in order. The file cannot
+     * change while f runs, so f must not use this file.
+     */
+    template <typename F> FileError visit(const uint32_t begin, const uint32_t end, F &&f) {
+        if (end < begin) {
+            return FileError{FileErrorCode::InvalidArguments, "End must be after the beginning"};
+        }
+        std::shared_lock lock{_data->lock};
+        return _data->visit(begin, end, std::forward<F>(f));
+    }
+
+    virtual FileError append(const common::BorrowedSlice data) override {
+        std::lock_guard lock{_data->lock};
+        return _data->append(&data, 1U);
+    }
+
+    virtual FileError appendv(const common::BorrowedSlice *parts, const size_t part_count) override {
+        std::lock_guard lock{_data->lock};
+        return _data->append(parts, part_count);
+    }
+
+    virtual FileError flush() override {
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    virtual void sync() override {
+    }
+
+    virtual FileError truncate(const uint32_t max) override {
+        std::lock_guard lock{_data->lock};
+        _data->truncate(max);
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    virtual FileError writeAt(const uint32_t offset, const common::BorrowedSlice data) override {
+        std::lock_guard lock{_data->lock};
+        return _data->overwrite(offset, data);
+    }
+
+    virtual bool canWriteAt() const noexcept override {
+        return true;
+    }
+};
+
+/**
+ * Keeps files in memory instead of on disk, for data which does not need to survive the process, such as a buffer in
+ * front of a slower stream, and for measuring the cost of a stream without the cost of its storage.
+ *
+ * Files use at most max_bytes of memory between them. An append which would go beyond that fails with DiskFull, the
+ * same as a full disk. Files grow in chunks of up to max_chunk_size bytes. As on a POSIX file system, a file which is
+ * removed or renamed over stays readable through the handles which already have it open.
+ */
+class MemoryFileSystem : public FileSystemInterface {
+  private:
+    std::shared_ptr<detail::MemoryBudget> _budget;
+    uint32_t _max_chunk_size;
+    std::mutex _lock{};
+    std::map<std::string, std::shared_ptr<detail::MemoryFileData>> _files{};
+
+  public:
+    explicit MemoryFileSystem(const uint64_t max_bytes = UINT64_MAX, const uint32_t max_chunk_size = 1024U * 1024U)
+        : _budget(std::make_shared<detail::MemoryBudget>(max_bytes)), _max_chunk_size(max_chunk_size){};
+
+    /**
+     * Memory allocated for file contents, including the unused end of the last chunk of each file.
+     */
+    uint64_t usedBytes() const {
+        return _budget->used();
+    }
+
+    virtual common::Expected<std::unique_ptr<FileLike>, FileError> open(const std::string &identifier) override {
+        std::lock_guard lock{_lock};
+        auto &data = _files[identifier];
+        if (!data) {
+            data = std::make_shared<detail::MemoryFileData>(_budget, _max_chunk_size);
+        }
+        return {std::make_unique<MemoryFileLike>(data)};
+    }
+
+    virtual bool exists(const std::string &identifier) override {
+        std::lock_guard lock{_lock};
+        return _files.find(identifier) != _files.end();
+    }
+
+    virtual FileError rename(const std::string &old_id, const std::string &new_id) override {
+        std::lock_guard lock{_lock};
+        auto it = _files.find(old_id);
+        if (it == _files.end()) {
+            return FileError{FileErrorCode::FileDoesNotExist, old_id + " Path does not exist"};
+        }
+        if (old_id != new_id) {
+            _files[new_id] = std::move(it->second);
+            std::ignore = _files.erase(old_id);
+        }
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    virtual FileError remove(const std::string &id) override {
+        std::lock_guard lock{_lock};
+        std::ignore = _files.erase(id);
+        return FileError{FileErrorCode::NoError, {}};
+    }
+
+    virtual common::Expected<std::vector<std::string>, FileError> list() override {
+        std::lock_guard lock{_lock};
+        std::vector<std::string> output;
+        output.reserve(_files.size());
+        for (const auto &file : _files) {
+            output.push_back(file.first);
+        }
+        return output;
+    }
+};
+} // namespace filesystem
+} // namespace store
+} // namespace aws
@@ -2,12 +2,18 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #pragma once
+#include <algorithm>
+#include <atomic>
 #include <aws/store/common/expected.hpp>
 #include <aws/store/filesystem/filesystem.hpp>
+#include <climits>
+#include <cstring>
 #include <fcntl.h>
 #include <filesystem>
 #include <mutex>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <vector>
 
 namespace aws {
 namespace store {
@@ -51,13 +57,222 @@ static FileError errnoToFileError(const int err, const std::string &str = {}) {
     }
 }
 
+static FileError writeAllAt(const int fileno, const uint32_t offset, const common::BorrowedSlice data) {
+    const auto *write_pointer = static_cast<const uint8_t *>(data.data());
+    uint32_t write_remaining = data.size();
+    auto position = static_cast<off_t>(offset);
+
+    while (write_remaining > 0U) {
+        const auto did_write = ::pwrite(fileno, write_pointer, write_remaining, position);
+        if (did_write <= 0) {
+            return errnoToFileError(errno);
+        }
+
+        write_remaining -= static_cast<uint32_t>(did_write);
+        write_pointer += did_write;
+        position += did_write;
+    }
+    return FileError{FileErrorCode::NoError, {}};
+}
+
+static void adviseFile(const int fileno, const AccessHint hint, const uint32_t offset, const uint32_t length) {
+#if defined(POSIX_FADV_SEQUENTIAL)
+    int advice = POSIX_FADV_NORMAL;
+    switch (hint) {
+    case AccessHint::Sequential:
+        advice = POSIX_FADV_SEQUENTIAL;
+        break;
+    case AccessHint::WillNeed:
+        advice = POSIX_FADV_WILLNEED;
+        break;
+    case AccessHint::DontNeed:
+        advice = POSIX_FADV_DONTNEED;
+        break;
+    }
+    std::ignore = posix_fadvise(fileno, static_cast<off_t>(offset), static_cast<off_t>(length), advice);
+#else
+    static_cast<void>(fileno);
+    static_cast<void>(hint);
+    static_cast<void>(offset);
+    static_cast<void>(length);
+#endif
+}
+
+// The iovecs for one write. Appends are usually only a few parts, so they are kept on the stack unless there are more.
+class IovecList {
+    static constexpr size_t INLINE_COUNT = 8U;
+    iovec _inline[INLINE_COUNT]{};
+    std::vector<iovec> _heap{};
+    iovec *_data;
+    size_t _size{0U};
+
+  public:
+    explicit IovecList(const size_t capacity) : _data(_inline) {
+        if (capacity > INLINE_COUNT) {
+            _heap.resize(capacity);
+            _data = _heap.data();
+        }
+    }
+    IovecList(IovecList &&) = delete;
+    IovecList(const IovecList &) = delete;
+    IovecList &operator=(const IovecList &) = delete;
+    IovecList &operator=(IovecList &&) = delete;
+    ~IovecList() = default;
+
+    void add(const void *data, const size_t size) {
+        if (size > 0U) {
+            _data[_size++] = iovec{const_cast<void *>(data), size};
+        }
+    }
+
+    iovec *data() {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+};
+
+// Write every iovec in order with as few calls as possible. Adds the number of bytes written to written, which on error
+// says how much of the data made it into the file.
+static FileError writevAll(const int fileno, iovec *iov, const size_t iov_count, uint64_t &written) {
+    size_t next = 0U;
+    while (true) {
+        while ((next < iov_count) && (iov[next].iov_len == 0U)) {
+            ++next;
+        }
+        if (next == iov_count) {
+            break;
+        }
+        const auto count = static_cast<int>(std::min<size_t>(iov_count - next, IOV_MAX));
+        const auto did_write = ::writev(fileno, iov + next, count);
+        if (did_write <= 0) {
+            if ((did_write < 0) && (errno == EINTR)) {
+                continue;
+            }
+            return errnoToFileError(errno);
+        }
+        written += static_cast<uint64_t>(did_write);
+
+        // Skip what was written, which may end part way through an iovec
+        auto remaining = static_cast<size_t>(did_write);
+        while ((next < iov_count) && (remaining >= iov[next].iov_len)) {
+            remaining -= iov[next].iov_len;
+            ++next;
+        }
+        if (remaining > 0U) {
+            iov[next].iov_base = static_cast<uint8_t *>(iov[next].iov_base) + remaining;
+            iov[next].iov_len -= remaining;
+        }
+    }
+    return FileError{FileErrorCode::NoError, {}};
+}
+
+// Positional reads leave the file offset alone, so any number of threads can read the same descriptor at once without
+// locking, and without disturbing appends.
+static FileError readAllAt(const int fileno, const uint32_t begin, uint8_t *out, const uint32_t length) {
+    auto *read_pointer = out;
+    uint32_t read_remaining = length;
+    auto position = static_cast<off_t>(begin);
+
+    while (read_remaining > 0U) {
+        const auto did_read = ::pread(fileno, read_pointer, read_remaining, position);
+        if (did_read == 0) {
+            return FileError{FileErrorCode::EndOfFile, {}};
+        }
+        if (did_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errnoToFileError(errno);
+        }
+
+        read_remaining -= static_cast<uint32_t>(did_read);
+        read_pointer += did_read;
+        position += did_read;
+    }
+    return FileError{FileErrorCode::NoError, {}};
+}
+
+// Files are opened for appending, which makes pwrite append as well on Linux. Writing in place needs a second
+// descriptor which is opened the first time it is needed.
+static FileError openForWriteAt(const std::filesystem::path &path, int &fileno) {
+    if (fileno > 0) {
+        return FileError{FileErrorCode::NoError, {}};
+    }
+    fileno = ::open(path.c_str(), O_WRONLY);
+    if (fileno <= 0) {
+        fileno = 0;
+        return errnoToFileError(errno);
+    }
+    return FileError{FileErrorCode::NoError, {}};
+}
+
+/**
+ * Starts asynchronous writeback of appended data every interval bytes, so that dirty pages do not pile up until the
+ * next sync. The sync then only waits for the last few bytes, rather than stalling on everything since the previous
+ * one. An interval of 0 turns it off.
+ */
+class WritebackSmoother {
+    uint64_t _interval;
+    // Bytes appended since writeback was last started
+    std::atomic<uint64_t> _unstarted{0U};
+
+  public:
+    explicit WritebackSmoother(const uint32_t interval) : _interval(interval){};
+
+    void appended(const uint64_t bytes) {
+        if (_interval != 0U) {
+            std::ignore = _unstarted.fetch_add(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    bool due() const {
+        return (_interval != 0U) && (_unstarted.load(std::memory_order_relaxed) >= _interval);
+    }
+
+    // Start writing back everything appended since the last call, which ends at end
+    void start(const int fileno, const uint64_t end) {
+        const auto bytes = std::min(_unstarted.exchange(0U, std::memory_order_relaxed), end);
+#if defined(SYNC_FILE_RANGE_WRITE)
+        std::ignore = sync_file_range(fileno, static_cast<off_t>(end - bytes), static_cast<off_t>(bytes),
+                                      SYNC_FILE_RANGE_WRITE);
+#else
+        static_cast<void>(fileno);
+        static_cast<void>(bytes);
+#endif
+    }
+
+    // Everything has been synced or truncated away
+    void reset() {
+        _unstarted.store(0U, std::memory_order_relaxed);
+    }
+};
+
 class PosixFileLike : public FileLike {
-    std::mutex _read_lock{};
+    // Appends of several parts smaller than this go through the stdio buffer rather than straight to the file
+    static constexpr size_t BUFFERED_APPENDV_LIMIT = 4096U;
+    // Set by appends which may still be in the stdio buffer, so that reads flush them first
+    std::atomic<bool> _unflushed{false};
     std::filesystem::path _path;
     FILE *_f = nullptr;
+    int _write_at_f{0};
+    WritebackSmoother _writeback;
+
+    void startWritebackIfDue() {
+        if (_writeback.due()) {
+            // The descriptor is in append mode, so after a write its offset is the end of the file
+            const auto end = lseek(fileno(_f), 0, SEEK_CUR);
+            if (end >= 0) {
+                _writeback.start(fileno(_f), static_cast<uint64_t>(end));
+            }
+        }
+    }
 
   public:
-    explicit PosixFileLike(std::filesystem::path &&path) : _path(std::move(path)){};
+    explicit PosixFileLike(std::filesystem::path &&path, const uint32_t writeback_interval = 0U)
+        : _path(std::move(path)), _writeback(writeback_interval){};
     PosixFileLike(PosixFileLike &&) = delete;
     PosixFileLike(PosixFileLike &) = delete;
     PosixFileLike &operator=(PosixFileLike &) = delete;
@@ -67,6 +282,9 @@ class PosixFileLike : public FileLike {
         if (_f != nullptr) {
             std::ignore = std::fclose(_f);
         }
+        if (_write_at_f > 0) {
+            std::ignore = ::close(_write_at_f);
+        }
     }
 
     virtual FileError open() noexcept {
@@ -85,40 +303,93 @@ class PosixFileLike : public FileLike {
             return common::OwnedSlice{0U};
         }
 
-        std::lock_guard lock{_read_lock};
-        clearerr(_f);
         auto d = common::OwnedSlice{(end - begin)};
-        if (std::fseek(_f, static_cast<off_t>(begin), SEEK_SET) != 0) {
-            return errnoToFileError(errno);
-        }
-        if (std::fread(d.data(), d.size(), 1U, _f) != 1U) {
-            if (feof(_f) != 0) {
-                return {FileError{FileErrorCode::EndOfFile, {}}};
-            }
-            return errnoToFileError(errno);
+        auto e = readInto(begin, d.data(), d.size());
+        if (!e.ok()) {
+            return e;
         }
         return d;
     };
 
+    virtual FileError readInto(const uint32_t begin, void *out, const uint32_t length) override {
+        // Appends still in the stdio buffer are not in the file yet, so they have to be flushed to be read back.
+        // stdio locks the stream itself, so this is safe alongside the writer.
+        if (_unflushed.load(std::memory_order_acquire)) {
+            auto e = flush();
+            if (!e.ok()) {
+                return e;
+            }
+        }
+        return readAllAt(fileno(_f), begin, static_cast<uint8_t *>(out), length);
+    }
+
     virtual FileError append(const common::BorrowedSlice data) override {
         clearerr(_f);
         if (fwrite(data.data(), data.size(), 1U, _f) != 1U) {
             return errnoToFileError(errno);
         }
+        _unflushed.store(true, std::memory_order_release);
+        _writeback.appended(data.size());
         return {FileErrorCode::NoError, {}};
     };
 
+    virtual FileError appendv(const common::BorrowedSlice *parts, const size_t part_count) override {
+        size_t total = 0U;
+        for (size_t i = 0U; i < part_count; i++) {
+            total += parts[i].size();
+        }
+        // No other thread may append through stdio until all the parts are written
+        flockfile(_f);
+        if (total < BUFFERED_APPENDV_LIMIT) {
+            // Small parts are cheaper to copy into the stdio buffer than to flush it and make a system call
+            auto e = FileError{FileErrorCode::NoError, {}};
+            clearerr(_f);
+            for (size_t i = 0U; i < part_count; i++) {
+                if ((parts[i].size() > 0U) && (fwrite(parts[i].data(), parts[i].size(), 1U, _f) != 1U)) {
+                    e = errnoToFileError(errno);
+                    break;
+                }
+            }
+            _unflushed.store(true, std::memory_order_release);
+            _writeback.appended(total);
+            funlockfile(_f);
+            return e;
+        }
+
+        IovecList iov{part_count};
+        for (size_t i = 0U; i < part_count; i++) {
+            iov.add(parts[i].data(), parts[i].size());
+        }
+        // Anything in the stdio buffer must be written first
+        auto e = flush();
+        uint64_t written = 0U;
+        if (e.ok()) {
+            e = writevAll(fileno(_f), iov.data(), iov.size(), written);
+        }
+        _writeback.appended(written);
+        startWritebackIfDue();
+        funlockfile(_f);
+        return e;
+    }
+
     virtual FileError flush() override {
+        _unflushed.store(false, std::memory_order_release);
         if (fflush(_f) == 0) {
+            startWritebackIfDue();
             return FileError{FileErrorCode::NoError, {}};
         }
         return errnoToFileError(errno);
     }
 
     virtual void sync() override {
+        _writeback.reset();
         aws::store::filesystem::sync(fileno(_f));
     }
 
+    virtual void advise(const AccessHint hint, const uint32_t offset, const uint32_t length) override {
+        adviseFile(fileno(_f), hint, offset, length);
+    }
+
     virtual FileError truncate(const uint32_t max) override {
         // Flush buffers before truncating since truncation is operating on the FD directly rather than the file
         // stream
@@ -126,17 +397,79 @@ class PosixFileLike : public FileLike {
         if (ftruncate(fileno(_f), static_cast<off_t>(max)) != 0) {
             return errnoToFileError(errno);
         }
+        _writeback.reset();
         return flush();
     }
+
+    virtual FileError writeAt(const uint32_t offset, const common::BorrowedSlice data) override {
+        // Anything still buffered must reach the file first so that it cannot overwrite this write later
+        auto e = flush();
+        if (e.ok()) {
+            e = openForWriteAt(_path, _write_at_f);
+        }
+        if (!e.ok()) {
+            return e;
+        }
+        return writeAllAt(_write_at_f, offset, data);
+    }
+
+    virtual bool canWriteAt() const noexcept override {
+        return true;
+    }
 };
 
+/**
+ * A file written with write(2) directly rather than through stdio.
+ *
+ * When write_buffer_size is not 0, appends are collected in a buffer of that size and written together once it is
+ * full, or when the file is flushed, synced, truncated or written in place. Reads of bytes which are still in the
+ * buffer are served from it. Truncating back to the size before a failed append drops the unwritten bytes from the
+ * buffer, the same as it would remove them from the file.
+ */
 class PosixUnbufferedFileLike : public FileLike {
     int _f{0};
-    std::mutex _read_lock{};
+    int _write_at_f{0};
     std::filesystem::path _path;
+    uint32_t _write_buffer_size;
+    std::vector<uint8_t> _buffer{};
+    // Guards the buffer. Reads only take it when they reach past the bytes which are already in the file.
+    std::mutex _buffer_lock{};
+    std::atomic<uint64_t> _file_size{0U};
+    WritebackSmoother _writeback;
+
+    // Write the iovecs, counting what was written into the file size. Buffer lock must be held when buffering.
+    FileError writeOut(iovec *iov, const size_t iov_count) {
+        uint64_t written = 0U;
+        auto e = writevAll(_f, iov, iov_count, written);
+        const auto end = _file_size.fetch_add(written, std::memory_order_release) + written;
+        _writeback.appended(written);
+        if (_writeback.due()) {
+            _writeback.start(_f, end);
+        }
+        // Keep whatever of the buffer could not be written, so that it is either retried or truncated away
+        const auto from_buffer = static_cast<std::ptrdiff_t>(std::min<uint64_t>(written, _buffer.size()));
+        std::ignore = _buffer.erase(_buffer.begin(), _buffer.begin() + from_buffer);
+        return e;
+    }
+
+    // Buffer lock must be held
+    FileError flushBuffer() {
+        auto iov = iovec{_buffer.data(), _buffer.size()};
+        return writeOut(&iov, 1U);
+    }
+
+    // Buffer lock must be held
+    void bufferParts(const common::BorrowedSlice *parts, const size_t part_count) {
+        for (size_t i = 0U; i < part_count; i++) {
+            const auto *const p = static_cast<const uint8_t *>(parts[i].data());
+            std::ignore = _buffer.insert(_buffer.end(), p, p + parts[i].size());
+        }
+    }
 
   public:
-    explicit PosixUnbufferedFileLike(std::filesystem::path &&path) : _path(std::move(path)){};
+    explicit PosixUnbufferedFileLike(std::filesystem::path &&path, const uint32_t write_buffer_size = 0U,
+                                     const uint32_t writeback_interval = 0U)
+        : _path(std::move(path)), _write_buffer_size(write_buffer_size), _writeback(writeback_interval){};
     PosixUnbufferedFileLike(PosixUnbufferedFileLike &&) = delete;
     PosixUnbufferedFileLike(PosixUnbufferedFileLike &) = delete;
     PosixUnbufferedFileLike &operator=(PosixUnbufferedFileLike &) = delete;
@@ -144,8 +477,12 @@ class PosixUnbufferedFileLike : public FileLike {
 
     virtual ~PosixUnbufferedFileLike() override {
         if (_f > 0) {
+            std::ignore = flush();
             std::ignore = ::close(_f);
         }
+        if (_write_at_f > 0) {
+            std::ignore = ::close(_write_at_f);
+        }
     }
 
     virtual FileError open() noexcept {
@@ -154,6 +491,12 @@ class PosixUnbufferedFileLike : public FileLike {
         if (_f <= 0) {
             return errnoToFileError(errno);
         }
+        const auto size = lseek(_f, 0, SEEK_END);
+        if (size < 0) {
+            return errnoToFileError(errno);
+        }
+        _file_size.store(static_cast<uint64_t>(size), std::memory_order_release);
+        _buffer.reserve(_write_buffer_size);
         return FileError{FileErrorCode::NoError, {}};
     }
 
@@ -164,73 +507,155 @@ class PosixUnbufferedFileLike : public FileLike {
         if (end == begin) {
             return common::OwnedSlice{0U};
         }
-
-        std::lock_guard lock{_read_lock};
         auto d = common::OwnedSlice{(end - begin)};
-
-        if (lseek(_f, static_cast<off_t>(begin), SEEK_SET) < 0) {
-            return errnoToFileError(errno);
+        auto e = readInto(begin, d.data(), d.size());
+        if (!e.ok()) {
+            return e;
         }
+        return d;
+    };
 
-        auto *read_pointer = static_cast<uint8_t *>(d.data());
-        uint32_t read_remaining = d.size();
-
-        while (read_remaining > 0U) {
-            const auto did_read = ::read(_f, read_pointer, read_remaining);
+    virtual FileError readInto(const uint32_t begin, void *out, const uint32_t length) override {
+        auto *const bytes = static_cast<uint8_t *>(out);
+        const auto end = static_cast<uint64_t>(begin) + length;
+        if ((_write_buffer_size == 0U) || (end <= _file_size.load(std::memory_order_acquire))) {
+            return readAllAt(_f, begin, bytes, length);
+        }
 
-            if (did_read == 0) {
-                return {FileError{FileErrorCode::EndOfFile, {}}};
-            }
-            if (did_read < 0) {
-                return errnoToFileError(errno);
+        std::lock_guard lock{_buffer_lock};
+        const auto file_size = _file_size.load(std::memory_order_relaxed);
+        // The buffer may have been written out while waiting for the lock
+        if (end <= file_size) {
+            return readAllAt(_f, begin, bytes, length);
+        }
+        if (end > (file_size + _buffer.size())) {
+            return FileError{FileErrorCode::EndOfFile, {}};
+        }
+        uint32_t from_file = 0U;
+        if (begin < file_size) {
+            from_file = static_cast<uint32_t>(std::min<uint64_t>(length, file_size - begin));
+            auto e = readAllAt(_f, begin, bytes, from_file);
+            if (!e.ok()) {
+                return e;
             }
+        }
+        const auto buffer_offset = static_cast<size_t>(begin + from_file - file_size);
+        std::ignore = memcpy(bytes + from_file, _buffer.data() + buffer_offset, length - from_file);
+        return FileError{FileErrorCode::NoError, {}};
+    }
 
-            read_remaining -= static_cast<uint32_t>(did_read);
-            read_pointer += did_read;
+    virtual FileError append(const common::BorrowedSlice data) override {
+        if (_write_buffer_size == 0U) {
+            auto iov = iovec{const_cast<void *>(data.data()), data.size()};
+            return writeOut(&iov, 1U);
         }
-        return d;
+        return appendv(&data, 1U);
     };
 
-    virtual FileError append(const common::BorrowedSlice data) override {
-        const auto *write_pointer = static_cast<const uint8_t *>(data.data());
-        uint32_t write_remaining = data.size();
+    virtual FileError appendv(const common::BorrowedSlice *parts, const size_t part_count) override {
+        size_t total = 0U;
+        for (size_t i = 0U; i < part_count; i++) {
+            total += parts[i].size();
+        }
 
-        while (write_remaining > 0U) {
-            const auto did_write = ::write(_f, write_pointer, write_remaining);
-            if (did_write <= 0) {
-                return errnoToFileError(errno);
+        IovecList iov{part_count + 1U};
+        std::unique_lock<std::mutex> lock{_buffer_lock, std::defer_lock};
+        if (_write_buffer_size != 0U) {
+            lock.lock();
+            if (total < _write_buffer_size) {
+                if ((_buffer.size() + total) > _write_buffer_size) {
+                    auto e = flushBuffer();
+                    if (!e.ok()) {
+                        return e;
+                    }
+                }
+                bufferParts(parts, part_count);
+                return FileError{FileErrorCode::NoError, {}};
             }
-
-            write_remaining -= static_cast<uint32_t>(did_write);
-            write_pointer += did_write;
+            // Too big to be worth copying, so write the buffer and the parts together
+            iov.add(_buffer.data(), _buffer.size());
         }
-
-        return FileError{FileErrorCode::NoError, {}};
-    };
+        for (size_t i = 0U; i < part_count; i++) {
+            iov.add(parts[i].data(), parts[i].size());
+        }
+        return writeOut(iov.data(), iov.size());
+    }
 
     virtual FileError flush() override {
-        return FileError{FileErrorCode::NoError, {}};
+        if (_write_buffer_size == 0U) {
+            return FileError{FileErrorCode::NoError, {}};
+        }
+        std::lock_guard lock{_buffer_lock};
+        return flushBuffer();
     }
 
     virtual void sync() override {
+        std::ignore = flush();
+        _writeback.reset();
         aws::store::filesystem::sync(_f);
     }
 
+    virtual void advise(const AccessHint hint, const uint32_t offset, const uint32_t length) override {
+        adviseFile(_f, hint, offset, length);
+    }
+
     virtual FileError truncate(const uint32_t max) override {
+        std::lock_guard lock{_buffer_lock};
+        const auto file_size = _file_size.load(std::memory_order_relaxed);
+        if ((_write_buffer_size != 0U) && (max >= file_size) && (max <= (file_size + _buffer.size()))) {
+            // Only buffered bytes are removed
+            _buffer.resize(static_cast<size_t>(max - file_size));
+            return {FileErrorCode::NoError, {}};
+        }
+        if (max > file_size) {
+            auto e = flushBuffer();
+            if (!e.ok()) {
+                return e;
+            }
+        }
+        _buffer.clear();
         if (ftruncate(_f, static_cast<off_t>(max)) != 0) {
             return errnoToFileError(errno);
         }
+        _file_size.store(max, std::memory_order_release);
+        _writeback.reset();
         return {FileErrorCode::NoError, {}};
     }
+
+    virtual FileError writeAt(const uint32_t offset, const common::BorrowedSlice data) override {
+        std::lock_guard lock{_buffer_lock};
+        auto e = flushBuffer();
+        if (e.ok()) {
+            e = openForWriteAt(_path, _write_at_f);
+        }
+        if (e.ok()) {
+            e = writeAllAt(_write_at_f, offset, data);
+        }
+        if (e.ok() && ((offset + static_cast<uint64_t>(data.size())) > _file_size.load(std::memory_order_relaxed))) {
+            _file_size.store(offset + static_cast<uint64_t>(data.size()), std::memory_order_release);
+        }
+        return e;
+    }
+
+    virtual bool canWriteAt() const noexcept override {
+        return true;
+    }
 };
 
+/**
+ * Opens files as PosixFileLike. A writeback_interval which is not 0 starts writing back appended data every that many
+ * bytes, which keeps syncs short on slow storage such as SD cards and eMMC.
+ */
 class PosixFileSystem : public FileSystemInterface {
   protected:
-    bool _initialized{false};
+    // Files may be opened from several threads, for example by CachingFileSystem reopening them
+    std::atomic<bool> _initialized{false};
     std::filesystem::path _base_path;
+    uint32_t _writeback_interval;
 
   public:
-    explicit PosixFileSystem(std::filesystem::path base_path) : _base_path(std::move(base_path)){};
+    explicit PosixFileSystem(std::filesystem::path base_path, const uint32_t writeback_interval = 0U)
+        : _base_path(std::move(base_path)), _writeback_interval(writeback_interval){};
 
     virtual common::Expected<std::unique_ptr<FileLike>, FileError> open(const std::string &identifier) override {
         if (!_initialized) {
@@ -242,7 +667,7 @@ class PosixFileSystem : public FileSystemInterface {
             _initialized = true;
         }
 
-        auto f = std::make_unique<PosixFileLike>(_base_path / identifier);
+        auto f = std::make_unique<PosixFileLike>(_base_path / identifier, _writeback_interval);
         auto res = f->open();
         if (res.ok()) {
             return {std::move(f)};
@@ -281,9 +706,17 @@ class PosixFileSystem : public FileSystemInterface {
     };
 };
 
+/**
+ * Opens files as PosixUnbufferedFileLike. A write_buffer_size which is not 0 lets each file collect that many bytes of
+ * appends before writing them. writeback_interval is the same as for PosixFileSystem.
+ */
 class PosixUnbufferedFileSystem : public PosixFileSystem {
+    uint32_t _write_buffer_size;
+
   public:
-    explicit PosixUnbufferedFileSystem(std::filesystem::path base_path) : PosixFileSystem(std::move(base_path)){};
+    explicit PosixUnbufferedFileSystem(std::filesystem::path base_path, const uint32_t write_buffer_size = 0U,
+                                       const uint32_t writeback_interval = 0U)
+        : PosixFileSystem(std::move(base_path), writeback_interval), _write_buffer_size(write_buffer_size){};
 
     virtual common::Expected<std::unique_ptr<FileLike>, FileError> open(const std::string &identifier) override {
         if (!_initialized) {
@@ -295,7 +728,8 @@ class PosixUnbufferedFileSystem : public PosixFileSystem {
             _initialized = true;
         }
 
-        auto f = std::make_unique<PosixUnbufferedFileLike>(_base_path / identifier);
+        auto f = std::make_unique<PosixUnbufferedFileLike>(_base_path / identifier, _write_buffer_size,
+                                                           _writeback_interval);
         auto res = f->open();
         if (res.ok()) {
             return {std::move(f)};
@@ -0,0 +1,279 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <aws/store/common/expected.hpp>
+#include <aws/store/filesystem/filesystem.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aws {
+namespace store {
+namespace filesystem {
+/**
+ * How long an operation takes: base, plus a uniformly distributed extra of up to jitter, plus a stall of stall with
+ * probability stall_probability.
+ */
+struct LatencyDistribution {
+    std::chrono::microseconds base{0};
+    std::chrono::microseconds jitter{0};
+    double stall_probability{0.0};
+    std::chrono::microseconds stall{0};
+};
+
+struct ShapingOptions {
+    LatencyDistribution open{};
+    LatencyDistribution read{};
+    // Appends and writes in place
+    LatencyDistribution write{};
+    LatencyDistribution flush{};
+    // Use stalls here to model a device which occasionally takes much longer to sync
+    LatencyDistribution sync{};
+    // Truncation, and exists, rename, remove and list on the file system
+    LatencyDistribution metadata{};
+    // Reads and writes each share one device which moves this many bytes per second. 0 is unlimited.
+    uint64_t read_bytes_per_second{0U};
+    uint64_t write_bytes_per_second{0U};
+    // Appends fail with DiskFull once this many bytes have been appended in total
+    uint64_t write_budget_bytes{UINT64_MAX};
+    // Latencies are drawn from a generator with this seed, so that the same operations see the same latencies
+    uint32_t seed{1U};
+    // Called with each delay instead of sleeping for it, for example to add up the delays without waiting for them
+    std::function<void(std::chrono::nanoseconds)> delay{};
+};
+
+namespace detail {
+// Shared by a ShapingFileSystem and all of its files
+class Shaper {
+  private:
+    ShapingOptions _opts;
+    std::mutex _lock{};
+    std::minstd_rand _rand;
+    std::chrono::steady_clock::time_point _read_busy_until{};
+    std::chrono::steady_clock::time_point _write_busy_until{};
+    std::atomic<uint64_t> _appended{0U};
+    std::atomic<bool> _disk_full{false};
+    std::atomic<int64_t> _delayed_ns{0};
+
+    // Lock must be held
+    std::chrono::nanoseconds sample(const LatencyDistribution &d) {
+        std::chrono::nanoseconds t = d.base;
+        if (d.jitter.count() > 0) {
+            const auto extra = _rand() % (static_cast<uint64_t>(d.jitter.count()) + 1U);
+            t += std::chrono::microseconds{static_cast<int64_t>(extra)};
+        }
+        if ((d.stall_probability > 0.0) &&
+            (static_cast<double>(_rand() - std::minstd_rand::min()) <
+             d.stall_probability * static_cast<double>(std::minstd_rand::max() - std::minstd_rand::min()))) {
+            t += d.stall;
+        }
+        return t;
+    }
+
+    // Lock must be held. The time until a device moving bytes_per_second can finish moving bytes more.
+    static std::chrono::nanoseconds transfer(std::chrono::steady_clock::time_point &busy_until, const uint64_t bytes,
+                                             const uint64_t bytes_per_second) {
+        if ((bytes_per_second == 0U) || (bytes == 0U)) {
+            return std::chrono::nanoseconds{0};
+        }
+        const auto now = std::chrono::steady_clock::now();
+        const auto seconds = static_cast<double>(bytes) / static_cast<double>(bytes_per_second);
+        busy_until = std::max(busy_until, now) + std::chrono::nanoseconds{static_cast<int64_t>(seconds * 1e9)};
+        return busy_until - now;
+    }
+
+  public:
+    explicit Shaper(ShapingOptions &&opts) : _opts(std::move(opts)), _rand(_opts.seed){};
+
+    const ShapingOptions &options() const {
+        return _opts;
+    }
+
+    // Wait as long as the operation would take on the modelled device
+    void wait(const LatencyDistribution &latency, const uint64_t read_bytes, const uint64_t write_bytes) {
+        std::chrono::nanoseconds t{};
+        {
+            std::lock_guard lock{_lock};
+            t = sample(latency) + transfer(_read_busy_until, read_bytes, _opts.read_bytes_per_second) +
+                transfer(_write_busy_until, write_bytes, _opts.write_bytes_per_second);
+        }
+        if (t.count() <= 0) {
+            return;
+        }
+        std::ignore = _delayed_ns.fetch_add(t.count(), std::memory_order_relaxed);
+        if (_opts.delay) {
+            _opts.delay(t);
+        } else {
+            std::this_thread::sleep_for(t);
+        }
+    }
+
+    // False when the device is out of space
+    bool reserve(const uint64_t bytes) {
+        if (_disk_full.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        auto appended = _appended.load(std::memory_order_relaxed);
+        do {
+            if ((appended + bytes) > _opts.write_budget_bytes) {
+                return false;
+            }
+        } while (!_appended.compare_exchange_weak(appended, appended + bytes, std::memory_order_relaxed));
+        return true;
+    }
+
+    void setDiskFull(const bool full) {
+        _disk_full.store(full, std::memory_order_relaxed);
+    }
+
+    std::chrono::nanoseconds delayed() const {
+        return std::chrono::nanoseconds{_delayed_ns.load(std::memory_order_relaxed)};
+    }
+};
+} // namespace detail
+
+/**
+ * A file of a ShapingFileSystem, which waits before each operation as the modelled device would.
+ */
+class ShapedFileLike : public FileLike {
+  private:
+    std::unique_ptr<FileLike> _f;
+    std::shared_ptr<detail::Shaper> _shaper;
+
+    FileError appendShaped(const common::BorrowedSlice *parts, const size_t part_count) {
+        uint64_t total = 0U;
+        for (size_t i = 0U; i < part_count; i++) {
+            total += parts[i].size();
+        }
+        if (!_shaper->reserve(total)) {
+            return FileError{FileErrorCode::DiskFull, "Disk full"};
+        }
+        _shaper->wait(_shaper->options().write, 0U, total);
+        // Single appends keep going to append(), which some files implement differently from appendv()
+        if (part_count == 1U) {
+            return _f->append(parts[0]);
+        }
+        return _f->appendv(parts, part_count);
+    }
+
+  public:
+    ShapedFileLike(std::unique_ptr<FileLike> f, std::shared_ptr<detail::Shaper> shaper)
+        : _f(std::move(f)), _shaper(std::move(shaper)){};
+
+    virtual common::Expected<common::OwnedSlice, FileError> read(const uint32_t begin, const uint32_t end) override {
+        _shaper->wait(_shaper->options().read, end > begin ? end - begin : 0U, 0U);
+        return _f->read(begin, end);
+    }
+
+    virtual FileError readInto(const uint32_t begin, void *out, const uint32_t length) override {
+        _shaper->wait(_shaper->options().read, length, 0U);
+        return _f->readInto(begin, out, length);
+    }
+
+    virtual FileError append(const common::BorrowedSlice data) override {
+        return appendShaped(&data, 1U);
+    }
+
+    virtual FileError appendv(const common::BorrowedSlice *parts, const size_t part_count) override {
+        return appendShaped(parts, part_count);
+    }
+
+    virtual FileError flush() override {
+        _shaper->wait(_shaper->options().flush, 0U, 0U);
+        return _f->flush();
+    }
+
+    virtual void sync() override {
+        _shaper->wait(_shaper->options().sync, 0U, 0U);
+        _f->sync();
+    }
+
+    virtual FileError truncate(const uint32_t max) override {
+        _shaper->wait(_shaper->options().metadata, 0U, 0U);
+        return _f->truncate(max);
+    }
+
+    virtual FileError writeAt(const uint32_t offset, const common::BorrowedSlice data) override {
+        _shaper->wait(_shaper->options().write, 0U, data.size());
+        return _f->writeAt(offset, data);
+    }
+
+    virtual bool canWriteAt() const noexcept override {
+        return _f->canWriteAt();
+    }
+
+    virtual void advise(const AccessHint hint, const uint32_t offset, const uint32_t length) override {
+        _f->advise(hint, offset, length);
+    }
+};
+
+/**
+ * Wraps another file system to behave like slower storage, such as an SD card or eMMC, so that benchmarks on a fast
+ * disk can show how batching, syncing and caching change latency on the devices we actually run on. Each operation
+ * first waits for a latency drawn from its LatencyDistribution, and reads and writes also wait for their bytes to move
+ * at the configured rate. Appends fail with DiskFull once the write budget is used up, or while setDiskFull(true) is
+ * in effect.
+ *
+ * Files are only ever used through their blocking interface, so async() is not available.
+ */
+class ShapingFileSystem : public FileSystemInterface {
+  private:
+    std::shared_ptr<FileSystemInterface> _fs;
+    std::shared_ptr<detail::Shaper> _shaper;
+
+  public:
+    ShapingFileSystem(std::shared_ptr<FileSystemInterface> fs, ShapingOptions opts)
+        : _fs(std::move(fs)), _shaper(std::make_shared<detail::Shaper>(std::move(opts))){};
+
+    void setDiskFull(const bool full) {
+        _shaper->setDiskFull(full);
+    }
+
+    /**
+     * Total delay added to operations so far.
+     */
+    std::chrono::nanoseconds delayed() const {
+        return _shaper->delayed();
+    }
+
+    virtual common::Expected<std::unique_ptr<FileLike>, FileError> open(const std::string &identifier) override {
+        _shaper->wait(_shaper->options().open, 0U, 0U);
+        auto f_or = _fs->open(identifier);
+        if (!f_or.ok()) {
+            return f_or.err();
+        }
+        return {std::make_unique<ShapedFileLike>(std::move(f_or.val()), _shaper)};
+    }
+
+    virtual bool exists(const std::string &identifier) override {
+        _shaper->wait(_shaper->options().metadata, 0U, 0U);
+        return _fs->exists(identifier);
+    }
+
+    virtual FileError rename(const std::string &old_id, const std::string &new_id) override {
+        _shaper->wait(_shaper->options().metadata, 0U, 0U);
+        return _fs->rename(old_id, new_id);
+    }
+
+    virtual FileError remove(const std::string &id) override {
+        _shaper->wait(_shaper->options().metadata, 0U, 0U);
+        return _fs->remove(id);
+    }
+
+    virtual common::Expected<std::vector<std::string>, FileError> list() override {
+        _shaper->wait(_shaper->options().metadata, 0U, 0U);
+        return _fs->list();
+    }
+};
+} // namespace filesystem
+} // namespace store
+} // namespace aws
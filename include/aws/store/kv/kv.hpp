@@ -5,6 +5,7 @@
 
 #include <aws/store/common/expected.hpp>
 #include <aws/store/common/logging.hpp>
+#include <aws/store/common/metrics.hpp>
 #include <aws/store/common/slices.hpp>
 #include <aws/store/common/util.hpp>
 #include <aws/store/filesystem/filesystem.hpp>
@@ -37,6 +38,19 @@ struct KVHeader {
 };
 #pragma pack(pop)
 
+struct KVCounters {
+    common::Counter puts{};
+    common::Counter put_bytes{};
+    common::Counter gets{};
+    common::Counter removes{};
+    common::Counter syncs{};
+    common::Counter compactions{};
+    common::Counter corruption_truncations{};
+    common::Histogram put_latency{};
+    common::Histogram get_latency{};
+    common::Histogram sync_latency{};
+    common::Histogram compaction_latency{};
+};
 } // namespace detail
 
 enum class KVErrorCodes : std::uint8_t {
@@ -63,6 +77,26 @@ struct KVOptions {
     int32_t compact_after;
 };
 
+/**
+ * What a KV has done since it was opened. Latencies are in nanoseconds and include waiting for other operations on the
+ * same KV.
+ */
+struct KVMetrics {
+    uint64_t puts;
+    uint64_t put_bytes;
+    uint64_t gets;
+    uint64_t removes;
+    // Syncs of the file, which only compaction does
+    uint64_t syncs;
+    uint64_t compactions;
+    // Times that a corrupted entry was cut off the end of the file when opening it
+    uint64_t corruption_truncations;
+    common::HistogramSnapshot put_latency;
+    common::HistogramSnapshot get_latency;
+    common::HistogramSnapshot sync_latency;
+    common::HistogramSnapshot compaction_latency;
+};
+
 class __attribute__((visibility("default"))) KV {
   private:
     KVOptions _opts;
@@ -72,6 +106,8 @@ class __attribute__((visibility("default"))) KV {
     std::uint32_t _byte_position{0U};
     std::uint32_t _added_bytes{0U};
     mutable std::mutex _lock{};
+    // Updated without holding the lock
+    mutable detail::KVCounters _counters{};
 
     store::common::Expected<detail::KVHeader, KVError> readHeaderFrom(const uint32_t) const noexcept;
 
@@ -104,10 +140,10 @@ class __attribute__((visibility("default"))) KV {
     inline void addOrRemoveKeyInInitialization(const std::string &key, const uint32_t beginning_pointer,
                                                const uint32_t added_size, const uint8_t flags) noexcept;
 
-    inline KVError writeEntry(const std::string &key, const common::BorrowedSlice data,
-                              const uint8_t flags) const noexcept;
+    inline KVError writeEntry(const std::string &key, const common::BorrowedSlice *parts, const size_t part_count,
+                              const uint32_t value_len, const uint8_t flags) const noexcept;
 
-    filesystem::FileError appendMultiple(const std::initializer_list<common::BorrowedSlice> args) const noexcept;
+    filesystem::FileError appendMultiple(const common::BorrowedSlice *slices, const size_t slice_count) const noexcept;
 
     KVError maybeCompact() noexcept;
 
@@ -118,6 +154,17 @@ class __attribute__((visibility("default"))) KV {
 
     KVError put(const std::string &, const common::BorrowedSlice) noexcept;
 
+    /**
+     * Put a value made of several parts, such as a header, body and trailer, without concatenating them first. The
+     * parts are checksummed and written one after the other and are read back as a single value.
+     */
+    KVError put(const std::string &, const std::initializer_list<common::BorrowedSlice> parts) noexcept;
+
+    /**
+     * Put a value made of part_count parts starting at parts, as with writev.
+     */
+    KVError put(const std::string &, const common::BorrowedSlice *parts, const size_t part_count) noexcept;
+
     KVError remove(const std::string &) noexcept;
 
     common::Expected<std::vector<std::string>, KVError> listKeys() const noexcept;
@@ -125,6 +172,8 @@ class __attribute__((visibility("default"))) KV {
     KVError compact() noexcept;
 
     std::uint32_t currentSizeBytes() const noexcept;
+
+    KVMetrics metrics() const noexcept;
 };
 
 template <typename T> inline constexpr uint32_t smallSizeOf() {
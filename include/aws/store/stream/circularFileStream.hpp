@@ -0,0 +1,104 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <aws/store/common/expected.hpp>
+#include <aws/store/common/slices.hpp>
+#include <aws/store/filesystem/filesystem.hpp>
+#include <aws/store/kv/kv.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <aws/store/stream/stream.hpp>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aws {
+namespace store {
+namespace stream {
+static constexpr auto CircularFileIdentifier = "circular";
+
+namespace detail {
+struct CircularRecordIndex {
+    uint64_t position;
+    uint32_t length;
+    int64_t timestamp;
+};
+} // namespace detail
+
+/**
+ * A stream kept in a single file of maximum_size_bytes which is allocated up front and used as a circular log.
+ *
+ * The file starts with two header slots which are written alternately, each protected by its own CRC, so that a torn
+ * header write always leaves the previous header intact. The header records where the oldest and newest records are,
+ * so opening the stream only reads the header plus any records which were appended after the header was last written.
+ * The header is written by appends which sync or wrap around, before the oldest records are overwritten, and when the
+ * stream is closed. When the file is full, new records overwrite the oldest ones in place.
+ *
+ * minimum_segment_size_bytes is not used. An existing file keeps the size it was created with.
+ */
+class __attribute__((visibility("default"))) CircularFileStream : public StreamInterface {
+  private:
+    mutable std::mutex _lock{};
+    StreamOptions _opts;
+    std::unique_ptr<filesystem::FileLike> _f{};
+    std::shared_ptr<kv::KV> _kv_store{};
+    std::vector<PersistentIterator> _iterators{};
+    uint64_t _capacity_bytes{0U};
+    uint64_t _generation{0U};
+    // Logical byte positions which only ever increase. The position in the file is the logical position modulo the
+    // capacity.
+    uint64_t _head{0U};
+    uint64_t _tail{0U};
+    // Whether records were appended since the header was last written
+    bool _header_stale{false};
+    // Records from _indexed_sequence_number up to the newest record. Records which were in the file when it was opened
+    // are only indexed once they are needed, so that opening doesn't have to read through the whole file.
+    mutable std::deque<detail::CircularRecordIndex> _index{};
+    mutable uint64_t _indexed_sequence_number{0U};
+
+    // coverity[autosar_cpp14_a15_4_3_violation] false positive, all implementations are noexcept
+    // coverity[misra_cpp_2008_rule_15_4_1_violation] false positive, implementation is also noexcept
+    explicit CircularFileStream(StreamOptions &&o) noexcept;
+
+    StreamError open() noexcept;
+    StreamError create() noexcept;
+    void recover() noexcept;
+    bool skipCorruptedOldest() noexcept;
+    StreamError writeHeader(const bool sync) noexcept;
+    StreamError indexAll() const noexcept;
+    StreamError evictOldest() noexcept;
+    common::Expected<detail::CircularRecordIndex, StreamError>
+    findRecord(uint64_t position, const uint64_t sequence_number) const noexcept;
+    common::Expected<OwnedRecord, StreamError> readAt(const detail::CircularRecordIndex &,
+                                                      const uint64_t sequence_number,
+                                                      const bool check_for_corruption) const noexcept;
+
+  public:
+    static common::Expected<std::shared_ptr<CircularFileStream>, StreamError> openOrCreate(StreamOptions &&) noexcept;
+
+    using StreamInterface::append;
+
+    common::Expected<uint64_t, StreamError> append(const common::BorrowedSlice,
+                                                   const AppendOptions &) noexcept override;
+
+    common::Expected<uint64_t, StreamError> append(common::OwnedSlice &&, const AppendOptions &) noexcept override;
+
+    common::Expected<OwnedRecord, StreamError> read(const uint64_t, const ReadOptions &) const noexcept override;
+
+    uint64_t removeOlderRecords(int64_t older_than_timestamp_ms) noexcept override;
+
+    Iterator openOrCreateIterator(const std::string &identifier, IteratorOptions) noexcept override;
+    StreamError deleteIterator(const std::string &identifier) noexcept override;
+
+    StreamError setCheckpoint(const std::string &, const uint64_t) noexcept override;
+
+    // coverity[autosar_cpp14_a15_4_3_violation] false positive, all implementations are noexcept
+    // coverity[misra_cpp_2008_rule_15_4_1_violation] false positive, implementation is also noexcept
+    ~CircularFileStream() noexcept override;
+};
+} // namespace stream
+} // namespace store
+} // namespace aws
@@ -0,0 +1,65 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <aws/store/common/slices.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace aws {
+namespace store {
+namespace stream {
+/**
+ * Compresses blocks of sealed FileStream segments. Each block is compressed on its own so that reading a record only
+ * needs to decompress the block holding it.
+ */
+class __attribute__((visibility("default"))) CompressionCodec {
+  public:
+    /**
+     * Identifies the codec within compressed segments, so that a segment is always read with the codec which wrote
+     * it. 0 is reserved.
+     */
+    virtual std::uint8_t id() const noexcept = 0;
+
+    /**
+     * Compress input, appending to output. The output may be larger than the input, in which case the block is
+     * stored uncompressed instead.
+     */
+    virtual void compress(const common::BorrowedSlice input, std::vector<uint8_t> &output) const noexcept = 0;
+
+    /**
+     * Decompress input into exactly output_size bytes at output.
+     *
+     * @return false if the input is not valid for this codec or does not decompress to exactly output_size bytes.
+     */
+    virtual bool decompress(const common::BorrowedSlice input, uint8_t *output,
+                            const std::uint32_t output_size) const noexcept = 0;
+
+    CompressionCodec() noexcept = default;
+    CompressionCodec(const CompressionCodec &) = default;
+    CompressionCodec(CompressionCodec &&) = default;
+    CompressionCodec &operator=(const CompressionCodec &) = default;
+    CompressionCodec &operator=(CompressionCodec &&) = default;
+    virtual ~CompressionCodec() noexcept = default;
+};
+
+/**
+ * LZ77 block codec in the style of LZ4, with a 64KB window and no external dependencies. Fast enough to run on small
+ * devices, and effective on the repetitive text which most records contain.
+ */
+class __attribute__((visibility("default"))) Lz77Codec : public CompressionCodec {
+  public:
+    static constexpr std::uint8_t ID = 1U;
+
+    std::uint8_t id() const noexcept override {
+        return ID;
+    }
+
+    void compress(const common::BorrowedSlice input, std::vector<uint8_t> &output) const noexcept override;
+
+    bool decompress(const common::BorrowedSlice input, uint8_t *output,
+                    const std::uint32_t output_size) const noexcept override;
+};
+} // namespace stream
+} // namespace store
+} // namespace aws
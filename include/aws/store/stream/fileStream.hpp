@@ -8,10 +8,12 @@
 #include <aws/store/filesystem/filesystem.hpp>
 #include <aws/store/kv/kv.hpp>
 #include <aws/store/stream/stream.hpp>
+#include <condition_variable>
 #include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -23,13 +25,60 @@ namespace stream {
 // Required to maintain compatibility with AWS Greengrass Stream Manager's header size
 constexpr uint8_t LOG_ENTRY_HEADER_SIZE = 32U;
 
+// Sealed segments which have been compressed, and compressed segments which are still being written
+static constexpr auto CompressedSegmentSuffix = ".logz";
+static constexpr auto CompressingSegmentSuffix = ".ztmp";
+
 struct LogEntryHeader;
+struct FrameHeader;
+
+namespace detail {
+class CompressedSegmentFile;
+
+// Where to find a record which is read once the stream's lock is released. A record in an uncompressed file is not read
+// while the stream is locked. file is set to the file holding it instead.
+struct ChunkedRead {
+    std::shared_ptr<filesystem::FileLike> file;
+    uint32_t length;
+    int64_t crc;
+};
+
+/**
+ * Read the record found by FileSegment::readChunked() from chunked.file, handing it to consumer in chunks.
+ */
+StreamError readInChunks(const ChunkedRead &chunked, const OwnedRecord &record, uint8_t *buffer,
+                         const uint32_t buffer_size, const RecordConsumer &consumer,
+                         const bool check_for_corruption) noexcept;
+
+// A record inside a batched frame (segment format version 2). offset is relative to the start of the frame body.
+struct BatchedFrameRecord {
+    uint64_t sequence_number;
+    int64_t timestamp;
+    uint32_t offset;
+    uint32_t length;
+};
+} // namespace detail
+
+/**
+ * One file of a FileStream.
+ *
+ * Segments are written either with one header per record (format version 1, compatible with Greengrass Stream
+ * Manager), or with batched frames (format version 2) where a single header and CRC cover many records. Each header
+ * carries its own version, so a segment may contain both and is always readable no matter which format is used for
+ * appending.
+ *
+ * Once sealed, a segment may be rewritten into independently compressed blocks. The compressed segment keeps the
+ * offsets of the original file, so reads and iterator offsets work the same, while only the blocks which are read are
+ * decompressed.
+ */
 class FileSegment {
   public:
     // coverity[autosar_cpp14_a15_4_3_violation] false positive, all implementations are noexcept
     // coverity[misra_cpp_2008_rule_15_4_1_violation] false positive, all implementations are noexcept
     FileSegment(const uint64_t base, std::shared_ptr<filesystem::FileSystemInterface>,
-                std::shared_ptr<logging::Logger>) noexcept;
+                std::shared_ptr<logging::Logger>, const bool batched_record_frames = false,
+                std::shared_ptr<common::BufferPool> buffer_pool = {},
+                detail::StreamCounters *counters = nullptr) noexcept;
 
     FileSegment(FileSegment &&s) = default;
     FileSegment &operator=(FileSegment &&s) = default;
@@ -37,10 +86,53 @@ class FileSegment {
     FileSegment(const FileSegment &) = delete;
     FileSegment &operator=(const FileSegment &) = delete;
 
-    ~FileSegment() = default;
+    // coverity[autosar_cpp14_a15_4_3_violation] false positive, all implementations are noexcept
+    // coverity[misra_cpp_2008_rule_15_4_1_violation] false positive, all implementations are noexcept
+    ~FileSegment() noexcept;
 
     StreamError open(const bool full_corruption_check_on_open) noexcept;
 
+    /**
+     * Open the compressed form of this segment. Blocks which fail to validate are dropped along with everything after
+     * them.
+     */
+    StreamError openCompressed(std::shared_ptr<const CompressionCodec>,
+                               const bool full_corruption_check_on_open) noexcept;
+
+    /**
+     * Open another handle to this segment's file, so that it can be read without holding the stream's lock.
+     */
+    common::Expected<std::unique_ptr<filesystem::FileLike>, filesystem::FileError> openReader() const noexcept;
+
+    /**
+     * Write a compressed copy of the sealed segment with the given base sequence number, read from source. The copy is
+     * written under a temporary name until useCompressedCopy() puts it in place.
+     */
+    static StreamError writeCompressedCopy(filesystem::FileLike &source, filesystem::FileSystemInterface &,
+                                           const uint64_t base, const CompressionCodec &) noexcept;
+
+    /**
+     * Decompress every block of the copy written by writeCompressedCopy() and check that it holds as many records and
+     * bytes as the segment it was made from. This reads the whole copy, so it should be done without holding the
+     * stream's lock.
+     */
+    static StreamError verifyCompressedCopy(std::shared_ptr<filesystem::FileSystemInterface>,
+                                            std::shared_ptr<logging::Logger>, const uint64_t base,
+                                            std::shared_ptr<const CompressionCodec>, const uint64_t highest_seq_num,
+                                            const uint32_t total_bytes) noexcept;
+
+    /**
+     * Replace this segment with the copy written by writeCompressedCopy() and remove the uncompressed file. The copy
+     * is expected to have been checked by verifyCompressedCopy() already.
+     */
+    StreamError useCompressedCopy(std::shared_ptr<const CompressionCodec>) noexcept;
+
+    static void removeCompressedCopy(filesystem::FileSystemInterface &, const uint64_t base) noexcept;
+
+    bool isCompressed() const noexcept {
+        return _compressed != nullptr;
+    }
+
     bool operator<(const FileSegment &other) const noexcept {
         return _base_seq_num < other._base_seq_num;
     }
@@ -48,10 +140,81 @@ class FileSegment {
     common::Expected<uint64_t, filesystem::FileError> append(const common::BorrowedSlice d, const int64_t timestamp_ms,
                                                              const uint64_t sequence_number, const bool sync) noexcept;
 
+    /**
+     * Append one record made of part_count parts, which are checksummed and written without concatenating them.
+     */
+    common::Expected<uint64_t, filesystem::FileError> append(const common::BorrowedSlice *parts,
+                                                             const size_t part_count, const int64_t timestamp_ms,
+                                                             const uint64_t sequence_number, const bool sync) noexcept;
+
+    /**
+     * Append a record of size bytes which producer writes in bounded chunks. The header's CRC is filled in once the
+     * whole record has been written. A record cut off by a crash part way through is dropped on open only when
+     * full_corruption_check_on_open is set; otherwise it fails its CRC check when read with check_for_corruption. In a
+     * batched segment the record is written in the original format, after any frame which is being filled.
+     */
+    common::Expected<uint64_t, filesystem::FileError> appendChunked(const uint32_t size, const RecordProducer &producer,
+                                                                    const int64_t timestamp_ms,
+                                                                    const uint64_t sequence_number,
+                                                                    const bool sync) noexcept;
+
+    /**
+     * Append a record staged by FileStream::reserve(), where the record follows LOG_ENTRY_HEADER_SIZE bytes which are
+     * free for the header. The header is filled in place so that the header and record are written together.
+     */
+    common::Expected<uint64_t, filesystem::FileError> appendStaged(common::OwnedSlice &staged,
+                                                                   const int64_t timestamp_ms,
+                                                                   const uint64_t sequence_number,
+                                                                   const bool sync) noexcept;
+
+    /**
+     * Append a record without flushing it. Call flush() once the batch is complete; if that flush fails, every record
+     * appended since the last successful flush is removed from the segment.
+     */
+    common::Expected<uint64_t, filesystem::FileError> appendUnflushed(const common::BorrowedSlice d,
+                                                                      const int64_t timestamp_ms,
+                                                                      const uint64_t sequence_number) noexcept;
+
+    common::Expected<uint64_t, filesystem::FileError> appendUnflushed(const common::BorrowedSlice *parts,
+                                                                      const size_t part_count,
+                                                                      const int64_t timestamp_ms,
+                                                                      const uint64_t sequence_number) noexcept;
+
+    /**
+     * Flush appended records to the file. When appending batched frames, the frame which is still being filled is only
+     * written when sync or write_frame is true; otherwise it stays in memory until it is full, synced, or the segment
+     * is sealed.
+     */
+    filesystem::FileError flush(const bool sync, const bool write_frame = false) noexcept;
+
+    /**
+     * Drop the records from sequence_number onwards which are still waiting for their frame. A failed flush keeps
+     * them so that they can be written later, and this lets the caller give up on the ones it has not acknowledged.
+     */
+    void dropFrameRecordsFrom(const uint64_t sequence_number) noexcept;
+
+    /**
+     * Write out any partially filled frame and flush. Called before the stream moves on to a new segment.
+     */
+    filesystem::FileError seal() noexcept;
+
     common::Expected<OwnedRecord, StreamError> read(const uint64_t sequence_number, const ReadOptions &) const noexcept;
 
+    /**
+     * Find a record which is to be read in chunks. A record in an uncompressed file is returned without its data and
+     * chunked.file is set to the file holding it. Any other record is returned with its data.
+     */
+    common::Expected<OwnedRecord, StreamError> readChunked(const uint64_t sequence_number, const ReadOptions &,
+                                                           detail::ChunkedRead &chunked) const noexcept;
+
     void remove() noexcept;
 
+    /**
+     * Tell the file system that the segment will not be read again, once every iterator has moved past it. Dirty pages
+     * cannot be dropped, so this keeps asking until the whole segment has been synced.
+     */
+    void releaseCache() noexcept;
+
     std::uint64_t getBaseSeqNum() const noexcept {
         return _base_seq_num;
     }
@@ -64,23 +227,80 @@ class FileSegment {
         return _latest_timestamp_ms;
     }
 
+    // Bytes used on disk, which is less than the size of the records for compressed segments
     std::uint32_t totalSizeBytes() const noexcept {
-        return _total_bytes;
+        return (_compressed != nullptr) ? _compressed_size_bytes : _total_bytes;
     }
 
   private:
-    std::unique_ptr<filesystem::FileLike> _f;
+    // Shared with chunked reads, which read from the file after the stream's lock is released
+    std::shared_ptr<filesystem::FileLike> _f;
     std::shared_ptr<filesystem::FileSystemInterface> _file_implementation{};
     std::shared_ptr<logging::Logger> _logger;
+    std::shared_ptr<common::BufferPool> _buffer_pool;
+    // The owning stream's counters of syncs and truncations, if any
+    detail::StreamCounters *_counters{nullptr};
     std::uint64_t _base_seq_num{1U};
     std::uint64_t _highest_seq_num{0U};
     std::int64_t _latest_timestamp_ms{0};
     std::uint32_t _total_bytes{0U};
+    std::uint64_t _flushed_highest_seq_num{0U};
+    std::int64_t _flushed_latest_timestamp_ms{0};
+    std::uint32_t _flushed_total_bytes{0U};
+    std::uint32_t _synced_total_bytes{0U};
+    bool _cache_released{false};
+    // Everything before this offset has already been asked for ahead of the readers
+    mutable std::uint32_t _read_ahead_end{0U};
     std::string _segment_id;
 
-    static LogEntryHeader convertSliceToHeader(const common::OwnedSlice &) noexcept;
-
+    bool _batched_record_frames{false};
+    // Records which are waiting to be written as one frame. _total_bytes already includes the encoded frame.
+    std::vector<uint8_t> _frame_body{};
+    std::vector<detail::BatchedFrameRecord> _frame_records{};
+    std::uint64_t _frame_start_highest_seq_num{0U};
+    std::int64_t _frame_start_latest_timestamp_ms{0};
+    // Kept between calls to appendChunked() so that each one does not allocate. Freed when the segment is sealed.
+    common::OwnedSlice _chunk_buffer{};
+    // The frame which was last read from the file, so that reading through a frame reads and decodes it only once.
+    // Only touched while the owning stream holds its lock.
+    mutable std::uint32_t _cached_frame_offset{UINT32_MAX};
+    mutable bool _cached_frame_crc_ok{false};
+    mutable common::OwnedSlice _cached_frame_body{};
+    mutable std::vector<detail::BatchedFrameRecord> _cached_frame_records{};
+
+    // Points into _f when the segment is compressed
+    detail::CompressedSegmentFile *_compressed{nullptr};
+    std::uint32_t _compressed_size_bytes{0U};
+
+    common::Expected<OwnedRecord, StreamError> readRecord(const uint64_t sequence_number,
+                                                          const ReadOptions &read_options,
+                                                          detail::ChunkedRead *chunked) const noexcept;
+    StreamError openCompressedFile(const std::string &identifier, std::shared_ptr<const CompressionCodec>,
+                                   const bool full_corruption_check_on_open) noexcept;
+    static LogEntryHeader convertSliceToHeader(const common::BorrowedSlice) noexcept;
+    static FrameHeader convertSliceToFrameHeader(const common::BorrowedSlice) noexcept;
+
+    void readAhead(const uint32_t offset) const noexcept;
     void truncateAndLog(const uint32_t truncate, const StreamError &err) const noexcept;
+    void rollbackToFlushed() noexcept;
+    std::uint32_t pendingFrameBytes() const noexcept;
+    common::Expected<uint64_t, filesystem::FileError> appendRecord(const common::BorrowedSlice *parts,
+                                                                   const size_t part_count, const int64_t timestamp_ms,
+                                                                   const uint64_t sequence_number,
+                                                                   const bool sync) noexcept;
+    filesystem::FileError writeRecord(const common::BorrowedSlice header, const common::BorrowedSlice *parts,
+                                      const size_t part_count, const bool sync) noexcept;
+    common::Expected<uint64_t, filesystem::FileError> appendToFrame(const common::BorrowedSlice *parts,
+                                                                    const size_t part_count, const uint32_t length,
+                                                                    const int64_t timestamp_ms,
+                                                                    const uint64_t sequence_number) noexcept;
+    filesystem::FileError writeFrame() noexcept;
+    StreamError loadFrame(const uint32_t offset, const uint32_t body_length) const noexcept;
+    common::Expected<OwnedRecord, StreamError> readFromRecords(const std::vector<detail::BatchedFrameRecord> &records,
+                                                               const uint8_t *body, const uint64_t sequence_number,
+                                                               const bool may_return_later_records,
+                                                               const uint32_t frame_offset,
+                                                               const uint32_t next_frame_offset) const noexcept;
 };
 
 class __attribute__((visibility("default"))) PersistentIterator {
@@ -106,11 +326,21 @@ class __attribute__((visibility("default"))) PersistentIterator {
 
 class __attribute__((visibility("default"))) FileStream : public StreamInterface {
   private:
+    // Taken before the segments lock by everything which adds or removes records. appendChunked() keeps it while the
+    // producer runs without the segments lock, so that readers carry on while the rest of the segments stay put.
+    std::mutex _append_lock{};
     mutable std::mutex _segments_lock{}; // TODO: would like this to be a shared_mutex, but that is c++17.
     StreamOptions _opts;
     std::shared_ptr<kv::KV> _kv_store{};
+    // Guards the iterators. When both locks are needed the segments lock must be taken first.
+    mutable std::mutex _iterators_lock{};
     std::vector<PersistentIterator> _iterators{};
     std::vector<FileSegment> _segments{};
+    // Base sequence numbers of sealed segments waiting to be compressed by the compression thread
+    std::vector<uint64_t> _segments_to_compress{};
+    std::condition_variable _compression_cv{};
+    bool _closing{false};
+    std::thread _compressor{};
 
     // coverity[autosar_cpp14_a15_4_3_violation] false positive, all implementations are noexcept
     // coverity[misra_cpp_2008_rule_15_4_1_violation] false positive, implementation is also noexcept
@@ -120,18 +350,69 @@ class __attribute__((visibility("default"))) FileStream : public StreamInterface
                                                        const bool remove_oldest_segments_if_full) noexcept;
     StreamError makeNextSegment() noexcept;
     StreamError loadExistingSegments() noexcept;
+    void updateCurrentSizeBytes() noexcept;
     std::vector<FileSegment>::iterator eraseSegment(std::vector<FileSegment>::iterator) noexcept;
+    bool needsNewSegment() const noexcept;
+    StreamError prepareToAppend(const uint32_t record_size, const AppendOptions &) noexcept;
+    common::Expected<OwnedRecord, StreamError> readRecord(const uint64_t sequence_number, const ReadOptions &,
+                                                          detail::ChunkedRead *chunked) const noexcept;
+    void compressionLoop() noexcept;
+    void releaseConsumedSegments() noexcept;
+
+  protected:
+    common::Expected<uint64_t, StreamError> commit(AppendReservation &&, const AppendOptions &) noexcept override;
 
   public:
     static common::Expected<std::shared_ptr<FileStream>, StreamError> openOrCreate(StreamOptions &&) noexcept;
 
+    using StreamInterface::append;
+
     common::Expected<uint64_t, StreamError> append(const common::BorrowedSlice,
                                                    const AppendOptions &) noexcept override;
 
     common::Expected<uint64_t, StreamError> append(common::OwnedSlice &&, const AppendOptions &) noexcept override;
 
+    common::Expected<uint64_t, StreamError> append(const common::BorrowedSlice *parts, const size_t part_count,
+                                                   const AppendOptions &) noexcept override;
+
+    /**
+     * Reserves a staging buffer with room for the record header in front of the record, so that committing computes
+     * the CRC and writes the header and record with a single append to the segment file.
+     */
+    common::Expected<AppendReservation, StreamError> reserve(const uint32_t size) noexcept override;
+
+    /**
+     * Append records which already have their sequence number and timestamp assigned, such as records moved here from
+     * another stream. The first record must have the sequence number highestSequenceNumber() + 1 and the rest must
+     * follow consecutively. The batch is written with as few flushes as possible.
+     *
+     * On error, records appended before the failure may have been kept; use highestSequenceNumber() to find out
+     * how far the batch got.
+     *
+     * With batched record frames, the last records of the batch may stay in memory until their frame fills up, unless
+     * the batch is synced or write_frames is true.
+     *
+     * @return the number of records appended.
+     */
+    common::Expected<uint64_t, StreamError> appendRecords(const std::vector<const OwnedRecord *> &records,
+                                                          const AppendOptions &,
+                                                          const bool write_frames = false) noexcept;
+
     common::Expected<OwnedRecord, StreamError> read(const uint64_t, const ReadOptions &) const noexcept override;
 
+    /**
+     * Records are written a chunk at a time straight to the segment file, in the original record format even when
+     * writing batched frames. A record cut off by a crash is only dropped on open with full_corruption_check_on_open,
+     * and is otherwise detected when it is read.
+     */
+    common::Expected<uint64_t, StreamError> appendChunked(const uint32_t size, const RecordProducer &producer,
+                                                          const AppendOptions &) noexcept override;
+
+    common::Expected<RecordMetadata, StreamError> readChunked(const uint64_t sequence_number, uint8_t *buffer,
+                                                              const uint32_t buffer_size,
+                                                              const RecordConsumer &consumer,
+                                                              const ReadOptions &) const noexcept override;
+
     uint64_t removeOlderRecords(int64_t older_than_timestamp_ms) noexcept override;
 
     Iterator openOrCreateIterator(const std::string &identifier, IteratorOptions) noexcept override;
@@ -139,7 +420,9 @@ class __attribute__((visibility("default"))) FileStream : public StreamInterface
 
     StreamError setCheckpoint(const std::string &, const uint64_t) noexcept override;
 
-    ~FileStream() override = default;
+    StreamMetrics metrics() const noexcept override;
+
+    ~FileStream() override;
 };
 
 } // namespace stream
@@ -4,6 +4,7 @@
 #pragma once
 #include <aws/store/common/expected.hpp>
 #include <aws/store/common/slices.hpp>
+#include <aws/store/filesystem/filesystem.hpp>
 #include <aws/store/stream/stream.hpp>
 #include <cstdint>
 #include <memory>
@@ -15,6 +16,8 @@
 namespace aws {
 namespace store {
 namespace stream {
+static constexpr auto DefaultSnapshotIdentifier = "snapshot";
+
 class __attribute__((visibility("default"))) MemoryStream : public StreamInterface {
   private:
     StreamOptions _opts;
@@ -29,6 +32,8 @@ class __attribute__((visibility("default"))) MemoryStream : public StreamInterfa
   public:
     static std::shared_ptr<MemoryStream> openOrCreate(StreamOptions &&) noexcept;
 
+    using StreamInterface::append;
+
     common::Expected<uint64_t, StreamError> append(const common::BorrowedSlice,
                                                    const AppendOptions &) noexcept override;
 
@@ -44,6 +49,23 @@ class __attribute__((visibility("default"))) MemoryStream : public StreamInterfa
 
     StreamError setCheckpoint(const std::string &, const uint64_t) noexcept override;
 
+    StreamMetrics metrics() const noexcept override;
+
+    /**
+     * Write all records and iterator checkpoints into one file so that the stream can be restored after a restart.
+     * The file is written sequentially under a temporary name and only replaces the previous snapshot once it has been
+     * completely written and synced.
+     */
+    StreamError snapshot(filesystem::FileSystemInterface &,
+                         const std::string &identifier = DefaultSnapshotIdentifier) noexcept;
+
+    /**
+     * Replace the records and iterator checkpoints of this stream with those from a file written by snapshot().
+     * The stream is left unchanged if the snapshot is missing or fails its CRC check.
+     */
+    StreamError restore(filesystem::FileSystemInterface &,
+                        const std::string &identifier = DefaultSnapshotIdentifier) noexcept;
+
     ~MemoryStream() override = default;
 };
 } // namespace stream
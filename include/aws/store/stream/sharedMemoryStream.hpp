@@ -0,0 +1,112 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <atomic>
+#include <aws/store/common/expected.hpp>
+#include <aws/store/common/slices.hpp>
+#include <aws/store/stream/stream.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace aws {
+namespace store {
+namespace stream {
+namespace detail {
+struct SharedStreamHeader;
+struct SharedRecordHeader;
+} // namespace detail
+
+struct SharedMemoryStreamOptions {
+    std::string name{};                                // Name of the shared memory object, such as "/telemetry"
+    uint32_t maximum_size_bytes = 16U * 1024U * 1024U; // 16MB ring for record headers and data
+    uint32_t maximum_records = 64U * 1024U;            // Maximum number of records held at once
+};
+
+/**
+ * A stream which lives in a POSIX shared memory object so that several processes can use it at once.
+ *
+ * Records are stored in a ring inside the shared memory. Appends from all processes are serialized by a process-shared
+ * mutex and get their sequence numbers from the shared header. Reads do not take any lock and do not make any
+ * syscalls; a reader copies the record out of the ring and then checks that the writer did not evict it meanwhile.
+ * Use peek() to look at a record in place without copying it, and waitForRecord() to block until a record is
+ * appended by any process.
+ *
+ * The first process to open a name creates the shared memory object with the given sizes. Later processes use the
+ * sizes that were chosen by the creator. The object lives until remove() is called, even if no process has it open.
+ *
+ * Only supported on Linux.
+ */
+class __attribute__((visibility("default"))) SharedMemoryStream : public StreamInterface {
+  private:
+    std::string _name;
+    void *_region{nullptr};
+    size_t _region_size{0U};
+    detail::SharedStreamHeader *_header{nullptr};
+    std::atomic_uint64_t *_index{nullptr};
+    uint8_t *_data{nullptr};
+
+    explicit SharedMemoryStream(std::string name) noexcept;
+
+    StreamError map(const SharedMemoryStreamOptions &) noexcept;
+    void evictOldestNoLock() noexcept;
+    detail::SharedRecordHeader recordHeaderAt(const uint64_t position) const noexcept;
+    void copyOut(const uint64_t position, void *dest, const uint32_t size) const noexcept;
+    void copyIn(const uint64_t position, const void *src, const uint32_t size) noexcept;
+    bool stillValid(const uint64_t sequence_number, const uint64_t position) const noexcept;
+
+  public:
+    static common::Expected<std::shared_ptr<SharedMemoryStream>, StreamError>
+    openOrCreate(const SharedMemoryStreamOptions &) noexcept;
+
+    /**
+     * Remove the shared memory object. Processes which already have it open can keep using it.
+     */
+    static StreamError remove(const std::string &name) noexcept;
+
+    using StreamInterface::append;
+
+    common::Expected<uint64_t, StreamError> append(const common::BorrowedSlice,
+                                                   const AppendOptions &) noexcept override;
+
+    common::Expected<uint64_t, StreamError> append(common::OwnedSlice &&, const AppendOptions &) noexcept override;
+
+    common::Expected<OwnedRecord, StreamError> read(const uint64_t sequence_number,
+                                                    const ReadOptions &) const noexcept override;
+
+    /**
+     * Call the visitor with the record's data in place in shared memory, without copying it.
+     * The data is only valid during the call. Because the writer may evict the record concurrently, the return value
+     * says whether the record was still intact after the visitor returned; if it was not, discard whatever the visitor
+     * did with the data.
+     */
+    StreamError peek(const uint64_t sequence_number, const ReadOptions &,
+                     const std::function<void(const common::BorrowedSlice, const int64_t timestamp)> &visitor) const
+        noexcept;
+
+    /**
+     * Block until a record with the given sequence number has been appended by any process, or the timeout expires.
+     *
+     * @return true if the record is available.
+     */
+    bool waitForRecord(const uint64_t sequence_number, const std::chrono::milliseconds timeout) const noexcept;
+
+    uint64_t removeOlderRecords(int64_t older_than_timestamp_ms) noexcept override;
+
+    Iterator openOrCreateIterator(const std::string &identifier, IteratorOptions) noexcept override;
+    StreamError deleteIterator(const std::string &identifier) noexcept override;
+
+    StreamError setCheckpoint(const std::string &, const uint64_t) noexcept override;
+
+    std::uint64_t firstSequenceNumber() const noexcept override;
+    std::uint64_t highestSequenceNumber() const noexcept override;
+    std::uint64_t currentSizeBytes() const noexcept override;
+
+    ~SharedMemoryStream() override;
+};
+} // namespace stream
+} // namespace store
+} // namespace aws
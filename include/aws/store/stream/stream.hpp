@@ -6,13 +6,16 @@
 #include <atomic>
 #include <aws/store/common/expected.hpp>
 #include <aws/store/common/logging.hpp>
+#include <aws/store/common/metrics.hpp>
 #include <aws/store/common/slices.hpp>
 #include <aws/store/common/util.hpp>
 #include <aws/store/filesystem/filesystem.hpp>
 #include <aws/store/kv/kv.hpp>
 #include <cstdint>
 #include <functional>
+#include <initializer_list>
 #include <string>
+#include <vector>
 
 #if __cplusplus >= 201703L
 #define WEAK_FROM_THIS weak_from_this
@@ -56,8 +59,88 @@ namespace stream __attribute__((visibility("default"))) {
     struct IteratorOptions {};
 
     class StreamInterface;
+    class CompressionCodec;
     using StreamError = common::GenericError<StreamErrorCode>;
 
+    /**
+     * Writes the next length bytes of a record being appended by StreamInterface::appendChunked() into buffer.
+     * Returning an error abandons the append.
+     */
+    using RecordProducer = std::function<StreamError(uint8_t *buffer, const uint32_t length)>;
+
+    /**
+     * Receives the next chunk of a record being read by StreamInterface::readChunked(). Returning an error stops the
+     * read.
+     */
+    using RecordConsumer = std::function<StreamError(const common::BorrowedSlice chunk)>;
+
+    /**
+     * A record which was read by StreamInterface::readChunked(), without its data.
+     */
+    struct RecordMetadata {
+        uint32_t offset;
+        uint32_t length;
+        int64_t timestamp;
+        uint64_t sequence_number;
+    };
+
+    /**
+     * How far the checkpoint of a persisted iterator is behind the end of the stream.
+     */
+    struct IteratorMetrics {
+        std::string identifier;
+        // The record which the iterator resumes from
+        uint64_t sequence_number;
+        // Records from sequence_number to the end of the stream
+        uint64_t lag;
+    };
+
+    /**
+     * What a stream has done since it was opened. Latencies are in nanoseconds and include waiting for other
+     * operations on the same stream. Streams report zero for anything which they do not do or do not track.
+     */
+    struct StreamMetrics {
+        // Records appended and read successfully, and the bytes of their data
+        uint64_t appends;
+        uint64_t appended_bytes;
+        uint64_t reads;
+        uint64_t read_bytes;
+        uint64_t syncs;
+        uint64_t segments_created;
+        uint64_t segments_removed;
+        // Compactions of the store which keeps the iterators' checkpoints
+        uint64_t compactions;
+        // Times that corrupted data was cut off the end of a file when opening it
+        uint64_t corruption_truncations;
+        common::HistogramSnapshot append_latency;
+        common::HistogramSnapshot read_latency;
+        common::HistogramSnapshot sync_latency;
+        common::HistogramSnapshot compaction_latency;
+        std::vector<IteratorMetrics> iterators;
+    };
+
+    namespace detail {
+    struct StreamCounters {
+        common::Counter appends{};
+        common::Counter appended_bytes{};
+        common::Counter reads{};
+        common::Counter read_bytes{};
+        common::Counter syncs{};
+        common::Counter segments_created{};
+        common::Counter segments_removed{};
+        common::Counter corruption_truncations{};
+        common::Histogram append_latency{};
+        common::Histogram read_latency{};
+        common::Histogram sync_latency{};
+    };
+
+    /**
+     * Hand data which is already in memory to consumer in chunks copied into buffer.
+     */
+    StreamError copyInChunks(const common::BorrowedSlice data, uint8_t *buffer, const uint32_t buffer_size,
+                             const RecordConsumer &consumer) noexcept;
+    } // namespace detail
+
     class CheckpointableOwnedRecord : public OwnedRecord {
       private:
         std::function<StreamError(void)> _checkpoint;
@@ -149,18 +232,88 @@ namespace stream __attribute__((visibility("default"))) {
         AppendOptions(bool sync_on_append_opt = false, bool remove_oldest_segments_if_full_opt = true);
     };
 
+    /**
+     * Space for one record reserved by StreamInterface::reserve(). Write the record into data(), then commit() it to
+     * append it to the stream, or abort() to discard it. A reservation which is destroyed without being committed is
+     * aborted.
+     */
+    class AppendReservation {
+      private:
+        std::weak_ptr<StreamInterface> _stream{};
+        common::OwnedSlice _buffer{};
+        // Bytes at the start of the buffer which the stream keeps for itself, such as for a record header
+        uint32_t _prefix_bytes{0U};
+
+      public:
+        AppendReservation() = default;
+
+        // coverity[autosar_cpp14_a15_4_3_violation] false positive, all implementations are noexcept
+        // coverity[misra_cpp_2008_rule_15_4_1_violation] false positive, implementation is noexcept
+        AppendReservation(std::weak_ptr<StreamInterface> s, common::OwnedSlice &&buffer,
+                          const uint32_t prefix_bytes) noexcept;
+
+        AppendReservation(AppendReservation &) = delete;
+        AppendReservation &operator=(AppendReservation &) = delete;
+        AppendReservation(AppendReservation &&) = default;
+        AppendReservation &operator=(AppendReservation &&) = default;
+        ~AppendReservation() = default;
+
+        /**
+         * Memory to write the record into.
+         */
+        uint8_t *data() const noexcept {
+            return static_cast<uint8_t *>(_buffer.data()) + _prefix_bytes;
+        }
+
+        uint32_t size() const noexcept {
+            return _buffer.size() - _prefix_bytes;
+        }
+
+        /**
+         * The whole buffer including the stream's prefix, for use by the stream which made the reservation.
+         */
+        common::OwnedSlice &buffer() noexcept {
+            return _buffer;
+        }
+
+        uint32_t prefixBytes() const noexcept {
+            return _prefix_bytes;
+        }
+
+        /**
+         * Append the record to the stream. The reservation is empty afterwards, whether or not the append succeeded.
+         *
+         * @return the sequence number of the record appended.
+         */
+        common::Expected<uint64_t, StreamError> commit(const AppendOptions &) noexcept;
+
+        /**
+         * Discard the record without appending it.
+         */
+        void abort() noexcept;
+    };
+
     class StreamInterface : public std::enable_shared_from_this<StreamInterface> {
       protected:
         std::atomic_uint64_t _first_sequence_number{0U};
         std::atomic_uint64_t _next_sequence_number{0U};
         std::atomic_uint64_t _current_size_bytes{0U};
+        // Updated without holding any lock of the stream
+        mutable detail::StreamCounters _counters{};
 
       public:
-        std::uint64_t firstSequenceNumber() const noexcept;
-        std::uint64_t highestSequenceNumber() const noexcept;
-        std::uint64_t currentSizeBytes() const noexcept;
+        // Virtual so that streams whose state lives outside this object (such as in shared memory) can report it.
+        virtual std::uint64_t firstSequenceNumber() const noexcept;
+        virtual std::uint64_t highestSequenceNumber() const noexcept;
+        virtual std::uint64_t currentSizeBytes() const noexcept;
         StreamInterface(StreamInterface &) = delete;
 
+        /**
+         * Counters and latency histograms of what the stream has done since it was opened, and how far behind each
+         * persisted iterator is. Recording these costs a few atomic additions per operation, so they are always on.
+         */
+        virtual StreamMetrics metrics() const noexcept;
+
         /**
          * Append data into the stream.
          *
@@ -177,6 +330,47 @@ namespace stream __attribute__((visibility("default"))) {
         virtual common::Expected<uint64_t, StreamError> append(common::OwnedSlice &&,
                                                                const AppendOptions &) noexcept = 0;
 
+        /**
+         * Append one record made of part_count parts starting at parts, as with writev. The parts are read back as a
+         * single record. The default copies the parts into one buffer; streams which can checksum and write the parts
+         * separately override it.
+         *
+         * @return the sequence number of the record appended.
+         */
+        virtual common::Expected<uint64_t, StreamError> append(const common::BorrowedSlice *parts,
+                                                               const size_t part_count,
+                                                               const AppendOptions &) noexcept;
+
+        /**
+         * Append one record made of several parts, such as a header, body and trailer, without concatenating them
+         * first.
+         *
+         * @return the sequence number of the record appended.
+         */
+        common::Expected<uint64_t, StreamError> append(const std::initializer_list<common::BorrowedSlice> parts,
+                                                       const AppendOptions &append_opts) noexcept {
+            return append(parts.begin(), parts.size(), append_opts);
+        }
+
+        /**
+         * Reserve memory for a record of size bytes, so that the record can be serialized directly into memory owned by
+         * the stream instead of into a buffer which append() then copies. Reservations are independent of each other,
+         * and records are given sequence numbers in the order that their reservations are committed.
+         *
+         * @return the reservation to write the record into.
+         */
+        virtual common::Expected<AppendReservation, StreamError> reserve(const uint32_t size) noexcept;
+
+        /**
+         * Append a record of size bytes which producer writes a chunk at a time, so that a large record never has to be
+         * in memory all at once. The CRC is computed as the chunks are written. The stream may be locked while
+         * producer runs. The default collects the whole record and appends it.
+         *
+         * @return the sequence number of the record appended.
+         */
+        virtual common::Expected<uint64_t, StreamError>
+        appendChunked(const uint32_t size, const RecordProducer &producer, const AppendOptions &) noexcept;
+
         /**
          * Read a record from the stream by its sequence number or an error.
          *
@@ -186,6 +380,21 @@ namespace stream __attribute__((visibility("default"))) {
         virtual common::Expected<OwnedRecord, StreamError> read(const uint64_t sequence_number,
                                                                 const ReadOptions &) const noexcept = 0;
 
+        /**
+         * Read a record by handing it to consumer as a sequence of chunks of at most buffer_size bytes, read into
+         * buffer. When checking for corruption, the CRC can only be verified once every chunk has been read, so a
+         * RecordDataCorrupted error may come after consumer has received the whole record, which must then be
+         * discarded. The default reads the whole record and then hands it out in chunks.
+         *
+         * @param sequence_number the sequence number of the record to read.
+         * @return the sequence number, timestamp and length of the record which was read.
+         */
+        virtual common::Expected<RecordMetadata, StreamError> readChunked(const uint64_t sequence_number,
+                                                                          uint8_t *buffer,
+                                                                          const uint32_t buffer_size,
+                                                                          const RecordConsumer &consumer,
+                                                                          const ReadOptions &) const noexcept;
+
         /**
          * Attempt to remove records from the stream that are older than the provided timestamp.
          *
@@ -229,6 +438,15 @@ namespace stream __attribute__((visibility("default"))) {
         StreamInterface() noexcept = default;
 
         virtual ~StreamInterface() noexcept = default;
+
+      protected:
+        friend class AppendReservation;
+
+        /**
+         * Append the record written into a reservation made by reserve(). The default moves the reserved buffer into
+         * append().
+         */
+        virtual common::Expected<uint64_t, StreamError> commit(AppendReservation &&, const AppendOptions &) noexcept;
     };
 
     struct StreamOptions {
@@ -239,11 +457,23 @@ namespace stream __attribute__((visibility("default"))) {
         const std::shared_ptr<filesystem::FileSystemInterface> file_implementation{};
         const std::shared_ptr<logging::Logger> logger{};
         kv::KVOptions kv_options = {false, file_implementation, logger, "kv", 128 * 1024};
+        // FileStream only. Write records in batched frames (segment format version 2) where one header and CRC cover
+        // many records, instead of one header per record. Records are buffered in memory until the frame is full or
+        // an append asks for a sync, so records appended without sync_on_append may be lost on a crash or a failed
+        // write. Segments written this way cannot be read by Greengrass Stream Manager.
+        bool batched_record_frames = false;
+        // FileStream only. When set, segments which are no longer being appended to are rewritten in the background
+        // into blocks compressed with this codec. Compressed segments are read transparently and count towards
+        // maximum_size_bytes with their compressed size.
+        std::shared_ptr<CompressionCodec> segment_compression_codec{};
+        // Records read from the stream take their memory from this pool, and give it back once they are freed,
+        // instead of allocating memory for every record. One pool may be shared by many streams.
+        std::shared_ptr<common::BufferPool> buffer_pool{};
     };
 
     int64_t timestamp() noexcept;
 
-    static constexpr auto RecordNotFoundErrorStr = "Record not found";
+    static constexpr common::Literal RecordNotFoundErrorStr{"Record not found"};
 } // namespace stream
 } // namespace store
 } // namespace aws
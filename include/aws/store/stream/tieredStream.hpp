@@ -0,0 +1,113 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <aws/store/common/expected.hpp>
+#include <aws/store/common/logging.hpp>
+#include <aws/store/common/slices.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <aws/store/stream/stream.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aws {
+namespace store {
+namespace stream {
+
+/**
+ * The point at which an append into a TieredStream is considered complete.
+ */
+enum class Durability : std::uint8_t {
+    Memory, // Return as soon as the record is in the memory tier. It is written to the file tier in the background.
+    File,   // Return once the record has been written to the file tier.
+    Synced, // Return once the record has been written to the file tier and synced to disk.
+};
+
+struct TieredStreamOptions {
+    uint32_t memory_size_bytes = 4U * 1024U * 1024U; // 4MB of recent records are kept in memory
+    uint32_t spill_batch_bytes = 256U * 1024U;       // Spill to the file tier once this much data is waiting
+    uint32_t spill_interval_ms = 100U;               // ... or once this much time has passed
+    Durability durability = Durability::Memory;
+};
+
+/**
+ * A stream which appends into memory and spills to a FileStream in the background.
+ *
+ * Recent records are kept in memory (up to memory_size_bytes) so that tail reads never touch the disk. Records are
+ * written to the file tier in batches and keep the same sequence numbers and timestamps there. Iterators and their
+ * checkpoints are persisted by the file tier.
+ * Records which have not been spilled are lost if the process exits uncleanly, unless the durability option (or
+ * sync_on_append) requires each append to wait for the file tier.
+ */
+class __attribute__((visibility("default"))) TieredStream : public StreamInterface {
+  private:
+    mutable std::mutex _lock{};
+    std::condition_variable _spill_cv{};   // Wakes up the spill thread
+    std::condition_variable _spilled_cv{}; // Wakes up appenders waiting on the spill thread
+    TieredStreamOptions _tier_opts;
+    uint32_t _maximum_size_bytes;
+    std::shared_ptr<logging::Logger> _logger;
+    std::shared_ptr<FileStream> _file;
+    std::deque<OwnedRecord> _records{};    // Memory tier, oldest first
+    uint64_t _spilled_sequence_number{0U}; // All records before this have been written to the file tier
+    uint64_t _sync_sequence_number{0U};    // Records before this must be synced when they are spilled
+    uint64_t _write_sequence_number{0U};   // Records before this must not be left waiting for their frame to fill
+    // Records before this were appended without remove_oldest_segments_if_full, and are spilled without it
+    uint64_t _keep_oldest_sequence_number{0U};
+    uint64_t _memory_bytes{0U};
+    uint64_t _unspilled_bytes{0U};
+    uint64_t _spill_attempts{0U};
+    uint32_t _spill_waiters{0U};
+    bool _closing{false};
+    StreamError _spill_error{StreamErrorCode::NoError, {}};
+    std::thread _spiller{};
+
+    // coverity[autosar_cpp14_a15_4_3_violation] false positive, all implementations are noexcept
+    // coverity[misra_cpp_2008_rule_15_4_1_violation] false positive, implementation is also noexcept
+    TieredStream(std::shared_ptr<FileStream> file, const TieredStreamOptions &tier_opts,
+                 const uint32_t maximum_size_bytes, std::shared_ptr<logging::Logger> logger) noexcept;
+
+    void spillLoop() noexcept;
+    StreamError waitForSpill(std::unique_lock<std::mutex> &lock, const uint64_t sequence_number,
+                             const Durability durability) noexcept;
+    void trimMemoryTier() noexcept;
+    void updateSizes() noexcept;
+    common::Expected<uint64_t, StreamError> appendRecord(common::OwnedSlice &&, const AppendOptions &) noexcept;
+
+  public:
+    static common::Expected<std::shared_ptr<TieredStream>, StreamError>
+    openOrCreate(StreamOptions &&, const TieredStreamOptions &) noexcept;
+
+    using StreamInterface::append;
+
+    common::Expected<uint64_t, StreamError> append(const common::BorrowedSlice,
+                                                   const AppendOptions &) noexcept override;
+
+    common::Expected<uint64_t, StreamError> append(common::OwnedSlice &&, const AppendOptions &) noexcept override;
+
+    common::Expected<OwnedRecord, StreamError> read(const uint64_t sequence_number,
+                                                    const ReadOptions &) const noexcept override;
+
+    uint64_t removeOlderRecords(int64_t older_than_timestamp_ms) noexcept override;
+
+    Iterator openOrCreateIterator(const std::string &identifier, IteratorOptions) noexcept override;
+    StreamError deleteIterator(const std::string &identifier) noexcept override;
+
+    StreamError setCheckpoint(const std::string &, const uint64_t) noexcept override;
+
+    /**
+     * Write all records currently in the memory tier to the file tier and wait for it to finish.
+     */
+    StreamError flush() noexcept;
+
+    ~TieredStream() override;
+};
+} // namespace stream
+} // namespace store
+} // namespace aws
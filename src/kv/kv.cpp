@@ -4,6 +4,7 @@
 #include <aws/store/common/crc32.hpp>
 #include <aws/store/common/expected.hpp>
 #include <aws/store/common/logging.hpp>
+#include <aws/store/common/metrics.hpp>
 #include <aws/store/common/slices.hpp>
 #include <aws/store/common/util.hpp>
 #include <aws/store/filesystem/filesystem.hpp>
@@ -43,8 +44,8 @@ common::Expected<std::shared_ptr<KV>, KVError> KV::openOrCreate(KVOptions &&o) n
     return kv;
 }
 
-static std::string string(const KVErrorCodes e) {
-    std::string v{};
+static const char *string(const KVErrorCodes e) {
+    const char *v = "";
     switch (e) {
     case KVErrorCodes::NoError:
         v = "NoError";
@@ -82,16 +83,10 @@ static std::string string(const KVErrorCodes e) {
 }
 
 void KV::truncateAndLog(const uint32_t truncate, const KVError &err) const noexcept {
-    if (_opts.logger && (_opts.logger->level <= logging::LogLevel::Warning)) {
-        auto message = std::string{"Truncating "} + _opts.identifier + " to a length of " + std::to_string(truncate);
-        if (!err.msg.empty()) {
-            message += " because " + err.msg;
-        } else {
-            message += " because " + string(err.code);
-        }
-        _opts.logger->log(logging::LogLevel::Warning, message);
-    }
+    logging::log(_opts.logger, logging::LogLevel::Warning, "Truncating ", _opts.identifier, " to a length of ",
+                 truncate, " because ", err.msg.empty() ? string(err.code) : err.msg.c_str());
     std::ignore = _f->truncate(truncate);
+    _counters.corruption_truncations.add();
 }
 
 KVError KV::openFile() noexcept {
@@ -224,14 +219,11 @@ static KVError fileErrorToKVError(const filesystem::FileError &e) {
 }
 
 common::Expected<detail::KVHeader, KVError> KV::readHeaderFrom(const uint32_t begin) const noexcept {
-    auto header_or = _f->read(begin, begin + smallSizeOf<detail::KVHeader>());
-    if (!header_or.ok()) {
-        return fileErrorToKVError(header_or.err());
-    }
-
     detail::KVHeader ret{};
-    // coverity[autosar_cpp14_a12_0_2_violation] Use memcpy instead of reinterpret cast to avoid UB
-    std::ignore = memcpy(&ret, header_or.val().data(), sizeof(detail::KVHeader));
+    const auto e = _f->readInto(begin, &ret, smallSizeOf<detail::KVHeader>());
+    if (!e.ok()) {
+        return fileErrorToKVError(e);
+    }
 
     if (static_cast<int8_t>(ret.magic_and_version) != static_cast<int8_t>(detail::MAGIC_AND_VERSION)) {
         return KVError{KVErrorCodes::HeaderCorrupted, "Invalid magic and version"};
@@ -242,12 +234,12 @@ common::Expected<detail::KVHeader, KVError> KV::readHeaderFrom(const uint32_t be
 
 common::Expected<std::string, KVError> KV::readKeyFrom(const uint32_t begin,
                                                        const detail::key_length_type key_length) const noexcept {
-    auto key_or =
-        _f->read(begin + smallSizeOf<detail::KVHeader>(), begin + smallSizeOf<detail::KVHeader>() + key_length);
-    if (!key_or.ok()) {
-        return fileErrorToKVError(key_or.err());
+    std::string key(key_length, '\0');
+    const auto e = _f->readInto(begin + smallSizeOf<detail::KVHeader>(), &key[0], key_length);
+    if (!e.ok()) {
+        return fileErrorToKVError(e);
     }
-    return key_or.val().string();
+    return key;
 }
 
 common::Expected<common::OwnedSlice, KVError> KV::readValueFrom(const uint32_t begin) const noexcept {
@@ -296,7 +288,25 @@ std::uint32_t KV::currentSizeBytes() const noexcept {
     return _byte_position;
 }
 
+KVMetrics KV::metrics() const noexcept {
+    return KVMetrics{
+        _counters.puts.value(),
+        _counters.put_bytes.value(),
+        _counters.gets.value(),
+        _counters.removes.value(),
+        _counters.syncs.value(),
+        _counters.compactions.value(),
+        _counters.corruption_truncations.value(),
+        _counters.put_latency.snapshot(),
+        _counters.get_latency.snapshot(),
+        _counters.sync_latency.snapshot(),
+        _counters.compaction_latency.snapshot(),
+    };
+}
+
 common::Expected<common::OwnedSlice, KVError> KV::get(const std::string &key) const noexcept {
+    const common::ScopedTimer timer{_counters.get_latency};
+    _counters.gets.add();
     std::lock_guard<std::mutex> lock(_lock);
 
     for (const auto &point : _key_pointers) {
@@ -307,18 +317,14 @@ common::Expected<common::OwnedSlice, KVError> KV::get(const std::string &key) co
     return KVError{KVErrorCodes::KeyNotFound, {}};
 }
 
-filesystem::FileError KV::appendMultiple(const std::initializer_list<common::BorrowedSlice> args) const noexcept {
-    // Try to append any non-zero data, rolling back all appends if any fails by truncating the file.
-    for (auto arg : args) {
-        if (arg.size() > 0) {
-            auto e = _f->append(arg);
-            if (!e.ok()) {
-                std::ignore = _f->truncate(_byte_position);
-                return e;
-            }
-        }
+filesystem::FileError KV::appendMultiple(const common::BorrowedSlice *slices, const size_t slice_count) const noexcept {
+    // Write the whole entry with one call, rolling back anything which was written if it fails by truncating the file.
+    auto e = _f->appendv(slices, slice_count);
+    if (!e.ok()) {
+        std::ignore = _f->truncate(_byte_position);
+        return e;
     }
-    auto e = _f->flush();
+    e = _f->flush();
     if (!e.ok()) {
         std::ignore = _f->truncate(_byte_position);
         return e;
@@ -326,24 +332,47 @@ filesystem::FileError KV::appendMultiple(const std::initializer_list<common::Bor
     return filesystem::FileError{filesystem::FileErrorCode::NoError, {}};
 }
 
-inline KVError KV::writeEntry(const std::string &key, const common::BorrowedSlice data,
-                              const uint8_t flags) const noexcept {
+inline KVError KV::writeEntry(const std::string &key, const common::BorrowedSlice *parts, const size_t part_count,
+                              const uint32_t value_len, const uint8_t flags) const noexcept {
     const auto key_len = static_cast<detail::key_length_type>(key.length());
-    const auto value_len = data.size();
 
-    const auto crc = store::common::crc32::crc32_of(
-        {common::BorrowedSlice{&flags, sizeof(flags)}, common::BorrowedSlice{&key_len, sizeof(key_len)},
-         common::BorrowedSlice{&value_len, sizeof(value_len)}, common::BorrowedSlice{data.data(), data.size()}});
+    auto crc = store::common::crc32::crc32_of({common::BorrowedSlice{&flags, sizeof(flags)},
+                                               common::BorrowedSlice{&key_len, sizeof(key_len)},
+                                               common::BorrowedSlice{&value_len, sizeof(value_len)}});
+    for (size_t i = 0U; i < part_count; i++) {
+        crc = store::common::crc32::update(crc, parts[i].data(), parts[i].size());
+    }
 
     const auto header = detail::KVHeader{
         detail::MAGIC_AND_VERSION, flags, key_len, crc, value_len,
     };
 
-    return fileErrorToKVError(
-        appendMultiple({common::BorrowedSlice(&header, sizeof(header)), common::BorrowedSlice{key}, data}));
+    const auto header_slice = common::BorrowedSlice{&header, sizeof(header)};
+    const auto key_slice = common::BorrowedSlice{key};
+    // A put has a single part and a remove has none, so their slices fit on the stack. Only values made of several
+    // parts are gathered in a vector.
+    if (part_count <= 1U) {
+        const common::BorrowedSlice slices[] = {header_slice, key_slice,
+                                                (part_count == 1U) ? parts[0] : common::BorrowedSlice{}};
+        return fileErrorToKVError(appendMultiple(slices, 2U + part_count));
+    }
+    std::vector<common::BorrowedSlice> slices{header_slice, key_slice};
+    slices.reserve(2U + part_count);
+    for (size_t i = 0U; i < part_count; i++) {
+        slices.push_back(parts[i]);
+    }
+    return fileErrorToKVError(appendMultiple(slices.data(), slices.size()));
 }
 
 KVError KV::put(const std::string &key, const common::BorrowedSlice data) noexcept {
+    return put(key, &data, 1U);
+}
+
+KVError KV::put(const std::string &key, const std::initializer_list<common::BorrowedSlice> parts) noexcept {
+    return put(key, parts.begin(), parts.size());
+}
+
+KVError KV::put(const std::string &key, const common::BorrowedSlice *parts, const size_t part_count) noexcept {
     if (key.empty()) {
         return KVError{KVErrorCodes::InvalidArguments, "Key cannot be empty"};
     }
@@ -351,13 +380,18 @@ KVError KV::put(const std::string &key, const common::BorrowedSlice data) noexce
         return KVError{KVErrorCodes::InvalidArguments,
                        "Key length cannot exceed " + std::to_string(static_cast<int32_t>(detail::KEY_LENGTH_MAX))};
     }
-    if (data.size() >= detail::VALUE_LENGTH_MAX) {
+    uint64_t value_len = 0U;
+    for (size_t i = 0U; i < part_count; i++) {
+        value_len += parts[i].size();
+    }
+    if (value_len >= detail::VALUE_LENGTH_MAX) {
         return KVError{KVErrorCodes::InvalidArguments,
                        "Value length cannot exceed " + std::to_string(detail::VALUE_LENGTH_MAX)};
     }
 
+    const common::ScopedTimer timer{_counters.put_latency};
     std::lock_guard<std::mutex> lock(_lock);
-    auto e = writeEntry(key, data, 0U);
+    auto e = writeEntry(key, parts, part_count, static_cast<uint32_t>(value_len), 0U);
     if (!e.ok()) {
         return e;
     }
@@ -371,7 +405,8 @@ KVError KV::put(const std::string &key, const common::BorrowedSlice data) noexce
         }
     }
 
-    const uint32_t added_size = smallSizeOf<detail::KVHeader>() + static_cast<uint32_t>(key.length()) + data.size();
+    const uint32_t added_size =
+        smallSizeOf<detail::KVHeader>() + static_cast<uint32_t>(key.length()) + static_cast<uint32_t>(value_len);
     if (found) {
         // If the key already existed in the map, then count the duplicated bytes to know when we need to compact.
         // Newly added keys do not count against compaction.
@@ -381,6 +416,8 @@ KVError KV::put(const std::string &key, const common::BorrowedSlice data) noexce
     }
 
     _byte_position += added_size;
+    _counters.puts.add();
+    _counters.put_bytes.add(value_len);
 
     return maybeCompact();
 }
@@ -407,15 +444,10 @@ common::Expected<uint32_t, KVError> KV::readWrite(const uint32_t begin, std::pai
     }
     const auto value = std::move(value_or.val());
 
-    auto e = f.append(common::BorrowedSlice{&header, sizeof(header)});
-    if (!e.ok()) {
-        return fileErrorToKVError(e);
-    }
-    e = f.append(common::BorrowedSlice{p.first});
-    if (!e.ok()) {
-        return fileErrorToKVError(e);
-    }
-    e = f.append(common::BorrowedSlice{value.data(), value.size()});
+    const common::BorrowedSlice slices[] = {common::BorrowedSlice{&header, sizeof(header)},
+                                            common::BorrowedSlice{p.first},
+                                            common::BorrowedSlice{value.data(), value.size()}};
+    auto e = f.appendv(slices, 3U);
     if (!e.ok()) {
         return fileErrorToKVError(e);
     }
@@ -428,6 +460,8 @@ KV::KV(KVOptions &&opts) noexcept : _opts(std::move(opts)), _shadow_name(_opts.i
 }
 
 KVError KV::compactNoLock() noexcept {
+    const common::ScopedTimer timer{_counters.compaction_latency};
+    _counters.compactions.add();
     // Remove any previous partially written shadow
     _opts.filesystem_implementation->remove(_shadow_name);
     auto shadow_or = _opts.filesystem_implementation->open(_shadow_name);
@@ -447,8 +481,8 @@ KVError KV::compactNoLock() noexcept {
                 // if key is corrupted, remove it from the map
                 if ((err_or.err().code == KVErrorCodes::HeaderCorrupted) ||
                     (err_or.err().code == KVErrorCodes::DataCorrupted)) {
-                    _opts.logger->log(logging::LogLevel::Warning, "Encountered corruption during compaction. Key <" +
-                                                                      point.first + "> will be dropped.");
+                    logging::log(_opts.logger, logging::LogLevel::Warning,
+                                 "Encountered corruption during compaction. Key <", point.first, "> will be dropped.");
                     continue;
                 }
                 // Close and delete the partially written shadow
@@ -467,7 +501,11 @@ KVError KV::compactNoLock() noexcept {
             _opts.filesystem_implementation->remove(_shadow_name);
             return KVError{KVErrorCodes::WriteError, e.msg};
         }
-        shadow->sync();
+        {
+            const common::ScopedTimer sync_timer{_counters.sync_latency};
+            shadow->sync();
+        }
+        _counters.syncs.add();
     }
 
     // Close our file handle before doing renames
@@ -508,7 +546,7 @@ KVError KV::remove(const std::string &key) noexcept {
         return KVError{KVErrorCodes::KeyNotFound, {}};
     }
 
-    auto e = writeEntry(key, common::BorrowedSlice{}, DELETED_FLAG);
+    auto e = writeEntry(key, nullptr, 0U, 0U, DELETED_FLAG);
     if (!e.ok()) {
         return e;
     }
@@ -516,6 +554,7 @@ KVError KV::remove(const std::string &key) noexcept {
     const uint32_t added_size = smallSizeOf<detail::KVHeader>() + static_cast<detail::key_length_type>(key.length());
     _byte_position += added_size;
     _added_bytes += added_size;
+    _counters.removes.add();
 
     return maybeCompact();
 }
@@ -0,0 +1,576 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <atomic>
+#include <aws/store/common/crc32.hpp>
+#include <aws/store/common/expected.hpp>
+#include <aws/store/common/logging.hpp>
+#include <aws/store/common/slices.hpp>
+#include <aws/store/filesystem/filesystem.hpp>
+#include <aws/store/kv/kv.hpp>
+#include <aws/store/stream/circularFileStream.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <aws/store/stream/stream.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace aws {
+namespace store {
+namespace stream {
+namespace detail {
+constexpr uint32_t CIRCULAR_FILE_MAGIC_AND_VERSION = 0x43495201U;
+constexpr uint32_t CIRCULAR_RECORD_MAGIC_AND_VERSION = 0x43524301U;
+// Two header slots, each one sector, followed by the records
+constexpr uint32_t CIRCULAR_HEADER_SLOT_BYTES = 512U;
+constexpr uint32_t CIRCULAR_DATA_START = 2U * CIRCULAR_HEADER_SLOT_BYTES;
+constexpr uint32_t CIRCULAR_PREALLOCATE_CHUNK_BYTES = 64U * 1024U;
+
+struct CircularFileHeader {
+    uint32_t magic_and_version;
+    uint32_t crc; // Of everything after this field
+    uint64_t generation;
+    uint64_t capacity_bytes;
+    uint64_t first_sequence_number;
+    uint64_t next_sequence_number;
+    uint64_t head;
+    uint64_t tail;
+    uint64_t size_bytes;
+};
+
+struct CircularRecordHeader {
+    uint32_t magic_and_version;
+    uint32_t length;
+    uint64_t sequence_number;
+    int64_t timestamp;
+    uint32_t crc; // Of the sequence number, timestamp, length, and data
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CircularFileHeader) <= CIRCULAR_HEADER_SLOT_BYTES, "Header must fit in its slot");
+static_assert(sizeof(CircularRecordHeader) == 32U, "Record header size must be 32 bytes");
+} // namespace detail
+
+static constexpr uint32_t CIRCULAR_RECORD_HEADER_SIZE = sizeof(detail::CircularRecordHeader);
+
+static uint32_t circularHeaderCrc(const detail::CircularFileHeader &header) noexcept {
+    constexpr auto crc_start = offsetof(detail::CircularFileHeader, generation);
+    return common::crc32::update(0U, reinterpret_cast<const uint8_t *>(&header) + crc_start,
+                                 sizeof(header) - crc_start);
+}
+
+static uint32_t circularRecordCrc(const detail::CircularRecordHeader &header,
+                                  const common::BorrowedSlice data) noexcept {
+    return common::crc32::crc32_of({common::BorrowedSlice{&header.sequence_number, sizeof(header.sequence_number)},
+                                    common::BorrowedSlice{&header.timestamp, sizeof(header.timestamp)},
+                                    common::BorrowedSlice{&header.length, sizeof(header.length)}, data});
+}
+
+static StreamError circularFileError(const filesystem::FileError &e) noexcept {
+    if (e.code == filesystem::FileErrorCode::DiskFull) {
+        return StreamError{StreamErrorCode::DiskFull, e.msg};
+    }
+    return StreamError{StreamErrorCode::WriteError, e.msg};
+}
+
+common::Expected<std::shared_ptr<CircularFileStream>, StreamError>
+CircularFileStream::openOrCreate(StreamOptions &&opts) noexcept {
+    if (opts.maximum_size_bytes <= (detail::CIRCULAR_DATA_START + CIRCULAR_RECORD_HEADER_SIZE)) {
+        return StreamError{StreamErrorCode::InvalidArguments, "Maximum size is too small"};
+    }
+
+    // coverity[autosar_cpp14_a20_8_6_violation] constructor is private, cannot use make_shared
+    // coverity[misra_cpp_2008_rule_18_4_1_violation] constructor is private, cannot use make_shared
+    auto stream = std::shared_ptr<CircularFileStream>(new CircularFileStream(std::move(opts)));
+    auto err = stream->open();
+    if (!err.ok()) {
+        return err;
+    }
+    return stream;
+}
+
+CircularFileStream::CircularFileStream(StreamOptions &&o) noexcept : _opts(std::move(o)) {
+    _iterators.reserve(1U);
+}
+
+CircularFileStream::~CircularFileStream() noexcept {
+    // Save opening the stream from reading through the records which were appended since the header was written
+    std::lock_guard<std::mutex> lock(_lock);
+    if (_header_stale) {
+        std::ignore = writeHeader(false);
+    }
+}
+
+StreamError CircularFileStream::open() noexcept {
+    auto kv_or = kv::KV::openOrCreate(std::move(_opts.kv_options));
+    if (!kv_or.ok()) {
+        return StreamError{StreamErrorCode::ReadError, kv_or.err().msg};
+    }
+    _kv_store = std::move(kv_or.val());
+
+    auto f_or = _opts.file_implementation->open(CircularFileIdentifier);
+    if (!f_or.ok()) {
+        return StreamError{StreamErrorCode::ReadError, f_or.err().msg};
+    }
+    _f = std::move(f_or.val());
+
+    auto slots_or = _f->read(0U, detail::CIRCULAR_DATA_START);
+    if (!slots_or.ok()) {
+        // A new file, or one which was never completely set up
+        return create();
+    }
+
+    // Use whichever slot has a valid CRC and the latest generation
+    bool found = false;
+    detail::CircularFileHeader header{};
+    for (uint32_t slot = 0U; slot < 2U; slot++) {
+        detail::CircularFileHeader candidate{};
+        std::ignore = memcpy(&candidate,
+                             static_cast<const uint8_t *>(slots_or.val().data()) +
+                                 slot * detail::CIRCULAR_HEADER_SLOT_BYTES,
+                             sizeof(candidate));
+        if ((candidate.magic_and_version == detail::CIRCULAR_FILE_MAGIC_AND_VERSION) &&
+            (candidate.crc == circularHeaderCrc(candidate)) && (!found || (candidate.generation > header.generation))) {
+            header = candidate;
+            found = true;
+        }
+    }
+    if (!found) {
+        logging::log(_opts.logger, logging::LogLevel::Warning, "Circular stream header is corrupted, starting over");
+        return create();
+    }
+
+    _generation = header.generation;
+    _capacity_bytes = header.capacity_bytes;
+    _head = header.head;
+    _tail = header.tail;
+    _first_sequence_number = header.first_sequence_number;
+    _next_sequence_number = header.next_sequence_number;
+    _current_size_bytes = header.size_bytes;
+    _indexed_sequence_number = _next_sequence_number;
+
+    // The oldest record can only be wrong if the disk reordered our writes. Keep whatever can still be read after it,
+    // or start from the newest position if nothing can.
+    if (_first_sequence_number < _next_sequence_number) {
+        auto oldest_or = findRecord(_tail, _first_sequence_number);
+        if ((!oldest_or.ok() || (oldest_or.val().position != _tail)) && !skipCorruptedOldest()) {
+            logging::log(_opts.logger, logging::LogLevel::Warning,
+                         "Oldest record in circular stream is corrupted, dropping all records");
+            _tail = _head;
+            _first_sequence_number = _next_sequence_number.load();
+            _current_size_bytes = 0U;
+        }
+    }
+
+    recover();
+
+    if (_opts.full_corruption_check_on_open && indexAll().ok()) {
+        for (size_t i = 0U; i < _index.size(); i++) {
+            if (!readAt(_index[i], _indexed_sequence_number + i, true).ok()) {
+                // Drop this record and everything after it
+                logging::log(_opts.logger, logging::LogLevel::Warning,
+                             "Dropping corrupted records from circular stream starting at sequence number ",
+                             _indexed_sequence_number + i);
+                _head = _index[i].position;
+                _next_sequence_number = _indexed_sequence_number + i;
+                while (_index.size() > i) {
+                    _current_size_bytes -= CIRCULAR_RECORD_HEADER_SIZE + _index.back().length;
+                    _index.pop_back();
+                }
+                if (_index.empty()) {
+                    _tail = _head;
+                    _first_sequence_number = _next_sequence_number.load();
+                }
+                break;
+            }
+        }
+    }
+
+    return writeHeader(true);
+}
+
+StreamError CircularFileStream::create() noexcept {
+    _capacity_bytes = _opts.maximum_size_bytes - detail::CIRCULAR_DATA_START;
+    _generation = 0U;
+    _head = 0U;
+    _tail = 0U;
+    _indexed_sequence_number = _next_sequence_number;
+    _index.clear();
+
+    // Write out the whole file now so that appends never need to allocate space
+    auto e = _f->truncate(0U);
+    const std::vector<uint8_t> zeros(detail::CIRCULAR_PREALLOCATE_CHUNK_BYTES, 0U);
+    uint32_t remaining = _opts.maximum_size_bytes;
+    while (e.ok() && (remaining > 0U)) {
+        const auto n = std::min(remaining, detail::CIRCULAR_PREALLOCATE_CHUNK_BYTES);
+        e = _f->append(common::BorrowedSlice{zeros.data(), n});
+        remaining -= n;
+    }
+    if (e.ok()) {
+        e = _f->flush();
+    }
+    if (!e.ok()) {
+        return circularFileError(e);
+    }
+    return writeHeader(true);
+}
+
+void CircularFileStream::recover() noexcept {
+    // Pick up records which were written after the header was last updated
+    while (true) {
+        auto record_or = findRecord(_head, _next_sequence_number);
+        if (!record_or.ok()) {
+            break;
+        }
+        const auto record = record_or.val();
+        const auto end = record.position + CIRCULAR_RECORD_HEADER_SIZE + record.length;
+        // It must not run into the oldest record, and it must be intact
+        if (((_first_sequence_number < _next_sequence_number) && ((end - _tail) > _capacity_bytes)) ||
+            !readAt(record, _next_sequence_number, true).ok()) {
+            break;
+        }
+        if (_first_sequence_number == _next_sequence_number) {
+            _tail = record.position;
+        }
+        _index.push_back(record);
+        _head = end;
+        _current_size_bytes += CIRCULAR_RECORD_HEADER_SIZE + record.length;
+        ++_next_sequence_number;
+    }
+}
+
+bool CircularFileStream::skipCorruptedOldest() noexcept {
+    // Without the oldest record we don't know where the next one starts, so look for the first intact record header
+    // between the tail and the head. Every record from there on must also be found for it to become the oldest.
+    const auto corrupted_first = _first_sequence_number.load();
+    auto position = _tail + 1U;
+    while ((position + CIRCULAR_RECORD_HEADER_SIZE) <= _head) {
+        const auto offset = position % _capacity_bytes;
+        // Records are never split across the end of the file
+        if ((_capacity_bytes - offset) < CIRCULAR_RECORD_HEADER_SIZE) {
+            position += _capacity_bytes - offset;
+            continue;
+        }
+        const auto end = std::min(_capacity_bytes, offset + detail::CIRCULAR_PREALLOCATE_CHUNK_BYTES);
+        auto chunk_or = _f->read(static_cast<uint32_t>(detail::CIRCULAR_DATA_START + offset),
+                                 static_cast<uint32_t>(detail::CIRCULAR_DATA_START + end));
+        if (!chunk_or.ok()) {
+            return false;
+        }
+        const auto *const chunk = static_cast<const uint8_t *>(chunk_or.val().data());
+        // Chunks overlap by a header, so that a header which starts at the end of one chunk is found in the next
+        const auto candidates = end - offset - CIRCULAR_RECORD_HEADER_SIZE + 1U;
+        for (uint64_t i = 0U; (i < candidates) && ((position + i + CIRCULAR_RECORD_HEADER_SIZE) <= _head); i++) {
+            detail::CircularRecordHeader header{};
+            std::ignore = memcpy(&header, chunk + i, CIRCULAR_RECORD_HEADER_SIZE);
+            if ((header.magic_and_version != detail::CIRCULAR_RECORD_MAGIC_AND_VERSION) ||
+                (header.sequence_number <= corrupted_first) || (header.sequence_number >= _next_sequence_number) ||
+                ((offset + i + CIRCULAR_RECORD_HEADER_SIZE + header.length) > _capacity_bytes)) {
+                continue;
+            }
+            const auto record = detail::CircularRecordIndex{position + i, header.length, header.timestamp};
+            if (!readAt(record, header.sequence_number, true).ok()) {
+                continue;
+            }
+            _tail = record.position;
+            _first_sequence_number = header.sequence_number;
+            _index.clear();
+            _indexed_sequence_number = _next_sequence_number;
+            if (!indexAll().ok()) {
+                continue;
+            }
+            _current_size_bytes = 0U;
+            for (const auto &r : _index) {
+                _current_size_bytes += CIRCULAR_RECORD_HEADER_SIZE + r.length;
+            }
+            logging::log(_opts.logger, logging::LogLevel::Warning,
+                         "Oldest records in circular stream are corrupted, dropping sequence numbers ",
+                         corrupted_first, " to ", header.sequence_number - 1U);
+            return true;
+        }
+        position += candidates;
+    }
+
+    _index.clear();
+    _indexed_sequence_number = _next_sequence_number;
+    return false;
+}
+
+StreamError CircularFileStream::writeHeader(const bool sync) noexcept {
+    ++_generation;
+    detail::CircularFileHeader header{};
+    header.magic_and_version = detail::CIRCULAR_FILE_MAGIC_AND_VERSION;
+    header.generation = _generation;
+    header.capacity_bytes = _capacity_bytes;
+    header.first_sequence_number = _first_sequence_number;
+    header.next_sequence_number = _next_sequence_number;
+    header.head = _head;
+    header.tail = _tail;
+    header.size_bytes = _current_size_bytes;
+    header.crc = circularHeaderCrc(header);
+
+    // Alternate between the slots so that a torn write leaves the previous header usable
+    const auto slot = static_cast<uint32_t>(_generation % 2U);
+    auto e = _f->writeAt(slot * detail::CIRCULAR_HEADER_SLOT_BYTES, common::BorrowedSlice{&header, sizeof(header)});
+    if (!e.ok()) {
+        return circularFileError(e);
+    }
+    if (sync) {
+        _f->sync();
+    }
+    _header_stale = false;
+    return StreamError{StreamErrorCode::NoError, {}};
+}
+
+common::Expected<detail::CircularRecordIndex, StreamError>
+CircularFileStream::findRecord(uint64_t position, const uint64_t sequence_number) const noexcept {
+    // A record which didn't fit at the end of the file was written at the start instead, so try both
+    for (int attempt = 0; attempt < 2; attempt++) {
+        const auto offset = position % _capacity_bytes;
+        if ((_capacity_bytes - offset) >= CIRCULAR_RECORD_HEADER_SIZE) {
+            const auto begin = static_cast<uint32_t>(detail::CIRCULAR_DATA_START + offset);
+            detail::CircularRecordHeader header{};
+            if (_f->readInto(begin, &header, CIRCULAR_RECORD_HEADER_SIZE).ok()) {
+                if ((header.magic_and_version == detail::CIRCULAR_RECORD_MAGIC_AND_VERSION) &&
+                    (header.sequence_number == sequence_number) &&
+                    ((offset + CIRCULAR_RECORD_HEADER_SIZE + header.length) <= _capacity_bytes)) {
+                    return detail::CircularRecordIndex{position, header.length, header.timestamp};
+                }
+            }
+        }
+        if (offset == 0U) {
+            break;
+        }
+        position += _capacity_bytes - offset;
+    }
+    return StreamError{StreamErrorCode::HeaderDataCorrupted, {}};
+}
+
+StreamError CircularFileStream::indexAll() const noexcept {
+    if (_indexed_sequence_number <= _first_sequence_number) {
+        return StreamError{StreamErrorCode::NoError, {}};
+    }
+
+    std::vector<detail::CircularRecordIndex> older{};
+    older.reserve(static_cast<size_t>(_indexed_sequence_number - _first_sequence_number));
+    auto position = _tail;
+    for (auto seq = _first_sequence_number.load(); seq < _indexed_sequence_number; seq++) {
+        auto record_or = findRecord(position, seq);
+        if (!record_or.ok()) {
+            return record_or.err();
+        }
+        older.push_back(record_or.val());
+        position = record_or.val().position + CIRCULAR_RECORD_HEADER_SIZE + record_or.val().length;
+    }
+    std::ignore = _index.insert(_index.begin(), older.begin(), older.end());
+    _indexed_sequence_number = _first_sequence_number;
+    return StreamError{StreamErrorCode::NoError, {}};
+}
+
+StreamError CircularFileStream::evictOldest() noexcept {
+    auto err = indexAll();
+    if (!err.ok()) {
+        return err;
+    }
+    _current_size_bytes -= CIRCULAR_RECORD_HEADER_SIZE + _index.front().length;
+    _index.pop_front();
+    ++_indexed_sequence_number;
+    ++_first_sequence_number;
+    _tail = _index.empty() ? _head : _index.front().position;
+    return StreamError{StreamErrorCode::NoError, {}};
+}
+
+common::Expected<uint64_t, StreamError> CircularFileStream::append(const common::BorrowedSlice d,
+                                                                   const AppendOptions &append_opts) noexcept {
+    const uint64_t need = CIRCULAR_RECORD_HEADER_SIZE + static_cast<uint64_t>(d.size());
+    if (need > _capacity_bytes) {
+        return StreamError{StreamErrorCode::RecordTooLarge, {}};
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    // Records are never split across the end of the file
+    auto position = _head;
+    const auto wraps = (_capacity_bytes - (position % _capacity_bytes)) < need;
+    if (wraps) {
+        position += _capacity_bytes - (position % _capacity_bytes);
+    }
+
+    bool evicted = false;
+    while ((position + need - _tail) > _capacity_bytes) {
+        if (_first_sequence_number == _next_sequence_number) {
+            break;
+        }
+        if (!append_opts.remove_oldest_segments_if_full) {
+            return StreamError{StreamErrorCode::StreamFull, {}};
+        }
+        auto err = evictOldest();
+        if (!err.ok()) {
+            return err;
+        }
+        evicted = true;
+    }
+    if (_first_sequence_number == _next_sequence_number) {
+        // The new record will be the oldest one
+        _tail = position;
+    }
+    // Move the tail past the records we're about to overwrite before overwriting them
+    if (evicted) {
+        auto err = writeHeader(append_opts.sync_on_append);
+        if (!err.ok()) {
+            return err;
+        }
+    }
+
+    const auto seq = _next_sequence_number.load();
+    detail::CircularRecordHeader header{};
+    header.magic_and_version = detail::CIRCULAR_RECORD_MAGIC_AND_VERSION;
+    header.length = d.size();
+    header.sequence_number = seq;
+    header.timestamp = timestamp();
+    header.crc = circularRecordCrc(header, d);
+
+    const auto begin = static_cast<uint32_t>(detail::CIRCULAR_DATA_START + (position % _capacity_bytes));
+    auto e = _f->writeAt(begin, common::BorrowedSlice{&header, sizeof(header)});
+    if (e.ok() && (d.size() > 0U)) {
+        e = _f->writeAt(begin + CIRCULAR_RECORD_HEADER_SIZE, d);
+    }
+    if (!e.ok()) {
+        return circularFileError(e);
+    }
+
+    _index.push_back(detail::CircularRecordIndex{position, header.length, header.timestamp});
+    _head = position + need;
+    _current_size_bytes += need;
+    ++_next_sequence_number;
+
+    // Opening the stream finds records appended after the header was written, so the header is only brought up to
+    // date when syncing or wrapping around. Otherwise it would double the writes of every append.
+    if (!append_opts.sync_on_append && !wraps) {
+        _header_stale = true;
+        return seq;
+    }
+    auto err = writeHeader(append_opts.sync_on_append);
+    if (!err.ok()) {
+        return err;
+    }
+    return seq;
+}
+
+common::Expected<uint64_t, StreamError> CircularFileStream::append(common::OwnedSlice &&d,
+                                                                   const AppendOptions &append_opts) noexcept {
+    const auto x = std::move(d);
+    return append(common::BorrowedSlice(x.data(), x.size()), append_opts);
+}
+
+common::Expected<OwnedRecord, StreamError>
+CircularFileStream::readAt(const detail::CircularRecordIndex &record, const uint64_t sequence_number,
+                           const bool check_for_corruption) const noexcept {
+    const auto begin = static_cast<uint32_t>(detail::CIRCULAR_DATA_START + (record.position % _capacity_bytes));
+    detail::CircularRecordHeader header{};
+    const auto header_e = _f->readInto(begin, &header, CIRCULAR_RECORD_HEADER_SIZE);
+    if (!header_e.ok()) {
+        return StreamError{StreamErrorCode::ReadError, header_e.msg};
+    }
+    if ((header.magic_and_version != detail::CIRCULAR_RECORD_MAGIC_AND_VERSION) ||
+        (header.sequence_number != sequence_number) || (header.length != record.length)) {
+        return StreamError{StreamErrorCode::HeaderDataCorrupted, {}};
+    }
+
+    auto data = common::OwnedSlice{header.length, _opts.buffer_pool};
+    const auto data_e = _f->readInto(begin + CIRCULAR_RECORD_HEADER_SIZE, data.data(), data.size());
+    if (!data_e.ok()) {
+        return StreamError{StreamErrorCode::ReadError, data_e.msg};
+    }
+    if (check_for_corruption &&
+        (header.crc != circularRecordCrc(header, common::BorrowedSlice{data.data(), data.size()}))) {
+        return StreamError{StreamErrorCode::RecordDataCorrupted, {}};
+    }
+    return OwnedRecord{std::move(data), header.timestamp, sequence_number, 0U};
+}
+
+common::Expected<OwnedRecord, StreamError> CircularFileStream::read(const uint64_t sequence_number,
+                                                                    const ReadOptions &read_options) const noexcept {
+    std::lock_guard<std::mutex> lock(_lock);
+    auto seq = sequence_number;
+    if (seq < _first_sequence_number) {
+        if (!read_options.may_return_later_records) {
+            return StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
+        }
+        seq = _first_sequence_number;
+    }
+    if (seq >= _next_sequence_number) {
+        return StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
+    }
+    if (seq < _indexed_sequence_number) {
+        auto err = indexAll();
+        if (!err.ok()) {
+            return err;
+        }
+    }
+    return readAt(_index[static_cast<size_t>(seq - _indexed_sequence_number)], seq,
+                  read_options.check_for_corruption);
+}
+
+uint64_t CircularFileStream::removeOlderRecords(const int64_t older_than_timestamp_ms) noexcept {
+    std::lock_guard<std::mutex> lock(_lock);
+    if (!indexAll().ok()) {
+        return 0U;
+    }
+
+    uint64_t removed = 0U;
+    while (!_index.empty() && (_index.front().timestamp < older_than_timestamp_ms)) {
+        removed += CIRCULAR_RECORD_HEADER_SIZE + _index.front().length;
+        std::ignore = evictOldest();
+    }
+    if (removed > 0U) {
+        std::ignore = writeHeader(false);
+    }
+    return removed;
+}
+
+Iterator CircularFileStream::openOrCreateIterator(const std::string &identifier, IteratorOptions) noexcept {
+    std::lock_guard<std::mutex> lock(_lock);
+    for (const auto &iter : _iterators) {
+        if (iter.getIdentifier() == identifier) {
+            return Iterator{WEAK_FROM_THIS(), identifier,
+                            std::max(_first_sequence_number.load(), iter.getSequenceNumber())};
+        }
+    }
+
+    _iterators.emplace_back(identifier, _first_sequence_number, _kv_store);
+    return Iterator{WEAK_FROM_THIS(), identifier,
+                    std::max(_first_sequence_number.load(), _iterators.back().getSequenceNumber())};
+}
+
+StreamError CircularFileStream::deleteIterator(const std::string &identifier) noexcept {
+    std::lock_guard<std::mutex> lock(_lock);
+    for (auto it = _iterators.begin(); it != _iterators.end(); ++it) {
+        if (it->getIdentifier() == identifier) {
+            auto e = it->remove();
+            std::ignore = _iterators.erase(it);
+            return e;
+        }
+    }
+    return StreamError{StreamErrorCode::IteratorNotFound, {}};
+}
+
+StreamError CircularFileStream::setCheckpoint(const std::string &identifier, const uint64_t sequence_number) noexcept {
+    std::lock_guard<std::mutex> lock(_lock);
+    for (auto &iter : _iterators) {
+        if (iter.getIdentifier() == identifier) {
+            return iter.setCheckpoint(sequence_number);
+        }
+    }
+    return StreamError{StreamErrorCode::IteratorNotFound, {}};
+}
+} // namespace stream
+} // namespace store
+} // namespace aws
@@ -0,0 +1,171 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <aws/store/common/slices.hpp>
+#include <aws/store/stream/compression.hpp>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <vector>
+
+namespace aws {
+namespace store {
+namespace stream {
+constexpr std::uint8_t Lz77Codec::ID;
+
+// Compressed data is a series of sequences. Each one starts with a token byte whose high nibble is the number of
+// literals and whose low nibble is the match length minus LZ77_MIN_MATCH. A nibble of 15 means that more length bytes
+// follow, each added to the length until one is less than 255. The literals come next, then the 2 byte little endian
+// offset back to the match. The last sequence only has literals and ends the input.
+constexpr std::uint32_t LZ77_MIN_MATCH = 4U;
+constexpr std::uint32_t LZ77_MAX_OFFSET = 0xFFFFU;
+constexpr std::uint32_t LZ77_HASH_BITS = 12U;
+constexpr std::uint32_t LZ77_NIBBLE_MAX = 15U;
+constexpr std::uint32_t LZ77_LENGTH_BYTE_MAX = 255U;
+constexpr std::uint32_t LZ77_NO_POSITION = UINT32_MAX;
+
+static std::uint32_t lz77Read32(const uint8_t *p) noexcept {
+    std::uint32_t v = 0U;
+    std::ignore = memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static std::uint32_t lz77Hash(const std::uint32_t v) noexcept {
+    constexpr std::uint32_t multiplier = 2654435761U;
+    constexpr std::uint32_t shift = 32U - LZ77_HASH_BITS;
+    return (v * multiplier) >> shift;
+}
+
+static void lz77AppendLength(std::vector<uint8_t> &out, std::uint32_t length) noexcept {
+    while (length >= LZ77_LENGTH_BYTE_MAX) {
+        out.push_back(static_cast<uint8_t>(LZ77_LENGTH_BYTE_MAX));
+        length -= LZ77_LENGTH_BYTE_MAX;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+static void lz77AppendSequence(std::vector<uint8_t> &out, const uint8_t *literals, const std::uint32_t literal_length,
+                               const std::uint32_t offset, const std::uint32_t match_length) noexcept {
+    constexpr std::uint32_t high_nibble_shift = 4U;
+    constexpr std::uint32_t byte_bits = 8U;
+    constexpr std::uint32_t byte_mask = 0xFFU;
+    const auto match_code = (match_length == 0U) ? 0U : match_length - LZ77_MIN_MATCH;
+    const auto literal_nibble = std::min(literal_length, LZ77_NIBBLE_MAX);
+    const auto match_nibble = std::min(match_code, LZ77_NIBBLE_MAX);
+    out.push_back(static_cast<uint8_t>((literal_nibble << high_nibble_shift) | match_nibble));
+    if (literal_nibble == LZ77_NIBBLE_MAX) {
+        lz77AppendLength(out, literal_length - LZ77_NIBBLE_MAX);
+    }
+    std::ignore = out.insert(out.end(), literals, literals + literal_length);
+    if (match_length == 0U) {
+        return;
+    }
+    out.push_back(static_cast<uint8_t>(offset & byte_mask));
+    out.push_back(static_cast<uint8_t>((offset >> byte_bits) & byte_mask));
+    if (match_nibble == LZ77_NIBBLE_MAX) {
+        lz77AppendLength(out, match_code - LZ77_NIBBLE_MAX);
+    }
+}
+
+void Lz77Codec::compress(const common::BorrowedSlice input, std::vector<uint8_t> &output) const noexcept {
+    const auto *const in = static_cast<const uint8_t *>(input.data());
+    const auto size = input.size();
+    // Positions of the most recent occurrence of each hashed 4 byte sequence
+    std::vector<std::uint32_t> table(static_cast<size_t>(1U) << LZ77_HASH_BITS, LZ77_NO_POSITION);
+
+    std::uint32_t anchor = 0U;
+    std::uint32_t i = 0U;
+    while ((size >= LZ77_MIN_MATCH) && (i <= size - LZ77_MIN_MATCH)) {
+        const auto v = lz77Read32(in + i);
+        auto &slot = table[lz77Hash(v)];
+        const auto candidate = slot;
+        slot = i;
+        if ((candidate == LZ77_NO_POSITION) || ((i - candidate) > LZ77_MAX_OFFSET) ||
+            (lz77Read32(in + candidate) != v)) {
+            ++i;
+            continue;
+        }
+
+        auto match_length = LZ77_MIN_MATCH;
+        while (((i + match_length) < size) && (in[candidate + match_length] == in[i + match_length])) {
+            ++match_length;
+        }
+        lz77AppendSequence(output, in + anchor, i - anchor, i - candidate, match_length);
+        i += match_length;
+        anchor = i;
+    }
+    lz77AppendSequence(output, in + anchor, size - anchor, 0U, 0U);
+}
+
+static bool lz77ReadLength(const uint8_t *&p, const uint8_t *const end, std::uint32_t &length) noexcept {
+    while (true) {
+        if (p == end) {
+            return false;
+        }
+        const std::uint32_t b = *p;
+        ++p;
+        if (length > (UINT32_MAX - b)) {
+            return false;
+        }
+        length += b;
+        if (b != LZ77_LENGTH_BYTE_MAX) {
+            return true;
+        }
+    }
+}
+
+bool Lz77Codec::decompress(const common::BorrowedSlice input, uint8_t *output,
+                           const std::uint32_t output_size) const noexcept {
+    constexpr std::uint32_t high_nibble_shift = 4U;
+    constexpr std::uint32_t nibble_mask = 0x0FU;
+    constexpr std::uint32_t byte_bits = 8U;
+    const auto *p = static_cast<const uint8_t *>(input.data());
+    const auto *const end = p + input.size();
+    std::uint32_t out = 0U;
+
+    while (p != end) {
+        const std::uint32_t token = *p;
+        ++p;
+
+        auto literal_length = token >> high_nibble_shift;
+        if ((literal_length == LZ77_NIBBLE_MAX) && !lz77ReadLength(p, end, literal_length)) {
+            return false;
+        }
+        if ((literal_length > static_cast<std::uint32_t>(end - p)) || (literal_length > (output_size - out))) {
+            return false;
+        }
+        std::ignore = memcpy(output + out, p, literal_length);
+        p += literal_length;
+        out += literal_length;
+
+        if (p == end) {
+            // The last sequence only has literals
+            break;
+        }
+
+        constexpr std::uint32_t offset_bytes = 2U;
+        if (static_cast<std::uint32_t>(end - p) < offset_bytes) {
+            return false;
+        }
+        const auto offset = static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << byte_bits);
+        p += offset_bytes;
+        auto match_length = token & nibble_mask;
+        if ((match_length == LZ77_NIBBLE_MAX) && !lz77ReadLength(p, end, match_length)) {
+            return false;
+        }
+        match_length += LZ77_MIN_MATCH;
+        if ((offset == 0U) || (offset > out) || (match_length > (output_size - out))) {
+            return false;
+        }
+        // Matches may overlap the bytes they produce, so copy one byte at a time
+        for (std::uint32_t j = 0U; j < match_length; j++) {
+            output[out] = output[out - offset];
+            ++out;
+        }
+    }
+    return out == output_size;
+}
+} // namespace stream
+} // namespace store
+} // namespace aws
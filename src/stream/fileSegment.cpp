@@ -5,20 +5,25 @@
 #include <aws/store/common/crc32.hpp>
 #include <aws/store/common/expected.hpp>
 #include <aws/store/common/logging.hpp>
+#include <aws/store/common/metrics.hpp>
 #include <aws/store/common/slices.hpp>
 #include <aws/store/common/util.hpp>
 #include <aws/store/filesystem/filesystem.hpp>
+#include <aws/store/stream/compression.hpp>
 #include <aws/store/stream/fileStream.hpp>
 #include <aws/store/stream/stream.hpp>
+#include <chrono>
 #include <climits>
 #include <cstdint>
 #include <cstring>
 #include <iomanip>
+#include <iterator>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 // coverity[misra_cpp_2008_rule_2_13_2_violation] need to check for edianness
 // coverity[autosar_cpp14_m2_13_2_violation] need to check for edianness
@@ -81,8 +86,265 @@ struct LogEntryHeader {
 
 static_assert(sizeof(LogEntryHeader) == LOG_ENTRY_HEADER_SIZE, "Header size must be 32 bytes!");
 
-static std::string string(const store::stream::StreamErrorCode e) noexcept {
-    std::string v{};
+// Segment format version 2 packs many records into one frame behind a single header and CRC.
+// The first 32 bytes of a frame header contain everything needed to skip over the frame, so readers can read the same
+// 32 bytes for either version and then decide from the version how to continue.
+//
+// The frame body holds each record as: varint sequence number delta from the previous record (0 for the first),
+// zigzag varint timestamp delta from the previous record (from base_timestamp for the first), varint payload length,
+// and then the payload. The CRC covers the header, with the CRC field set to 0, and the body.
+constexpr uint8_t FRAME_VERSION = 0x02U;
+constexpr int32_t FRAME_MAGIC_AND_VERSION = MAGIC_BYTES << 8 | static_cast<int8_t>(FRAME_VERSION);
+constexpr uint32_t FRAME_HEADER_SIZE = 40U;
+// A frame is written out once its body reaches this size.
+constexpr uint32_t FRAME_TARGET_BODY_BYTES = 4U * 1024U;
+// Smallest encoding of a record in a frame body, an empty payload with 3 single byte varints.
+constexpr uint32_t FRAME_MIN_RECORD_BYTES = 3U;
+// How far ahead of an iterator the file system is asked to read.
+constexpr uint32_t READ_AHEAD_BYTES = 256U * 1024U;
+
+#pragma pack(push, 4)
+struct FrameHeader {
+    int32_t magic_and_version;
+    int32_t base_relative_sequence_number;
+    int32_t last_relative_sequence_number;
+    int32_t record_count;
+    int32_t body_length_bytes;
+    int32_t crc;
+    int64_t base_timestamp;
+    int64_t last_timestamp;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(FrameHeader) == FRAME_HEADER_SIZE, "Frame header size must be 40 bytes!");
+
+static void appendFrameVarint(std::vector<uint8_t> &out, std::uint64_t v) noexcept {
+    constexpr std::uint64_t low_bits = 0x7FU;
+    constexpr std::uint8_t continuation = 0x80U;
+    constexpr std::uint32_t bits_per_byte = 7U;
+    while (v > low_bits) {
+        out.push_back(static_cast<uint8_t>((v & low_bits) | continuation));
+        v >>= bits_per_byte;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static bool readFrameVarint(const uint8_t *&p, const uint8_t *const end, std::uint64_t &v) noexcept {
+    constexpr std::uint8_t low_bits = 0x7FU;
+    constexpr std::uint8_t continuation = 0x80U;
+    constexpr std::uint32_t bits_per_byte = 7U;
+    constexpr std::uint32_t max_shift = 63U;
+    v = 0U;
+    for (std::uint32_t shift = 0U; shift <= max_shift; shift += bits_per_byte) {
+        if (p == end) {
+            return false;
+        }
+        const auto b = *p;
+        ++p;
+        v |= static_cast<std::uint64_t>(b & low_bits) << shift;
+        if ((b & continuation) == 0U) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::uint64_t zigzagEncode(const std::int64_t v) noexcept {
+    constexpr std::uint32_t sign_shift = 63U;
+    return (static_cast<std::uint64_t>(v) << 1U) ^ static_cast<std::uint64_t>(v >> sign_shift);
+}
+
+static std::int64_t zigzagDecode(const std::uint64_t v) noexcept {
+    return static_cast<std::int64_t>((v >> 1U) ^ (~(v & 1U) + 1U));
+}
+
+static bool frameHeaderIsValid(const FrameHeader &header) noexcept {
+    return (header.magic_and_version == FRAME_MAGIC_AND_VERSION) && (header.record_count > 0) &&
+           (header.base_relative_sequence_number >= 0) &&
+           (header.last_relative_sequence_number >= header.base_relative_sequence_number) &&
+           (static_cast<std::int64_t>(header.body_length_bytes) >=
+            static_cast<std::int64_t>(header.record_count) * FRAME_MIN_RECORD_BYTES);
+}
+
+static bool decodeFrameBody(const uint8_t *body, const std::uint32_t length, const FrameHeader &header,
+                            const std::uint64_t base_seq_num,
+                            std::vector<detail::BatchedFrameRecord> &records) noexcept {
+    records.clear();
+    records.reserve(static_cast<size_t>(header.record_count));
+    const auto *p = body;
+    const auto *const end = body + length;
+    auto seq = base_seq_num + static_cast<std::uint64_t>(header.base_relative_sequence_number);
+    auto ts = header.base_timestamp;
+    for (int32_t i = 0; i < header.record_count; i++) {
+        std::uint64_t seq_delta = 0U;
+        std::uint64_t ts_delta = 0U;
+        std::uint64_t payload_length = 0U;
+        if (!readFrameVarint(p, end, seq_delta) || !readFrameVarint(p, end, ts_delta) ||
+            !readFrameVarint(p, end, payload_length) || (payload_length > static_cast<std::uint64_t>(end - p))) {
+            return false;
+        }
+        seq += seq_delta;
+        ts = static_cast<std::int64_t>(static_cast<std::uint64_t>(ts) +
+                                       static_cast<std::uint64_t>(zigzagDecode(ts_delta)));
+        records.push_back(detail::BatchedFrameRecord{seq, ts, static_cast<std::uint32_t>(p - body),
+                                                     static_cast<std::uint32_t>(payload_length)});
+        p += payload_length;
+    }
+    return (p == end) && (records.back().sequence_number ==
+                          base_seq_num + static_cast<std::uint64_t>(header.last_relative_sequence_number));
+}
+
+// Compressed segments start with a CompressedSegmentHeader which is followed by the blocks. Each block is a
+// CompressedBlockHeader and the block's data, which covers whole records of the original segment. Block data is
+// stored uncompressed when compressing would not make it smaller, in which case its stored length is the same as its
+// uncompressed length. The block headers are read when the segment is opened and kept in memory as the block index.
+constexpr int32_t COMPRESSED_SEGMENT_MAGIC_AND_VERSION = 0x5A534701; // "ZSG" version 1
+constexpr int32_t COMPRESSED_BLOCK_MAGIC = 0x5A424C4B;               // "ZBLK"
+// Records are grouped into blocks of about this many bytes before compressing them.
+constexpr uint32_t COMPRESSED_BLOCK_TARGET_BYTES = 64U * 1024U;
+
+#pragma pack(push, 4)
+struct CompressedSegmentHeader {
+    int32_t magic_and_version;
+    int32_t codec_id;
+};
+
+struct CompressedBlockHeader {
+    int32_t magic;
+    int32_t first_relative_sequence_number;
+    int32_t last_relative_sequence_number;
+    int32_t uncompressed_length_bytes;
+    int32_t stored_length_bytes;
+    int32_t crc;
+    int64_t latest_timestamp;
+};
+#pragma pack(pop)
+
+namespace detail {
+struct CompressedSegmentBlock {
+    uint32_t uncompressed_offset;
+    uint32_t uncompressed_length;
+    uint32_t file_offset;
+    uint32_t stored_length;
+    int32_t last_relative_sequence_number;
+    // CRC of the block header with its CRC set to 0, to continue the CRC over the data with
+    uint32_t header_crc;
+    uint32_t crc;
+};
+
+/**
+ * Read only view of a compressed segment which presents the bytes of the original segment file.
+ * Only touched while the owning stream holds its lock.
+ */
+class CompressedSegmentFile final : public filesystem::FileLike {
+  public:
+    CompressedSegmentFile(std::unique_ptr<filesystem::FileLike> f, std::shared_ptr<const CompressionCodec> codec,
+                          std::vector<CompressedSegmentBlock> blocks) noexcept
+        : _f(std::move(f)), _codec(std::move(codec)), _blocks(std::move(blocks)) {
+        if (!_blocks.empty()) {
+            _size = _blocks.back().uncompressed_offset + _blocks.back().uncompressed_length;
+        }
+    }
+
+    static filesystem::FileError readBlock(filesystem::FileLike &f, const CompressionCodec &codec,
+                                           const CompressedSegmentBlock &block, std::vector<uint8_t> &out) noexcept {
+        auto stored_or = f.read(block.file_offset, block.file_offset + block.stored_length);
+        if (!stored_or.ok()) {
+            return stored_or.err();
+        }
+        const auto &stored = stored_or.val();
+        if (common::crc32::update(block.header_crc, stored.data(), stored.size()) != block.crc) {
+            return filesystem::FileError{filesystem::FileErrorCode::IOError, "Compressed block failed its CRC check"};
+        }
+        out.resize(block.uncompressed_length);
+        if (block.stored_length == block.uncompressed_length) {
+            std::ignore = memcpy(out.data(), stored.data(), stored.size());
+        } else if (!codec.decompress(common::BorrowedSlice{stored.data(), stored.size()}, out.data(),
+                                     block.uncompressed_length)) {
+            return filesystem::FileError{filesystem::FileErrorCode::IOError, "Compressed block cannot be decompressed"};
+        }
+        return filesystem::FileError{filesystem::FileErrorCode::NoError, {}};
+    }
+
+    common::Expected<common::OwnedSlice, filesystem::FileError> read(const uint32_t begin,
+                                                                     const uint32_t end) override {
+        if ((begin > end) || (end > _size)) {
+            return filesystem::FileError{filesystem::FileErrorCode::EndOfFile, {}};
+        }
+        common::OwnedSlice out{end - begin};
+        auto pos = begin;
+        while (pos < end) {
+            // The last block which starts at or before pos
+            const auto block = std::prev(std::upper_bound(
+                _blocks.cbegin(), _blocks.cend(), pos,
+                [](const uint32_t p, const CompressedSegmentBlock &b) { return p < b.uncompressed_offset; }));
+            const auto index = static_cast<size_t>(std::distance(_blocks.cbegin(), block));
+            if (index != _cached_block) {
+                _cached_block = SIZE_MAX;
+                const auto e = readBlock(*_f, *_codec, *block, _cached_data);
+                if (!e.ok()) {
+                    return e;
+                }
+                _cached_block = index;
+            }
+            const auto in_block = pos - block->uncompressed_offset;
+            const auto n = std::min(end - pos, block->uncompressed_length - in_block);
+            std::ignore = memcpy(static_cast<uint8_t *>(out.data()) + (pos - begin), _cached_data.data() + in_block, n);
+            pos += n;
+        }
+        return out;
+    }
+
+    // Offset of the first block which may hold the record, so that reads can skip the blocks before it
+    uint32_t startOffsetFor(const int32_t relative_sequence_number) const noexcept {
+        const auto block = std::lower_bound(_blocks.cbegin(), _blocks.cend(), relative_sequence_number,
+                                            [](const CompressedSegmentBlock &b, const int32_t rel) {
+                                                return b.last_relative_sequence_number < rel;
+                                            });
+        return (block == _blocks.cend()) ? _size : block->uncompressed_offset;
+    }
+
+    filesystem::FileError append(common::BorrowedSlice) override {
+        return filesystem::FileError{filesystem::FileErrorCode::InvalidArguments, "Compressed segments are read only"};
+    }
+
+    filesystem::FileError flush() override {
+        return filesystem::FileError{filesystem::FileErrorCode::NoError, {}};
+    }
+
+    void sync() override {
+    }
+
+    filesystem::FileError truncate(uint32_t) override {
+        return filesystem::FileError{filesystem::FileErrorCode::InvalidArguments, "Compressed segments are read only"};
+    }
+
+  private:
+    std::unique_ptr<filesystem::FileLike> _f;
+    std::shared_ptr<const CompressionCodec> _codec;
+    std::vector<CompressedSegmentBlock> _blocks;
+    uint32_t _size{0U};
+    size_t _cached_block{SIZE_MAX};
+    std::vector<uint8_t> _cached_data{};
+};
+} // namespace detail
+
+static StreamError compressionFileErrorToStreamError(const filesystem::FileError &e) noexcept {
+    auto err = StreamError{StreamErrorCode::WriteError, e.msg};
+    if (e.code == filesystem::FileErrorCode::DiskFull) {
+        err = StreamError{StreamErrorCode::DiskFull, e.msg};
+    }
+    return err;
+}
+
+static std::string segmentIdentifier(const uint64_t base, const char *suffix) noexcept {
+    std::ostringstream oss;
+    oss << std::setw(UINT64_MAX_DECIMAL_COUNT) << std::setfill('0') << base << suffix;
+    return oss.str();
+}
+
+static const char *string(const store::stream::StreamErrorCode e) noexcept {
+    const char *v = "";
     switch (e) {
     case store::stream::StreamErrorCode::NoError:
         v = "NoError";
@@ -128,26 +390,32 @@ static std::string string(const store::stream::StreamErrorCode e) noexcept {
 }
 
 FileSegment::FileSegment(const uint64_t base, std::shared_ptr<filesystem::FileSystemInterface> interface,
-                         std::shared_ptr<logging::Logger> logger) noexcept
-    : _file_implementation(std::move(interface)), _logger(std::move(logger)), _base_seq_num(base),
-      _highest_seq_num(base) {
-    std::ostringstream oss;
-    oss << std::setw(UINT64_MAX_DECIMAL_COUNT) << std::setfill('0') << _base_seq_num << ".log";
-
-    _segment_id = oss.str();
+                         std::shared_ptr<logging::Logger> logger, const bool batched_record_frames,
+                         std::shared_ptr<common::BufferPool> buffer_pool, detail::StreamCounters *counters) noexcept
+    : _file_implementation(std::move(interface)), _logger(std::move(logger)), _buffer_pool(std::move(buffer_pool)),
+      _counters(counters), _base_seq_num(base), _highest_seq_num(base), _flushed_highest_seq_num(base),
+      _segment_id(segmentIdentifier(base, ".log")), _batched_record_frames(batched_record_frames) {
 }
 
-void FileSegment::truncateAndLog(const uint32_t truncate, const StreamError &err) const noexcept {
-    if (_logger && (_logger->level <= logging::LogLevel::Warning)) {
-        auto message = std::string{"Truncating "} + _segment_id + " to a length of " + std::to_string(truncate);
-        if (!err.msg.empty()) {
-            message += " because " + err.msg;
-        } else {
-            message += " because " + string(err.code);
+FileSegment::~FileSegment() noexcept {
+    // Records waiting for their frame would otherwise be lost when the stream is closed.
+    if (_f && !_frame_records.empty()) {
+        const auto e = seal();
+        if (!e.ok()) {
+            logging::log(_logger, logging::LogLevel::Warning, "Unable to write final frame of ", _segment_id,
+                         " due to: ", e.msg);
         }
-        _logger->log(logging::LogLevel::Warning, message);
     }
+}
+
+void FileSegment::truncateAndLog(const uint32_t truncate, const StreamError &err) const noexcept {
+    logging::log(_logger, logging::LogLevel::Warning, "Truncating ", _segment_id, " to a length of ", truncate,
+                 " because ", err.msg.empty() ? string(err.code) : err.msg.c_str());
     std::ignore = _f->truncate(truncate);
+    _cached_frame_offset = UINT32_MAX;
+    if (_counters != nullptr) {
+        _counters->corruption_truncations.add();
+    }
 }
 
 StreamError FileSegment::open(const bool full_corruption_check_on_open) noexcept {
@@ -157,23 +425,67 @@ StreamError FileSegment::open(const bool full_corruption_check_on_open) noexcept
     }
 
     _f = std::move(file_or.val());
+    _f->advise(filesystem::AccessHint::Sequential, 0U, 0U);
     uint32_t offset = 0U;
 
+    // Big enough for a frame header, which begins with the same fields as a record header
+    uint8_t header_data[FRAME_HEADER_SIZE];
     while (true) {
-        const auto header_data_or = _f->read(offset, offset + LOG_ENTRY_HEADER_SIZE);
-        if (!header_data_or.ok()) {
-            if (header_data_or.err().code == filesystem::FileErrorCode::EndOfFile) {
+        const auto header_e = _f->readInto(offset, header_data, LOG_ENTRY_HEADER_SIZE);
+        if (!header_e.ok()) {
+            if (header_e.code == filesystem::FileErrorCode::EndOfFile) {
                 // If we reached the end of the file, there could have been extra data at the end, but less
                 // than what we were hoping to read. Truncate the file now so that everything before this point
                 // is known valid and everything after is gone.
                 std::ignore = _f->truncate(offset);
+                _flushed_total_bytes = _total_bytes;
+                _synced_total_bytes = _total_bytes;
+                _flushed_highest_seq_num = _highest_seq_num;
+                _flushed_latest_timestamp_ms = _latest_timestamp_ms;
                 return StreamError{StreamErrorCode::NoError, {}};
             }
 
-            truncateAndLog(offset, StreamError{StreamErrorCode::ReadError, header_data_or.err().msg});
+            truncateAndLog(offset, StreamError{StreamErrorCode::ReadError, header_e.msg});
+            continue;
+        }
+        const LogEntryHeader header = convertSliceToHeader(common::BorrowedSlice{header_data, LOG_ENTRY_HEADER_SIZE});
+
+        if (header.magic_and_version == FRAME_MAGIC_AND_VERSION) {
+            const auto frame_e = _f->readInto(offset + LOG_ENTRY_HEADER_SIZE, header_data + LOG_ENTRY_HEADER_SIZE,
+                                              FRAME_HEADER_SIZE - LOG_ENTRY_HEADER_SIZE);
+            if (!frame_e.ok()) {
+                truncateAndLog(offset, StreamError{StreamErrorCode::HeaderDataCorrupted, frame_e.msg});
+                continue;
+            }
+            const FrameHeader frame = convertSliceToFrameHeader(common::BorrowedSlice{header_data, FRAME_HEADER_SIZE});
+            if (!frameHeaderIsValid(frame)) {
+                truncateAndLog(offset, StreamError{StreamErrorCode::HeaderDataCorrupted, {}});
+                continue;
+            }
+            const auto frame_length = FRAME_HEADER_SIZE + static_cast<uint32_t>(frame.body_length_bytes);
+            uint8_t last_byte{};
+            if (full_corruption_check_on_open) {
+                auto err = loadFrame(offset, static_cast<uint32_t>(frame.body_length_bytes));
+                if (err.ok() && !_cached_frame_crc_ok) {
+                    err = StreamError{StreamErrorCode::RecordDataCorrupted, {}};
+                }
+                if (!err.ok()) {
+                    truncateAndLog(offset, err);
+                    continue;
+                }
+            } else if (!_f->readInto(offset + frame_length - 1U, &last_byte, 1U).ok()) {
+                // Without reading the whole frame, at least make sure that all of it made it into the file.
+                truncateAndLog(offset, StreamError{StreamErrorCode::RecordDataCorrupted, "Frame is incomplete"});
+                continue;
+            }
+
+            offset += frame_length;
+            _total_bytes += frame_length;
+            _highest_seq_num = std::max(
+                _highest_seq_num, _base_seq_num + static_cast<std::uint64_t>(frame.last_relative_sequence_number));
+            _latest_timestamp_ms = std::max(_latest_timestamp_ms, frame.last_timestamp);
             continue;
         }
-        const LogEntryHeader header = convertSliceToHeader(header_data_or.val());
 
         if (header.magic_and_version != MAGIC_AND_VERSION) {
             truncateAndLog(offset, StreamError{StreamErrorCode::HeaderDataCorrupted, {}});
@@ -197,7 +509,7 @@ StreamError FileSegment::open(const bool full_corruption_check_on_open) noexcept
     }
 }
 
-LogEntryHeader FileSegment::convertSliceToHeader(const common::OwnedSlice &data) noexcept {
+LogEntryHeader FileSegment::convertSliceToHeader(const common::BorrowedSlice data) noexcept {
     LogEntryHeader header{};
     // coverity[autosar_cpp14_a12_0_2_violation] Use memcpy instead of reinterpret cast to avoid UB.
     std::ignore = memcpy(&header, data.data(), sizeof(LogEntryHeader));
@@ -213,86 +525,658 @@ LogEntryHeader FileSegment::convertSliceToHeader(const common::OwnedSlice &data)
     return header;
 }
 
+FrameHeader FileSegment::convertSliceToFrameHeader(const common::BorrowedSlice data) noexcept {
+    FrameHeader header{};
+    // Readers may only have the first 32 bytes, which is enough to skip the frame; last_timestamp is then left as 0.
+    // coverity[autosar_cpp14_a12_0_2_violation] Use memcpy instead of reinterpret cast to avoid UB.
+    std::ignore = memcpy(&header, data.data(), std::min(static_cast<size_t>(data.size()), sizeof(FrameHeader)));
+
+    header.magic_and_version = static_cast<int32_t>(my_ntohl(static_cast<std::uint32_t>(header.magic_and_version)));
+    header.base_relative_sequence_number =
+        static_cast<int32_t>(my_ntohl(static_cast<std::uint32_t>(header.base_relative_sequence_number)));
+    header.last_relative_sequence_number =
+        static_cast<int32_t>(my_ntohl(static_cast<std::uint32_t>(header.last_relative_sequence_number)));
+    header.record_count = static_cast<int32_t>(my_ntohl(static_cast<std::uint32_t>(header.record_count)));
+    header.body_length_bytes = static_cast<int32_t>(my_ntohl(static_cast<std::uint32_t>(header.body_length_bytes)));
+    header.crc = static_cast<int32_t>(my_ntohl(static_cast<std::uint32_t>(header.crc)));
+    header.base_timestamp = static_cast<int64_t>(my_ntohll(static_cast<std::uint64_t>(header.base_timestamp)));
+    header.last_timestamp = static_cast<int64_t>(my_ntohll(static_cast<std::uint64_t>(header.last_timestamp)));
+    return header;
+}
+
 common::Expected<uint64_t, filesystem::FileError> FileSegment::append(const common::BorrowedSlice d,
                                                                       const int64_t timestamp_ms,
                                                                       const uint64_t sequence_number,
                                                                       const bool sync) noexcept {
+    return append(&d, 1U, timestamp_ms, sequence_number, sync);
+}
+
+common::Expected<uint64_t, filesystem::FileError> FileSegment::append(const common::BorrowedSlice *parts,
+                                                                      const size_t part_count,
+                                                                      const int64_t timestamp_ms,
+                                                                      const uint64_t sequence_number,
+                                                                      const bool sync) noexcept {
+    // Files with asynchronous I/O take the header, the payload and the sync as one linked submission. The sync cannot
+    // be timed apart from the writes which it is linked to, so the whole submission is timed as the sync.
+    const auto linked_sync = sync && !_batched_record_frames && (_f->async() != nullptr);
+    const auto linked_start = (linked_sync && (_counters != nullptr)) ? std::chrono::steady_clock::now()
+                                                                      : std::chrono::steady_clock::time_point{};
+    auto added_or = linked_sync ? appendRecord(parts, part_count, timestamp_ms, sequence_number, true)
+                                : appendUnflushed(parts, part_count, timestamp_ms, sequence_number);
+    if (!added_or.ok()) {
+        return added_or;
+    }
+    auto e = flush(sync && !linked_sync);
+    if (!e.ok()) {
+        // Records which were appended before this one are kept, but this one has failed
+        dropFrameRecordsFrom(sequence_number);
+        return e;
+    }
+    if (linked_sync) {
+        _synced_total_bytes = _flushed_total_bytes;
+        if (_counters != nullptr) {
+            const auto elapsed = std::chrono::steady_clock::now() - linked_start;
+            _counters->sync_latency.record(
+                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            _counters->syncs.add();
+        }
+    }
+    return added_or;
+}
+
+common::Expected<uint64_t, filesystem::FileError> FileSegment::appendStaged(common::OwnedSlice &staged,
+                                                                            const int64_t timestamp_ms,
+                                                                            const uint64_t sequence_number,
+                                                                            const bool sync) noexcept {
+    auto *const buffer = static_cast<uint8_t *>(staged.data());
+    const auto d = common::BorrowedSlice{buffer + LOG_ENTRY_HEADER_SIZE, staged.size() - LOG_ENTRY_HEADER_SIZE};
+    if (_batched_record_frames) {
+        return append(d, timestamp_ms, sequence_number, sync);
+    }
+
     const auto ts = static_cast<int64_t>(my_htonll(static_cast<std::uint64_t>(timestamp_ms)));
     const auto data_len_swap = static_cast<int32_t>(my_htonl(d.size()));
-    const auto byte_position = static_cast<int32_t>(my_htonl(_total_bytes));
-
     const auto crc = static_cast<int64_t>(my_htonll(store::common::crc32::crc32_of(
         {common::BorrowedSlice{&ts, sizeof(ts)}, common::BorrowedSlice{&data_len_swap, sizeof(data_len_swap)}, d})));
     const auto header = LogEntryHeader{
         static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(MAGIC_AND_VERSION))),
         static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(sequence_number - _base_seq_num))),
-        byte_position,
+        static_cast<int32_t>(my_htonl(_total_bytes)),
         crc,
         ts,
-        static_cast<int32_t>(my_htonl(d.size())),
+        data_len_swap,
     };
+    std::ignore = memcpy(buffer, &header, sizeof(header));
 
-    // If an error happens when appending, truncate the file to the current size so that we don't have any
-    // partial data in the file, and then return the error.
-    auto e = _f->append(common::BorrowedSlice{&header, sizeof(header)});
+    auto e = _f->append(common::BorrowedSlice{buffer, staged.size()});
     if (!e.ok()) {
         std::ignore = _f->truncate(_total_bytes);
         return e;
     }
-    e = _f->append(d);
+
+    _highest_seq_num = std::max(_highest_seq_num, sequence_number);
+    _total_bytes += staged.size();
+    _latest_timestamp_ms = timestamp_ms;
+
+    e = flush(sync);
     if (!e.ok()) {
+        return e;
+    }
+    return staged.size();
+}
+
+common::Expected<uint64_t, filesystem::FileError> FileSegment::appendChunked(const uint32_t size,
+                                                                             const RecordProducer &producer,
+                                                                             const int64_t timestamp_ms,
+                                                                             const uint64_t sequence_number,
+                                                                             const bool sync) noexcept {
+    // Frames are built in memory, so the record is written on its own in the original format once any frame which is
+    // being filled has been written.
+    if (_batched_record_frames) {
+        const auto e = writeFrame();
+        if (!e.ok()) {
+            return e;
+        }
+    }
+
+    if (!_f->canWriteAt()) {
+        // This file cannot be written in place, so the whole record has to be collected before it can be written
+        auto record = common::OwnedSlice{size, _buffer_pool};
+        if ((record.data() == nullptr) && (size > 0U)) {
+            return filesystem::FileError{filesystem::FileErrorCode::InvalidArguments,
+                                         "Unable to allocate memory for the record"};
+        }
+        if (size > 0U) {
+            const auto err = producer(static_cast<uint8_t *>(record.data()), size);
+            if (!err.ok()) {
+                return filesystem::FileError{filesystem::FileErrorCode::InvalidArguments, err.msg};
+            }
+        }
+        return append(common::BorrowedSlice{record.data(), record.size()}, timestamp_ms, sequence_number, sync);
+    }
+
+    constexpr uint32_t chunk_bytes = 64U * 1024U;
+    if ((size > 0U) && (_chunk_buffer.data() == nullptr)) {
+        _chunk_buffer = common::OwnedSlice{chunk_bytes, _buffer_pool};
+        if (_chunk_buffer.data() == nullptr) {
+            return filesystem::FileError{filesystem::FileErrorCode::InvalidArguments,
+                                         "Unable to allocate memory for the record"};
+        }
+    }
+    auto *const chunk_data = static_cast<uint8_t *>(_chunk_buffer.data());
+
+    const auto ts = static_cast<int64_t>(my_htonll(static_cast<std::uint64_t>(timestamp_ms)));
+    const auto data_len_swap = static_cast<int32_t>(my_htonl(size));
+    auto header = LogEntryHeader{
+        static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(MAGIC_AND_VERSION))),
+        static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(sequence_number - _base_seq_num))),
+        static_cast<int32_t>(my_htonl(_total_bytes)),
+        0,
+        ts,
+        data_len_swap,
+    };
+    const auto header_slice = common::BorrowedSlice{&header, sizeof(header)};
+    const auto rollback = [this](const filesystem::FileError &e) {
         std::ignore = _f->truncate(_total_bytes);
         return e;
+    };
+
+    // The header is written first without its CRC and is filled in once the whole record has been written. Until then
+    // the record fails its CRC check. If we crash part way through, it is only dropped when the segment is opened with
+    // a full corruption check; otherwise it is found when it is read with check_for_corruption.
+    auto e = _f->append(header_slice);
+    if (!e.ok()) {
+        return rollback(e);
     }
-    e = _f->flush();
+
+    auto crc32 = store::common::crc32::crc32_of(
+        {common::BorrowedSlice{&ts, sizeof(ts)}, common::BorrowedSlice{&data_len_swap, sizeof(data_len_swap)}});
+    uint32_t remaining = size;
+    while (remaining > 0U) {
+        const auto n = std::min(remaining, chunk_bytes);
+        const auto err = producer(chunk_data, n);
+        if (!err.ok()) {
+            return rollback(filesystem::FileError{filesystem::FileErrorCode::InvalidArguments, err.msg});
+        }
+        crc32 = store::common::crc32::update(crc32, chunk_data, n);
+        e = _f->append(common::BorrowedSlice{chunk_data, n});
+        if (!e.ok()) {
+            return rollback(e);
+        }
+        remaining -= n;
+    }
+
+    header.crc = static_cast<int64_t>(my_htonll(crc32));
+    e = _f->writeAt(_total_bytes, header_slice);
+    if (!e.ok()) {
+        return rollback(e);
+    }
+
+    _highest_seq_num = std::max(_highest_seq_num, sequence_number);
+    _total_bytes += size + static_cast<uint32_t>(sizeof(LogEntryHeader));
+    _latest_timestamp_ms = timestamp_ms;
+
+    e = flush(sync);
+    if (!e.ok()) {
+        return e;
+    }
+    return size + sizeof(LogEntryHeader);
+}
+
+common::Expected<uint64_t, filesystem::FileError>
+FileSegment::appendUnflushed(const common::BorrowedSlice d, const int64_t timestamp_ms,
+                             const uint64_t sequence_number) noexcept {
+    return appendUnflushed(&d, 1U, timestamp_ms, sequence_number);
+}
+
+common::Expected<uint64_t, filesystem::FileError>
+FileSegment::appendUnflushed(const common::BorrowedSlice *parts, const size_t part_count, const int64_t timestamp_ms,
+                             const uint64_t sequence_number) noexcept {
+    if (_batched_record_frames) {
+        std::uint32_t length = 0U;
+        for (size_t i = 0U; i < part_count; i++) {
+            length += parts[i].size();
+        }
+        return appendToFrame(parts, part_count, length, timestamp_ms, sequence_number);
+    }
+    return appendRecord(parts, part_count, timestamp_ms, sequence_number, false);
+}
+
+common::Expected<uint64_t, filesystem::FileError>
+FileSegment::appendRecord(const common::BorrowedSlice *parts, const size_t part_count, const int64_t timestamp_ms,
+                          const uint64_t sequence_number, const bool sync) noexcept {
+    std::uint32_t length = 0U;
+    for (size_t i = 0U; i < part_count; i++) {
+        length += parts[i].size();
+    }
+
+    const auto ts = static_cast<int64_t>(my_htonll(static_cast<std::uint64_t>(timestamp_ms)));
+    const auto data_len_swap = static_cast<int32_t>(my_htonl(length));
+    const auto byte_position = static_cast<int32_t>(my_htonl(_total_bytes));
+
+    auto crc32 = store::common::crc32::crc32_of(
+        {common::BorrowedSlice{&ts, sizeof(ts)}, common::BorrowedSlice{&data_len_swap, sizeof(data_len_swap)}});
+    for (size_t i = 0U; i < part_count; i++) {
+        crc32 = store::common::crc32::update(crc32, parts[i].data(), parts[i].size());
+    }
+    const auto header = LogEntryHeader{
+        static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(MAGIC_AND_VERSION))),
+        static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(sequence_number - _base_seq_num))),
+        byte_position,
+        static_cast<int64_t>(my_htonll(crc32)),
+        ts,
+        data_len_swap,
+    };
+
+    // If an error happens when appending, truncate the file to the current size so that we don't have any
+    // partial data in the file, and then return the error.
+    auto e = writeRecord(common::BorrowedSlice{&header, sizeof(header)}, parts, part_count, sync);
     if (!e.ok()) {
         std::ignore = _f->truncate(_total_bytes);
         return e;
     }
 
-    if (sync) {
-        _f->sync();
+    _highest_seq_num = std::max(_highest_seq_num, sequence_number);
+    _total_bytes += length + static_cast<uint32_t>(sizeof(LogEntryHeader));
+    _latest_timestamp_ms = timestamp_ms;
+
+    return length + sizeof(LogEntryHeader);
+}
+
+filesystem::FileError FileSegment::writeRecord(const common::BorrowedSlice header, const common::BorrowedSlice *parts,
+                                               const size_t part_count, const bool sync) noexcept {
+    const auto write = [this, sync](const common::BorrowedSlice *slices, const size_t slice_count) {
+        auto *const async = _f->async();
+        if (async == nullptr) {
+            return _f->appendv(slices, slice_count);
+        }
+
+        auto e = filesystem::FileError{filesystem::FileErrorCode::NoError, {}};
+        auto queued = async->appendAsync(slices, slice_count, sync,
+                                         [&e](const filesystem::FileError &result) { e = result; });
+        if (!queued.ok()) {
+            return queued;
+        }
+        async->waitAll();
+        return e;
+    };
+
+    // Almost every record is a single part, so its slices can stay on the stack
+    if (part_count <= 1U) {
+        const common::BorrowedSlice slices[] = {header, (part_count == 1U) ? parts[0] : common::BorrowedSlice{}};
+        return write(slices, 1U + part_count);
+    }
+    std::vector<common::BorrowedSlice> slices{};
+    slices.reserve(part_count + 1U);
+    slices.push_back(header);
+    for (size_t i = 0U; i < part_count; i++) {
+        slices.push_back(parts[i]);
     }
+    return write(slices.data(), slices.size());
+}
 
+std::uint32_t FileSegment::pendingFrameBytes() const noexcept {
+    if (_frame_records.empty()) {
+        return 0U;
+    }
+    return FRAME_HEADER_SIZE + static_cast<std::uint32_t>(_frame_body.size());
+}
+
+common::Expected<uint64_t, filesystem::FileError>
+FileSegment::appendToFrame(const common::BorrowedSlice *parts, const size_t part_count, const uint32_t length,
+                           const int64_t timestamp_ms, const uint64_t sequence_number) noexcept {
+    auto previous_seq = sequence_number;
+    auto previous_ts = timestamp_ms;
+    if (_frame_records.empty()) {
+        _frame_start_highest_seq_num = _highest_seq_num;
+        _frame_start_latest_timestamp_ms = _latest_timestamp_ms;
+    } else {
+        previous_seq = _frame_records.back().sequence_number;
+        previous_ts = _frame_records.back().timestamp;
+    }
+    const auto before = pendingFrameBytes();
+
+    appendFrameVarint(_frame_body, sequence_number - previous_seq);
+    appendFrameVarint(_frame_body, zigzagEncode(static_cast<std::int64_t>(static_cast<std::uint64_t>(timestamp_ms) -
+                                                                          static_cast<std::uint64_t>(previous_ts))));
+    appendFrameVarint(_frame_body, length);
+    const auto offset = static_cast<std::uint32_t>(_frame_body.size());
+    for (size_t i = 0U; i < part_count; i++) {
+        const auto *const data = static_cast<const uint8_t *>(parts[i].data());
+        std::ignore = _frame_body.insert(_frame_body.end(), data, data + parts[i].size());
+    }
+    _frame_records.push_back(detail::BatchedFrameRecord{sequence_number, timestamp_ms, offset, length});
+
+    const auto added = pendingFrameBytes() - before;
     _highest_seq_num = std::max(_highest_seq_num, sequence_number);
-    _total_bytes += d.size() + static_cast<uint32_t>(sizeof(LogEntryHeader));
+    _total_bytes += added;
     _latest_timestamp_ms = timestamp_ms;
 
-    return d.size() + sizeof(LogEntryHeader);
+    if (_frame_body.size() >= FRAME_TARGET_BODY_BYTES) {
+        const auto e = writeFrame();
+        if (!e.ok()) {
+            // Only this record fails. The records before it were already acknowledged, so they stay in the frame to
+            // be written by the next attempt.
+            dropFrameRecordsFrom(sequence_number);
+            return e;
+        }
+    }
+    return added;
+}
+
+void FileSegment::dropFrameRecordsFrom(const uint64_t sequence_number) noexcept {
+    auto keep = _frame_records.size();
+    while ((keep > 0U) && (_frame_records[keep - 1U].sequence_number >= sequence_number)) {
+        --keep;
+    }
+    if (keep == _frame_records.size()) {
+        return;
+    }
+
+    const auto before = pendingFrameBytes();
+    if (keep == 0U) {
+        _frame_body.clear();
+        _highest_seq_num = _frame_start_highest_seq_num;
+        _latest_timestamp_ms = _frame_start_latest_timestamp_ms;
+    } else {
+        // Each record's encoded fields are followed by its data, so the last record which is kept ends the body
+        const auto &last = _frame_records[keep - 1U];
+        _frame_body.resize(last.offset + last.length);
+        _highest_seq_num = last.sequence_number;
+        _latest_timestamp_ms = last.timestamp;
+    }
+    std::ignore =
+        _frame_records.erase(_frame_records.begin() + static_cast<std::ptrdiff_t>(keep), _frame_records.end());
+    _total_bytes -= before - pendingFrameBytes();
+}
+
+filesystem::FileError FileSegment::writeFrame() noexcept {
+    if (_frame_records.empty()) {
+        return filesystem::FileError{filesystem::FileErrorCode::NoError, {}};
+    }
+
+    const auto &first = _frame_records.front();
+    const auto &last = _frame_records.back();
+    auto header = FrameHeader{
+        static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(FRAME_MAGIC_AND_VERSION))),
+        static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(first.sequence_number - _base_seq_num))),
+        static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(last.sequence_number - _base_seq_num))),
+        static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(_frame_records.size()))),
+        static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(_frame_body.size()))),
+        0,
+        static_cast<int64_t>(my_htonll(static_cast<std::uint64_t>(first.timestamp))),
+        static_cast<int64_t>(my_htonll(static_cast<std::uint64_t>(last.timestamp))),
+    };
+    const auto body = common::BorrowedSlice{_frame_body.data(), static_cast<std::uint32_t>(_frame_body.size())};
+    header.crc = static_cast<int32_t>(
+        my_htonl(store::common::crc32::crc32_of({common::BorrowedSlice{&header, sizeof(header)}, body})));
+
+    const common::BorrowedSlice slices[] = {common::BorrowedSlice{&header, sizeof(header)}, body};
+    auto e = _f->appendv(slices, 2U);
+    // The frame is flushed straight away, so that a failure is known while its records are still here to retry
+    if (e.ok()) {
+        e = _f->flush();
+    }
+    if (!e.ok()) {
+        rollbackToFlushed();
+        return e;
+    }
+
+    _frame_body.clear();
+    _frame_records.clear();
+    _flushed_total_bytes = _total_bytes;
+    _flushed_highest_seq_num = _highest_seq_num;
+    _flushed_latest_timestamp_ms = _latest_timestamp_ms;
+    return filesystem::FileError{filesystem::FileErrorCode::NoError, {}};
+}
+
+void FileSegment::rollbackToFlushed() noexcept {
+    // We don't know how much of the unflushed data made it to the file, so drop all of it. Records which are still
+    // waiting for their frame are not in the file at all, so they are kept and written with the frame later.
+    std::ignore = _f->truncate(_flushed_total_bytes);
+    _total_bytes = _flushed_total_bytes + pendingFrameBytes();
+    if (_frame_records.empty()) {
+        _highest_seq_num = _flushed_highest_seq_num;
+        _latest_timestamp_ms = _flushed_latest_timestamp_ms;
+    }
+    _cached_frame_offset = UINT32_MAX;
+}
+
+filesystem::FileError FileSegment::flush(const bool sync, const bool write_frame) noexcept {
+    auto e = filesystem::FileError{filesystem::FileErrorCode::NoError, {}};
+    if (sync || write_frame) {
+        e = writeFrame();
+    }
+    if (e.ok()) {
+        e = _f->flush();
+    }
+    if (!e.ok()) {
+        rollbackToFlushed();
+        return e;
+    }
+
+    if (sync) {
+        if (_counters != nullptr) {
+            const common::ScopedTimer timer{_counters->sync_latency};
+            _f->sync();
+            _counters->syncs.add();
+        } else {
+            _f->sync();
+        }
+    }
+
+    // Records still waiting for their frame are not in the file yet, so they are not part of the flushed state.
+    _flushed_total_bytes = _total_bytes - pendingFrameBytes();
+    if (_frame_records.empty()) {
+        _flushed_highest_seq_num = _highest_seq_num;
+        _flushed_latest_timestamp_ms = _latest_timestamp_ms;
+    } else {
+        _flushed_highest_seq_num = _frame_start_highest_seq_num;
+        _flushed_latest_timestamp_ms = _frame_start_latest_timestamp_ms;
+    }
+    if (sync) {
+        _synced_total_bytes = _flushed_total_bytes;
+    }
+    return filesystem::FileError{filesystem::FileErrorCode::NoError, {}};
+}
+
+void FileSegment::releaseCache() noexcept {
+    if (_cache_released || !_f) {
+        return;
+    }
+    _f->advise(filesystem::AccessHint::DontNeed, 0U, 0U);
+    _cache_released = _synced_total_bytes >= _total_bytes;
+}
+
+void FileSegment::readAhead(const uint32_t offset) const noexcept {
+    // Ask for the next window once the reader is half way through the current one, so that it never has to wait
+    if ((offset + (READ_AHEAD_BYTES / 2U)) < _read_ahead_end) {
+        return;
+    }
+    const auto begin = std::max(offset, _read_ahead_end);
+    _read_ahead_end = offset + READ_AHEAD_BYTES;
+    _f->advise(filesystem::AccessHint::WillNeed, begin, _read_ahead_end - begin);
+}
+
+filesystem::FileError FileSegment::seal() noexcept {
+    const auto e = writeFrame();
+    if (!e.ok()) {
+        return e;
+    }
+    // Nothing more is appended to a sealed segment
+    _chunk_buffer = common::OwnedSlice{};
+    return flush(false);
+}
+
+StreamError FileSegment::loadFrame(const uint32_t offset, const uint32_t body_length) const noexcept {
+    if (_cached_frame_offset == offset) {
+        return StreamError{StreamErrorCode::NoError, {}};
+    }
+    _cached_frame_offset = UINT32_MAX;
+
+    auto frame_or = _f->read(offset, offset + FRAME_HEADER_SIZE + body_length);
+    if (!frame_or.ok()) {
+        return StreamError{StreamErrorCode::ReadError, frame_or.err().msg};
+    }
+    auto frame = std::move(frame_or.val());
+    const FrameHeader header = convertSliceToFrameHeader(common::BorrowedSlice{frame.data(), frame.size()});
+    if (!frameHeaderIsValid(header) || (static_cast<uint32_t>(header.body_length_bytes) != body_length)) {
+        return StreamError{StreamErrorCode::HeaderDataCorrupted, {}};
+    }
+
+    const auto *const body = static_cast<const uint8_t *>(frame.data()) + FRAME_HEADER_SIZE;
+    FrameHeader crc_header{};
+    // coverity[autosar_cpp14_a12_0_2_violation] Use memcpy instead of reinterpret cast to avoid UB.
+    std::ignore = memcpy(&crc_header, frame.data(), sizeof(FrameHeader));
+    crc_header.crc = 0;
+    _cached_frame_crc_ok = static_cast<uint32_t>(header.crc) ==
+                           store::common::crc32::crc32_of({common::BorrowedSlice{&crc_header, sizeof(crc_header)},
+                                                           common::BorrowedSlice{body, body_length}});
+
+    if (!decodeFrameBody(body, body_length, header, _base_seq_num, _cached_frame_records)) {
+        return StreamError{_cached_frame_crc_ok ? StreamErrorCode::HeaderDataCorrupted
+                                                : StreamErrorCode::RecordDataCorrupted,
+                           {}};
+    }
+    _cached_frame_body = std::move(frame);
+    _cached_frame_offset = offset;
+    return StreamError{StreamErrorCode::NoError, {}};
+}
+
+common::Expected<OwnedRecord, StreamError>
+FileSegment::readFromRecords(const std::vector<detail::BatchedFrameRecord> &records, const uint8_t *body,
+                             const uint64_t sequence_number, const bool may_return_later_records,
+                             const uint32_t frame_offset, const uint32_t next_frame_offset) const noexcept {
+    const auto record = std::lower_bound(
+        records.cbegin(), records.cend(), sequence_number,
+        [](const detail::BatchedFrameRecord &r, const uint64_t seq) { return r.sequence_number < seq; });
+    if ((record == records.cend()) || ((record->sequence_number != sequence_number) && !may_return_later_records)) {
+        return StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
+    }
+
+    // Iterators suggest offset + data size as the start of their next read. Point that at the start of this frame so
+    // the next record comes from the frame we already have, or at the next frame once this one is used up.
+    // The subtraction may wrap around, which is undone again by the iterator's addition.
+    const auto next_read = (std::next(record) == records.cend()) ? next_frame_offset : frame_offset;
+    return OwnedRecord{
+        common::OwnedSlice{common::BorrowedSlice{body + record->offset, record->length}, _buffer_pool},
+        record->timestamp,
+        record->sequence_number,
+        next_read - record->length,
+    };
 }
 
 common::Expected<OwnedRecord, StreamError> FileSegment::read(const uint64_t sequence_number,
                                                              const ReadOptions &read_options) const noexcept {
+    return readRecord(sequence_number, read_options, nullptr);
+}
+
+common::Expected<OwnedRecord, StreamError> FileSegment::readChunked(const uint64_t sequence_number,
+                                                                    const ReadOptions &read_options,
+                                                                    detail::ChunkedRead &chunked) const noexcept {
+    auto record_or = readRecord(sequence_number, read_options, &chunked);
+    if (record_or.ok() && (chunked.file == nullptr)) {
+        // Records from batched frames and compressed segments are decoded into memory
+        chunked.length = record_or.val().data.size();
+    }
+    return record_or;
+}
+
+common::Expected<OwnedRecord, StreamError> FileSegment::readRecord(const uint64_t sequence_number,
+                                                                   const ReadOptions &read_options,
+                                                                   detail::ChunkedRead *chunked) const noexcept {
     // We will try to find the record by reading the segment starting at the offset.
     // If a suggested starting position within the segment was suggested to us, we start from further into the file.
     // If any error occurs with the suggested starting point, we will restart from the beginning of the file.
     // Any failures during reading without a suggested started point are raised immediately.
 
-    auto offset = read_options.suggested_start;
-    auto suggested_start = offset != 0U;
+    // Records waiting for their frame are only in memory. Their next read should also come from memory, so point the
+    // iterator at the end of the file.
+    const auto file_bytes = _total_bytes - pendingFrameBytes();
+    const auto read_pending = [&]() {
+        return readFromRecords(_frame_records, _frame_body.data(), sequence_number,
+                               read_options.may_return_later_records, file_bytes, file_bytes);
+    };
+    if (!_frame_records.empty() && (sequence_number >= _frame_records.front().sequence_number)) {
+        return read_pending();
+    }
+
+    // Compressed segments can start from the block holding the record instead of from the beginning of the file
+    const auto restart_offset =
+        (_compressed != nullptr) ? _compressed->startOffsetFor(static_cast<int32_t>(sequence_number - _base_seq_num))
+                                 : 0U;
+    auto suggested_start = read_options.suggested_start != 0U;
+    auto offset = suggested_start ? read_options.suggested_start : restart_offset;
 
+    uint8_t header_data[LOG_ENTRY_HEADER_SIZE];
     while (true) {
-        auto header_data_or = _f->read(offset, offset + LOG_ENTRY_HEADER_SIZE);
-        if (!header_data_or.ok()) {
+        const auto header_e = _f->readInto(offset, header_data, LOG_ENTRY_HEADER_SIZE);
+        if (!header_e.ok()) {
             if (suggested_start) {
-                offset = 0U;
+                offset = restart_offset;
                 suggested_start = false;
                 continue;
             }
-            if (header_data_or.err().code == filesystem::FileErrorCode::EndOfFile) {
+            if (header_e.code == filesystem::FileErrorCode::EndOfFile) {
+                if (read_options.may_return_later_records && !_frame_records.empty()) {
+                    return read_pending();
+                }
                 return StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
             }
-            return StreamError{StreamErrorCode::ReadError, header_data_or.err().msg};
+            return StreamError{StreamErrorCode::ReadError, header_e.msg};
+        }
+        const auto header_slice = common::BorrowedSlice{header_data, LOG_ENTRY_HEADER_SIZE};
+        const LogEntryHeader header = convertSliceToHeader(header_slice);
+
+        const auto rel = sequence_number - _base_seq_num;
+        const auto expected_rel_seq_num = static_cast<int32_t>(rel);
+
+        if (header.magic_and_version == FRAME_MAGIC_AND_VERSION) {
+            const FrameHeader frame = convertSliceToFrameHeader(header_slice);
+            if (suggested_start && (frame.base_relative_sequence_number > expected_rel_seq_num)) {
+                offset = restart_offset;
+                suggested_start = false;
+                continue;
+            }
+            if ((frame.base_relative_sequence_number > expected_rel_seq_num) &&
+                (!read_options.may_return_later_records)) {
+                return StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
+            }
+
+            const auto body_length = static_cast<std::uint32_t>(frame.body_length_bytes);
+            const auto next_offset = offset + FRAME_HEADER_SIZE + body_length;
+            // Frames which end before the record we want are skipped using only their header
+            if (frame.last_relative_sequence_number < expected_rel_seq_num) {
+                offset = next_offset;
+                continue;
+            }
+
+            readAhead(offset);
+            const auto err = loadFrame(offset, body_length);
+            if (!err.ok()) {
+                return err;
+            }
+            if (read_options.check_for_corruption && !_cached_frame_crc_ok) {
+                return StreamError{StreamErrorCode::RecordDataCorrupted, {}};
+            }
+            return readFromRecords(_cached_frame_records,
+                                   static_cast<const uint8_t *>(_cached_frame_body.data()) + FRAME_HEADER_SIZE,
+                                   sequence_number, read_options.may_return_later_records, offset, next_offset);
+        }
+
+        // The suggested start is only a hint (it may come from a different segment or stream tier), so if it does not
+        // point at a header at or before the record we want, restart from the beginning of the file.
+        if (suggested_start && ((header.magic_and_version != MAGIC_AND_VERSION) ||
+                                (header.relative_sequence_number > expected_rel_seq_num))) {
+            offset = restart_offset;
+            suggested_start = false;
+            continue;
         }
-        const LogEntryHeader header = convertSliceToHeader(header_data_or.val());
 
         if (header.magic_and_version != MAGIC_AND_VERSION) {
             return StreamError{StreamErrorCode::HeaderDataCorrupted, {}};
         }
 
-        const auto rel = sequence_number - _base_seq_num;
-        const auto expected_rel_seq_num = static_cast<int32_t>(rel);
-
         // If the record we read is after the one we wanted, and we're not allowed to return later records, we must fail
         if ((header.relative_sequence_number > expected_rel_seq_num) && (!read_options.may_return_later_records)) {
             return StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
@@ -301,13 +1185,19 @@ common::Expected<OwnedRecord, StreamError> FileSegment::read(const uint64_t sequ
         // We found the one we want, or the next available sequence number was acceptable to us
         if ((header.relative_sequence_number == expected_rel_seq_num) ||
             ((header.relative_sequence_number > expected_rel_seq_num) && read_options.may_return_later_records)) {
-            auto data_or =
-                _f->read(offset + LOG_ENTRY_HEADER_SIZE,
-                         offset + LOG_ENTRY_HEADER_SIZE + static_cast<std::uint32_t>(header.payload_length_bytes));
-            if (!data_or.ok()) {
-                return StreamError{StreamErrorCode::ReadError, header_data_or.err().msg};
+            readAhead(offset);
+            if ((chunked != nullptr) && (_compressed == nullptr)) {
+                chunked->file = _f;
+                chunked->length = static_cast<std::uint32_t>(header.payload_length_bytes);
+                chunked->crc = header.crc;
+                return OwnedRecord{common::OwnedSlice{}, header.timestamp, sequence_number,
+                                   offset + LOG_ENTRY_HEADER_SIZE};
+            }
+            auto data = common::OwnedSlice{static_cast<std::uint32_t>(header.payload_length_bytes), _buffer_pool};
+            const auto data_e = _f->readInto(offset + LOG_ENTRY_HEADER_SIZE, data.data(), data.size());
+            if (!data_e.ok()) {
+                return StreamError{StreamErrorCode::ReadError, data_e.msg};
             }
-            auto data = std::move(data_or.val());
             const auto data_len_swap =
                 static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(header.payload_length_bytes)));
             const auto ts_swap = static_cast<int64_t>(my_htonll(static_cast<std::uint64_t>(header.timestamp)));
@@ -333,12 +1223,353 @@ common::Expected<OwnedRecord, StreamError> FileSegment::read(const uint64_t sequ
     }
 }
 
+StreamError detail::readInChunks(const ChunkedRead &chunked, const OwnedRecord &record, uint8_t *buffer,
+                                 const uint32_t buffer_size, const RecordConsumer &consumer,
+                                 const bool check_for_corruption) noexcept {
+    const auto length = chunked.length;
+    if ((buffer_size == 0U) && (length > 0U)) {
+        return StreamError{StreamErrorCode::InvalidArguments, "Buffer cannot be empty"};
+    }
+    const auto data_len_swap = static_cast<int32_t>(my_htonl(length));
+    const auto ts_swap = static_cast<int64_t>(my_htonll(static_cast<std::uint64_t>(record.timestamp)));
+    auto crc32 = store::common::crc32::crc32_of({common::BorrowedSlice{&ts_swap, sizeof(ts_swap)},
+                                                 common::BorrowedSlice{&data_len_swap, sizeof(data_len_swap)}});
+
+    uint32_t position = 0U;
+    while (position < length) {
+        const auto n = std::min(length - position, buffer_size);
+        const auto e = chunked.file->readInto(record.offset + position, buffer, n);
+        if (!e.ok()) {
+            return StreamError{StreamErrorCode::ReadError, e.msg};
+        }
+        if (check_for_corruption) {
+            crc32 = store::common::crc32::update(crc32, buffer, n);
+        }
+        const auto err = consumer(common::BorrowedSlice{buffer, n});
+        if (!err.ok()) {
+            return err;
+        }
+        position += n;
+    }
+
+    if (check_for_corruption && (chunked.crc != static_cast<int64_t>(crc32))) {
+        return StreamError{StreamErrorCode::RecordDataCorrupted, {}};
+    }
+    return StreamError{StreamErrorCode::NoError, {}};
+}
+
+common::Expected<std::unique_ptr<filesystem::FileLike>, filesystem::FileError>
+FileSegment::openReader() const noexcept {
+    return _file_implementation->open(_segment_id);
+}
+
+StreamError FileSegment::openCompressed(std::shared_ptr<const CompressionCodec> codec,
+                                        const bool full_corruption_check_on_open) noexcept {
+    return openCompressedFile(segmentIdentifier(_base_seq_num, CompressedSegmentSuffix), std::move(codec),
+                              full_corruption_check_on_open);
+}
+
+StreamError FileSegment::openCompressedFile(const std::string &compressed_id,
+                                            std::shared_ptr<const CompressionCodec> codec,
+                                            const bool full_corruption_check_on_open) noexcept {
+    auto file_or = _file_implementation->open(compressed_id);
+    if (!file_or.ok()) {
+        return StreamError{StreamErrorCode::ReadError, file_or.err().msg};
+    }
+    auto f = std::move(file_or.val());
+
+    const auto warn = [this, &compressed_id](const std::string &message) {
+        logging::log(_logger, logging::LogLevel::Warning, compressed_id, " ", message);
+    };
+    // Counted like the truncations of uncompressed segments
+    const auto truncate_to = [this, &f, &warn](const uint32_t length, const std::string &message) {
+        warn(message);
+        std::ignore = f->truncate(length);
+        if (_counters != nullptr) {
+            _counters->corruption_truncations.add();
+        }
+    };
+
+    uint32_t offset = sizeof(CompressedSegmentHeader);
+    CompressedSegmentHeader header{};
+    if (!f->readInto(0U, &header, sizeof(header)).ok()) {
+        header = CompressedSegmentHeader{};
+    }
+    if (static_cast<int32_t>(my_ntohl(static_cast<std::uint32_t>(header.magic_and_version))) !=
+        COMPRESSED_SEGMENT_MAGIC_AND_VERSION) {
+        // Compressed segments are only put in place once completely written, so there is nothing to recover.
+        warn("has no valid header and is treated as empty");
+        offset = 0U;
+    }
+    const auto codec_id = static_cast<int32_t>(my_ntohl(static_cast<std::uint32_t>(header.codec_id)));
+    if ((offset != 0U) && (!codec || (static_cast<int32_t>(codec->id()) != codec_id))) {
+        if (codec_id != static_cast<int32_t>(Lz77Codec::ID)) {
+            return StreamError{StreamErrorCode::ReadError,
+                               compressed_id + " is compressed with unknown codec " + std::to_string(codec_id)};
+        }
+        codec = std::make_shared<const Lz77Codec>();
+    }
+
+    std::vector<detail::CompressedSegmentBlock> blocks;
+    std::vector<uint8_t> scratch;
+    uint32_t uncompressed = 0U;
+    while (offset != 0U) {
+        CompressedBlockHeader raw{};
+        const auto block_header_e = f->readInto(offset, &raw, sizeof(CompressedBlockHeader));
+        if (!block_header_e.ok()) {
+            if (block_header_e.code != filesystem::FileErrorCode::EndOfFile) {
+                truncate_to(offset, "is truncated because " + block_header_e.msg);
+            }
+            break;
+        }
+        const auto crc = my_ntohl(static_cast<std::uint32_t>(raw.crc));
+        raw.crc = 0;
+        const auto block = detail::CompressedSegmentBlock{
+            uncompressed,
+            my_ntohl(static_cast<std::uint32_t>(raw.uncompressed_length_bytes)),
+            offset + static_cast<uint32_t>(sizeof(CompressedBlockHeader)),
+            my_ntohl(static_cast<std::uint32_t>(raw.stored_length_bytes)),
+            static_cast<int32_t>(my_ntohl(static_cast<std::uint32_t>(raw.last_relative_sequence_number))),
+            store::common::crc32::crc32_of({common::BorrowedSlice{&raw, sizeof(raw)}}),
+            crc,
+        };
+        const auto first_rel =
+            static_cast<int32_t>(my_ntohl(static_cast<std::uint32_t>(raw.first_relative_sequence_number)));
+        const auto block_end = static_cast<uint64_t>(block.file_offset) + block.stored_length;
+
+        auto valid = (static_cast<int32_t>(my_ntohl(static_cast<std::uint32_t>(raw.magic))) ==
+                      COMPRESSED_BLOCK_MAGIC) &&
+                     (first_rel >= 0) && (block.last_relative_sequence_number >= first_rel) &&
+                     (block.stored_length <= block.uncompressed_length) && (block.uncompressed_length > 0U) &&
+                     (block_end <= UINT32_MAX) &&
+                     ((static_cast<uint64_t>(uncompressed) + block.uncompressed_length) <= UINT32_MAX);
+        if (valid && full_corruption_check_on_open) {
+            valid = detail::CompressedSegmentFile::readBlock(*f, *codec, block, scratch).ok();
+        } else if (valid && (block.stored_length > 0U)) {
+            // Without reading the whole block, at least make sure that all of it is in the file.
+            uint8_t last_byte{};
+            valid = f->readInto(static_cast<uint32_t>(block_end) - 1U, &last_byte, 1U).ok();
+        }
+        if (!valid) {
+            truncate_to(offset,
+                        "is truncated to a length of " + std::to_string(offset) + " because a block is corrupted");
+            break;
+        }
+
+        blocks.push_back(block);
+        offset = static_cast<uint32_t>(block_end);
+        uncompressed += block.uncompressed_length;
+        _highest_seq_num = std::max(_highest_seq_num,
+                                    _base_seq_num + static_cast<std::uint64_t>(block.last_relative_sequence_number));
+        _latest_timestamp_ms = std::max(
+            _latest_timestamp_ms, static_cast<int64_t>(my_ntohll(static_cast<std::uint64_t>(raw.latest_timestamp))));
+    }
+
+    _compressed_size_bytes = std::max(offset, static_cast<uint32_t>(sizeof(CompressedSegmentHeader)));
+    _total_bytes = uncompressed;
+    _flushed_total_bytes = _total_bytes;
+    _flushed_highest_seq_num = _highest_seq_num;
+    _flushed_latest_timestamp_ms = _latest_timestamp_ms;
+    _cached_frame_offset = UINT32_MAX;
+
+    auto compressed = std::unique_ptr<detail::CompressedSegmentFile>(
+        new detail::CompressedSegmentFile(std::move(f), std::move(codec), std::move(blocks)));
+    _compressed = compressed.get();
+    _f = std::move(compressed);
+    return StreamError{StreamErrorCode::NoError, {}};
+}
+
+StreamError FileSegment::writeCompressedCopy(filesystem::FileLike &source, filesystem::FileSystemInterface &fs,
+                                             const uint64_t base, const CompressionCodec &codec) noexcept {
+    const auto temporary_id = segmentIdentifier(base, CompressingSegmentSuffix);
+    // Start over if an earlier attempt was interrupted
+    std::ignore = fs.remove(temporary_id);
+    auto out_or = fs.open(temporary_id);
+    if (!out_or.ok()) {
+        return StreamError{StreamErrorCode::WriteError, out_or.err().msg};
+    }
+    auto &out = *out_or.val();
+
+    const auto header = CompressedSegmentHeader{
+        static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(COMPRESSED_SEGMENT_MAGIC_AND_VERSION))),
+        static_cast<int32_t>(my_htonl(codec.id())),
+    };
+    auto e = out.append(common::BorrowedSlice{&header, sizeof(header)});
+    if (!e.ok()) {
+        return compressionFileErrorToStreamError(e);
+    }
+
+    uint32_t offset = 0U;
+    uint32_t block_start = 0U;
+    int32_t first_rel = 0;
+    int32_t last_rel = 0;
+    int64_t latest_timestamp = 0;
+    std::vector<uint8_t> compressed;
+    const auto write_block = [&]() -> filesystem::FileError {
+        auto data_or = source.read(block_start, offset);
+        if (!data_or.ok()) {
+            return data_or.err();
+        }
+        const auto data = std::move(data_or.val());
+        compressed.clear();
+        codec.compress(common::BorrowedSlice{data.data(), data.size()}, compressed);
+        const auto compressed_size = static_cast<std::uint32_t>(compressed.size());
+        const auto stored = (compressed_size < data.size()) ? common::BorrowedSlice{compressed.data(), compressed_size}
+                                                            : common::BorrowedSlice{data.data(), data.size()};
+
+        auto block_header = CompressedBlockHeader{
+            static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(COMPRESSED_BLOCK_MAGIC))),
+            static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(first_rel))),
+            static_cast<int32_t>(my_htonl(static_cast<std::uint32_t>(last_rel))),
+            static_cast<int32_t>(my_htonl(data.size())),
+            static_cast<int32_t>(my_htonl(stored.size())),
+            0,
+            static_cast<int64_t>(my_htonll(static_cast<std::uint64_t>(latest_timestamp))),
+        };
+        block_header.crc = static_cast<int32_t>(my_htonl(
+            store::common::crc32::crc32_of({common::BorrowedSlice{&block_header, sizeof(block_header)}, stored})));
+        auto err = out.append(common::BorrowedSlice{&block_header, sizeof(block_header)});
+        if (err.ok()) {
+            err = out.append(stored);
+        }
+        block_start = offset;
+        latest_timestamp = 0;
+        return err;
+    };
+
+    uint8_t header_data[FRAME_HEADER_SIZE];
+    while (true) {
+        const auto header_e = source.readInto(offset, header_data, LOG_ENTRY_HEADER_SIZE);
+        if (!header_e.ok()) {
+            if (header_e.code == filesystem::FileErrorCode::EndOfFile) {
+                break;
+            }
+            return StreamError{StreamErrorCode::ReadError, header_e.msg};
+        }
+        const LogEntryHeader entry = convertSliceToHeader(common::BorrowedSlice{header_data, LOG_ENTRY_HEADER_SIZE});
+
+        int32_t entry_first_rel = 0;
+        int32_t entry_last_rel = 0;
+        int64_t entry_timestamp = 0;
+        uint32_t entry_length = 0U;
+        if (entry.magic_and_version == FRAME_MAGIC_AND_VERSION) {
+            const auto frame_e = source.readInto(offset + LOG_ENTRY_HEADER_SIZE, header_data + LOG_ENTRY_HEADER_SIZE,
+                                                 FRAME_HEADER_SIZE - LOG_ENTRY_HEADER_SIZE);
+            if (!frame_e.ok()) {
+                return StreamError{StreamErrorCode::HeaderDataCorrupted, frame_e.msg};
+            }
+            const FrameHeader frame = convertSliceToFrameHeader(common::BorrowedSlice{header_data, FRAME_HEADER_SIZE});
+            if (!frameHeaderIsValid(frame)) {
+                return StreamError{StreamErrorCode::HeaderDataCorrupted, {}};
+            }
+            entry_first_rel = frame.base_relative_sequence_number;
+            entry_last_rel = frame.last_relative_sequence_number;
+            entry_timestamp = frame.last_timestamp;
+            entry_length = FRAME_HEADER_SIZE + static_cast<uint32_t>(frame.body_length_bytes);
+        } else if (entry.magic_and_version == MAGIC_AND_VERSION) {
+            entry_first_rel = entry.relative_sequence_number;
+            entry_last_rel = entry.relative_sequence_number;
+            entry_timestamp = entry.timestamp;
+            entry_length = LOG_ENTRY_HEADER_SIZE + static_cast<uint32_t>(entry.payload_length_bytes);
+        } else {
+            return StreamError{StreamErrorCode::HeaderDataCorrupted, {}};
+        }
+
+        if (offset == block_start) {
+            first_rel = entry_first_rel;
+        }
+        last_rel = entry_last_rel;
+        latest_timestamp = std::max(latest_timestamp, entry_timestamp);
+        offset += entry_length;
+
+        if ((offset - block_start) >= COMPRESSED_BLOCK_TARGET_BYTES) {
+            e = write_block();
+            if (!e.ok()) {
+                return compressionFileErrorToStreamError(e);
+            }
+        }
+    }
+    if (offset > block_start) {
+        e = write_block();
+        if (!e.ok()) {
+            return compressionFileErrorToStreamError(e);
+        }
+    }
+
+    e = out.flush();
+    if (!e.ok()) {
+        return compressionFileErrorToStreamError(e);
+    }
+    out.sync();
+    return StreamError{StreamErrorCode::NoError, {}};
+}
+
+StreamError FileSegment::verifyCompressedCopy(std::shared_ptr<filesystem::FileSystemInterface> fs,
+                                              std::shared_ptr<logging::Logger> logger, const uint64_t base,
+                                              std::shared_ptr<const CompressionCodec> codec,
+                                              const uint64_t highest_seq_num, const uint32_t total_bytes) noexcept {
+    FileSegment copy{base, std::move(fs), std::move(logger)};
+    auto err = copy.openCompressedFile(segmentIdentifier(base, CompressingSegmentSuffix), std::move(codec), true);
+    if (err.ok() && ((copy.getHighestSeqNum() != highest_seq_num) || (copy._total_bytes != total_bytes))) {
+        err = StreamError{StreamErrorCode::HeaderDataCorrupted, "Compressed segment does not match"};
+    }
+    return err;
+}
+
+StreamError FileSegment::useCompressedCopy(std::shared_ptr<const CompressionCodec> codec) noexcept {
+    const auto compressed_id = segmentIdentifier(_base_seq_num, CompressedSegmentSuffix);
+    const auto e =
+        _file_implementation->rename(segmentIdentifier(_base_seq_num, CompressingSegmentSuffix), compressed_id);
+    if (!e.ok()) {
+        return StreamError{StreamErrorCode::WriteError, e.msg};
+    }
+
+    auto err = StreamError{StreamErrorCode::NoError, {}};
+    {
+        FileSegment compressed{_base_seq_num, _file_implementation, _logger, _batched_record_frames, _buffer_pool,
+                               _counters};
+        // Every block was checked by verifyCompressedCopy(), so only make sure that this is still the same file
+        err = compressed.openCompressed(std::move(codec), false);
+        if (err.ok() &&
+            ((compressed.getHighestSeqNum() != _highest_seq_num) || (compressed._total_bytes != _total_bytes))) {
+            err = StreamError{StreamErrorCode::HeaderDataCorrupted, "Compressed segment does not match"};
+        }
+        if (err.ok()) {
+            // From now on the compressed copy is used, even if removing the original fails. Opening the stream again
+            // will prefer the compressed copy too.
+            _f.reset();
+            const auto remove_err = _file_implementation->remove(_segment_id);
+            if (!remove_err.ok()) {
+                logging::log(_logger, logging::LogLevel::Warning, "Issue deleting ", _segment_id, " due to: ",
+                             remove_err.msg);
+            }
+            *this = std::move(compressed);
+            return err;
+        }
+    }
+
+    // The copy is closed by now. It is removed by name, since remove() would take a segment whose compressed file
+    // failed to open for the original.
+    const auto remove_err = _file_implementation->remove(compressed_id);
+    if (!remove_err.ok()) {
+        logging::log(_logger, logging::LogLevel::Warning, "Issue deleting ", compressed_id, " due to: ",
+                     remove_err.msg);
+    }
+    return err;
+}
+
+void FileSegment::removeCompressedCopy(filesystem::FileSystemInterface &fs, const uint64_t base) noexcept {
+    std::ignore = fs.remove(segmentIdentifier(base, CompressingSegmentSuffix));
+}
+
 void FileSegment::remove() noexcept {
     // Close file handle, then delete file
+    const auto id = (_compressed != nullptr) ? segmentIdentifier(_base_seq_num, CompressedSegmentSuffix) : _segment_id;
     _f.reset();
-    const auto e = _file_implementation->remove(_segment_id);
-    if ((!e.ok()) && (_logger->level <= logging::LogLevel::Warning)) {
-        _logger->log(logging::LogLevel::Warning, "Issue deleting " + _segment_id + " due to: " + e.msg);
+    _compressed = nullptr;
+    const auto e = _file_implementation->remove(id);
+    if (!e.ok()) {
+        logging::log(_logger, logging::LogLevel::Warning, "Issue deleting ", id, " due to: ", e.msg);
     }
 }
 } // namespace stream
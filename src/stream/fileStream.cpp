@@ -4,10 +4,12 @@
 #include <algorithm>
 #include <atomic>
 #include <aws/store/common/expected.hpp>
+#include <aws/store/common/metrics.hpp>
 #include <aws/store/common/slices.hpp>
 #include <aws/store/common/util.hpp>
 #include <aws/store/filesystem/filesystem.hpp>
 #include <aws/store/kv/kv.hpp>
+#include <aws/store/stream/compression.hpp>
 #include <aws/store/stream/fileStream.hpp>
 #include <aws/store/stream/stream.hpp>
 #include <cerrno>
@@ -17,7 +19,9 @@
 #include <iterator>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -33,9 +37,30 @@ common::Expected<std::shared_ptr<FileStream>, StreamError> FileStream::openOrCre
     if (!err.ok()) {
         return err;
     }
+
+    if (stream->_opts.segment_compression_codec) {
+        // Every segment but the one we're appending to is sealed and can be compressed
+        for (size_t i = 0U; (i + 1U) < stream->_segments.size(); i++) {
+            if (!stream->_segments[i].isCompressed()) {
+                stream->_segments_to_compress.push_back(stream->_segments[i].getBaseSeqNum());
+            }
+        }
+        stream->_compressor = std::thread{&FileStream::compressionLoop, stream.get()};
+    }
     return stream;
 }
 
+FileStream::~FileStream() {
+    {
+        std::lock_guard<std::mutex> lock(_segments_lock);
+        _closing = true;
+    }
+    _compression_cv.notify_all();
+    if (_compressor.joinable()) {
+        _compressor.join();
+    }
+}
+
 static constexpr int BASE_10 = 10;
 
 static StreamError kvErrorToStreamError(const kv::KVError &kv_err) noexcept {
@@ -80,7 +105,17 @@ StreamError FileStream::loadExistingSegments() noexcept {
     }
 
     auto files = std::move(files_or.val());
+    const std::set<std::string> file_set{files.cbegin(), files.cend()};
+    const auto has_suffix = [](const std::string &f, const std::string &suffix) {
+        return (f.size() > suffix.size()) && (f.compare(f.size() - suffix.size(), suffix.size(), suffix) == 0);
+    };
     for (const auto &f : files) {
+        if (has_suffix(f, CompressingSegmentSuffix)) {
+            // Left behind when compressing a segment was interrupted
+            std::ignore = _opts.file_implementation->remove(f);
+            continue;
+        }
+        const auto compressed = has_suffix(f, CompressedSegmentSuffix);
         auto idx = f.rfind(".log");
         if (idx != std::string::npos) {
             char *end_ptr = nullptr; // NOLINT(cppcoreguidelines-pro-type-vararg)
@@ -94,8 +129,16 @@ StreamError FileStream::loadExistingSegments() noexcept {
             if (((base == 0U) && (end_ptr == f.c_str())) || (errno != 0)) {
                 continue;
             }
-            FileSegment segment{base, _opts.file_implementation, _opts.logger};
-            auto err = segment.open(_opts.full_corruption_check_on_open);
+            if (!compressed && (file_set.count(f + "z") != 0U)) {
+                // The segment was compressed, but removing the uncompressed file was interrupted
+                std::ignore = _opts.file_implementation->remove(f);
+                continue;
+            }
+            FileSegment segment{base, _opts.file_implementation, _opts.logger, _opts.batched_record_frames,
+                                _opts.buffer_pool, &_counters};
+            auto err = compressed ? segment.openCompressed(_opts.segment_compression_codec,
+                                                           _opts.full_corruption_check_on_open)
+                                  : segment.open(_opts.full_corruption_check_on_open);
             if (!err.ok()) {
                 return err;
             }
@@ -109,18 +152,36 @@ StreamError FileStream::loadExistingSegments() noexcept {
     if (!_segments.empty()) {
         _next_sequence_number = _segments.back().getHighestSeqNum() + 1U;
         _first_sequence_number = _segments.front().getBaseSeqNum();
-        uint64_t size = 0U;
-        for (const auto &s : _segments) {
-            size += s.totalSizeBytes();
-        }
-        _current_size_bytes = size;
+        updateCurrentSizeBytes();
     }
 
     return StreamError{StreamErrorCode::NoError, {}};
 }
 
+void FileStream::updateCurrentSizeBytes() noexcept {
+    uint64_t size = 0U;
+    for (const auto &s : _segments) {
+        size += s.totalSizeBytes();
+    }
+    _current_size_bytes = size;
+}
+
 StreamError FileStream::makeNextSegment() noexcept {
-    FileSegment segment{_next_sequence_number, _opts.file_implementation, _opts.logger};
+    if (!_segments.empty() && !_segments.back().isCompressed()) {
+        // Write out any frame which the current segment is still holding, so that it is complete once we move on.
+        const auto e = _segments.back().seal();
+        if (!e.ok()) {
+            updateCurrentSizeBytes();
+            return fileErrorToStreamError(e);
+        }
+        if (_compressor.joinable()) {
+            _segments_to_compress.push_back(_segments.back().getBaseSeqNum());
+            _compression_cv.notify_one();
+        }
+    }
+
+    FileSegment segment{_next_sequence_number, _opts.file_implementation, _opts.logger, _opts.batched_record_frames,
+                        _opts.buffer_pool, &_counters};
 
     auto err = segment.open(_opts.full_corruption_check_on_open);
     if (!err.ok()) {
@@ -128,42 +189,264 @@ StreamError FileStream::makeNextSegment() noexcept {
     }
 
     _segments.push_back(std::move(segment));
+    _counters.segments_created.add();
     return StreamError{StreamErrorCode::NoError, {}};
 }
 
+bool FileStream::needsNewSegment() const noexcept {
+    // Compressed segments are read only
+    return _segments.empty() || _segments.back().isCompressed() ||
+           (_segments.back().totalSizeBytes() >= _opts.minimum_segment_size_bytes);
+}
+
+void FileStream::compressionLoop() noexcept {
+    std::unique_lock<std::mutex> lock(_segments_lock);
+    const auto find_segment = [this](const uint64_t base) {
+        return std::find_if(_segments.begin(), _segments.end(),
+                            [base](const FileSegment &s) { return s.getBaseSeqNum() == base; });
+    };
+
+    while (true) {
+        _compression_cv.wait(lock, [this]() { return _closing || !_segments_to_compress.empty(); });
+        if (_closing) {
+            return;
+        }
+        const auto base = _segments_to_compress.front();
+        std::ignore = _segments_to_compress.erase(_segments_to_compress.begin());
+
+        auto seg = find_segment(base);
+        if ((seg == _segments.end()) || seg->isCompressed()) {
+            continue;
+        }
+        // Open the segment while we hold the lock, so that it cannot be removed in the meantime. Compressing only
+        // reads the sealed file, so the lock is released while doing so.
+        auto reader_or = seg->openReader();
+        if (!reader_or.ok()) {
+            continue;
+        }
+        auto reader = std::move(reader_or.val());
+        const auto highest_seq_num = seg->getHighestSeqNum();
+        const auto total_bytes = seg->totalSizeBytes();
+        lock.unlock();
+        auto err = FileSegment::writeCompressedCopy(*reader, *_opts.file_implementation, base,
+                                                    *_opts.segment_compression_codec);
+        reader.reset();
+        // Decompressing the whole copy to check it is as slow as writing it, so it isn't done under the lock either
+        if (err.ok()) {
+            err = FileSegment::verifyCompressedCopy(_opts.file_implementation, _opts.logger, base,
+                                                    _opts.segment_compression_codec, highest_seq_num, total_bytes);
+        }
+        lock.lock();
+
+        // The segment may have been removed while we were compressing it
+        seg = find_segment(base);
+        if (err.ok() && (seg != _segments.end())) {
+            err = seg->useCompressedCopy(_opts.segment_compression_codec);
+        }
+        if (!err.ok() || (seg == _segments.end())) {
+            FileSegment::removeCompressedCopy(*_opts.file_implementation, base);
+        }
+        if (!err.ok()) {
+            logging::log(_opts.logger, logging::LogLevel::Warning, "Unable to compress segment ", base, " due to: ",
+                         err.msg);
+        }
+        updateCurrentSizeBytes();
+    }
+}
+
 common::Expected<uint64_t, StreamError> FileStream::append(const common::BorrowedSlice d,
                                                            const AppendOptions &append_opts) noexcept {
+    return append(&d, 1U, append_opts);
+}
+
+common::Expected<uint64_t, StreamError> FileStream::append(const common::BorrowedSlice *parts, const size_t part_count,
+                                                           const AppendOptions &append_opts) noexcept {
+    uint64_t size = 0U;
+    for (size_t i = 0U; i < part_count; i++) {
+        size += parts[i].size();
+    }
+    if (size > UINT32_MAX) {
+        return StreamError{StreamErrorCode::RecordTooLarge, {}};
+    }
+
+    const common::ScopedTimer timer{_counters.append_latency};
+    std::lock_guard<std::mutex> append_lock(_append_lock);
     std::lock_guard<std::mutex> lock(_segments_lock);
 
-    auto err = removeSegmentsIfNewRecordBeyondMaxSize(d.size(), append_opts.remove_oldest_segments_if_full);
+    auto err = prepareToAppend(static_cast<uint32_t>(size), append_opts);
+    if (!err.ok()) {
+        return err;
+    }
+
+    // Now append the record into the last segment
+    auto &seg = _segments.back();
+    auto seq = _next_sequence_number.fetch_add(1U);
+
+    auto e = seg.append(parts, part_count, timestamp(), seq, append_opts.sync_on_append);
+    if (!e.ok()) {
+        // On failure, we expect the segment to not keep any partially written data. Earlier records which are still
+        // waiting for their frame are kept. There could be partly written data if the application dies before
+        // truncating, but we'll find that when we startup again later.
+        updateCurrentSizeBytes();
+        return fileErrorToStreamError(e.err());
+    }
+    _current_size_bytes += e.val();
+    _counters.appends.add();
+    _counters.appended_bytes.add(size);
+    if (append_opts.sync_on_append) {
+        releaseConsumedSegments();
+    }
+
+    return seq;
+}
+
+StreamError FileStream::prepareToAppend(const uint32_t record_size, const AppendOptions &append_opts) noexcept {
+    auto err = removeSegmentsIfNewRecordBeyondMaxSize(record_size, append_opts.remove_oldest_segments_if_full);
     if (!err.ok()) {
         return err;
     }
 
     // Check if we need a new segment because we don't have any, or the last segment is getting too big.
-    if (_segments.empty() || (_segments.back().totalSizeBytes() >= _opts.minimum_segment_size_bytes)) {
+    if (needsNewSegment()) {
         err = makeNextSegment();
-        if (!err.ok()) {
-            return err;
-        }
+    }
+    return err;
+}
+
+common::Expected<AppendReservation, StreamError> FileStream::reserve(const uint32_t size) noexcept {
+    if (size > (_opts.maximum_size_bytes - LOG_ENTRY_HEADER_SIZE)) {
+        return StreamError{StreamErrorCode::RecordTooLarge, {}};
+    }
+    auto buffer = common::OwnedSlice{LOG_ENTRY_HEADER_SIZE + size};
+    if (buffer.data() == nullptr) {
+        return StreamError{StreamErrorCode::RecordTooLarge, "Unable to allocate memory for the record"};
+    }
+    return AppendReservation{WEAK_FROM_THIS(), std::move(buffer), LOG_ENTRY_HEADER_SIZE};
+}
+
+common::Expected<uint64_t, StreamError> FileStream::commit(AppendReservation &&reservation,
+                                                           const AppendOptions &append_opts) noexcept {
+    auto r = std::move(reservation);
+    if (r.prefixBytes() != LOG_ENTRY_HEADER_SIZE) {
+        return StreamInterface::commit(std::move(r), append_opts);
+    }
+
+    const common::ScopedTimer timer{_counters.append_latency};
+    std::lock_guard<std::mutex> append_lock(_append_lock);
+    std::lock_guard<std::mutex> lock(_segments_lock);
+
+    auto err = prepareToAppend(r.size(), append_opts);
+    if (!err.ok()) {
+        return err;
     }
 
-    // Now append the record into the last segment
     auto &seg = _segments.back();
     auto seq = _next_sequence_number.fetch_add(1U);
 
-    auto e = seg.append(d, timestamp(), seq, append_opts.sync_on_append);
+    auto e = seg.appendStaged(r.buffer(), timestamp(), seq, append_opts.sync_on_append);
     if (!e.ok()) {
+        updateCurrentSizeBytes();
         return fileErrorToStreamError(e.err());
     }
-    // Only increment the size if successful. On failure, we expect the segment to not keep any partially written
-    // data. There could be partly written data if the application dies before truncating, but we'll find that
-    // when we startup again later.
     _current_size_bytes += e.val();
+    _counters.appends.add();
+    _counters.appended_bytes.add(r.size());
+    if (append_opts.sync_on_append) {
+        releaseConsumedSegments();
+    }
 
     return seq;
 }
 
+common::Expected<uint64_t, StreamError>
+FileStream::appendRecords(const std::vector<const OwnedRecord *> &records, const AppendOptions &append_opts,
+                          const bool write_frames) noexcept {
+    std::lock_guard<std::mutex> append_lock(_append_lock);
+    std::lock_guard<std::mutex> lock(_segments_lock);
+
+    // Records are appended to the active segment without flushing, and the segment is flushed once when the batch
+    // is complete or when we roll over to a new segment. This turns a batch into a few large sequential writes.
+    // If a flush fails, the records of this batch which are not in the file are dropped again.
+    uint64_t pending_records = 0U;
+    uint64_t pending_start = _next_sequence_number;
+    const auto flush_pending = [&]() -> StreamError {
+        if (pending_records == 0U) {
+            return StreamError{StreamErrorCode::NoError, {}};
+        }
+        auto &seg = _segments.back();
+        const auto e = seg.flush(append_opts.sync_on_append, write_frames);
+        if (!e.ok()) {
+            // The segment has dropped what it had not flushed, but keeps records which are waiting for their frame
+            // (including earlier ones which were already acknowledged). Give up on this batch's, and continue from
+            // whatever the segment still holds.
+            seg.dropFrameRecordsFrom(pending_start);
+            _next_sequence_number = ((seg.totalSizeBytes() > 0U) && (seg.getHighestSeqNum() >= pending_start))
+                                        ? (seg.getHighestSeqNum() + 1U)
+                                        : pending_start;
+            updateCurrentSizeBytes();
+            pending_records = 0U;
+            return fileErrorToStreamError(e);
+        }
+        pending_records = 0U;
+        pending_start = _next_sequence_number;
+        if (append_opts.sync_on_append) {
+            releaseConsumedSegments();
+        }
+        return StreamError{StreamErrorCode::NoError, {}};
+    };
+
+    for (const auto *record : records) {
+        if (record->sequence_number != _next_sequence_number) {
+            std::ignore = flush_pending();
+            return StreamError{StreamErrorCode::InvalidArguments,
+                               "Record sequence numbers must continue from the end of the stream"};
+        }
+
+        auto err = removeSegmentsIfNewRecordBeyondMaxSize(record->data.size(),
+                                                          append_opts.remove_oldest_segments_if_full);
+        if (!err.ok()) {
+            std::ignore = flush_pending();
+            return err;
+        }
+        if (_segments.empty()) {
+            // Everything was removed to make room, including any records pending in this batch.
+            pending_records = 0U;
+            pending_start = _next_sequence_number;
+        }
+
+        if (needsNewSegment()) {
+            err = flush_pending();
+            if (!err.ok()) {
+                return err;
+            }
+            err = makeNextSegment();
+            if (!err.ok()) {
+                return err;
+            }
+        }
+
+        auto e = _segments.back().appendUnflushed(
+            common::BorrowedSlice{record->data.data(), record->data.size()}, record->timestamp,
+            record->sequence_number);
+        if (!e.ok()) {
+            std::ignore = flush_pending();
+            updateCurrentSizeBytes();
+            return fileErrorToStreamError(e.err());
+        }
+        ++_next_sequence_number;
+        _current_size_bytes += e.val();
+        ++pending_records;
+        _counters.appends.add();
+        _counters.appended_bytes.add(record->data.size());
+    }
+
+    auto err = flush_pending();
+    if (!err.ok()) {
+        return err;
+    }
+    return static_cast<uint64_t>(records.size());
+}
+
 FileStream::FileStream(StreamOptions &&o) noexcept : _opts(std::move(o)) {
     _iterators.reserve(1U);
     const auto toReserve = 1U + (_opts.maximum_size_bytes - 1U) / _opts.minimum_segment_size_bytes;
@@ -198,6 +481,105 @@ common::Expected<uint64_t, StreamError> FileStream::append(common::OwnedSlice &&
 
 common::Expected<OwnedRecord, StreamError> FileStream::read(const uint64_t sequence_number,
                                                             const ReadOptions &provided_options) const noexcept {
+    const common::ScopedTimer timer{_counters.read_latency};
+    // The record is found while the lock is held and its data is read once the lock is released. Only a record which
+    // fails its CRC check may be skipped for a later one, and that has to be decided while the lock is held.
+    const auto read_unlocked = !(provided_options.check_for_corruption && provided_options.may_return_later_records);
+    auto located = detail::ChunkedRead{nullptr, 0U, 0};
+    auto record_or = readRecord(sequence_number, provided_options, read_unlocked ? &located : nullptr);
+    if (record_or.ok() && (located.file != nullptr)) {
+        auto &record = record_or.val();
+        record.data = common::OwnedSlice{located.length, _opts.buffer_pool};
+        const auto err = detail::readInChunks(
+            located, record, static_cast<uint8_t *>(record.data.data()), located.length,
+            [](const common::BorrowedSlice) { return StreamError{StreamErrorCode::NoError, {}}; },
+            provided_options.check_for_corruption);
+        if (!err.ok()) {
+            return err;
+        }
+    }
+    if (record_or.ok()) {
+        _counters.reads.add();
+        _counters.read_bytes.add(record_or.val().data.size());
+    }
+    return record_or;
+}
+
+common::Expected<RecordMetadata, StreamError> FileStream::readChunked(const uint64_t sequence_number,
+                                                                      uint8_t *buffer, const uint32_t buffer_size,
+                                                                      const RecordConsumer &consumer,
+                                                                      const ReadOptions &read_options) const noexcept {
+    const common::ScopedTimer timer{_counters.read_latency};
+    auto chunked = detail::ChunkedRead{nullptr, 0U, 0};
+    auto record_or = readRecord(sequence_number, read_options, &chunked);
+    if (!record_or.ok()) {
+        return record_or.err();
+    }
+    // The stream is no longer locked, so the consumer does not hold up anyone else and may use the stream itself
+    const auto &record = record_or.val();
+    const auto err = (chunked.file != nullptr)
+                         ? detail::readInChunks(chunked, record, buffer, buffer_size, consumer,
+                                                read_options.check_for_corruption)
+                         : detail::copyInChunks(common::BorrowedSlice{record.data.data(), record.data.size()},
+                                                buffer, buffer_size, consumer);
+    if (!err.ok()) {
+        return err;
+    }
+    _counters.reads.add();
+    _counters.read_bytes.add(chunked.length);
+    return RecordMetadata{record.offset, chunked.length, record.timestamp, record.sequence_number};
+}
+
+common::Expected<uint64_t, StreamError> FileStream::appendChunked(const uint32_t size, const RecordProducer &producer,
+                                                                  const AppendOptions &append_opts) noexcept {
+    const common::ScopedTimer timer{_counters.append_latency};
+    std::lock_guard<std::mutex> append_lock(_append_lock);
+    std::unique_lock<std::mutex> lock(_segments_lock);
+
+    auto err = prepareToAppend(size, append_opts);
+    if (!err.ok()) {
+        return err;
+    }
+
+    auto &seg = _segments.back();
+    // The sequence number is only given out once the record is complete, so readers do not look for it before then
+    const auto seq = _next_sequence_number.load();
+
+    auto producer_err = StreamError{StreamErrorCode::NoError, {}};
+    const RecordProducer record_producer = [&producer, &producer_err, &lock](uint8_t *buffer,
+                                                                             const uint32_t length) {
+        // Readers carry on while the producer runs. Other writers wait for the append lock, so seg stays where it is.
+        lock.unlock();
+        producer_err = producer(buffer, length);
+        lock.lock();
+        return producer_err;
+    };
+    auto e = seg.appendChunked(size, record_producer, timestamp(), seq, append_opts.sync_on_append);
+    if (!e.ok()) {
+        updateCurrentSizeBytes();
+        // A record which failed only to flush is kept by the segment. Otherwise its sequence number can be used again.
+        if ((seg.totalSizeBytes() > 0U) && (seg.getHighestSeqNum() >= seq)) {
+            _next_sequence_number = seq + 1U;
+        }
+        if (!producer_err.ok()) {
+            return producer_err;
+        }
+        return fileErrorToStreamError(e.err());
+    }
+    _next_sequence_number = seq + 1U;
+    _current_size_bytes += e.val();
+    _counters.appends.add();
+    _counters.appended_bytes.add(size);
+    if (append_opts.sync_on_append) {
+        releaseConsumedSegments();
+    }
+
+    return seq;
+}
+
+common::Expected<OwnedRecord, StreamError> FileStream::readRecord(const uint64_t sequence_number,
+                                                                  const ReadOptions &provided_options,
+                                                                  detail::ChunkedRead *chunked) const noexcept {
     if ((sequence_number < _first_sequence_number) || (sequence_number >= _next_sequence_number)) {
         return StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
     }
@@ -225,7 +607,8 @@ common::Expected<OwnedRecord, StreamError> FileStream::read(const uint64_t seque
         }
 
         if (have_exact_segment || (!find_exact)) {
-            auto val_or = seg.read(sequence_number, read_options);
+            auto val_or = (chunked != nullptr) ? seg.readChunked(sequence_number, read_options, *chunked)
+                                               : seg.read(sequence_number, read_options);
             if (val_or.ok()) {
                 return val_or;
             }
@@ -251,6 +634,7 @@ std::vector<FileSegment>::iterator FileStream::eraseSegment(std::vector<FileSegm
 
     // Remove from in-memory
     auto out = _segments.erase(segment);
+    _counters.segments_removed.add();
     if (_segments.empty()) {
         // use the next available sequence number
         _first_sequence_number = prev_highest_sequence_num + 1;
@@ -262,6 +646,7 @@ std::vector<FileSegment>::iterator FileStream::eraseSegment(std::vector<FileSegm
 }
 
 uint64_t FileStream::removeOlderRecords(const int64_t older_than_timestamp_ms) noexcept {
+    std::lock_guard<std::mutex> append_lock(_append_lock);
     std::lock_guard<std::mutex> lock(_segments_lock);
     uint64_t totalSizeBytes = 0;
     auto seg = _segments.begin();
@@ -277,6 +662,7 @@ uint64_t FileStream::removeOlderRecords(const int64_t older_than_timestamp_ms) n
 }
 
 Iterator FileStream::openOrCreateIterator(const std::string &identifier, IteratorOptions) noexcept {
+    std::lock_guard<std::mutex> lock(_iterators_lock);
     for (const auto &iter : _iterators) {
         if (iter.getIdentifier() == identifier) {
             return Iterator{WEAK_FROM_THIS(), identifier,
@@ -290,6 +676,7 @@ Iterator FileStream::openOrCreateIterator(const std::string &identifier, Iterato
 }
 
 StreamError FileStream::deleteIterator(const std::string &identifier) noexcept {
+    std::lock_guard<std::mutex> lock(_iterators_lock);
     auto e = StreamError{StreamErrorCode::IteratorNotFound, {}};
     for (size_t i = 0U; i < _iterators.size(); i++) {
         auto iter = _iterators[i];
@@ -306,15 +693,65 @@ StreamError FileStream::deleteIterator(const std::string &identifier) noexcept {
 
 StreamError FileStream::setCheckpoint(const std::string &identifier, const uint64_t sequence_number) noexcept {
     auto e = StreamError{StreamErrorCode::IteratorNotFound, {}};
-    for (auto &iter : _iterators) {
-        if (iter.getIdentifier() == identifier) {
-            e = iter.setCheckpoint(sequence_number);
-            break;
+    {
+        std::lock_guard<std::mutex> lock(_iterators_lock);
+        for (auto &iter : _iterators) {
+            if (iter.getIdentifier() == identifier) {
+                e = iter.setCheckpoint(sequence_number);
+                break;
+            }
         }
     }
+    // The iterators lock is released first so that the locks are always taken in the same order
+    if (e.ok()) {
+        std::lock_guard<std::mutex> lock(_segments_lock);
+        releaseConsumedSegments();
+    }
     return e;
 }
 
+StreamMetrics FileStream::metrics() const noexcept {
+    auto m = StreamInterface::metrics();
+    if (_kv_store) {
+        auto kv_metrics = _kv_store->metrics();
+        m.compactions = kv_metrics.compactions;
+        m.compaction_latency = std::move(kv_metrics.compaction_latency);
+    }
+
+    std::lock_guard<std::mutex> lock(_iterators_lock);
+    const auto end = _next_sequence_number.load();
+    m.iterators.reserve(_iterators.size());
+    for (const auto &iter : _iterators) {
+        const auto start = iter.getSequenceNumber();
+        m.iterators.push_back(IteratorMetrics{iter.getIdentifier(), start, (end > start) ? (end - start) : 0U});
+    }
+    return m;
+}
+
+// Must be called with the segments lock held.
+void FileStream::releaseConsumedSegments() noexcept {
+    if (_segments.size() < 2U) {
+        return;
+    }
+    uint64_t lowest = UINT64_MAX;
+    {
+        std::lock_guard<std::mutex> lock(_iterators_lock);
+        if (_iterators.empty()) {
+            return;
+        }
+        for (const auto &iter : _iterators) {
+            lowest = std::min(lowest, iter.getSequenceNumber());
+        }
+    }
+    // The last segment is still being appended to, so it is never released
+    for (auto seg = _segments.begin(); seg != std::prev(_segments.end()); ++seg) {
+        if (seg->getHighestSeqNum() >= lowest) {
+            break;
+        }
+        seg->releaseCache();
+    }
+}
+
 PersistentIterator::PersistentIterator(std::string id, const uint64_t start, std::shared_ptr<kv::KV> kv) noexcept
     : _id(std::move(id)), _store(std::move(kv)), _sequence_number(start) {
     auto value_or = _store->get(_id);
@@ -3,11 +3,15 @@
 
 #include <algorithm>
 #include <atomic>
+#include <aws/store/common/crc32.hpp>
 #include <aws/store/common/expected.hpp>
+#include <aws/store/common/metrics.hpp>
 #include <aws/store/common/slices.hpp>
+#include <aws/store/filesystem/filesystem.hpp>
 #include <aws/store/stream/memoryStream.hpp>
 #include <aws/store/stream/stream.hpp>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -18,6 +22,132 @@
 namespace aws {
 namespace store {
 namespace stream {
+namespace detail {
+constexpr uint32_t SNAPSHOT_MAGIC_AND_VERSION = 0x534E4101U;
+// Snapshots are written and read in chunks of this size so that each is a handful of large sequential I/Os
+constexpr uint32_t SNAPSHOT_IO_BYTES = 1024U * 1024U;
+
+struct SnapshotHeader {
+    uint32_t magic_and_version;
+    uint32_t iterator_count;
+    uint64_t record_count;
+    uint64_t next_sequence_number;
+    uint64_t total_bytes; // Including this header and the trailing CRC
+};
+
+struct SnapshotRecordHeader {
+    uint64_t sequence_number;
+    int64_t timestamp;
+    uint32_t length;
+    uint32_t reserved;
+};
+
+struct SnapshotIteratorHeader {
+    uint64_t sequence_number;
+    uint32_t identifier_length;
+    uint32_t reserved;
+};
+
+// Buffers small writes into large appends and computes the CRC of everything written
+class SnapshotWriter {
+  private:
+    filesystem::FileLike &_f;
+    std::vector<uint8_t> _buffer{};
+    uint32_t _crc{0U};
+
+  public:
+    explicit SnapshotWriter(filesystem::FileLike &f) : _f(f) {
+        _buffer.reserve(SNAPSHOT_IO_BYTES);
+    }
+
+    filesystem::FileError put(const common::BorrowedSlice d) noexcept {
+        _crc = common::crc32::update(_crc, d.data(), d.size());
+        if ((_buffer.size() + d.size()) > SNAPSHOT_IO_BYTES) {
+            auto e = drain();
+            if (!e.ok()) {
+                return e;
+            }
+        }
+        if (d.size() >= SNAPSHOT_IO_BYTES) {
+            return _f.append(d);
+        }
+        const auto *p = static_cast<const uint8_t *>(d.data());
+        std::ignore = _buffer.insert(_buffer.end(), p, p + d.size());
+        return filesystem::FileError{filesystem::FileErrorCode::NoError, {}};
+    }
+
+    filesystem::FileError drain() noexcept {
+        if (_buffer.empty()) {
+            return filesystem::FileError{filesystem::FileErrorCode::NoError, {}};
+        }
+        auto e = _f.append(common::BorrowedSlice{_buffer.data(), static_cast<uint32_t>(_buffer.size())});
+        _buffer.clear();
+        return e;
+    }
+
+    uint32_t crc() const noexcept {
+        return _crc;
+    }
+};
+
+// Reads the snapshot in large chunks, handing out pieces of it and computing the CRC of everything handed out
+class SnapshotReader {
+  private:
+    filesystem::FileLike &_f;
+    uint32_t _file_position;
+    uint32_t _end;
+    common::OwnedSlice _chunk{};
+    uint32_t _chunk_position{0U};
+    uint32_t _crc;
+
+  public:
+    SnapshotReader(filesystem::FileLike &f, const uint32_t begin, const uint32_t end, const uint32_t initial_crc)
+        : _f(f), _file_position(begin), _end(end), _crc(initial_crc) {
+    }
+
+    filesystem::FileError take(void *dest, const uint32_t size) noexcept {
+        auto *out = static_cast<uint8_t *>(dest);
+        uint32_t remaining = size;
+        while (remaining > 0U) {
+            if (_chunk_position == _chunk.size()) {
+                if (_file_position == _end) {
+                    return filesystem::FileError{filesystem::FileErrorCode::EndOfFile, {}};
+                }
+                const auto chunk_size = std::min(SNAPSHOT_IO_BYTES, _end - _file_position);
+                auto chunk_or = _f.read(_file_position, _file_position + chunk_size);
+                if (!chunk_or.ok()) {
+                    return chunk_or.err();
+                }
+                _chunk = std::move(chunk_or.val());
+                _chunk_position = 0U;
+                _file_position += _chunk.size();
+            }
+            const auto n = std::min(remaining, _chunk.size() - _chunk_position);
+            std::ignore = memcpy(out, static_cast<const uint8_t *>(_chunk.data()) + _chunk_position, n);
+            _crc = common::crc32::update(_crc, out, n);
+            out += n;
+            _chunk_position += n;
+            remaining -= n;
+        }
+        return filesystem::FileError{filesystem::FileErrorCode::NoError, {}};
+    }
+
+    uint32_t crc() const noexcept {
+        return _crc;
+    }
+};
+} // namespace detail
+
+static StreamError snapshotFileErrorToStreamError(const filesystem::FileError &e, const StreamErrorCode code) noexcept {
+    if (e.code == filesystem::FileErrorCode::DiskFull) {
+        return StreamError{StreamErrorCode::DiskFull, e.msg};
+    }
+    if (e.code == filesystem::FileErrorCode::EndOfFile) {
+        return StreamError{StreamErrorCode::HeaderDataCorrupted, "Snapshot is truncated"};
+    }
+    return StreamError{code, e.msg};
+}
+
 std::shared_ptr<MemoryStream> MemoryStream::openOrCreate(StreamOptions &&opts) noexcept {
     // coverity[autosar_cpp14_a20_8_6_violation] constructor is private, cannot use make_shared
     // coverity[misra_cpp_2008_rule_18_4_1_violation] constructor is private, cannot use make_shared
@@ -26,6 +156,7 @@ std::shared_ptr<MemoryStream> MemoryStream::openOrCreate(StreamOptions &&opts) n
 
 common::Expected<uint64_t, StreamError> MemoryStream::append(const common::BorrowedSlice d,
                                                              const AppendOptions &) noexcept {
+    const common::ScopedTimer timer{_counters.append_latency};
     const auto record_size = d.size();
     auto err = remove_records_if_new_record_beyond_max_size(record_size);
     if (!err.ok()) {
@@ -35,6 +166,8 @@ common::Expected<uint64_t, StreamError> MemoryStream::append(const common::Borro
     auto seq = _next_sequence_number.fetch_add(1U);
     _current_size_bytes += d.size();
     _records.emplace_back(common::OwnedSlice(d), timestamp(), seq, 0);
+    _counters.appends.add();
+    _counters.appended_bytes.add(record_size);
     return seq;
 }
 
@@ -64,6 +197,7 @@ StreamError MemoryStream::remove_records_if_new_record_beyond_max_size(const uin
 }
 
 common::Expected<uint64_t, StreamError> MemoryStream::append(common::OwnedSlice &&d, const AppendOptions &) noexcept {
+    const common::ScopedTimer timer{_counters.append_latency};
     auto data = std::move(d);
     const auto record_size = data.size();
     auto err = remove_records_if_new_record_beyond_max_size(record_size);
@@ -74,11 +208,14 @@ common::Expected<uint64_t, StreamError> MemoryStream::append(common::OwnedSlice
     uint64_t seq = _next_sequence_number.fetch_add(1U);
     _current_size_bytes += data.size();
     _records.emplace_back(std::move(data), timestamp(), seq, 0);
+    _counters.appends.add();
+    _counters.appended_bytes.add(record_size);
     return seq;
 }
 
 common::Expected<OwnedRecord, StreamError> MemoryStream::read(const uint64_t sequence_number,
                                                               const ReadOptions &) const noexcept {
+    const common::ScopedTimer timer{_counters.read_latency};
     if (sequence_number < _first_sequence_number) {
         return StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
     }
@@ -87,9 +224,11 @@ common::Expected<OwnedRecord, StreamError> MemoryStream::read(const uint64_t seq
             break;
         }
         if (r.sequence_number == sequence_number) {
+            _counters.reads.add();
+            _counters.read_bytes.add(r.data.size());
             return OwnedRecord{
                 // TODO: This is copying the data because the file-based version needs to return an owned record
-                common::OwnedSlice{common::BorrowedSlice(r.data.data(), r.data.size())},
+                common::OwnedSlice{common::BorrowedSlice(r.data.data(), r.data.size()), _opts.buffer_pool},
                 r.timestamp,
                 r.sequence_number,
                 0U,
@@ -129,6 +268,176 @@ StreamError MemoryStream::setCheckpoint(const std::string &identifier, const uin
     return StreamError{StreamErrorCode::NoError, {}};
 }
 
+StreamMetrics MemoryStream::metrics() const noexcept {
+    auto m = StreamInterface::metrics();
+    const auto end = _next_sequence_number.load();
+    m.iterators.reserve(_iterators.size());
+    for (const auto &it : _iterators) {
+        m.iterators.push_back(IteratorMetrics{it.first, it.second, (end > it.second) ? (end - it.second) : 0U});
+    }
+    return m;
+}
+
+StreamError MemoryStream::snapshot(filesystem::FileSystemInterface &fs, const std::string &identifier) noexcept {
+    uint64_t total_bytes = sizeof(detail::SnapshotHeader) + sizeof(uint32_t);
+    for (const auto &r : _records) {
+        total_bytes += sizeof(detail::SnapshotRecordHeader) + r.data.size();
+    }
+    for (const auto &it : _iterators) {
+        total_bytes += sizeof(detail::SnapshotIteratorHeader) + it.first.size();
+    }
+    if (total_bytes > UINT32_MAX) {
+        return StreamError{StreamErrorCode::InvalidArguments, "Stream is too large to snapshot"};
+    }
+
+    // Write into a shadow file and only rename it over the previous snapshot once it is complete
+    const auto shadow_name = identifier + "s";
+    std::ignore = fs.remove(shadow_name);
+    auto shadow_or = fs.open(shadow_name);
+    if (!shadow_or.ok()) {
+        return snapshotFileErrorToStreamError(shadow_or.err(), StreamErrorCode::WriteError);
+    }
+    auto shadow = std::move(shadow_or.val());
+    auto writer = detail::SnapshotWriter{*shadow};
+
+    const auto write_all = [&]() -> filesystem::FileError {
+        const auto header = detail::SnapshotHeader{detail::SNAPSHOT_MAGIC_AND_VERSION,
+                                                   static_cast<uint32_t>(_iterators.size()),
+                                                   static_cast<uint64_t>(_records.size()), _next_sequence_number.load(),
+                                                   total_bytes};
+        auto e = writer.put(common::BorrowedSlice{&header, sizeof(header)});
+        for (auto r = _records.cbegin(); e.ok() && (r != _records.cend()); ++r) {
+            const auto record_header =
+                detail::SnapshotRecordHeader{r->sequence_number, r->timestamp, r->data.size(), 0U};
+            e = writer.put(common::BorrowedSlice{&record_header, sizeof(record_header)});
+            if (e.ok()) {
+                e = writer.put(common::BorrowedSlice{r->data.data(), r->data.size()});
+            }
+        }
+        for (auto it = _iterators.cbegin(); e.ok() && (it != _iterators.cend()); ++it) {
+            const auto iterator_header =
+                detail::SnapshotIteratorHeader{it->second, static_cast<uint32_t>(it->first.size()), 0U};
+            e = writer.put(common::BorrowedSlice{&iterator_header, sizeof(iterator_header)});
+            if (e.ok()) {
+                e = writer.put(common::BorrowedSlice{it->first});
+            }
+        }
+        const auto crc = writer.crc();
+        if (e.ok()) {
+            e = writer.put(common::BorrowedSlice{&crc, sizeof(crc)});
+        }
+        if (e.ok()) {
+            e = writer.drain();
+        }
+        if (e.ok()) {
+            e = shadow->flush();
+        }
+        return e;
+    };
+
+    auto e = write_all();
+    if (!e.ok()) {
+        // Close and delete the partially written shadow
+        shadow.reset();
+        std::ignore = fs.remove(shadow_name);
+        return snapshotFileErrorToStreamError(e, StreamErrorCode::WriteError);
+    }
+    shadow->sync();
+    shadow.reset();
+
+    e = fs.rename(shadow_name, identifier);
+    if (!e.ok()) {
+        return snapshotFileErrorToStreamError(e, StreamErrorCode::WriteError);
+    }
+    return StreamError{StreamErrorCode::NoError, {}};
+}
+
+StreamError MemoryStream::restore(filesystem::FileSystemInterface &fs, const std::string &identifier) noexcept {
+    // snapshot() renames a complete shadow over the previous snapshot, so there is never a time without one once the
+    // first has been put in place. Without a snapshot, fall back to a shadow left behind by a first snapshot which
+    // did not finish or could not be renamed. It is either complete or fails the CRC check below.
+    auto name = identifier;
+    if (!fs.exists(name)) {
+        name = identifier + "s";
+        if (!fs.exists(name)) {
+            return StreamError{StreamErrorCode::ReadError, "Snapshot does not exist"};
+        }
+    }
+    auto f_or = fs.open(name);
+    if (!f_or.ok()) {
+        return snapshotFileErrorToStreamError(f_or.err(), StreamErrorCode::ReadError);
+    }
+    auto f = std::move(f_or.val());
+
+    auto header_or = f->read(0U, sizeof(detail::SnapshotHeader));
+    if (!header_or.ok()) {
+        return snapshotFileErrorToStreamError(header_or.err(), StreamErrorCode::ReadError);
+    }
+    detail::SnapshotHeader header{};
+    std::ignore = memcpy(&header, header_or.val().data(), sizeof(header));
+    if ((header.magic_and_version != detail::SNAPSHOT_MAGIC_AND_VERSION) || (header.total_bytes > UINT32_MAX) ||
+        (header.total_bytes < (sizeof(header) + sizeof(uint32_t)))) {
+        return StreamError{StreamErrorCode::HeaderDataCorrupted, "Snapshot header is invalid"};
+    }
+
+    const auto body_end = static_cast<uint32_t>(header.total_bytes - sizeof(uint32_t));
+    auto reader = detail::SnapshotReader{*f, static_cast<uint32_t>(sizeof(header)), body_end,
+                                         common::crc32::update(0U, &header, sizeof(header))};
+
+    std::vector<OwnedRecord> records{};
+    uint64_t size_bytes = 0U;
+    for (uint64_t i = 0U; i < header.record_count; i++) {
+        detail::SnapshotRecordHeader record_header{};
+        auto e = reader.take(&record_header, sizeof(record_header));
+        if (e.ok() && (record_header.length > (body_end - sizeof(header)))) {
+            return StreamError{StreamErrorCode::HeaderDataCorrupted, "Snapshot record length is invalid"};
+        }
+        auto data = common::OwnedSlice{record_header.length};
+        if (e.ok()) {
+            e = reader.take(data.data(), data.size());
+        }
+        if (!e.ok()) {
+            return snapshotFileErrorToStreamError(e, StreamErrorCode::ReadError);
+        }
+        size_bytes += data.size();
+        records.emplace_back(std::move(data), record_header.timestamp, record_header.sequence_number, 0U);
+    }
+
+    std::unordered_map<std::string, uint64_t> iterators{};
+    for (uint32_t i = 0U; i < header.iterator_count; i++) {
+        detail::SnapshotIteratorHeader iterator_header{};
+        auto e = reader.take(&iterator_header, sizeof(iterator_header));
+        if (e.ok() && (iterator_header.identifier_length > (body_end - sizeof(header)))) {
+            return StreamError{StreamErrorCode::HeaderDataCorrupted, "Snapshot iterator is invalid"};
+        }
+        std::string iterator_identifier(iterator_header.identifier_length, '\0');
+        if (e.ok()) {
+            e = reader.take(&iterator_identifier[0], iterator_header.identifier_length);
+        }
+        if (!e.ok()) {
+            return snapshotFileErrorToStreamError(e, StreamErrorCode::ReadError);
+        }
+        iterators[iterator_identifier] = iterator_header.sequence_number;
+    }
+
+    auto crc_or = f->read(body_end, body_end + static_cast<uint32_t>(sizeof(uint32_t)));
+    if (!crc_or.ok()) {
+        return snapshotFileErrorToStreamError(crc_or.err(), StreamErrorCode::ReadError);
+    }
+    uint32_t expected_crc = 0U;
+    std::ignore = memcpy(&expected_crc, crc_or.val().data(), sizeof(expected_crc));
+    if (reader.crc() != expected_crc) {
+        return StreamError{StreamErrorCode::RecordDataCorrupted, "Snapshot failed CRC check"};
+    }
+
+    // Everything checks out, swap it in
+    _records = std::move(records);
+    _iterators = std::move(iterators);
+    _current_size_bytes = size_bytes;
+    _next_sequence_number = header.next_sequence_number;
+    _first_sequence_number = _records.empty() ? header.next_sequence_number : _records.front().sequence_number;
+    return StreamError{StreamErrorCode::NoError, {}};
+}
 } // namespace stream
 } // namespace store
 } // namespace aws
@@ -0,0 +1,585 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <atomic>
+#include <aws/store/common/crc32.hpp>
+#include <aws/store/common/expected.hpp>
+#include <aws/store/common/slices.hpp>
+#include <aws/store/stream/sharedMemoryStream.hpp>
+#include <aws/store/stream/stream.hpp>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <linux/futex.h>
+#include <memory>
+#include <new>
+#include <pthread.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <utility>
+
+namespace aws {
+namespace store {
+namespace stream {
+namespace detail {
+constexpr uint32_t SHARED_MAGIC_AND_VERSION = 0x53484D01U;
+constexpr uint32_t MAX_SHARED_ITERATORS = 32U;
+constexpr uint32_t MAX_SHARED_ITERATOR_ID_LENGTH = 63U;
+constexpr uint64_t RECORD_ALIGNMENT = 8U;
+constexpr uint64_t HEADER_ALIGNMENT = 64U;
+constexpr int OPEN_RETRIES = 1000;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "64 bit atomics must be lock free to be shared between processes");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "32 bit atomics must be lock free to be shared between processes");
+static_assert(sizeof(std::atomic_uint32_t) == sizeof(uint32_t), "Futex word must be 32 bits");
+
+struct SharedIteratorSlot {
+    std::atomic_uint64_t sequence_number;
+    std::atomic_uint32_t in_use;
+    char identifier[MAX_SHARED_ITERATOR_ID_LENGTH + 1U];
+};
+
+struct SharedStreamHeader {
+    std::atomic_uint32_t magic_and_version; // Set last by the creating process, once everything else is initialized
+    uint32_t maximum_records;
+    uint64_t capacity_bytes;
+    pthread_mutex_t append_lock;
+    std::atomic_uint64_t first_sequence_number;
+    std::atomic_uint64_t next_sequence_number;
+    std::atomic_uint64_t head; // Logical byte position where the next record will be written. Never wraps.
+    std::atomic_uint64_t tail; // Logical byte position of the oldest record
+    std::atomic_uint64_t size_bytes;
+    std::atomic_uint32_t appends; // Futex word, bumped after every append
+    std::atomic_uint32_t waiters;
+    SharedIteratorSlot iterators[MAX_SHARED_ITERATORS];
+};
+
+struct SharedRecordHeader {
+    uint32_t length;
+    uint32_t crc;
+    int64_t timestamp;
+    uint64_t sequence_number;
+};
+} // namespace detail
+
+static constexpr uint64_t alignUp(const uint64_t v, const uint64_t alignment) noexcept {
+    return (v + alignment - 1U) & ~(alignment - 1U);
+}
+
+static size_t headerBytes() noexcept {
+    return static_cast<size_t>(alignUp(sizeof(detail::SharedStreamHeader), detail::HEADER_ALIGNMENT));
+}
+
+static size_t regionBytes(const uint64_t capacity_bytes, const uint32_t maximum_records) noexcept {
+    return headerBytes() + static_cast<size_t>(maximum_records) * sizeof(std::atomic_uint64_t) +
+           static_cast<size_t>(capacity_bytes);
+}
+
+static std::string normalizeName(const std::string &name) {
+    return (!name.empty() && (name[0] == '/')) ? name : ("/" + name);
+}
+
+static StreamError errnoToStreamError(const std::string &what, const int err) {
+    return StreamError{StreamErrorCode::ReadError, what + " failed with errno " + std::to_string(err)};
+}
+
+static long futex(std::atomic_uint32_t *word, const int op, const uint32_t val, const timespec *timeout) noexcept {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), op, val, timeout, nullptr, 0);
+}
+
+namespace {
+// Locks the process-shared append mutex, recovering it if a process died while holding it.
+class SharedLock {
+  private:
+    pthread_mutex_t *_mutex;
+    bool _locked{false};
+
+  public:
+    explicit SharedLock(pthread_mutex_t *mutex, bool &owner_died) noexcept : _mutex(mutex) {
+        const auto rc = pthread_mutex_lock(_mutex);
+        if (rc == EOWNERDEAD) {
+            owner_died = true;
+            std::ignore = pthread_mutex_consistent(_mutex);
+        }
+        _locked = (rc == 0) || (rc == EOWNERDEAD);
+    }
+    SharedLock(const SharedLock &) = delete;
+    SharedLock &operator=(const SharedLock &) = delete;
+
+    bool locked() const noexcept {
+        return _locked;
+    }
+
+    ~SharedLock() {
+        if (_locked) {
+            std::ignore = pthread_mutex_unlock(_mutex);
+        }
+    }
+};
+} // namespace
+
+SharedMemoryStream::SharedMemoryStream(std::string name) noexcept : _name(std::move(name)) {
+}
+
+SharedMemoryStream::~SharedMemoryStream() {
+    if (_region != nullptr) {
+        std::ignore = munmap(_region, _region_size);
+    }
+}
+
+common::Expected<std::shared_ptr<SharedMemoryStream>, StreamError>
+SharedMemoryStream::openOrCreate(const SharedMemoryStreamOptions &opts) noexcept {
+    if (opts.name.empty() || (opts.name.find('/', 1U) != std::string::npos)) {
+        return StreamError{StreamErrorCode::InvalidArguments, "Name must be set and cannot contain '/'"};
+    }
+    if ((opts.maximum_records == 0U) ||
+        (opts.maximum_size_bytes < alignUp(sizeof(detail::SharedRecordHeader), detail::RECORD_ALIGNMENT))) {
+        return StreamError{StreamErrorCode::InvalidArguments, "Maximum size and maximum records are too small"};
+    }
+
+    // coverity[autosar_cpp14_a20_8_6_violation] constructor is private, cannot use make_shared
+    // coverity[misra_cpp_2008_rule_18_4_1_violation] constructor is private, cannot use make_shared
+    auto stream = std::shared_ptr<SharedMemoryStream>(new SharedMemoryStream(normalizeName(opts.name)));
+    auto err = stream->map(opts);
+    if (!err.ok()) {
+        return err;
+    }
+    return stream;
+}
+
+StreamError SharedMemoryStream::map(const SharedMemoryStreamOptions &opts) noexcept {
+    // The ring capacity must be a multiple of the record alignment so that records never straddle the end
+    const auto capacity = alignUp(opts.maximum_size_bytes, detail::RECORD_ALIGNMENT);
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    int fd = shm_open(_name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+    const bool created = fd >= 0;
+    if (!created) {
+        if (errno != EEXIST) {
+            return errnoToStreamError("shm_open", errno);
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+        fd = shm_open(_name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            return errnoToStreamError("shm_open", errno);
+        }
+    }
+
+    if (created) {
+        _region_size = regionBytes(capacity, opts.maximum_records);
+        if (ftruncate(fd, static_cast<off_t>(_region_size)) != 0) {
+            const auto e = errno;
+            std::ignore = ::close(fd);
+            std::ignore = shm_unlink(_name.c_str());
+            return errnoToStreamError("ftruncate", e);
+        }
+    } else {
+        // Another process created the object. Wait for it to size and initialize the header.
+        for (int i = 0; i < detail::OPEN_RETRIES; i++) {
+            struct stat st {};
+            if ((fstat(fd, &st) == 0) && (static_cast<size_t>(st.st_size) >= headerBytes())) {
+                _region_size = static_cast<size_t>(st.st_size);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        if (_region_size == 0U) {
+            std::ignore = ::close(fd);
+            return StreamError{StreamErrorCode::ReadError, "Shared memory was never initialized"};
+        }
+    }
+
+    _region = mmap(nullptr, _region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const auto mmap_err = errno;
+    // The mapping keeps the object alive, we don't need the descriptor anymore
+    std::ignore = ::close(fd);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast)
+    if (_region == MAP_FAILED) {
+        _region = nullptr;
+        return errnoToStreamError("mmap", mmap_err);
+    }
+
+    auto *base = static_cast<uint8_t *>(_region);
+    if (created) {
+        _header = new (_region) detail::SharedStreamHeader{};
+        _header->maximum_records = opts.maximum_records;
+        _header->capacity_bytes = capacity;
+
+        pthread_mutexattr_t attr{};
+        std::ignore = pthread_mutexattr_init(&attr);
+        std::ignore = pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        std::ignore = pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        std::ignore = pthread_mutex_init(&_header->append_lock, &attr);
+        std::ignore = pthread_mutexattr_destroy(&attr);
+
+        _header->first_sequence_number.store(0U);
+        _header->next_sequence_number.store(0U);
+        _header->head.store(0U);
+        _header->tail.store(0U);
+        _header->size_bytes.store(0U);
+        _header->appends.store(0U);
+        _header->waiters.store(0U);
+        for (auto &slot : _header->iterators) {
+            slot.in_use.store(0U);
+            slot.sequence_number.store(0U);
+        }
+        _header->magic_and_version.store(detail::SHARED_MAGIC_AND_VERSION, std::memory_order_release);
+    } else {
+        _header = reinterpret_cast<detail::SharedStreamHeader *>(base);
+        int retries = detail::OPEN_RETRIES;
+        while ((_header->magic_and_version.load(std::memory_order_acquire) != detail::SHARED_MAGIC_AND_VERSION) &&
+               (retries-- > 0)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        if ((_header->magic_and_version.load(std::memory_order_acquire) != detail::SHARED_MAGIC_AND_VERSION) ||
+            (regionBytes(_header->capacity_bytes, _header->maximum_records) > _region_size)) {
+            return StreamError{StreamErrorCode::HeaderDataCorrupted, "Shared memory has an unknown layout"};
+        }
+    }
+
+    _index = reinterpret_cast<std::atomic_uint64_t *>(base + headerBytes());
+    _data = base + headerBytes() + static_cast<size_t>(_header->maximum_records) * sizeof(std::atomic_uint64_t);
+    return StreamError{StreamErrorCode::NoError, {}};
+}
+
+StreamError SharedMemoryStream::remove(const std::string &name) noexcept {
+    if (shm_unlink(normalizeName(name).c_str()) != 0) {
+        return errnoToStreamError("shm_unlink", errno);
+    }
+    return StreamError{StreamErrorCode::NoError, {}};
+}
+
+detail::SharedRecordHeader SharedMemoryStream::recordHeaderAt(const uint64_t position) const noexcept {
+    detail::SharedRecordHeader header{};
+    copyOut(position, &header, static_cast<uint32_t>(sizeof(header)));
+    return header;
+}
+
+void SharedMemoryStream::copyOut(const uint64_t position, void *dest, const uint32_t size) const noexcept {
+    // Records never straddle the end of the ring, so the copy is always contiguous
+    std::ignore = memcpy(dest, _data + (position % _header->capacity_bytes), size);
+}
+
+void SharedMemoryStream::copyIn(const uint64_t position, const void *src, const uint32_t size) noexcept {
+    std::ignore = memcpy(_data + (position % _header->capacity_bytes), src, size);
+}
+
+bool SharedMemoryStream::stillValid(const uint64_t sequence_number, const uint64_t position) const noexcept {
+    // Pairs with the release fence in append(). If the writer evicted the record before we finished reading it,
+    // we are guaranteed to see the advanced first sequence number and tail here.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (_header->first_sequence_number.load(std::memory_order_relaxed) <= sequence_number) &&
+           (_header->tail.load(std::memory_order_relaxed) <= position);
+}
+
+void SharedMemoryStream::evictOldestNoLock() noexcept {
+    const auto first = _header->first_sequence_number.load(std::memory_order_relaxed);
+    const auto next = _header->next_sequence_number.load(std::memory_order_relaxed);
+    if (first == next) {
+        return;
+    }
+    const auto mr = _header->maximum_records;
+    const auto header = recordHeaderAt(_index[first % mr].load(std::memory_order_relaxed));
+    const auto new_tail = ((first + 1U) < next) ? _index[(first + 1U) % mr].load(std::memory_order_relaxed)
+                                                : _header->head.load(std::memory_order_relaxed);
+    _header->tail.store(new_tail, std::memory_order_relaxed);
+    _header->first_sequence_number.store(first + 1U, std::memory_order_relaxed);
+    std::ignore = _header->size_bytes.fetch_sub(header.length, std::memory_order_relaxed);
+}
+
+common::Expected<uint64_t, StreamError> SharedMemoryStream::append(const common::BorrowedSlice d,
+                                                                   const AppendOptions &append_opts) noexcept {
+    const auto capacity = _header->capacity_bytes;
+    const auto need = alignUp(sizeof(detail::SharedRecordHeader) + d.size(), detail::RECORD_ALIGNMENT);
+    if (need > capacity) {
+        return StreamError{StreamErrorCode::RecordTooLarge, {}};
+    }
+
+    const auto ts = timestamp();
+    const auto length = d.size();
+    const auto crc = common::crc32::crc32_of(
+        {common::BorrowedSlice{&ts, sizeof(ts)}, common::BorrowedSlice{&length, sizeof(length)}, d});
+
+    uint64_t seq = 0U;
+    {
+        bool owner_died = false;
+        SharedLock lock{&_header->append_lock, owner_died};
+        if (!lock.locked()) {
+            return StreamError{StreamErrorCode::Unknown, "Unable to lock shared memory"};
+        }
+        const auto mr = _header->maximum_records;
+        if (owner_died) {
+            // A process died while appending. Nothing it didn't publish is visible, but it may have been part way
+            // through evicting, so recompute the tail from the oldest record.
+            const auto first = _header->first_sequence_number.load(std::memory_order_relaxed);
+            const auto next = _header->next_sequence_number.load(std::memory_order_relaxed);
+            _header->tail.store((first < next) ? _index[first % mr].load(std::memory_order_relaxed)
+                                               : _header->head.load(std::memory_order_relaxed),
+                                std::memory_order_relaxed);
+        }
+
+        auto head = _header->head.load(std::memory_order_relaxed);
+        auto skip = ((capacity - (head % capacity)) < need) ? (capacity - (head % capacity)) : 0U;
+        // Make room for the record (skipping to the start of the ring if it doesn't fit at the end) and its index slot
+        while (((head + skip + need - _header->tail.load(std::memory_order_relaxed)) > capacity) ||
+               ((_header->next_sequence_number.load(std::memory_order_relaxed) -
+                 _header->first_sequence_number.load(std::memory_order_relaxed)) >= mr)) {
+            if (_header->first_sequence_number.load(std::memory_order_relaxed) ==
+                _header->next_sequence_number.load(std::memory_order_relaxed)) {
+                // Empty, so just start over from the beginning of the ring
+                head += skip;
+                skip = 0U;
+                _header->tail.store(head, std::memory_order_relaxed);
+                break;
+            }
+            if (!append_opts.remove_oldest_segments_if_full) {
+                return StreamError{StreamErrorCode::StreamFull, {}};
+            }
+            evictOldestNoLock();
+        }
+        // Make sure that readers see the eviction before they could see any of the data overwriting it
+        std::atomic_thread_fence(std::memory_order_release);
+
+        seq = _header->next_sequence_number.load(std::memory_order_relaxed);
+        const auto position = head + skip;
+        const auto header = detail::SharedRecordHeader{length, crc, ts, seq};
+        copyIn(position, &header, static_cast<uint32_t>(sizeof(header)));
+        if (length > 0U) {
+            copyIn(position + sizeof(header), d.data(), length);
+        }
+        _index[seq % mr].store(position, std::memory_order_relaxed);
+        _header->head.store(position + need, std::memory_order_relaxed);
+        std::ignore = _header->size_bytes.fetch_add(length, std::memory_order_relaxed);
+        _header->next_sequence_number.store(seq + 1U, std::memory_order_seq_cst);
+    }
+
+    // Only make the wake syscall if somebody is waiting
+    std::ignore = _header->appends.fetch_add(1U, std::memory_order_seq_cst);
+    if (_header->waiters.load(std::memory_order_seq_cst) > 0U) {
+        std::ignore = futex(&_header->appends, FUTEX_WAKE, INT_MAX, nullptr);
+    }
+
+    if (append_opts.sync_on_append) {
+        std::ignore = msync(_region, _region_size, MS_SYNC);
+    }
+    return seq;
+}
+
+common::Expected<uint64_t, StreamError> SharedMemoryStream::append(common::OwnedSlice &&d,
+                                                                   const AppendOptions &append_opts) noexcept {
+    const auto x = std::move(d);
+    return append(common::BorrowedSlice(x.data(), x.size()), append_opts);
+}
+
+StreamError SharedMemoryStream::peek(
+    const uint64_t sequence_number, const ReadOptions &read_options,
+    const std::function<void(const common::BorrowedSlice, const int64_t)> &visitor) const noexcept {
+    const auto mr = _header->maximum_records;
+    if ((sequence_number < _header->first_sequence_number.load(std::memory_order_acquire)) ||
+        (sequence_number >= _header->next_sequence_number.load(std::memory_order_acquire))) {
+        return StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
+    }
+
+    const auto capacity = _header->capacity_bytes;
+    const auto position = _index[sequence_number % mr].load(std::memory_order_acquire);
+    // The position may be stale if the record is being overwritten, so make sure that neither the header nor the data
+    // could run off the end of the ring before copying anything
+    const auto offset = position % capacity;
+    detail::SharedRecordHeader header{};
+    const auto header_fits = (capacity - offset) >= sizeof(header);
+    if (header_fits) {
+        header = recordHeaderAt(position);
+    }
+    if (!header_fits || (header.sequence_number != sequence_number) ||
+        ((offset + sizeof(header) + header.length) > capacity)) {
+        return stillValid(sequence_number, position)
+                   ? StreamError{StreamErrorCode::HeaderDataCorrupted, {}}
+                   : StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
+    }
+
+    const auto data = common::BorrowedSlice{_data + offset + sizeof(header), header.length};
+    if (read_options.check_for_corruption &&
+        (header.crc != common::crc32::crc32_of({common::BorrowedSlice{&header.timestamp, sizeof(header.timestamp)},
+                                                common::BorrowedSlice{&header.length, sizeof(header.length)},
+                                                data}))) {
+        return stillValid(sequence_number, position)
+                   ? StreamError{StreamErrorCode::RecordDataCorrupted, {}}
+                   : StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
+    }
+
+    visitor(data, header.timestamp);
+    if (!stillValid(sequence_number, position)) {
+        return StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
+    }
+    return StreamError{StreamErrorCode::NoError, {}};
+}
+
+common::Expected<OwnedRecord, StreamError> SharedMemoryStream::read(const uint64_t sequence_number,
+                                                                    const ReadOptions &read_options) const noexcept {
+    auto seq = sequence_number;
+    // A record can only be evicted from under us a few times before we catch up with the oldest record
+    constexpr int max_attempts = 8;
+    for (int attempt = 0; attempt < max_attempts; attempt++) {
+        const auto first = _header->first_sequence_number.load(std::memory_order_acquire);
+        if ((seq < first) && read_options.may_return_later_records) {
+            seq = first;
+        }
+
+        common::OwnedSlice data{};
+        int64_t ts = 0;
+        const auto err = peek(seq, read_options, [&data, &ts](const common::BorrowedSlice d, const int64_t t) {
+            data = common::OwnedSlice{d};
+            ts = t;
+        });
+        if (err.ok()) {
+            return OwnedRecord{std::move(data), ts, seq, 0U};
+        }
+        if ((err.code != StreamErrorCode::RecordNotFound) || !read_options.may_return_later_records ||
+            (seq >= _header->next_sequence_number.load(std::memory_order_acquire))) {
+            return err;
+        }
+    }
+    return StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
+}
+
+bool SharedMemoryStream::waitForRecord(const uint64_t sequence_number,
+                                       const std::chrono::milliseconds timeout) const noexcept {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        if (_header->next_sequence_number.load(std::memory_order_acquire) > sequence_number) {
+            return true;
+        }
+
+        const auto appends = _header->appends.load(std::memory_order_seq_cst);
+        std::ignore = _header->waiters.fetch_add(1U, std::memory_order_seq_cst);
+        // Check again now that the writer is guaranteed to see that we are waiting
+        if (_header->next_sequence_number.load(std::memory_order_seq_cst) > sequence_number) {
+            std::ignore = _header->waiters.fetch_sub(1U, std::memory_order_seq_cst);
+            return true;
+        }
+
+        const auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::steady_clock::duration::zero()) {
+            std::ignore = _header->waiters.fetch_sub(1U, std::memory_order_seq_cst);
+            return false;
+        }
+        const auto secs = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+        const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - secs);
+        const timespec ts{static_cast<time_t>(secs.count()), static_cast<long>(nanos.count())};
+        // Not FUTEX_PRIVATE, the word is shared between processes. Returns immediately if an append happened since
+        // we read the word.
+        std::ignore = futex(&_header->appends, FUTEX_WAIT, appends, &ts);
+        std::ignore = _header->waiters.fetch_sub(1U, std::memory_order_seq_cst);
+    }
+}
+
+uint64_t SharedMemoryStream::removeOlderRecords(const int64_t older_than_timestamp_ms) noexcept {
+    bool owner_died = false;
+    SharedLock lock{&_header->append_lock, owner_died};
+    if (!lock.locked()) {
+        return 0U;
+    }
+
+    uint64_t removed = 0U;
+    const auto mr = _header->maximum_records;
+    while (true) {
+        const auto first = _header->first_sequence_number.load(std::memory_order_relaxed);
+        if (first == _header->next_sequence_number.load(std::memory_order_relaxed)) {
+            break;
+        }
+        const auto header = recordHeaderAt(_index[first % mr].load(std::memory_order_relaxed));
+        if (header.timestamp >= older_than_timestamp_ms) {
+            break;
+        }
+        removed += header.length;
+        evictOldestNoLock();
+    }
+    return removed;
+}
+
+Iterator SharedMemoryStream::openOrCreateIterator(const std::string &identifier, IteratorOptions) noexcept {
+    const auto first = _header->first_sequence_number.load(std::memory_order_acquire);
+    if (identifier.size() > detail::MAX_SHARED_ITERATOR_ID_LENGTH) {
+        return Iterator{WEAK_FROM_THIS(), identifier, first};
+    }
+    bool owner_died = false;
+    SharedLock lock{&_header->append_lock, owner_died};
+    if (!lock.locked()) {
+        // The iterator still works, it just can't be shared with other processes
+        return Iterator{WEAK_FROM_THIS(), identifier, first};
+    }
+
+    detail::SharedIteratorSlot *free_slot = nullptr;
+    for (auto &slot : _header->iterators) {
+        if (slot.in_use.load(std::memory_order_relaxed) == 0U) {
+            free_slot = (free_slot == nullptr) ? &slot : free_slot;
+        } else if (identifier == slot.identifier) {
+            return Iterator{WEAK_FROM_THIS(), identifier,
+                            std::max(first, slot.sequence_number.load(std::memory_order_relaxed))};
+        }
+    }
+    if (free_slot != nullptr) {
+        std::ignore = memset(free_slot->identifier, 0, sizeof(free_slot->identifier));
+        std::ignore = memcpy(free_slot->identifier, identifier.data(), identifier.size());
+        free_slot->sequence_number.store(first, std::memory_order_relaxed);
+        free_slot->in_use.store(1U, std::memory_order_release);
+    }
+    return Iterator{WEAK_FROM_THIS(), identifier, first};
+}
+
+StreamError SharedMemoryStream::deleteIterator(const std::string &identifier) noexcept {
+    bool owner_died = false;
+    SharedLock lock{&_header->append_lock, owner_died};
+    if (!lock.locked()) {
+        return StreamError{StreamErrorCode::Unknown, "Unable to lock shared memory"};
+    }
+    for (auto &slot : _header->iterators) {
+        if ((slot.in_use.load(std::memory_order_relaxed) != 0U) && (identifier == slot.identifier)) {
+            slot.in_use.store(0U, std::memory_order_release);
+            return StreamError{StreamErrorCode::NoError, {}};
+        }
+    }
+    return StreamError{StreamErrorCode::IteratorNotFound, {}};
+}
+
+StreamError SharedMemoryStream::setCheckpoint(const std::string &identifier, const uint64_t sequence_number) noexcept {
+    bool owner_died = false;
+    SharedLock lock{&_header->append_lock, owner_died};
+    if (!lock.locked()) {
+        return StreamError{StreamErrorCode::Unknown, "Unable to lock shared memory"};
+    }
+    for (auto &slot : _header->iterators) {
+        if ((slot.in_use.load(std::memory_order_relaxed) != 0U) && (identifier == slot.identifier)) {
+            // Point at the first unread record, the same as FileStream does
+            slot.sequence_number.store(sequence_number + 1U, std::memory_order_relaxed);
+            return StreamError{StreamErrorCode::NoError, {}};
+        }
+    }
+    return StreamError{StreamErrorCode::IteratorNotFound, {}};
+}
+
+std::uint64_t SharedMemoryStream::firstSequenceNumber() const noexcept {
+    return _header->first_sequence_number.load(std::memory_order_acquire);
+}
+
+std::uint64_t SharedMemoryStream::highestSequenceNumber() const noexcept {
+    return _header->next_sequence_number.load(std::memory_order_acquire) - 1U;
+}
+
+std::uint64_t SharedMemoryStream::currentSizeBytes() const noexcept {
+    return _header->size_bytes.load(std::memory_order_relaxed);
+}
+} // namespace stream
+} // namespace store
+} // namespace aws
@@ -1,14 +1,17 @@
 // Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <algorithm>
 #include <aws/store/common/expected.hpp>
 #include <aws/store/common/slices.hpp>
 #include <aws/store/stream/stream.hpp>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <utility>
 
 namespace aws {
@@ -24,6 +27,29 @@ AppendOptions::AppendOptions(bool sync_on_append_opt, bool remove_oldest_segment
     : sync_on_append(sync_on_append_opt), remove_oldest_segments_if_full(remove_oldest_segments_if_full_opt) {
 }
 
+AppendReservation::AppendReservation(std::weak_ptr<StreamInterface> s, common::OwnedSlice &&buffer,
+                                     const uint32_t prefix_bytes) noexcept
+    : _stream(std::move(s)), _buffer(std::move(buffer)), _prefix_bytes(prefix_bytes) {
+}
+
+common::Expected<uint64_t, StreamError> AppendReservation::commit(const AppendOptions &append_opts) noexcept {
+    if (_buffer.data() == nullptr) {
+        return StreamError{StreamErrorCode::InvalidArguments, "Reservation is empty"};
+    }
+    const auto stream = _stream.lock();
+    if (!stream) {
+        abort();
+        return StreamError{StreamErrorCode::StreamClosed, "Unable to commit to a destroyed stream"};
+    }
+    return stream->commit(std::move(*this), append_opts);
+}
+
+void AppendReservation::abort() noexcept {
+    _buffer = common::OwnedSlice{};
+    _prefix_bytes = 0U;
+    _stream.reset();
+}
+
 Iterator &Iterator::operator++() noexcept {
     ++sequence_number;
     timestamp = 0;
@@ -84,6 +110,118 @@ std::uint64_t StreamInterface::currentSizeBytes() const noexcept {
     return _current_size_bytes;
 }
 
+StreamMetrics StreamInterface::metrics() const noexcept {
+    return StreamMetrics{
+        _counters.appends.value(),
+        _counters.appended_bytes.value(),
+        _counters.reads.value(),
+        _counters.read_bytes.value(),
+        _counters.syncs.value(),
+        _counters.segments_created.value(),
+        _counters.segments_removed.value(),
+        0U,
+        _counters.corruption_truncations.value(),
+        _counters.append_latency.snapshot(),
+        _counters.read_latency.snapshot(),
+        _counters.sync_latency.snapshot(),
+        {},
+        {},
+    };
+}
+
+common::Expected<uint64_t, StreamError> StreamInterface::append(const common::BorrowedSlice *parts,
+                                                                const size_t part_count,
+                                                                const AppendOptions &append_opts) noexcept {
+    uint64_t size = 0U;
+    for (size_t i = 0U; i < part_count; i++) {
+        size += parts[i].size();
+    }
+    if (size > UINT32_MAX) {
+        return StreamError{StreamErrorCode::RecordTooLarge, {}};
+    }
+    auto record = common::OwnedSlice{static_cast<uint32_t>(size)};
+    if ((record.data() == nullptr) && (size > 0U)) {
+        return StreamError{StreamErrorCode::RecordTooLarge, "Unable to allocate memory for the record"};
+    }
+    auto *out = static_cast<uint8_t *>(record.data());
+    for (size_t i = 0U; i < part_count; i++) {
+        if (parts[i].size() > 0U) {
+            std::ignore = memcpy(out, parts[i].data(), parts[i].size());
+            out += parts[i].size();
+        }
+    }
+    return append(std::move(record), append_opts);
+}
+
+common::Expected<uint64_t, StreamError> StreamInterface::appendChunked(const uint32_t size,
+                                                                       const RecordProducer &producer,
+                                                                       const AppendOptions &append_opts) noexcept {
+    auto record = common::OwnedSlice{size};
+    if ((record.data() == nullptr) && (size > 0U)) {
+        return StreamError{StreamErrorCode::RecordTooLarge, "Unable to allocate memory for the record"};
+    }
+    if (size > 0U) {
+        auto err = producer(static_cast<uint8_t *>(record.data()), size);
+        if (!err.ok()) {
+            return err;
+        }
+    }
+    return append(std::move(record), append_opts);
+}
+
+common::Expected<RecordMetadata, StreamError>
+StreamInterface::readChunked(const uint64_t sequence_number, uint8_t *buffer, const uint32_t buffer_size,
+                             const RecordConsumer &consumer, const ReadOptions &read_options) const noexcept {
+    auto record_or = read(sequence_number, read_options);
+    if (!record_or.ok()) {
+        return record_or.err();
+    }
+    const auto &record = record_or.val();
+    auto err = detail::copyInChunks(common::BorrowedSlice{record.data.data(), record.data.size()}, buffer,
+                                    buffer_size, consumer);
+    if (!err.ok()) {
+        return err;
+    }
+    return RecordMetadata{record.offset, record.data.size(), record.timestamp, record.sequence_number};
+}
+
+StreamError detail::copyInChunks(const common::BorrowedSlice data, uint8_t *buffer, const uint32_t buffer_size,
+                                 const RecordConsumer &consumer) noexcept {
+    if ((buffer_size == 0U) && (data.size() > 0U)) {
+        return StreamError{StreamErrorCode::InvalidArguments, "Buffer cannot be empty"};
+    }
+    const auto *p = static_cast<const uint8_t *>(data.data());
+    uint32_t remaining = data.size();
+    while (remaining > 0U) {
+        const auto n = std::min(remaining, buffer_size);
+        std::ignore = memcpy(buffer, p, n);
+        auto err = consumer(common::BorrowedSlice{buffer, n});
+        if (!err.ok()) {
+            return err;
+        }
+        p += n;
+        remaining -= n;
+    }
+    return StreamError{StreamErrorCode::NoError, {}};
+}
+
+common::Expected<AppendReservation, StreamError> StreamInterface::reserve(const uint32_t size) noexcept {
+    auto buffer = common::OwnedSlice{size};
+    if ((buffer.data() == nullptr) && (size > 0U)) {
+        return StreamError{StreamErrorCode::RecordTooLarge, "Unable to allocate memory for the record"};
+    }
+    return AppendReservation{WEAK_FROM_THIS(), std::move(buffer), 0U};
+}
+
+common::Expected<uint64_t, StreamError> StreamInterface::commit(AppendReservation &&reservation,
+                                                                const AppendOptions &append_opts) noexcept {
+    auto r = std::move(reservation);
+    if (r.prefixBytes() != 0U) {
+        return append(common::BorrowedSlice{r.data(), r.size()}, append_opts);
+    }
+    return append(std::move(r.buffer()), append_opts);
+}
+
 Iterator::Iterator(std::weak_ptr<StreamInterface> s, std::string id, const uint64_t seq) noexcept
     : _stream(std::move(s)), _id(std::move(id)), sequence_number(seq) {
 }
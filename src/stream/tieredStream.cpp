@@ -0,0 +1,288 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <aws/store/common/expected.hpp>
+#include <aws/store/common/logging.hpp>
+#include <aws/store/common/slices.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <aws/store/stream/stream.hpp>
+#include <aws/store/stream/tieredStream.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace aws {
+namespace store {
+namespace stream {
+common::Expected<std::shared_ptr<TieredStream>, StreamError>
+TieredStream::openOrCreate(StreamOptions &&opts, const TieredStreamOptions &tier_opts) noexcept {
+    if ((tier_opts.memory_size_bytes == 0U) || (opts.maximum_size_bytes <= LOG_ENTRY_HEADER_SIZE)) {
+        return StreamError{StreamErrorCode::InvalidArguments, "Memory and maximum stream sizes must be set"};
+    }
+
+    const auto maximum_size_bytes = opts.maximum_size_bytes;
+    auto logger = opts.logger;
+    auto file_or = FileStream::openOrCreate(std::move(opts));
+    if (!file_or.ok()) {
+        return file_or.err();
+    }
+
+    // coverity[autosar_cpp14_a20_8_6_violation] constructor is private, cannot use make_shared
+    // coverity[misra_cpp_2008_rule_18_4_1_violation] constructor is private, cannot use make_shared
+    auto stream = std::shared_ptr<TieredStream>(
+        new TieredStream(std::move(file_or.val()), tier_opts, maximum_size_bytes, std::move(logger)));
+    stream->_spiller = std::thread{&TieredStream::spillLoop, stream.get()};
+    return stream;
+}
+
+TieredStream::TieredStream(std::shared_ptr<FileStream> file, const TieredStreamOptions &tier_opts,
+                           const uint32_t maximum_size_bytes, std::shared_ptr<logging::Logger> logger) noexcept
+    : _tier_opts(tier_opts), _maximum_size_bytes(maximum_size_bytes), _logger(std::move(logger)),
+      _file(std::move(file)) {
+    // Continue the sequence numbers from wherever the file tier left off
+    _next_sequence_number = _file->highestSequenceNumber() + 1U;
+    _spilled_sequence_number = _next_sequence_number;
+    updateSizes();
+}
+
+TieredStream::~TieredStream() {
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _closing = true;
+    }
+    _spill_cv.notify_all();
+    // The spill thread writes out anything left in memory before it exits
+    if (_spiller.joinable()) {
+        _spiller.join();
+    }
+}
+
+void TieredStream::spillLoop() noexcept {
+    std::unique_lock<std::mutex> lock(_lock);
+    while (true) {
+        const auto should_spill = [this]() -> bool {
+            return _closing || ((_spilled_sequence_number != _next_sequence_number) &&
+                                ((_spill_waiters > 0U) || (_unspilled_bytes >= _tier_opts.spill_batch_bytes)));
+        };
+        std::ignore =
+            _spill_cv.wait_for(lock, std::chrono::milliseconds{_tier_opts.spill_interval_ms}, should_spill);
+
+        if (_spilled_sequence_number == _next_sequence_number) {
+            if (_closing) {
+                break;
+            }
+            continue;
+        }
+
+        // Records are never removed from the memory tier until they are spilled, and the deque never moves existing
+        // elements when appending, so these pointers stay valid while we write them without holding the lock.
+        std::vector<const OwnedRecord *> batch{};
+        batch.reserve(static_cast<size_t>(_next_sequence_number - _spilled_sequence_number));
+        for (auto i = static_cast<size_t>(_spilled_sequence_number - _records.front().sequence_number);
+             i < _records.size(); i++) {
+            batch.push_back(&_records[i]);
+        }
+        const bool sync = _sync_sequence_number > _spilled_sequence_number;
+        const bool write_frames = _write_sequence_number > _spilled_sequence_number;
+        const bool remove_oldest = _keep_oldest_sequence_number <= _spilled_sequence_number;
+
+        lock.unlock();
+        const auto spilled_or = _file->appendRecords(batch, AppendOptions{sync, remove_oldest}, write_frames);
+        // Even if the batch failed part way, the file tier tells us exactly how far it got.
+        const auto file_next_sequence_number = _file->highestSequenceNumber() + 1U;
+        lock.lock();
+
+        for (const auto *record : batch) {
+            if (record->sequence_number >= file_next_sequence_number) {
+                break;
+            }
+            _unspilled_bytes -= record->data.size();
+        }
+        _spilled_sequence_number = std::max(_spilled_sequence_number, file_next_sequence_number);
+        _spill_error = spilled_or.ok() ? StreamError{StreamErrorCode::NoError, {}} : spilled_or.err();
+        ++_spill_attempts;
+        trimMemoryTier();
+        updateSizes();
+        _spilled_cv.notify_all();
+
+        if (!spilled_or.ok()) {
+            logging::log(_logger, logging::LogLevel::Warning, "Unable to spill records to the file tier: ",
+                         _spill_error.msg);
+            if (_closing) {
+                break;
+            }
+            // Back off before trying again so that a full disk doesn't turn into a busy loop
+            std::ignore = _spill_cv.wait_for(lock, std::chrono::milliseconds{_tier_opts.spill_interval_ms},
+                                             [this]() -> bool { return _closing; });
+        }
+    }
+}
+
+StreamError TieredStream::waitForSpill(std::unique_lock<std::mutex> &lock, const uint64_t sequence_number,
+                                       const Durability durability) noexcept {
+    if (_spilled_sequence_number >= sequence_number) {
+        return StreamError{StreamErrorCode::NoError, {}};
+    }
+    if (durability == Durability::Synced) {
+        _sync_sequence_number = std::max(_sync_sequence_number, sequence_number);
+    }
+    if (durability != Durability::Memory) {
+        _write_sequence_number = std::max(_write_sequence_number, sequence_number);
+    }
+
+    ++_spill_waiters;
+    const auto attempts = _spill_attempts;
+    _spill_cv.notify_one();
+    _spilled_cv.wait(lock, [&]() -> bool {
+        return (_spilled_sequence_number >= sequence_number) || ((_spill_attempts != attempts) && !_spill_error.ok());
+    });
+    --_spill_waiters;
+
+    if (_spilled_sequence_number >= sequence_number) {
+        return StreamError{StreamErrorCode::NoError, {}};
+    }
+    return _spill_error;
+}
+
+void TieredStream::trimMemoryTier() noexcept {
+    const auto file_first_sequence_number = _file->firstSequenceNumber();
+    // Only spilled records may leave memory. Drop them when we are over budget, or when the file tier has already
+    // removed them to make room.
+    while (!_records.empty() && (_records.front().sequence_number < _spilled_sequence_number) &&
+           ((_memory_bytes > _tier_opts.memory_size_bytes) ||
+            (_records.front().sequence_number < file_first_sequence_number))) {
+        _memory_bytes -= _records.front().data.size();
+        _records.pop_front();
+    }
+}
+
+void TieredStream::updateSizes() noexcept {
+    _first_sequence_number = _file->firstSequenceNumber();
+    const auto unspilled_records = _next_sequence_number - _spilled_sequence_number;
+    _current_size_bytes = _file->currentSizeBytes() + _unspilled_bytes + unspilled_records * LOG_ENTRY_HEADER_SIZE;
+}
+
+common::Expected<uint64_t, StreamError> TieredStream::append(const common::BorrowedSlice d,
+                                                             const AppendOptions &append_opts) noexcept {
+    // Check the size before we copy anything
+    if (d.size() > (_maximum_size_bytes - LOG_ENTRY_HEADER_SIZE)) {
+        return StreamError{StreamErrorCode::RecordTooLarge, {}};
+    }
+    return appendRecord(common::OwnedSlice{d}, append_opts);
+}
+
+common::Expected<uint64_t, StreamError> TieredStream::append(common::OwnedSlice &&d,
+                                                             const AppendOptions &append_opts) noexcept {
+    return appendRecord(std::move(d), append_opts);
+}
+
+common::Expected<uint64_t, StreamError> TieredStream::appendRecord(common::OwnedSlice &&d,
+                                                                   const AppendOptions &append_opts) noexcept {
+    auto data = std::move(d);
+    const auto record_size = data.size();
+    if (record_size > (_maximum_size_bytes - LOG_ENTRY_HEADER_SIZE)) {
+        return StreamError{StreamErrorCode::RecordTooLarge, {}};
+    }
+
+    std::unique_lock<std::mutex> lock(_lock);
+    if ((!append_opts.remove_oldest_segments_if_full) &&
+        ((_current_size_bytes + record_size + LOG_ENTRY_HEADER_SIZE) > _maximum_size_bytes)) {
+        return StreamError{StreamErrorCode::StreamFull, {}};
+    }
+
+    // When memory is full of records which are not yet in the file tier, wait for the spill thread to catch up.
+    while ((_unspilled_bytes > 0U) && ((_unspilled_bytes + record_size) > _tier_opts.memory_size_bytes)) {
+        auto err = waitForSpill(lock, _next_sequence_number, Durability::Memory);
+        if (!err.ok()) {
+            return err;
+        }
+    }
+
+    const auto seq = _next_sequence_number.fetch_add(1U);
+    _memory_bytes += record_size;
+    _unspilled_bytes += record_size;
+    _records.emplace_back(std::move(data), timestamp(), seq, 0U);
+    updateSizes();
+    // The spill thread honours this for every record up to this one, since they are all written in order
+    if (!append_opts.remove_oldest_segments_if_full) {
+        _keep_oldest_sequence_number = seq + 1U;
+    }
+
+    const auto durability = append_opts.sync_on_append ? Durability::Synced : _tier_opts.durability;
+    if (durability != Durability::Memory) {
+        auto err = waitForSpill(lock, seq + 1U, durability);
+        if (!err.ok()) {
+            return err;
+        }
+    } else if (_unspilled_bytes >= _tier_opts.spill_batch_bytes) {
+        _spill_cv.notify_one();
+    }
+
+    trimMemoryTier();
+    return seq;
+}
+
+common::Expected<OwnedRecord, StreamError> TieredStream::read(const uint64_t sequence_number,
+                                                              const ReadOptions &read_options) const noexcept {
+    auto seq = sequence_number;
+    if (read_options.may_return_later_records) {
+        seq = std::max(seq, _first_sequence_number.load());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (!_records.empty() && (seq >= _records.front().sequence_number)) {
+            if (seq >= _next_sequence_number) {
+                return StreamError{StreamErrorCode::RecordNotFound, RecordNotFoundErrorStr};
+            }
+            const auto &r = _records[static_cast<size_t>(seq - _records.front().sequence_number)];
+            return OwnedRecord{
+                common::OwnedSlice{common::BorrowedSlice(r.data.data(), r.data.size())},
+                r.timestamp,
+                r.sequence_number,
+                0U,
+            };
+        }
+    }
+
+    return _file->read(seq, read_options);
+}
+
+StreamError TieredStream::flush() noexcept {
+    std::unique_lock<std::mutex> lock(_lock);
+    return waitForSpill(lock, _next_sequence_number, Durability::File);
+}
+
+uint64_t TieredStream::removeOlderRecords(const int64_t older_than_timestamp_ms) noexcept {
+    // The file tier decides what can be removed, so make sure it has everything first.
+    std::ignore = flush();
+    const auto removed = _file->removeOlderRecords(older_than_timestamp_ms);
+
+    std::lock_guard<std::mutex> lock(_lock);
+    trimMemoryTier();
+    updateSizes();
+    return removed;
+}
+
+Iterator TieredStream::openOrCreateIterator(const std::string &identifier, IteratorOptions iterator_opts) noexcept {
+    // Iterators are persisted by the file tier, but reads must go through this stream so they can be served from memory
+    const auto file_iterator = _file->openOrCreateIterator(identifier, iterator_opts);
+    return Iterator{WEAK_FROM_THIS(), identifier, file_iterator.sequence_number};
+}
+
+StreamError TieredStream::deleteIterator(const std::string &identifier) noexcept {
+    return _file->deleteIterator(identifier);
+}
+
+StreamError TieredStream::setCheckpoint(const std::string &identifier, const uint64_t sequence_number) noexcept {
+    return _file->setCheckpoint(identifier, sequence_number);
+}
+} // namespace stream
+} // namespace store
+} // namespace aws
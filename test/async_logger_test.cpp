@@ -0,0 +1,220 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <atomic>
+#include <aws/store/common/asyncLogger.hpp>
+#include <aws/store/common/logging.hpp>
+#include <aws/store/filesystem/memoryFileSystem.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace aws::store;
+
+namespace {
+// Keeps every message, optionally waiting until it is allowed to continue
+class CollectingLogger final : public logging::Logger {
+  public:
+    mutable std::mutex lock{};
+    mutable std::condition_variable cv{};
+    mutable std::vector<std::string> messages{};
+    mutable int records{0};
+    bool blocked{false};
+
+    void log(const logging::LogLevel, const std::string &msg) const override {
+        std::unique_lock<std::mutex> l{lock};
+        cv.wait(l, [this]() { return !blocked; });
+        messages.push_back(msg);
+    }
+
+    void record(const logging::LogMessage &message) const override {
+        {
+            std::lock_guard<std::mutex> l{lock};
+            ++records;
+        }
+        Logger::record(message);
+    }
+
+    void unblock() {
+        std::lock_guard<std::mutex> l{lock};
+        blocked = false;
+        cv.notify_all();
+    }
+};
+} // namespace
+
+SCENARIO("Log messages are formatted from their parts", "[logging]") {
+    const std::string text{"text"};
+    const common::ErrorMessage error{std::string{"formatted error"}};
+    const logging::LogMessage message{logging::LogLevel::Info,
+                                      "literal ",
+                                      text,
+                                      " ",
+                                      static_cast<int32_t>(-12),
+                                      " ",
+                                      static_cast<uint64_t>(UINT64_MAX),
+                                      " ",
+                                      error,
+                                      text.c_str()};
+    REQUIRE(message.format() == "literal text -12 18446744073709551615 formatted errortext");
+
+    WHEN("A message has characters and booleans") {
+        const logging::LogMessage typed{logging::LogLevel::Info, 'x', " ", true, " ", false};
+        THEN("They are not formatted as numbers") {
+            REQUIRE(typed.format() == "x true false");
+        }
+    }
+
+    WHEN("A message has a char array which changes before it is formatted") {
+        char buffer[16] = "before";
+        const logging::LogMessage copied{logging::LogLevel::Info, buffer};
+        buffer[0] = 'X';
+        THEN("The array was copied") {
+            REQUIRE(copied.format() == "before");
+        }
+    }
+
+    WHEN("A message has too much text") {
+        const std::string big(logging::LogMessage::TEXT_BYTES + 10U, 'a');
+        THEN("The text which fits is kept, and literals do not take up room") {
+            const logging::LogMessage truncated{logging::LogLevel::Info, common::Literal{"start "}, big,
+                                                common::Literal{"end"}};
+            REQUIRE(truncated.format() ==
+                    "start " + std::string(logging::LogMessage::TEXT_BYTES, 'a') + "end" + "...");
+        }
+        THEN("Char arrays are copied into the text") {
+            const logging::LogMessage truncated{logging::LogLevel::Info, "start ", big, "end"};
+            REQUIRE(truncated.format() ==
+                    "start " + std::string(logging::LogMessage::TEXT_BYTES - 6U, 'a') + "...");
+        }
+    }
+
+    WHEN("A message has too many parts") {
+        const logging::LogMessage truncated{logging::LogLevel::Info, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5,
+                                            6, 7};
+        THEN("The parts which fit are kept") {
+            REQUIRE(truncated.format() == "0123456789012345...");
+        }
+    }
+}
+
+SCENARIO("Messages below the logger's level are not recorded", "[logging]") {
+    auto logger = std::make_shared<CollectingLogger>();
+    logger->level = logging::LogLevel::Warning;
+    const std::shared_ptr<logging::Logger> base = logger;
+
+    logging::log(base, logging::LogLevel::Info, "not logged ", 1);
+    logging::log(base, logging::LogLevel::Warning, "logged ", 2);
+    logging::log(nullptr, logging::LogLevel::Error, "no logger");
+    REQUIRE(logger->records == 1);
+    REQUIRE(logger->messages == std::vector<std::string>{"logged 2"});
+}
+
+SCENARIO("Asynchronous loggers deliver messages from a background thread", "[logging]") {
+    auto target = std::make_shared<CollectingLogger>();
+    target->level = logging::LogLevel::Debug;
+
+    WHEN("Many threads log at once") {
+        auto logger = std::make_shared<logging::AsyncLogger>(target, 64U);
+        REQUIRE(logger->level == logging::LogLevel::Debug);
+        const std::shared_ptr<logging::Logger> base = logger;
+        std::vector<std::thread> threads{};
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&base, t]() {
+                for (int i = 0; i < 200; i++) {
+                    logging::log(base, logging::LogLevel::Info, "thread ", t, " message ", i);
+                    if (i % 16 == 0) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        logger->flush();
+
+        THEN("Every message which was not dropped arrives in the order of its thread") {
+            std::lock_guard<std::mutex> l{target->lock};
+            REQUIRE(target->messages.size() + logger->dropped() == 800U);
+            std::vector<int> next(4U, 0);
+            for (const auto &m : target->messages) {
+                const auto t = m[7] - '0';
+                const auto i = std::stoi(m.substr(m.rfind(' ') + 1U));
+                REQUIRE(i >= next[static_cast<size_t>(t)]);
+                next[static_cast<size_t>(t)] = i + 1;
+            }
+        }
+    }
+
+    WHEN("The other logger is stuck") {
+        target->blocked = true;
+        auto logger = std::make_shared<logging::AsyncLogger>(target, 8U);
+        for (int i = 0; i < 100; i++) {
+            logger->log(logging::LogLevel::Warning, "message " + std::to_string(i));
+        }
+
+        THEN("Logging does not wait, and messages are dropped once the ring is full") {
+            const auto dropped_while_stuck = logger->dropped();
+            target->unblock();
+            REQUIRE(dropped_while_stuck > 0U);
+            logger->flush();
+            std::lock_guard<std::mutex> l{target->lock};
+            REQUIRE(target->messages.size() + logger->dropped() == 100U);
+            REQUIRE(target->messages.front() == "message 0");
+        }
+    }
+
+    WHEN("The logger is destroyed") {
+        {
+            logging::AsyncLogger logger{target};
+            logger.log(logging::LogLevel::Error, "last words");
+        }
+        THEN("Messages which were logged are still delivered") {
+            std::lock_guard<std::mutex> l{target->lock};
+            REQUIRE(target->messages == std::vector<std::string>{"last words"});
+        }
+    }
+}
+
+SCENARIO("Streams log recovery through an asynchronous logger", "[logging][stream]") {
+    auto fs = std::make_shared<filesystem::MemoryFileSystem>();
+    auto target = std::make_shared<CollectingLogger>();
+    auto logger = std::make_shared<logging::AsyncLogger>(target);
+
+    const auto open = [&fs, &logger]() {
+        return stream::FileStream::openOrCreate(stream::StreamOptions{
+            64 * 1024, 10 * 1024 * 1024, true, fs, logger, kv::KVOptions{true, fs, logger, "m", 1024},
+        });
+    };
+    {
+        auto stream = std::move(open().val());
+        for (int i = 0; i < 10; i++) {
+            REQUIRE(stream->append(common::BorrowedSlice{std::string(100, 'x')}, stream::AppendOptions{true, false})
+                        .ok());
+        }
+    }
+    // Cut the last record short
+    const auto files = fs->list().val();
+    for (const auto &f : files) {
+        if (f.find(".log") != std::string::npos) {
+            auto file = std::move(fs->open(f).val());
+            REQUIRE(file->truncate(10U * (32U + 100U) - 5U).ok());
+        }
+    }
+
+    auto stream_or = open();
+    REQUIRE(stream_or.ok());
+    REQUIRE(stream_or.val()->highestSequenceNumber() == 8U);
+    logger->flush();
+    std::lock_guard<std::mutex> l{target->lock};
+    REQUIRE(target->messages.size() == 1U);
+    REQUIRE(target->messages[0].find("Truncating") == 0U);
+}
@@ -0,0 +1,173 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <atomic>
+#include <aws/store/common/bufferPool.hpp>
+#include <aws/store/filesystem/memoryFileSystem.hpp>
+#include <aws/store/stream/compression.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <aws/store/stream/memoryStream.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace aws::store;
+
+SCENARIO("Buffer pools reuse freed slices", "[pool]") {
+    common::BufferPoolOptions opts{};
+    opts.max_buffer_size = 4096U;
+    opts.max_retained_bytes = 64U * 1024U;
+    opts.buffers_per_thread = 4U;
+    auto pool = std::make_shared<common::BufferPool>(opts);
+
+    const std::string value{"some record"};
+    {
+        const common::OwnedSlice slice{common::BorrowedSlice{value}, pool};
+        REQUIRE(slice.string() == value);
+        REQUIRE(pool->stats().misses == 1U);
+    }
+    // The buffer is kept once the slice is freed, and given to the next slice of a similar size
+    REQUIRE(pool->stats().retained_bytes == 64U);
+    {
+        const common::OwnedSlice slice{40U, pool};
+        REQUIRE(pool->stats().hits == 1U);
+        REQUIRE(pool->stats().retained_bytes == 0U);
+    }
+
+    WHEN("Slices are too large to pool") {
+        { const common::OwnedSlice slice{8192U, pool}; }
+        THEN("They are freed as usual") {
+            REQUIRE(pool->stats().misses == 2U);
+            REQUIRE(pool->stats().retained_bytes == 64U);
+        }
+    }
+
+    WHEN("More slices are freed than the pool may keep") {
+        std::vector<common::OwnedSlice> slices{};
+        for (int i = 0; i < 40; i++) {
+            slices.emplace_back(4000U, pool);
+        }
+        slices.clear();
+        THEN("Only as many bytes as allowed are kept") {
+            REQUIRE(pool->stats().retained_bytes <= opts.max_retained_bytes);
+            REQUIRE(pool->stats().retained_bytes > opts.max_retained_bytes - 4096U);
+        }
+    }
+
+    WHEN("Many threads take and free slices at once") {
+        std::atomic<int> failures{0};
+        std::vector<std::thread> threads{};
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&pool, &failures, t]() {
+                for (int i = 0; i < 1000; i++) {
+                    const auto size = static_cast<uint32_t>(1 + ((i * 37 + t) % 4096));
+                    common::OwnedSlice slice{size, pool};
+                    memset(slice.data(), t, size);
+                    if (static_cast<const uint8_t *>(slice.data())[size - 1U] != t) {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        THEN("Most slices reuse memory") {
+            REQUIRE(failures == 0);
+            const auto stats = pool->stats();
+            REQUIRE(stats.hits + stats.misses == 4002U);
+            REQUIRE(stats.hits > stats.misses);
+            REQUIRE(stats.retained_bytes <= opts.max_retained_bytes);
+        }
+    }
+}
+
+SCENARIO("Streams read records into pooled buffers", "[stream][pool]") {
+    auto fs = std::make_shared<filesystem::MemoryFileSystem>();
+    auto pool = std::make_shared<common::BufferPool>();
+    const auto kind = GENERATE(0, 1, 2);
+
+    std::shared_ptr<stream::StreamInterface> stream{};
+    auto opts = stream::StreamOptions{
+        64 * 1024, 10 * 1024 * 1024, true, fs, nullptr, kv::KVOptions{true, fs, nullptr, "m", 1024},
+    };
+    opts.buffer_pool = pool;
+    // Both one header per record and batched frames
+    opts.batched_record_frames = kind == 1;
+    if (kind == 2) {
+        stream = stream::MemoryStream::openOrCreate(std::move(opts));
+    } else {
+        stream = std::move(stream::FileStream::openOrCreate(std::move(opts)).val());
+    }
+
+    std::vector<std::string> values{};
+    for (int i = 0; i < 100; i++) {
+        std::string value{};
+        test::utils::random_string(value, static_cast<size_t>(1 + (i * 131) % 2000));
+        REQUIRE(stream->append(common::BorrowedSlice{value}, stream::AppendOptions{true, false}).ok());
+        values.push_back(std::move(value));
+    }
+    for (int round = 0; round < 2; round++) {
+        for (uint64_t i = 0U; i < values.size(); i++) {
+            auto record_or = stream->read(i, stream::ReadOptions{true, false, 0U});
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().data.string() == values[i]);
+        }
+    }
+
+    // The second round reads into buffers freed by the first
+    const auto stats = pool->stats();
+    REQUIRE(stats.hits + stats.misses == 2U * values.size());
+    REQUIRE(stats.hits >= values.size());
+    REQUIRE(stats.retained_bytes > 0U);
+}
+
+SCENARIO("Compressed segments read records into pooled buffers", "[stream][pool][compression]") {
+    auto fs = std::make_shared<filesystem::MemoryFileSystem>();
+    auto pool = std::make_shared<common::BufferPool>();
+    auto opts = stream::StreamOptions{
+        64 * 1024, 10 * 1024 * 1024, true, fs, nullptr, kv::KVOptions{true, fs, nullptr, "m", 1024},
+    };
+    opts.buffer_pool = pool;
+    opts.batched_record_frames = GENERATE(false, true);
+    opts.segment_compression_codec = std::make_shared<stream::Lz77Codec>();
+    auto stream = std::move(stream::FileStream::openOrCreate(std::move(opts)).val());
+
+    std::vector<std::string> values{};
+    for (int i = 0; i < 3000; i++) {
+        values.emplace_back("{\"sensor\":\"temperature\",\"index\":" + std::to_string(i) + "}");
+        REQUIRE(stream->append(common::BorrowedSlice{values.back()}, stream::AppendOptions{true, false}).ok());
+    }
+    const auto compressed_segments = [&fs]() {
+        auto count = 0U;
+        const auto files = fs->list().val();
+        for (const auto &f : files) {
+            count += (f.size() > 5U && f.compare(f.size() - 5U, 5U, ".logz") == 0) ? 1U : 0U;
+        }
+        return count;
+    };
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{20};
+    while ((compressed_segments() < 2U) && (std::chrono::steady_clock::now() < deadline)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    REQUIRE(compressed_segments() >= 2U);
+
+    for (int round = 0; round < 2; round++) {
+        for (uint64_t i = 0U; i < values.size(); i++) {
+            auto record_or = stream->read(i, stream::ReadOptions{true, false, 0U});
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().data.string() == values[i]);
+        }
+    }
+
+    // Records from compressed segments are pooled like any others
+    const auto stats = pool->stats();
+    REQUIRE(stats.hits + stats.misses == 2U * values.size());
+    REQUIRE(stats.hits >= values.size());
+}
@@ -0,0 +1,160 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <atomic>
+#include <aws/store/filesystem/cachingFileSystem.hpp>
+#include <aws/store/filesystem/posixFileSystem.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace aws::store;
+
+SCENARIO("Cached files are closed and reopened within the budget", "[fs][cache]") {
+    auto temp_dir = test::utils::TempDir();
+    auto cache = std::make_shared<filesystem::FileHandleCache>(2U);
+    // Two file systems share one budget
+    auto posix = std::make_shared<filesystem::PosixFileSystem>(temp_dir.path());
+    auto unbuffered = std::make_shared<filesystem::PosixUnbufferedFileSystem>(temp_dir.path() / "unbuffered", 64U);
+    filesystem::CachingFileSystem first{posix, cache};
+    filesystem::CachingFileSystem second{unbuffered, cache};
+
+    std::vector<std::unique_ptr<filesystem::FileLike>> files{};
+    std::vector<std::string> expected{};
+    for (int i = 0; i < 6; i++) {
+        auto &fs = i % 2 == 0 ? first : second;
+        auto f_or = fs.open("file" + std::to_string(i));
+        REQUIRE(f_or.ok());
+        files.push_back(std::move(f_or.val()));
+        // Not flushed, so the data is still buffered when the file is closed by the cache
+        expected.push_back("value" + std::to_string(i));
+        REQUIRE(files.back()->append(common::BorrowedSlice{expected.back()}).ok());
+        REQUIRE(cache->openFiles() <= cache->maxOpen());
+        REQUIRE(files.back()->async() == nullptr);
+    }
+
+    // Every file is opened again to be read and written
+    for (int round = 0; round < 3; round++) {
+        for (size_t i = 0; i < files.size(); i++) {
+            auto read_or = files[i]->read(0, static_cast<uint32_t>(expected[i].size()));
+            REQUIRE(read_or.ok());
+            REQUIRE(read_or.val().string() == expected[i]);
+            REQUIRE(cache->openFiles() <= cache->maxOpen());
+
+            REQUIRE(files[i]->append(common::BorrowedSlice{std::string{"+"}}).ok());
+            expected[i] += "+";
+            REQUIRE(files[i]->truncate(static_cast<uint32_t>(expected[i].size() - 1U)).ok());
+            expected[i].pop_back();
+            files[i]->sync();
+        }
+    }
+
+    // Closing files gives their place in the budget back
+    files.clear();
+    REQUIRE(cache->openFiles() == 0U);
+    REQUIRE(std::filesystem::file_size(temp_dir.path() / "file0") == expected[0].size());
+    REQUIRE(std::filesystem::file_size(temp_dir.path() / "unbuffered" / "file1") == expected[1].size());
+}
+
+SCENARIO("Cached files can be used by many threads at once", "[fs][cache]") {
+    auto temp_dir = test::utils::TempDir();
+    auto cache = std::make_shared<filesystem::FileHandleCache>(3U);
+    filesystem::CachingFileSystem fs{std::make_shared<filesystem::PosixFileSystem>(temp_dir.path()), cache};
+
+    std::vector<std::vector<std::unique_ptr<filesystem::FileLike>>> files(4U);
+    for (size_t t = 0; t < files.size(); t++) {
+        for (int i = 0; i < 3; i++) {
+            files[t].push_back(std::move(fs.open(std::to_string(t) + "-" + std::to_string(i)).val()));
+        }
+    }
+    std::string expected{};
+    for (int i = 0; i < 200; i++) {
+        expected += std::to_string(i) + ";";
+    }
+
+    // Catch assertions are not thread safe, so each thread only counts the files it could not read back
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads{};
+    for (auto &thread_files : files) {
+        threads.emplace_back([&thread_files, &failures]() {
+            for (int i = 0; i < 200; i++) {
+                const auto value = std::to_string(i) + ";";
+                for (auto &f : thread_files) {
+                    if (!f->append(common::BorrowedSlice{value}).ok()) {
+                        ++failures;
+                    }
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    threads.clear();
+    for (auto &thread_files : files) {
+        threads.emplace_back([&thread_files, &failures, &expected]() {
+            for (auto &f : thread_files) {
+                auto read_or = f->read(0, static_cast<uint32_t>(expected.size()));
+                if (!read_or.ok() || (read_or.val().string() != expected)) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    REQUIRE(failures == 0);
+    REQUIRE(cache->openFiles() <= cache->maxOpen());
+    files.clear();
+    REQUIRE(cache->openFiles() == 0U);
+}
+
+SCENARIO("Streams with more segments than open files", "[stream][cache]") {
+    auto temp_dir = test::utils::TempDir();
+    auto cache = std::make_shared<filesystem::FileHandleCache>(4U);
+    auto fs = std::make_shared<filesystem::CachingFileSystem>(
+        std::make_shared<filesystem::PosixFileSystem>(temp_dir.path()), cache);
+    const auto batched = GENERATE(false, true);
+
+    const auto open = [&fs, batched]() {
+        auto opts = stream::StreamOptions{
+            16 * 1024, 10 * 1024 * 1024, true, fs, nullptr, kv::KVOptions{true, fs, nullptr, "m", 1024},
+        };
+        opts.batched_record_frames = batched;
+        return stream::FileStream::openOrCreate(std::move(opts));
+    };
+
+    auto stream_or = open();
+    REQUIRE(stream_or.ok());
+    std::vector<std::string> values;
+    for (int i = 0; i < 100; i++) {
+        std::string value;
+        test::utils::random_string(value, 2048);
+        REQUIRE(stream_or.val()->append(common::BorrowedSlice{value}, stream::AppendOptions{i % 10 == 0, false}).ok());
+        values.push_back(std::move(value));
+        REQUIRE(cache->openFiles() <= cache->maxOpen());
+    }
+
+    const auto check = [&values, &cache](const std::shared_ptr<stream::FileStream> &stream) {
+        REQUIRE(stream->highestSequenceNumber() == values.size() - 1);
+        for (auto i = stream->firstSequenceNumber(); i < values.size(); i++) {
+            auto record_or = stream->read(i, stream::ReadOptions{true, false, 0U});
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().data.string() == values[i]);
+            REQUIRE(cache->openFiles() <= cache->maxOpen());
+        }
+    };
+    check(stream_or.val());
+
+    stream_or.val().reset();
+    stream_or = open();
+    REQUIRE(stream_or.ok());
+    check(stream_or.val());
+}
@@ -0,0 +1,271 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <aws/store/filesystem/posixFileSystem.hpp>
+#include <aws/store/stream/circularFileStream.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+static auto open_circular_stream(const std::shared_ptr<aws::store::filesystem::FileSystemInterface> &fs,
+                                 const bool full_corruption_check_on_open = false) {
+    return aws::store::stream::CircularFileStream::openOrCreate(aws::store::stream::StreamOptions{
+        0,
+        64 * 1024,
+        full_corruption_check_on_open,
+        fs,
+        {},
+        aws::store::kv::KVOptions{
+            true,
+            fs,
+            {},
+            "m",
+            1 * 1024,
+        },
+    });
+}
+
+SCENARIO("Circular stream overwrites the oldest records", "[circular]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+
+    auto stream_or = open_circular_stream(fs);
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+    const auto file_path = temp_dir.path() / aws::store::stream::CircularFileIdentifier;
+    REQUIRE(std::filesystem::file_size(file_path) == 64U * 1024U);
+
+    std::vector<std::string> values;
+    for (auto i = 0U; i < 500U; i++) {
+        std::string value;
+        aws::store::test::utils::random_string(value, 1000);
+        auto seq_or = stream->append(aws::store::common::BorrowedSlice{value}, aws::store::stream::AppendOptions{});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == i);
+        values.emplace_back(std::move(value));
+    }
+
+    THEN("The file never grows and only the newest records are kept") {
+        REQUIRE(std::filesystem::file_size(file_path) == 64U * 1024U);
+        REQUIRE(stream->highestSequenceNumber() == 499U);
+        REQUIRE(stream->firstSequenceNumber() > 430U);
+        REQUIRE(stream->currentSizeBytes() <= 64U * 1024U);
+        REQUIRE(stream->read(0, aws::store::stream::ReadOptions{}).err().code ==
+                aws::store::stream::StreamErrorCode::RecordNotFound);
+        for (auto i = stream->firstSequenceNumber(); i < values.size(); i++) {
+            auto record_or = stream->read(i, aws::store::stream::ReadOptions{});
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().data.string() == values[i]);
+        }
+    }
+
+    THEN("Appends can fail instead of overwriting") {
+        auto seq_or = stream->append(aws::store::common::BorrowedSlice{values[0]},
+                                     aws::store::stream::AppendOptions{false, false});
+        REQUIRE(seq_or.err().code == aws::store::stream::StreamErrorCode::StreamFull);
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{std::string(64 * 1024, 'a')},
+                               aws::store::stream::AppendOptions{})
+                    .err()
+                    .code == aws::store::stream::StreamErrorCode::RecordTooLarge);
+    }
+
+    WHEN("I reopen the stream") {
+        const auto first = stream->firstSequenceNumber();
+        auto it = stream->openOrCreateIterator("ita", aws::store::stream::IteratorOptions{});
+        REQUIRE(it.sequence_number == first);
+        ++it;
+        REQUIRE((*it).val().checkpoint().ok());
+
+        stream.reset();
+        stream_or = open_circular_stream(fs, true);
+        REQUIRE(stream_or.ok());
+        stream = std::move(stream_or.val());
+
+        THEN("All records and iterators are still there") {
+            REQUIRE(stream->firstSequenceNumber() == first);
+            REQUIRE(stream->highestSequenceNumber() == 499U);
+            for (auto i = first; i < values.size(); i++) {
+                auto record_or = stream->read(i, aws::store::stream::ReadOptions{});
+                REQUIRE(record_or.ok());
+                REQUIRE(record_or.val().data.string() == values[i]);
+            }
+            REQUIRE(stream->openOrCreateIterator("ita", aws::store::stream::IteratorOptions{}).sequence_number ==
+                    first + 2U);
+
+            auto seq_or =
+                stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{});
+            REQUIRE(seq_or.ok());
+            REQUIRE(seq_or.val() == 500U);
+        }
+    }
+
+    WHEN("I remove older records") {
+        REQUIRE(stream->removeOlderRecords(aws::store::stream::timestamp() + 1) > 0U);
+        THEN("The stream is empty but keeps its sequence numbers") {
+            REQUIRE(stream->currentSizeBytes() == 0U);
+            REQUIRE(stream->firstSequenceNumber() == 500U);
+            auto seq_or =
+                stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{});
+            REQUIRE(seq_or.ok());
+            REQUIRE(seq_or.val() == 500U);
+            REQUIRE(stream->read(500, aws::store::stream::ReadOptions{}).val().data.string() == "val");
+        }
+    }
+}
+
+SCENARIO("Circular stream recovers from a corrupted header", "[circular]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+
+    auto stream_or = open_circular_stream(fs);
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+    for (auto i = 0; i < 10; i++) {
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"val" + std::to_string(i)},
+                               aws::store::stream::AppendOptions{})
+                    .ok());
+    }
+    stream.reset();
+
+    // Whichever slot holds the newest header, the other one plus the records which follow it are enough
+    for (const auto slot : {0, 1}) {
+        {
+            std::fstream file(temp_dir.path() / aws::store::stream::CircularFileIdentifier,
+                              std::ios::in | std::ios::out | std::ios::binary);
+            REQUIRE(file);
+            file.seekp(slot * 512 + 20);
+            file.put('\xFF');
+        }
+
+        stream_or = open_circular_stream(fs);
+        REQUIRE(stream_or.ok());
+        stream = std::move(stream_or.val());
+        REQUIRE(stream->firstSequenceNumber() == 0U);
+        REQUIRE(stream->highestSequenceNumber() == 9U);
+        for (auto i = 0U; i < 10U; i++) {
+            auto record_or = stream->read(i, aws::store::stream::ReadOptions{});
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().data.string() == "val" + std::to_string(i));
+        }
+        stream.reset();
+    }
+}
+
+SCENARIO("Circular stream keeps the records after a corrupted oldest record", "[circular]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+
+    auto stream_or = open_circular_stream(fs);
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+    std::vector<std::string> values;
+    for (auto i = 0U; i < 500U; i++) {
+        std::string value;
+        aws::store::test::utils::random_string(value, 1000);
+        // Sync the last one so that the header knows about every record
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{value}, aws::store::stream::AppendOptions{i == 499U})
+                    .ok());
+        values.emplace_back(std::move(value));
+    }
+    const auto first = stream->firstSequenceNumber();
+    REQUIRE(first > 0U);
+    stream.reset();
+
+    // Find the oldest record by its magic, length, and sequence number, and break its header
+    {
+        const auto file_path = temp_dir.path() / aws::store::stream::CircularFileIdentifier;
+        std::ifstream in(file_path, std::ios::binary);
+        const std::string contents{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+        const uint32_t magic_and_length[2] = {0x43524301U, 1000U};
+        std::string pattern(reinterpret_cast<const char *>(magic_and_length), sizeof(magic_and_length));
+        pattern.append(reinterpret_cast<const char *>(&first), sizeof(first));
+        const auto tail = contents.find(pattern);
+        REQUIRE(tail != std::string::npos);
+
+        std::fstream file(file_path, std::ios::in | std::ios::out | std::ios::binary);
+        REQUIRE(file);
+        file.seekp(static_cast<std::streamoff>(tail));
+        file.put('\xFF');
+    }
+
+    const bool full_corruption_check_on_open = GENERATE(false, true);
+    stream_or = open_circular_stream(fs, full_corruption_check_on_open);
+    REQUIRE(stream_or.ok());
+    stream = std::move(stream_or.val());
+
+    THEN("Only the unreadable record is dropped") {
+        REQUIRE(stream->firstSequenceNumber() == first + 1U);
+        REQUIRE(stream->highestSequenceNumber() == 499U);
+        REQUIRE(stream->currentSizeBytes() == (499U - first) * (32U + 1000U));
+        for (auto i = first + 1U; i < values.size(); i++) {
+            auto record_or = stream->read(i, aws::store::stream::ReadOptions{true});
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().data.string() == values[i]);
+        }
+
+        auto seq_or = stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == 500U);
+    }
+}
+
+SCENARIO("Circular stream only writes its header when it has to", "[circular]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+    const auto file_path = temp_dir.path() / aws::store::stream::CircularFileIdentifier;
+    // The newest generation of the two header slots
+    const auto generation = [](const std::filesystem::path &path) {
+        std::ifstream file(path, std::ios::binary);
+        uint64_t newest = 0U;
+        for (const auto slot : {0, 1}) {
+            uint64_t g = 0U;
+            file.seekg(slot * 512 + 8);
+            file.read(reinterpret_cast<char *>(&g), sizeof(g));
+            newest = std::max(newest, g);
+        }
+        return newest;
+    };
+
+    auto stream_or = open_circular_stream(fs);
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+    const auto opened = generation(file_path);
+    for (auto i = 0; i < 10; i++) {
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"val" + std::to_string(i)},
+                               aws::store::stream::AppendOptions{})
+                    .ok());
+    }
+    REQUIRE(generation(file_path) == opened);
+
+    THEN("Records appended since the header was written are recovered") {
+        // As if the process had stopped without closing the stream
+        auto copy_dir = aws::store::test::utils::TempDir();
+        std::filesystem::create_directories(copy_dir.path());
+        std::filesystem::copy_file(file_path, copy_dir.path() / aws::store::stream::CircularFileIdentifier);
+        auto copy_or = open_circular_stream(std::make_shared<aws::store::filesystem::PosixFileSystem>(copy_dir.path()));
+        REQUIRE(copy_or.ok());
+        REQUIRE(copy_or.val()->highestSequenceNumber() == 9U);
+        for (auto i = 0U; i < 10U; i++) {
+            REQUIRE(copy_or.val()->read(i, aws::store::stream::ReadOptions{}).val().data.string() ==
+                    "val" + std::to_string(i));
+        }
+    }
+
+    THEN("Synced appends and closing the stream write the header") {
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"synced"}, aws::store::stream::AppendOptions{true})
+                    .ok());
+        REQUIRE(generation(file_path) == opened + 1U);
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"unsynced"}, aws::store::stream::AppendOptions{})
+                    .ok());
+        stream.reset();
+        REQUIRE(generation(file_path) == opened + 2U);
+    }
+}
@@ -0,0 +1,76 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <aws/store/common/crc32.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <string>
+
+using namespace aws::store::common;
+
+static uint32_t bytewise_crc(const std::string &data, const size_t offset, const size_t len) {
+    const auto *u = reinterpret_cast<const uint8_t *>(data.data()) + offset;
+    return crc32::detail::updateBytewise(0xFFFFFFFFU, u, len) ^ 0xFFFFFFFFU;
+}
+
+SCENARIO("CRC32 matches the IEEE check value", "[crc32]") {
+    const std::string check{"123456789"};
+    REQUIRE(crc32::update(0, check.data(), check.size()) == 0xCBF43926U);
+    REQUIRE(crc32::update(0, check.data(), 0) == 0U);
+    REQUIRE(crc32::crc32_of({BorrowedSlice{check}}) == 0xCBF43926U);
+}
+
+SCENARIO("CRC32 kernels give identical results", "[crc32]") {
+    std::string data;
+    aws::store::test::utils::random_string(data, 4096 + 64);
+
+    // Cover every alignment and the boundaries where the vectorized kernels hand over to the scalar ones
+    for (size_t offset = 0; offset < 16; offset++) {
+        for (size_t len = 0; len < 300; len++) {
+            const auto expected = bytewise_crc(data, offset, len);
+            const auto *u = reinterpret_cast<const uint8_t *>(data.data()) + offset;
+            REQUIRE((crc32::detail::updateSlicingBy8(0xFFFFFFFFU, u, len) ^ 0xFFFFFFFFU) == expected);
+            REQUIRE(crc32::update(0, u, len) == expected);
+        }
+    }
+    REQUIRE(crc32::update(0, data.data(), data.size()) == bytewise_crc(data, 0, data.size()));
+
+    // Incremental updates give the same result as a single one
+    for (size_t split = 0; split <= data.size(); split += 97) {
+        const auto first = crc32::update(0, data.data(), split);
+        REQUIRE(crc32::update(first, data.data() + split, data.size() - split) == bytewise_crc(data, 0, data.size()));
+    }
+}
+
+SCENARIO("CRC32 of separate parts can be combined", "[crc32]") {
+    std::string data;
+    aws::store::test::utils::random_string(data, 10000);
+    const auto whole = crc32::update(0, data.data(), data.size());
+
+    for (const size_t split : {size_t{0}, size_t{1}, size_t{7}, size_t{64}, size_t{4095}, size_t{9999}, data.size()}) {
+        const auto first = crc32::update(0, data.data(), split);
+        const auto second = crc32::update(0, data.data() + split, data.size() - split);
+        REQUIRE(crc32::crc32_combine(first, second, data.size() - split) == whole);
+    }
+}
+
+SCENARIO("CRC32 benchmarks", "[.][benchmark][crc32]") {
+    std::string data;
+    aws::store::test::utils::random_string(data, 64 * 1024);
+    const auto *u = reinterpret_cast<const uint8_t *>(data.data());
+
+    BENCHMARK("bytewise 64KB") {
+        return crc32::detail::updateBytewise(0xFFFFFFFFU, u, data.size());
+    };
+    BENCHMARK("slicing-by-8 64KB") {
+        return crc32::detail::updateSlicingBy8(0xFFFFFFFFU, u, data.size());
+    };
+    BENCHMARK("dispatched 64KB") {
+        return crc32::update(0, u, data.size());
+    };
+    BENCHMARK("dispatched 64 bytes") {
+        return crc32::update(0, u, 64);
+    };
+}
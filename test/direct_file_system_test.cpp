@@ -0,0 +1,195 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <aws/store/filesystem/directFileSystem.hpp>
+#include <aws/store/filesystem/posixFileSystem.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aws::store;
+
+static common::BorrowedSlice slice_of(const std::string &s, const size_t begin, const size_t end) {
+    return common::BorrowedSlice{s.data() + begin, static_cast<uint32_t>(end - begin)};
+}
+
+SCENARIO("Direct files keep their contents across flushes, truncation and reopening", "[fs][direct]") {
+    auto temp_dir = test::utils::TempDir();
+    // A small block size so that appends cross many block boundaries
+    auto fs = std::make_shared<filesystem::DirectFileSystem>(temp_dir.path(), 8192U, 2U);
+    const auto on_disk = [&temp_dir]() { return std::filesystem::file_size(temp_dir.path() / "file"); };
+
+    std::string source;
+    test::utils::random_string(source, 100 * 1024);
+    std::string expected;
+
+    auto f_or = fs->open("file");
+    REQUIRE(f_or.ok());
+    auto f = std::move(f_or.val());
+
+    std::minstd_rand rand{42};
+    size_t position = 0;
+    for (int i = 0; i < 200; i++) {
+        const auto length = rand() % 1500;
+        const auto begin = position % (source.size() - 1500);
+        REQUIRE(f->append(slice_of(source, begin, begin + length)).ok());
+        expected += source.substr(begin, length);
+        position += length;
+
+        if (i % 17 == 0) {
+            REQUIRE(f->flush().ok());
+            REQUIRE(on_disk() == expected.size());
+        }
+        if (i % 23 == 0) {
+            // Roll back the last append, as a failed append would
+            REQUIRE(f->truncate(static_cast<uint32_t>(expected.size() - length)).ok());
+            expected.resize(expected.size() - length);
+        }
+        if (i % 31 == 0) {
+            // Truncate further back than the tail
+            const auto new_size = expected.size() > 20000 ? expected.size() - 20000 : 0;
+            REQUIRE(f->truncate(static_cast<uint32_t>(new_size)).ok());
+            expected.resize(new_size);
+        }
+        if ((i % 7 == 0) && !expected.empty()) {
+            const auto b = rand() % expected.size();
+            const auto e = b + rand() % (expected.size() - b) + 1;
+            auto read_or = f->read(static_cast<uint32_t>(b), static_cast<uint32_t>(e));
+            REQUIRE(read_or.ok());
+            REQUIRE(read_or.val().string() == expected.substr(b, e - b));
+        }
+    }
+
+    auto read_or = f->read(0, static_cast<uint32_t>(expected.size()));
+    REQUIRE(read_or.ok());
+    REQUIRE(read_or.val().string() == expected);
+    read_or = f->read(0, static_cast<uint32_t>(expected.size() + 1));
+    REQUIRE(!read_or.ok());
+    REQUIRE(read_or.err().code == filesystem::FileErrorCode::EndOfFile);
+
+    // Writing in place works both in the file and in the tail
+    REQUIRE(expected.size() > 20000);
+    const std::string patch(300, '#');
+    for (const auto offset : {size_t{10}, size_t{8000}, expected.size() - 5000, expected.size() - 100}) {
+        REQUIRE(f->writeAt(static_cast<uint32_t>(offset), common::BorrowedSlice{patch.data(), 100}).ok());
+        expected.replace(offset, 100, patch.substr(0, 100));
+    }
+    REQUIRE(!f->writeAt(static_cast<uint32_t>(expected.size() - 10), common::BorrowedSlice{patch}).ok());
+
+    f.reset();
+    REQUIRE(on_disk() == expected.size());
+    f_or = fs->open("file");
+    REQUIRE(f_or.ok());
+    f = std::move(f_or.val());
+    read_or = f->read(0, static_cast<uint32_t>(expected.size()));
+    REQUIRE(read_or.ok());
+    REQUIRE(read_or.val().string() == expected);
+
+    // Appending after reopening continues the partial block at the end
+    REQUIRE(f->append(slice_of(source, 0, 5000)).ok());
+    expected += source.substr(0, 5000);
+    f.reset();
+    f_or = fs->open("file");
+    REQUIRE(f_or.ok());
+    read_or = f_or.val()->read(0, static_cast<uint32_t>(expected.size()));
+    REQUIRE(read_or.ok());
+    REQUIRE(read_or.val().string() == expected);
+}
+
+SCENARIO("Streams can be stored in direct files", "[stream][direct]") {
+    auto temp_dir = test::utils::TempDir();
+    auto fs = std::make_shared<filesystem::DirectFileSystem>(temp_dir.path());
+    const auto batched = GENERATE(false, true);
+
+    const auto open = [&fs, batched]() {
+        auto opts = stream::StreamOptions{
+            256 * 1024, 10 * 1024 * 1024, true, fs, nullptr, kv::KVOptions{true, fs, nullptr, "m", 1024},
+        };
+        opts.batched_record_frames = batched;
+        return stream::FileStream::openOrCreate(std::move(opts));
+    };
+
+    auto stream_or = open();
+    REQUIRE(stream_or.ok());
+    std::vector<std::string> values;
+    for (int i = 0; i < 300; i++) {
+        std::string value;
+        test::utils::random_string(value, static_cast<size_t>(1 + (i * 7919) % 10000));
+        REQUIRE(stream_or.val()->append(common::BorrowedSlice{value}, stream::AppendOptions{i % 5 == 0, true}).ok());
+        values.push_back(std::move(value));
+    }
+
+    stream_or.val().reset();
+    stream_or = open();
+    REQUIRE(stream_or.ok());
+    const auto &stream = stream_or.val();
+    REQUIRE(stream->highestSequenceNumber() == values.size() - 1);
+    for (auto i = stream->firstSequenceNumber(); i < values.size(); i++) {
+        auto record_or = stream->read(i, stream::ReadOptions{true, false, 0U});
+        REQUIRE(record_or.ok());
+        REQUIRE(record_or.val().data.string() == values[i]);
+    }
+}
+
+SCENARIO("Direct and buffered file system performance", "[.][benchmark][direct]") {
+    auto temp_dir = test::utils::TempDir();
+    std::string record;
+    test::utils::random_string(record, 1024);
+    constexpr int records = 4096;
+
+    const auto append_records = [&record](filesystem::FileSystemInterface &fs, const std::string &name,
+                                          const bool sync) {
+        std::ignore = fs.remove(name);
+        auto f = std::move(fs.open(name).val());
+        for (int i = 0; i < records; i++) {
+            std::ignore = f->append(common::BorrowedSlice{record});
+            std::ignore = f->flush();
+            if (sync && (i % 64 == 0)) {
+                f->sync();
+            }
+        }
+        return f;
+    };
+    const auto read_records = [&record](filesystem::FileLike &f) {
+        size_t total = 0;
+        for (uint32_t i = 0; i < records; i++) {
+            total += f.read(i * static_cast<uint32_t>(record.size()), (i + 1) * static_cast<uint32_t>(record.size()))
+                         .val()
+                         .size();
+        }
+        return total;
+    };
+
+    filesystem::PosixFileSystem posix{temp_dir.path() / "posix"};
+    filesystem::DirectFileSystem direct{temp_dir.path() / "direct"};
+
+    BENCHMARK("Posix append and flush 4MB") {
+        return append_records(posix, "file", false);
+    };
+    BENCHMARK("Direct append and flush 4MB") {
+        return append_records(direct, "file", false);
+    };
+    BENCHMARK("Posix append 4MB with a sync every 64 records") {
+        return append_records(posix, "file", true);
+    };
+    BENCHMARK("Direct append 4MB with a sync every 64 records") {
+        return append_records(direct, "file", true);
+    };
+
+    auto posix_file = append_records(posix, "read", false);
+    auto direct_file = append_records(direct, "read", false);
+    BENCHMARK("Posix sequential reads") {
+        return read_records(*posix_file);
+    };
+    BENCHMARK("Direct sequential reads") {
+        return read_records(*direct_file);
+    };
+}
@@ -0,0 +1,220 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <aws/store/common/expected.hpp>
+#include <aws/store/common/util.hpp>
+#include <aws/store/filesystem/memoryFileSystem.hpp>
+#include <aws/store/kv/kv.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+
+using namespace aws::store;
+
+// Count the allocations made by this thread while counting is turned on
+static thread_local bool counting_allocations = false;
+static thread_local size_t allocations = 0U;
+
+// Not inlined, so that the compiler does not see new paired with free()
+__attribute__((noinline)) static void *countedAlloc(const size_t size) noexcept {
+    if (counting_allocations) {
+        ++allocations;
+    }
+    return malloc(size == 0U ? 1U : size);
+}
+
+__attribute__((noinline)) static void countedFree(void *p) noexcept {
+    free(p);
+}
+
+void *operator new(const size_t size) {
+    auto *const p = countedAlloc(size);
+    if (p == nullptr) {
+        abort();
+    }
+    return p;
+}
+void *operator new[](const size_t size) {
+    return operator new(size);
+}
+void *operator new(const size_t size, const std::nothrow_t &) noexcept {
+    return countedAlloc(size);
+}
+void *operator new[](const size_t size, const std::nothrow_t &) noexcept {
+    return countedAlloc(size);
+}
+void operator delete(void *p) noexcept {
+    countedFree(p);
+}
+void operator delete[](void *p) noexcept {
+    countedFree(p);
+}
+void operator delete(void *p, size_t) noexcept {
+    countedFree(p);
+}
+void operator delete[](void *p, size_t) noexcept {
+    countedFree(p);
+}
+
+template <typename F> static size_t allocationsOf(F &&f) {
+    allocations = 0U;
+    counting_allocations = true;
+    f();
+    counting_allocations = false;
+    return allocations;
+}
+
+namespace {
+// Counts how many instances are alive
+struct Tracked {
+    static int alive;
+    int value{0};
+
+    Tracked() {
+        ++alive;
+    }
+    explicit Tracked(const int v) : value(v) {
+        ++alive;
+    }
+    Tracked(const Tracked &other) : value(other.value) {
+        ++alive;
+    }
+    Tracked(Tracked &&other) noexcept : value(other.value) {
+        ++alive;
+    }
+    Tracked &operator=(const Tracked &) = default;
+    Tracked &operator=(Tracked &&) = default;
+    ~Tracked() {
+        --alive;
+    }
+};
+int Tracked::alive = 0;
+} // namespace
+
+SCENARIO("Expected holds only a value or an error", "[expected]") {
+    using Error = common::GenericError<stream::StreamErrorCode>;
+    // Not both side by side
+    REQUIRE(sizeof(common::Expected<stream::OwnedRecord, stream::StreamError>) <
+            sizeof(stream::OwnedRecord) + sizeof(stream::StreamError));
+    REQUIRE(sizeof(stream::StreamError) < sizeof(stream::StreamErrorCode) + sizeof(std::string));
+
+    {
+        common::Expected<Tracked, Error> value{Tracked{1}};
+        REQUIRE(Tracked::alive == 1);
+        common::Expected<Tracked, Error> error{Error{stream::StreamErrorCode::RecordNotFound, "missing"}};
+        REQUIRE(Tracked::alive == 1);
+        REQUIRE(error.err().msg == "missing");
+
+        auto copy = value;
+        REQUIRE(Tracked::alive == 2);
+        REQUIRE(copy.val().value == 1);
+        copy = error;
+        REQUIRE(Tracked::alive == 1);
+        REQUIRE(!copy.ok());
+        copy = std::move(value);
+        REQUIRE(Tracked::alive == 2);
+        REQUIRE(copy.val().value == 1);
+        copy = common::Expected<Tracked, Error>{Tracked{2}};
+        REQUIRE(Tracked::alive == 2);
+        REQUIRE(copy.val().value == 2);
+
+        auto other_error = error;
+        other_error = common::Expected<Tracked, Error>{Error{stream::StreamErrorCode::ReadError, "read"}};
+        REQUIRE(other_error.err().msg == "read");
+        REQUIRE(Tracked::alive == 2);
+    }
+    REQUIRE(Tracked::alive == 0);
+}
+
+SCENARIO("Error messages only allocate when they are formatted", "[expected]") {
+    bool same = false;
+    REQUIRE(allocationsOf([&same]() {
+                const stream::StreamError e{stream::StreamErrorCode::RecordNotFound, stream::RecordNotFoundErrorStr};
+                const auto copy = e;
+                same = copy.msg == "Record not found";
+            }) == 0U);
+    REQUIRE(same);
+    REQUIRE(allocationsOf([&same]() {
+                const stream::StreamError e{stream::StreamErrorCode::NoError, {}};
+                same = e.msg.empty();
+            }) == 0U);
+    REQUIRE(same);
+
+    // Copies share the formatted message
+    const stream::StreamError formatted{stream::StreamErrorCode::ReadError, "Unable to read " + std::to_string(1234)};
+    REQUIRE(allocationsOf([&formatted, &same]() {
+                const auto copy = formatted;
+                same = copy.msg == "Unable to read 1234";
+            }) == 0U);
+    REQUIRE(same);
+    REQUIRE(("Failed: " + formatted.msg) == "Failed: Unable to read 1234");
+
+    // A message in a char array which is not a literal is copied, so it outlives the array
+    stream::StreamError from_buffer{stream::StreamErrorCode::ReadError, {}};
+    {
+        char buffer[16] = "short lived";
+        from_buffer = stream::StreamError{stream::StreamErrorCode::ReadError, buffer};
+        buffer[0] = 'X';
+    }
+    REQUIRE(from_buffer.msg == "short lived");
+
+    // Messages can be searched and passed on as strings like before
+    REQUIRE(allocationsOf([&formatted, &same]() {
+                same = (formatted.msg.find("read") == 10U) && (formatted.msg.find("read", 11U) == std::string::npos) &&
+                       (formatted.msg.find("Unable") == 0U) && (formatted.msg.find("x", 100U) == std::string::npos) &&
+                       (formatted.msg.size() == 19U);
+            }) == 0U);
+    REQUIRE(same);
+    const std::string as_string = formatted.msg;
+    REQUIRE(as_string == "Unable to read 1234");
+    REQUIRE(formatted.msg == as_string);
+    REQUIRE(formatted.msg.find(std::string{"1234"}) == 15U);
+}
+
+SCENARIO("Reading records and values does not allocate memory for errors", "[expected]") {
+    auto fs = std::make_shared<filesystem::MemoryFileSystem>();
+    auto pool = std::make_shared<common::BufferPool>();
+    auto opts = stream::StreamOptions{
+        64 * 1024, 10 * 1024 * 1024, false, fs, nullptr, kv::KVOptions{false, fs, nullptr, "m", 1024},
+    };
+    opts.buffer_pool = pool;
+    auto stream = std::move(stream::FileStream::openOrCreate(std::move(opts)).val());
+    const std::string value(1000, 'x');
+    for (int i = 0; i < 10; i++) {
+        REQUIRE(stream->append(common::BorrowedSlice{value}, stream::AppendOptions{false, false}).ok());
+    }
+    // Give the pool a buffer to read into
+    std::ignore = stream->read(5, stream::ReadOptions{true, false, 0U});
+
+    size_t found = 0U;
+    REQUIRE(allocationsOf([&stream, &found]() {
+                found += stream->read(5, stream::ReadOptions{true, false, 0U}).ok() ? 1U : 0U;
+            }) == 0U);
+    REQUIRE(found == 1U);
+    REQUIRE(allocationsOf([&stream, &found]() {
+                found += stream->read(100, stream::ReadOptions{true, false, 0U}).ok() ? 1U : 0U;
+            }) == 0U);
+    REQUIRE(found == 1U);
+
+    auto kv = std::move(kv::KV::openOrCreate(kv::KVOptions{false, fs, nullptr, "kv", 1024 * 1024}).val());
+    const std::string key{"a key which is longer than any short string"};
+    REQUIRE(kv->put(key, common::BorrowedSlice{value}).ok());
+    // Only the value which is returned
+    REQUIRE(allocationsOf([&kv, &key, &found]() { found += kv->get(key).ok() ? 1U : 0U; }) == 1U);
+    REQUIRE(found == 2U);
+    const std::string missing{"a missing key which is longer than any short string"};
+    REQUIRE(allocationsOf([&kv, &missing, &found]() { found += kv->get(missing).ok() ? 1U : 0U; }) == 0U);
+    REQUIRE(found == 2U);
+
+    // Writing a key which is already there does not allocate either
+    bool written = false;
+    REQUIRE(allocationsOf([&kv, &key, &value, &written]() {
+                written = kv->put(key, common::BorrowedSlice{value}).ok();
+            }) == 0U);
+    REQUIRE(written);
+}
@@ -0,0 +1,188 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <aws/store/filesystem/ioUringFileSystem.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace aws::store;
+
+static std::string slice_to_string(const common::OwnedSlice &s) {
+    return std::string{s.string()};
+}
+
+SCENARIO("io_uring files behave like other files", "[fs][io_uring]") {
+    const auto use_io_uring = GENERATE(true, false);
+    auto temp_dir = test::utils::TempDir();
+    auto fs = std::make_shared<filesystem::IoUringFileSystem>(temp_dir.path(), 8U, use_io_uring);
+
+    auto f_or = fs->open("file");
+    REQUIRE(f_or.ok());
+    auto f = std::move(f_or.val());
+    REQUIRE(f->async() != nullptr);
+
+    REQUIRE(f->append(common::BorrowedSlice{std::string{"hello "}}).ok());
+    REQUIRE(f->append(common::BorrowedSlice{std::string{"world"}}).ok());
+    REQUIRE(f->flush().ok());
+    f->sync();
+
+    auto read_or = f->read(0, 11);
+    REQUIRE(read_or.ok());
+    REQUIRE(slice_to_string(read_or.val()) == "hello world");
+
+    // Reading past the end is reported as the end of the file
+    read_or = f->read(6, 20);
+    REQUIRE(!read_or.ok());
+    REQUIRE(read_or.err().code == filesystem::FileErrorCode::EndOfFile);
+
+    REQUIRE(f->writeAt(0, common::BorrowedSlice{std::string{"HELLO"}}).ok());
+    REQUIRE(f->truncate(8).ok());
+    REQUIRE(f->append(common::BorrowedSlice{std::string{"!"}}).ok());
+    read_or = f->read(0, 9);
+    REQUIRE(read_or.ok());
+    REQUIRE(slice_to_string(read_or.val()) == "HELLO wo!");
+
+    // Existing contents are appended to after reopening
+    f.reset();
+    f_or = fs->open("file");
+    REQUIRE(f_or.ok());
+    f = std::move(f_or.val());
+    REQUIRE(f->append(common::BorrowedSlice{std::string{"?"}}).ok());
+    read_or = f->read(0, 10);
+    REQUIRE(read_or.ok());
+    REQUIRE(slice_to_string(read_or.val()) == "HELLO wo!?");
+}
+
+SCENARIO("io_uring files complete operations asynchronously", "[fs][io_uring]") {
+    const auto use_io_uring = GENERATE(true, false);
+    auto temp_dir = test::utils::TempDir();
+    auto fs = std::make_shared<filesystem::IoUringFileSystem>(temp_dir.path(), 4U, use_io_uring);
+
+    auto f_or = fs->open("file");
+    REQUIRE(f_or.ok());
+    auto f = std::move(f_or.val());
+    auto *const async = f->async();
+    REQUIRE(async != nullptr);
+
+    WHEN("Many appends are queued") {
+        // More appends than the ring has entries, so that queueing has to wait for earlier ones to complete
+        std::vector<std::string> values{};
+        for (int i = 0; i < 50; i++) {
+            values.push_back("value" + std::to_string(i) + ";");
+        }
+        std::string expected{};
+        uint32_t completed = 0U;
+        for (size_t i = 0; i < values.size(); i++) {
+            const auto parts = std::vector<common::BorrowedSlice>{common::BorrowedSlice{values[i]},
+                                                                  common::BorrowedSlice{values[i]}};
+            expected += values[i] + values[i];
+            const auto sync = i % 10 == 0;
+            REQUIRE(async->appendAsync(parts.data(), parts.size(), sync, [&completed](const filesystem::FileError &e) {
+                              REQUIRE(e.ok());
+                              ++completed;
+                          }).ok());
+        }
+
+        bool synced = false;
+        REQUIRE(async->syncAsync([&synced](const filesystem::FileError &e) {
+                         REQUIRE(e.ok());
+                         synced = true;
+                     }).ok());
+        async->waitAll();
+        REQUIRE(completed == values.size());
+        REQUIRE(synced);
+
+        THEN("The data is in the order it was queued") {
+            std::string out(expected.size(), '\0');
+            bool read = false;
+            REQUIRE(async->readAsync(0, reinterpret_cast<uint8_t *>(out.data()), static_cast<uint32_t>(out.size()),
+                                     [&read, &out](const common::Expected<uint32_t, filesystem::FileError> &n) {
+                                         REQUIRE(n.ok());
+                                         REQUIRE(n.val() == out.size());
+                                         read = true;
+                                     })
+                        .ok());
+            while (async->poll() == 0U) {
+            }
+            REQUIRE(read);
+            REQUIRE(out == expected);
+
+            // A short read returns the number of bytes which were read
+            uint32_t short_read = 0U;
+            REQUIRE(async->readAsync(static_cast<uint32_t>(expected.size() - 3U),
+                                     reinterpret_cast<uint8_t *>(out.data()), 10U,
+                                     [&short_read](const common::Expected<uint32_t, filesystem::FileError> &n) {
+                                         REQUIRE(n.ok());
+                                         short_read = n.val();
+                                     })
+                        .ok());
+            async->waitAll();
+            REQUIRE(short_read == 3U);
+        }
+    }
+}
+
+SCENARIO("Streams can be stored with io_uring", "[stream][io_uring]") {
+    const auto use_io_uring = GENERATE(true, false);
+    const auto batched = GENERATE(false, true);
+    auto temp_dir = test::utils::TempDir();
+    auto fs = std::make_shared<filesystem::IoUringFileSystem>(temp_dir.path(), 16U, use_io_uring);
+
+    const auto open = [&fs, batched]() {
+        auto opts = stream::StreamOptions{
+            1024 * 1024, 10 * 1024 * 1024, true, fs, nullptr, kv::KVOptions{true, fs, nullptr, "m", 1024},
+        };
+        opts.batched_record_frames = batched;
+        return stream::FileStream::openOrCreate(std::move(opts));
+    };
+
+    auto stream_or = open();
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+
+    std::vector<std::string> values{};
+    for (int i = 0; i < 200; i++) {
+        std::string value;
+        test::utils::random_string(value, 10 * 1024);
+        // Alternate synced and unsynced appends, and single and multi-part records
+        const auto opts = stream::AppendOptions{i % 3 == 0, false};
+        if (i % 2 == 0) {
+            REQUIRE(stream->append(common::BorrowedSlice{value}, opts).ok());
+        } else {
+            const auto half = static_cast<uint32_t>(value.size() / 2);
+            const auto rest = static_cast<uint32_t>(value.size()) - half;
+            REQUIRE(stream
+                        ->append({common::BorrowedSlice{value.data(), half},
+                                  common::BorrowedSlice{value.data() + half, rest}},
+                                 opts)
+                        .ok());
+        }
+        values.push_back(std::move(value));
+    }
+
+    const auto check = [&values](const std::shared_ptr<stream::FileStream> &s) {
+        REQUIRE(s->highestSequenceNumber() == values.size() - 1);
+        for (size_t i = 0; i < values.size(); i++) {
+            auto record_or = s->read(i, stream::ReadOptions{true, false, 0U});
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().data.string() == values[i]);
+        }
+    };
+    check(stream);
+    // Syncs linked to their appends are timed too
+    const auto m = stream->metrics();
+    REQUIRE(m.syncs >= 67U);
+    REQUIRE(m.sync_latency.count == m.syncs);
+
+    // Everything is read back after reopening the stream
+    stream.reset();
+    stream_or = open();
+    REQUIRE(stream_or.ok());
+    check(stream_or.val());
+}
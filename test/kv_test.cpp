@@ -527,3 +527,42 @@ SCENARIO("I can create a KV map", "[kv]") {
         }
     }
 }
+
+SCENARIO("I can put a value made of several parts", "[kv]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto kv_or = open_kv(temp_dir.path());
+    REQUIRE(kv_or.ok());
+    auto kv = std::move(kv_or.val());
+
+    const std::string header{"header:"};
+    std::string body;
+    aws::store::test::utils::random_string(body, 5000);
+    const std::string trailer{":trailer"};
+
+    REQUIRE(kv->put("key", {aws::store::common::BorrowedSlice{header}, aws::store::common::BorrowedSlice{body},
+                            aws::store::common::BorrowedSlice{trailer}})
+                .ok());
+    const aws::store::common::BorrowedSlice parts[] = {aws::store::common::BorrowedSlice{trailer},
+                                                       aws::store::common::BorrowedSlice{header}};
+    REQUIRE(kv->put("other", parts, 2U).ok());
+
+    auto v_or = kv->get("key");
+    REQUIRE(v_or.ok());
+    REQUIRE(v_or.val().string() == header + body + trailer);
+
+    WHEN("I close the KV and open it again") {
+        kv.reset();
+        kv_or = open_kv(temp_dir.path());
+        REQUIRE(kv_or.ok());
+        kv = std::move(kv_or.val());
+
+        THEN("The values pass the CRC check") {
+            v_or = kv->get("key");
+            REQUIRE(v_or.ok());
+            REQUIRE(v_or.val().string() == header + body + trailer);
+            v_or = kv->get("other");
+            REQUIRE(v_or.ok());
+            REQUIRE(v_or.val().string() == trailer + header);
+        }
+    }
+}
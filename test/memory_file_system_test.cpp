@@ -0,0 +1,225 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <aws/store/filesystem/memoryFileSystem.hpp>
+#include <aws/store/filesystem/posixFileSystem.hpp>
+#include <aws/store/kv/kv.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aws::store;
+
+SCENARIO("Memory files behave like other files", "[fs][memory]") {
+    // A small chunk size so that reads and writes cross chunk boundaries
+    auto fs = std::make_shared<filesystem::MemoryFileSystem>(UINT64_MAX, 8192U);
+
+    std::string source;
+    test::utils::random_string(source, 100 * 1024);
+    std::string expected;
+
+    auto f_or = fs->open("file");
+    REQUIRE(f_or.ok());
+    auto f = std::move(f_or.val());
+
+    std::minstd_rand rand{7};
+    size_t position = 0;
+    for (int i = 0; i < 300; i++) {
+        const auto length = rand() % 3000;
+        const auto begin = position % (source.size() - 3000);
+        if (i % 3 == 0) {
+            const auto half = length / 2;
+            const auto parts = std::vector<common::BorrowedSlice>{
+                common::BorrowedSlice{source.data() + begin, half},
+                common::BorrowedSlice{source.data() + begin + half, length - half}};
+            REQUIRE(f->appendv(parts.data(), parts.size()).ok());
+        } else {
+            REQUIRE(f->append(common::BorrowedSlice{source.data() + begin, length}).ok());
+        }
+        expected += source.substr(begin, length);
+        position += length;
+
+        if (i % 41 == 0) {
+            const auto new_size = expected.size() > 30000 ? expected.size() - 30000 : 0;
+            REQUIRE(f->truncate(static_cast<uint32_t>(new_size)).ok());
+            expected.resize(new_size);
+        }
+        if ((i % 7 == 0) && !expected.empty()) {
+            const auto b = rand() % expected.size();
+            const auto e = b + rand() % (expected.size() - b) + 1;
+            auto read_or = f->read(static_cast<uint32_t>(b), static_cast<uint32_t>(e));
+            REQUIRE(read_or.ok());
+            REQUIRE(read_or.val().string() == expected.substr(b, e - b));
+        }
+    }
+
+    auto read_or = f->read(0, static_cast<uint32_t>(expected.size()));
+    REQUIRE(read_or.ok());
+    REQUIRE(read_or.val().string() == expected);
+    read_or = f->read(0, static_cast<uint32_t>(expected.size() + 1));
+    REQUIRE(!read_or.ok());
+    REQUIRE(read_or.err().code == filesystem::FileErrorCode::EndOfFile);
+
+    // Reading without copying sees the same bytes
+    auto *const memory_file = static_cast<filesystem::MemoryFileLike *>(f.get());
+    std::string visited;
+    REQUIRE(memory_file
+                ->visit(100, static_cast<uint32_t>(expected.size()),
+                        [&visited](const common::BorrowedSlice piece) { visited += piece.string(); })
+                .ok());
+    REQUIRE(visited == expected.substr(100));
+
+    const std::string patch(300, '#');
+    REQUIRE(f->writeAt(8000, common::BorrowedSlice{patch}).ok());
+    expected.replace(8000, patch.size(), patch);
+    REQUIRE(!f->writeAt(static_cast<uint32_t>(expected.size() - 10), common::BorrowedSlice{patch}).ok());
+
+    // Another handle sees the same contents
+    f_or = fs->open("file");
+    REQUIRE(f_or.ok());
+    read_or = f_or.val()->read(0, static_cast<uint32_t>(expected.size()));
+    REQUIRE(read_or.ok());
+    REQUIRE(read_or.val().string() == expected);
+}
+
+SCENARIO("Memory file systems manage files like a disk", "[fs][memory]") {
+    filesystem::MemoryFileSystem fs{};
+    auto a = std::move(fs.open("a").val());
+    REQUIRE(a->append(common::BorrowedSlice{std::string{"a"}}).ok());
+    REQUIRE(fs.exists("a"));
+    REQUIRE(!fs.exists("b"));
+
+    WHEN("A file is renamed over another") {
+        auto b = std::move(fs.open("b").val());
+        REQUIRE(b->append(common::BorrowedSlice{std::string{"bb"}}).ok());
+        REQUIRE(fs.rename("a", "b").ok());
+
+        THEN("Only the new name exists, with the renamed contents") {
+            REQUIRE(fs.list().val() == std::vector<std::string>{"b"});
+            REQUIRE(fs.open("b").val()->read(0, 1).val().string() == "a");
+            // Handles which were already open keep the replaced file
+            REQUIRE(b->read(0, 2).val().string() == "bb");
+        }
+        REQUIRE(!fs.rename("a", "c").ok());
+    }
+
+    WHEN("A file is removed") {
+        REQUIRE(fs.remove("a").ok());
+
+        THEN("It is gone, but still readable through open handles") {
+            REQUIRE(!fs.exists("a"));
+            REQUIRE(fs.list().val().empty());
+            REQUIRE(a->read(0, 1).val().string() == "a");
+            REQUIRE(fs.open("a").val()->read(0, 1).err().code == filesystem::FileErrorCode::EndOfFile);
+        }
+    }
+}
+
+SCENARIO("Memory file systems stay within their memory limit", "[fs][memory]") {
+    filesystem::MemoryFileSystem fs{64U * 1024U, 16U * 1024U};
+    auto f = std::move(fs.open("file").val());
+    const std::string value(1000, 'x');
+
+    uint32_t appended = 0U;
+    while (f->append(common::BorrowedSlice{value}).ok()) {
+        appended += static_cast<uint32_t>(value.size());
+        REQUIRE(fs.usedBytes() <= 64U * 1024U);
+    }
+    REQUIRE(f->append(common::BorrowedSlice{value}).code == filesystem::FileErrorCode::DiskFull);
+    // A failed append leaves the file as it was
+    REQUIRE(f->read(0, appended).ok());
+    REQUIRE(!f->read(0, appended + 1U).ok());
+
+    // Truncating and removing files gives their memory back
+    REQUIRE(f->truncate(0U).ok());
+    REQUIRE(fs.usedBytes() == 0U);
+    REQUIRE(f->append(common::BorrowedSlice{value}).ok());
+    REQUIRE(fs.remove("file").ok());
+    REQUIRE(fs.usedBytes() > 0U);
+    f.reset();
+    REQUIRE(fs.usedBytes() == 0U);
+}
+
+SCENARIO("Streams and KV stores can be kept in memory", "[stream][memory]") {
+    auto fs = std::make_shared<filesystem::MemoryFileSystem>();
+    const auto batched = GENERATE(false, true);
+
+    const auto open = [&fs, batched]() {
+        auto opts = stream::StreamOptions{
+            64 * 1024, 10 * 1024 * 1024, true, fs, nullptr, kv::KVOptions{true, fs, nullptr, "m", 1024},
+        };
+        opts.batched_record_frames = batched;
+        return stream::FileStream::openOrCreate(std::move(opts));
+    };
+
+    auto stream_or = open();
+    REQUIRE(stream_or.ok());
+    std::vector<std::string> values;
+    for (int i = 0; i < 300; i++) {
+        std::string value;
+        test::utils::random_string(value, static_cast<size_t>(1 + (i * 7919) % 5000));
+        REQUIRE(stream_or.val()->append(common::BorrowedSlice{value}, stream::AppendOptions{i % 5 == 0, true}).ok());
+        values.push_back(std::move(value));
+    }
+    std::ignore = stream_or.val()->openOrCreateIterator("it", stream::IteratorOptions{});
+    REQUIRE(stream_or.val()->setCheckpoint("it", 10).ok());
+
+    // Everything is still there when the stream is opened again in the same file system
+    stream_or.val().reset();
+    stream_or = open();
+    REQUIRE(stream_or.ok());
+    const auto &stream = stream_or.val();
+    REQUIRE(stream->highestSequenceNumber() == values.size() - 1);
+    for (auto i = stream->firstSequenceNumber(); i < values.size(); i++) {
+        auto record_or = stream->read(i, stream::ReadOptions{true, false, 0U});
+        REQUIRE(record_or.ok());
+        REQUIRE(record_or.val().data.string() == values[i]);
+    }
+    REQUIRE(stream->openOrCreateIterator("it", stream::IteratorOptions{}).sequence_number == 11U);
+}
+
+SCENARIO("Memory and disk stream performance", "[.][benchmark][memory]") {
+    auto temp_dir = test::utils::TempDir();
+    std::string record;
+    test::utils::random_string(record, 1024);
+
+    const auto append_records = [&record](const std::shared_ptr<filesystem::FileSystemInterface> &fs) {
+        const auto files = fs->list().val();
+        for (const auto &f : files) {
+            std::ignore = fs->remove(f);
+        }
+        auto stream = std::move(stream::FileStream::openOrCreate(stream::StreamOptions{
+                                                                     1024 * 1024,
+                                                                     64 * 1024 * 1024,
+                                                                     false,
+                                                                     fs,
+                                                                     nullptr,
+                                                                     kv::KVOptions{true, fs, nullptr, "m", 1024},
+                                                                 })
+                                    .val());
+        for (int i = 0; i < 4096; i++) {
+            std::ignore = stream->append(common::BorrowedSlice{record}, stream::AppendOptions{false, true});
+        }
+        return stream;
+    };
+
+    std::filesystem::create_directories(temp_dir.path());
+    std::shared_ptr<filesystem::FileSystemInterface> posix =
+        std::make_shared<filesystem::PosixFileSystem>(temp_dir.path());
+    std::shared_ptr<filesystem::FileSystemInterface> memory = std::make_shared<filesystem::MemoryFileSystem>();
+
+    BENCHMARK("Posix stream append 4MB") {
+        return append_records(posix);
+    };
+    BENCHMARK("Memory stream append 4MB") {
+        return append_records(memory);
+    };
+}
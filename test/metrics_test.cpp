@@ -0,0 +1,236 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <aws/store/common/metrics.hpp>
+#include <aws/store/filesystem/memoryFileSystem.hpp>
+#include <aws/store/kv/kv.hpp>
+#include <aws/store/stream/compression.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <aws/store/stream/memoryStream.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace aws::store;
+
+SCENARIO("Histograms keep values to within an eighth of their size", "[metrics]") {
+    for (uint64_t v = 0U; v < (1U << 20U); v += 1U + (v / 64U)) {
+        const auto bucket = common::Histogram::bucketOf(v);
+        REQUIRE(bucket < common::Histogram::BUCKET_COUNT);
+        REQUIRE(v <= common::Histogram::bucketUpperBound(bucket));
+        if (bucket > 0U) {
+            REQUIRE(v > common::Histogram::bucketUpperBound(bucket - 1U));
+        }
+        REQUIRE(common::Histogram::bucketUpperBound(bucket) - v <= v / 8U);
+    }
+    REQUIRE(common::Histogram::bucketOf(UINT64_MAX) == common::Histogram::BUCKET_COUNT - 1U);
+
+    common::Histogram h{};
+    REQUIRE(h.snapshot().percentile(99.0) == 0U);
+    for (uint64_t v = 1U; v <= 1000U; v++) {
+        h.record(v);
+    }
+    const auto s = h.snapshot();
+    REQUIRE(s.count == 1000U);
+    REQUIRE(s.sum == 500500U);
+    REQUIRE(s.mean() == 500U);
+    REQUIRE(s.max == 1000U);
+    REQUIRE(s.percentile(50.0) >= 500U);
+    REQUIRE(s.percentile(50.0) <= 500U + 500U / 8U);
+    REQUIRE(s.percentile(99.0) >= 990U);
+    REQUIRE(s.percentile(100.0) == 1000U);
+
+    WHEN("Many threads record at once") {
+        common::Histogram shared{};
+        std::vector<std::thread> threads{};
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&shared, t]() {
+                for (uint64_t i = 0U; i < 10000U; i++) {
+                    shared.record(i * static_cast<uint64_t>(t + 1));
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        THEN("Every value is counted") {
+            const auto counted = shared.snapshot();
+            REQUIRE(counted.count == 40000U);
+            REQUIRE(counted.max == 9999U * 4U);
+        }
+    }
+}
+
+SCENARIO("File streams report what they have done", "[metrics][stream]") {
+    auto fs = std::make_shared<filesystem::MemoryFileSystem>();
+    const auto open = [&fs]() {
+        return stream::FileStream::openOrCreate(stream::StreamOptions{
+            1024, 8 * 1024, true, fs, nullptr, kv::KVOptions{false, fs, nullptr, "m", 1},
+        });
+    };
+    auto stream = std::move(open().val());
+    const std::string value(200, 'x');
+    for (int i = 0; i < 20; i++) {
+        REQUIRE(stream->append(common::BorrowedSlice{value}, stream::AppendOptions{i % 2 == 0, true}).ok());
+    }
+    for (uint64_t i = 0U; i < 5U; i++) {
+        REQUIRE(stream->read(i, stream::ReadOptions{}).ok());
+    }
+    std::ignore = stream->openOrCreateIterator("it", stream::IteratorOptions{});
+    REQUIRE(stream->setCheckpoint("it", 4U).ok());
+    REQUIRE(stream->setCheckpoint("it", 6U).ok());
+
+    auto m = stream->metrics();
+    REQUIRE(m.appends == 20U);
+    REQUIRE(m.appended_bytes == 20U * value.size());
+    REQUIRE(m.reads == 5U);
+    REQUIRE(m.read_bytes == 5U * value.size());
+    REQUIRE(m.syncs >= 10U);
+    REQUIRE(m.sync_latency.count == m.syncs);
+    REQUIRE(m.segments_created == 4U);
+    REQUIRE(m.segments_removed == 0U);
+    REQUIRE(m.compactions >= 1U);
+    REQUIRE(m.compaction_latency.count == m.compactions);
+    REQUIRE(m.corruption_truncations == 0U);
+    REQUIRE(m.append_latency.count == 20U);
+    REQUIRE(m.read_latency.count == 5U);
+    REQUIRE(m.iterators.size() == 1U);
+    REQUIRE(m.iterators[0].identifier == "it");
+    REQUIRE(m.iterators[0].sequence_number == 7U);
+    REQUIRE(m.iterators[0].lag == 13U);
+
+    WHEN("The stream fills up") {
+        for (int i = 0; i < 20; i++) {
+            REQUIRE(stream->append(common::BorrowedSlice{value}, stream::AppendOptions{false, true}).ok());
+        }
+        THEN("The oldest segments are removed") {
+            m = stream->metrics();
+            REQUIRE(m.segments_created > 4U);
+            REQUIRE(m.segments_removed > 0U);
+            REQUIRE(m.iterators[0].lag == 33U);
+        }
+    }
+
+    WHEN("The stream is opened with a record cut short") {
+        stream.reset();
+        const auto files = fs->list().val();
+        for (const auto &f : files) {
+            if (f.find(".log") != std::string::npos) {
+                auto file = std::move(fs->open(f).val());
+                // Every segment holds 5 records
+                REQUIRE(file->truncate(5U * (32U + 200U) - 5U).ok());
+            }
+        }
+        stream = std::move(open().val());
+        THEN("The truncation is counted") {
+            REQUIRE(stream->metrics().corruption_truncations == 4U);
+            REQUIRE(stream->metrics().appends == 0U);
+        }
+    }
+}
+
+SCENARIO("Compressed segments report what they have done", "[metrics][stream][compression]") {
+    auto fs = std::make_shared<filesystem::MemoryFileSystem>();
+    const auto open = [&fs]() {
+        auto opts = stream::StreamOptions{
+            4 * 1024, 1024 * 1024, true, fs, nullptr, kv::KVOptions{false, fs, nullptr, "m", 1},
+        };
+        opts.segment_compression_codec = std::make_shared<stream::Lz77Codec>();
+        return stream::FileStream::openOrCreate(std::move(opts));
+    };
+    const auto compressed_segments = [&fs]() {
+        std::vector<std::string> compressed{};
+        const auto files = fs->list().val();
+        for (const auto &f : files) {
+            if (f.find(".logz") != std::string::npos) {
+                compressed.push_back(f);
+            }
+        }
+        return compressed;
+    };
+
+    auto stream = std::move(open().val());
+    const std::string value(200, 'x');
+    for (int i = 0; i < 100; i++) {
+        REQUIRE(stream->append(common::BorrowedSlice{value}, stream::AppendOptions{false, true}).ok());
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{20};
+    while ((compressed_segments().size() < 2U) && (std::chrono::steady_clock::now() < deadline)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    REQUIRE(compressed_segments().size() >= 2U);
+
+    for (uint64_t i = 0U; i < 5U; i++) {
+        REQUIRE(stream->read(i, stream::ReadOptions{}).ok());
+    }
+    auto m = stream->metrics();
+    REQUIRE(m.reads == 5U);
+    REQUIRE(m.read_bytes == 5U * value.size());
+    REQUIRE(m.corruption_truncations == 0U);
+
+    WHEN("The stream is opened with a compressed block cut short") {
+        stream.reset();
+        const auto compressed = compressed_segments();
+        auto file = std::move(fs->open(compressed.front()).val());
+        uint32_t size = 0U;
+        uint8_t byte{};
+        while (file->readInto(size, &byte, 1U).ok()) {
+            size++;
+        }
+        REQUIRE(file->truncate(size - 1U).ok());
+        file.reset();
+        stream = std::move(open().val());
+        THEN("The truncation is counted") {
+            REQUIRE(stream->metrics().corruption_truncations == 1U);
+        }
+    }
+}
+
+SCENARIO("Memory streams report what they have done", "[metrics][stream]") {
+    auto stream = stream::MemoryStream::openOrCreate(stream::StreamOptions{});
+    REQUIRE(stream->append(common::BorrowedSlice{std::string{"abc"}}, stream::AppendOptions{}).ok());
+    REQUIRE(stream->append(common::OwnedSlice{common::BorrowedSlice{std::string{"de"}}}, stream::AppendOptions{})
+                .ok());
+    REQUIRE(stream->read(1U, stream::ReadOptions{}).ok());
+    REQUIRE(!stream->read(5U, stream::ReadOptions{}).ok());
+    REQUIRE(stream->setCheckpoint("it", 1U).ok());
+
+    const auto m = stream->metrics();
+    REQUIRE(m.appends == 2U);
+    REQUIRE(m.appended_bytes == 5U);
+    REQUIRE(m.reads == 1U);
+    REQUIRE(m.read_bytes == 2U);
+    REQUIRE(m.read_latency.count == 2U);
+    REQUIRE(m.syncs == 0U);
+    REQUIRE(m.iterators.size() == 1U);
+    REQUIRE(m.iterators[0].lag == 1U);
+}
+
+SCENARIO("KVs report what they have done", "[metrics][kv]") {
+    auto fs = std::make_shared<filesystem::MemoryFileSystem>();
+    auto kv = std::move(kv::KV::openOrCreate(kv::KVOptions{false, fs, nullptr, "kv", -1}).val());
+    REQUIRE(kv->put("a", common::BorrowedSlice{std::string{"1234"}}).ok());
+    REQUIRE(kv->put("a", common::BorrowedSlice{std::string{"56"}}).ok());
+    REQUIRE(kv->get("a").ok());
+    REQUIRE(!kv->get("b").ok());
+    REQUIRE(kv->remove("a").ok());
+    REQUIRE(kv->compact().ok());
+
+    const auto m = kv->metrics();
+    REQUIRE(m.puts == 2U);
+    REQUIRE(m.put_bytes == 6U);
+    REQUIRE(m.gets == 2U);
+    REQUIRE(m.removes == 1U);
+    REQUIRE(m.compactions == 1U);
+    REQUIRE(m.syncs == 1U);
+    REQUIRE(m.put_latency.count == 2U);
+    REQUIRE(m.get_latency.count == 2U);
+    REQUIRE(m.compaction_latency.count == 1U);
+    REQUIRE(m.sync_latency.count == 1U);
+    REQUIRE(m.corruption_truncations == 0U);
+}
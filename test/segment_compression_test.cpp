@@ -0,0 +1,337 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <atomic>
+#include <aws/store/filesystem/posixFileSystem.hpp>
+#include <aws/store/stream/compression.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+SCENARIO("LZ77 codec round trips data", "[compression]") {
+    const aws::store::stream::Lz77Codec codec{};
+
+    std::string random;
+    aws::store::test::utils::random_string(random, 100 * 1024);
+    std::string repetitive;
+    for (auto i = 0; repetitive.size() < 200 * 1024; i++) {
+        repetitive += "{\"sensor\":\"temperature\",\"reading\":" + std::to_string(i % 50) + "}";
+    }
+    const std::string input = GENERATE_COPY(std::string{}, std::string{"abc"}, std::string(1000, 'x'), random,
+                                            repetitive);
+
+    std::vector<uint8_t> compressed;
+    codec.compress(aws::store::common::BorrowedSlice{input}, compressed);
+    if (input == repetitive) {
+        REQUIRE(compressed.size() < input.size() / 4U);
+    }
+
+    std::vector<uint8_t> output(input.size());
+    REQUIRE(codec.decompress(
+        aws::store::common::BorrowedSlice{compressed.data(), static_cast<uint32_t>(compressed.size())}, output.data(),
+        static_cast<uint32_t>(output.size())));
+    REQUIRE(std::string(output.cbegin(), output.cend()) == input);
+
+    THEN("Decompressing to the wrong size fails") {
+        std::vector<uint8_t> larger(input.size() + 1U);
+        REQUIRE_FALSE(codec.decompress(
+            aws::store::common::BorrowedSlice{compressed.data(), static_cast<uint32_t>(compressed.size())},
+            larger.data(), static_cast<uint32_t>(larger.size())));
+    }
+}
+
+SCENARIO("Sealed segments are compressed in the background", "[compression]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+    const auto batched = GENERATE(false, true);
+    const auto open_stream = [&fs, batched](std::shared_ptr<aws::store::stream::CompressionCodec> codec) {
+        return aws::store::stream::FileStream::openOrCreate(aws::store::stream::StreamOptions{
+            64 * 1024,
+            10 * 1024 * 1024,
+            true,
+            fs,
+            {},
+            aws::store::kv::KVOptions{true, fs, {}, "m", 1 * 1024},
+            batched,
+            std::move(codec),
+        });
+    };
+    const auto count_files = [&temp_dir](const std::string &extension) {
+        auto count = 0U;
+        for (const auto &entry : std::filesystem::directory_iterator(temp_dir.path())) {
+            if (entry.path().extension() == extension) {
+                count++;
+            }
+        }
+        return count;
+    };
+
+    auto stream_or = open_stream(std::make_shared<aws::store::stream::Lz77Codec>());
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+
+    std::vector<std::string> values;
+    for (auto i = 0; i < 3000; i++) {
+        values.emplace_back("{\"sensor\":\"temperature\",\"index\":" + std::to_string(i) + ",\"reading\":" +
+                            std::to_string(i % 50) + ",\"unit\":\"celsius\"}");
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{values.back()}, aws::store::stream::AppendOptions{})
+                    .ok());
+    }
+
+    // Wait for all but the segment being appended to to be compressed
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{20};
+    while (((count_files(".log") != 1U) || (count_files(".ztmp") != 0U)) &&
+           (std::chrono::steady_clock::now() < deadline)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    REQUIRE(count_files(".log") == 1U);
+    REQUIRE(count_files(".logz") > 2U);
+
+    uint64_t uncompressed_size = 0U;
+    for (const auto &v : values) {
+        uncompressed_size += v.size();
+    }
+
+    const auto check_values = [&values](aws::store::stream::StreamInterface &s) {
+        REQUIRE(s.highestSequenceNumber() == values.size() - 1U);
+        for (auto i = values.size(); i > 0U; i--) {
+            auto record_or = s.read(i - 1U, aws::store::stream::ReadOptions{});
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().data.string() == values[i - 1U]);
+        }
+        auto it = s.openOrCreateIterator("it", aws::store::stream::IteratorOptions{});
+        for (auto i = 0U; i < values.size(); i++, ++it) {
+            auto record_or = *it;
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().data.string() == values[i]);
+        }
+        REQUIRE(s.deleteIterator("it").ok());
+    };
+
+    THEN("Records are read from compressed segments and take less space") {
+        check_values(*stream);
+        REQUIRE(stream->currentSizeBytes() < uncompressed_size / 2U);
+
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"more"}, aws::store::stream::AppendOptions{}).ok());
+        values.emplace_back("more");
+        REQUIRE(stream->read(values.size() - 1U, aws::store::stream::ReadOptions{}).val().data.string() == "more");
+    }
+
+    WHEN("I reopen the stream") {
+        const auto size = stream->currentSizeBytes();
+        stream.reset();
+
+        THEN("Compressed segments are read back even without a codec configured") {
+            stream_or = open_stream({});
+            REQUIRE(stream_or.ok());
+            stream = std::move(stream_or.val());
+            REQUIRE(stream->currentSizeBytes() == size);
+            check_values(*stream);
+        }
+    }
+
+    WHEN("Old records are removed") {
+        const auto removed = stream->removeOlderRecords(aws::store::stream::timestamp() + 1);
+        THEN("Compressed segments are removed too") {
+            REQUIRE(removed > 0U);
+            REQUIRE(count_files(".logz") == 0U);
+            REQUIRE(stream->currentSizeBytes() == 0U);
+        }
+    }
+}
+
+namespace {
+// Fails to open compressed segments, as when running out of file descriptors
+class NoCompressedOpenFileSystem : public aws::store::filesystem::FileSystemInterface {
+  public:
+    std::shared_ptr<aws::store::filesystem::FileSystemInterface> real;
+    std::atomic_uint32_t failed_opens{0U};
+
+    explicit NoCompressedOpenFileSystem(std::shared_ptr<aws::store::filesystem::FileSystemInterface> r)
+        : real(std::move(r)) {
+    }
+
+    aws::store::common::Expected<std::unique_ptr<aws::store::filesystem::FileLike>,
+                                 aws::store::filesystem::FileError>
+    open(const std::string &identifier) override {
+        if (std::filesystem::path(identifier).extension() == ".logz") {
+            failed_opens++;
+            return aws::store::filesystem::FileError{aws::store::filesystem::FileErrorCode::TooManyOpenFiles,
+                                                     "Too many open files"};
+        }
+        return real->open(identifier);
+    }
+
+    bool exists(const std::string &identifier) override {
+        return real->exists(identifier);
+    }
+
+    aws::store::filesystem::FileError rename(const std::string &old_id, const std::string &new_id) override {
+        return real->rename(old_id, new_id);
+    }
+
+    aws::store::filesystem::FileError remove(const std::string &identifier) override {
+        return real->remove(identifier);
+    }
+
+    aws::store::common::Expected<std::vector<std::string>, aws::store::filesystem::FileError> list() override {
+        return real->list();
+    }
+};
+} // namespace
+
+SCENARIO("Segments are kept when their compressed copy cannot be opened", "[compression]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<NoCompressedOpenFileSystem>(
+        std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path()));
+    const auto open_stream = [&fs]() {
+        return aws::store::stream::FileStream::openOrCreate(aws::store::stream::StreamOptions{
+            64 * 1024,
+            10 * 1024 * 1024,
+            true,
+            fs,
+            {},
+            aws::store::kv::KVOptions{true, fs, {}, "m", 1 * 1024},
+            false,
+            std::make_shared<aws::store::stream::Lz77Codec>(),
+        });
+    };
+
+    auto stream_or = open_stream();
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+    std::vector<std::string> values;
+    for (auto i = 0; i < 3000; i++) {
+        values.emplace_back("{\"sensor\":\"temperature\",\"index\":" + std::to_string(i) + "}");
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{values.back()}, aws::store::stream::AppendOptions{})
+                    .ok());
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{20};
+    while ((fs->failed_opens < 2U) && (std::chrono::steady_clock::now() < deadline)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    REQUIRE(fs->failed_opens >= 2U);
+    stream.reset();
+
+    auto compressed = 0U;
+    for (const auto &entry : std::filesystem::directory_iterator(temp_dir.path())) {
+        if (entry.path().extension() == ".logz") {
+            compressed++;
+        }
+    }
+    REQUIRE(compressed == 0U);
+
+    stream_or = open_stream();
+    REQUIRE(stream_or.ok());
+    stream = std::move(stream_or.val());
+    for (auto i = 0U; i < values.size(); i++) {
+        auto record_or = stream->read(i, aws::store::stream::ReadOptions{});
+        REQUIRE(record_or.ok());
+        REQUIRE(record_or.val().data.string() == values[i]);
+    }
+}
+
+// Holds up the second open of a compressed copy which is still being written, which is when it is checked
+class BlockingCheckFileSystem : public aws::store::filesystem::FileSystemInterface {
+  public:
+    std::shared_ptr<aws::store::filesystem::FileSystemInterface> real;
+    std::mutex lock{};
+    std::condition_variable cv{};
+    std::map<std::string, uint32_t> temporary_opens{};
+    bool checking = false;
+    bool released = false;
+
+    explicit BlockingCheckFileSystem(std::shared_ptr<aws::store::filesystem::FileSystemInterface> r)
+        : real(std::move(r)) {
+    }
+
+    aws::store::common::Expected<std::unique_ptr<aws::store::filesystem::FileLike>,
+                                 aws::store::filesystem::FileError>
+    open(const std::string &identifier) override {
+        if (std::filesystem::path(identifier).extension() == ".ztmp") {
+            std::unique_lock<std::mutex> l(lock);
+            if (++temporary_opens[identifier] == 2U) {
+                checking = true;
+                cv.notify_all();
+                cv.wait(l, [this]() { return released; });
+            }
+        }
+        return real->open(identifier);
+    }
+
+    bool exists(const std::string &identifier) override {
+        return real->exists(identifier);
+    }
+
+    aws::store::filesystem::FileError rename(const std::string &old_id, const std::string &new_id) override {
+        return real->rename(old_id, new_id);
+    }
+
+    aws::store::filesystem::FileError remove(const std::string &identifier) override {
+        return real->remove(identifier);
+    }
+
+    aws::store::common::Expected<std::vector<std::string>, aws::store::filesystem::FileError> list() override {
+        return real->list();
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> l(lock);
+        released = true;
+        cv.notify_all();
+    }
+};
+
+SCENARIO("Compressed copies are checked without holding the stream's lock", "[compression]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<BlockingCheckFileSystem>(
+        std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path()));
+    auto stream_or = aws::store::stream::FileStream::openOrCreate(aws::store::stream::StreamOptions{
+        64 * 1024,
+        10 * 1024 * 1024,
+        true,
+        fs,
+        {},
+        aws::store::kv::KVOptions{true, fs, {}, "m", 1 * 1024},
+        false,
+        std::make_shared<aws::store::stream::Lz77Codec>(),
+    });
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+    for (auto i = 0; i < 3000; i++) {
+        REQUIRE(stream
+                    ->append(aws::store::common::BorrowedSlice{"{\"sensor\":\"temperature\",\"index\":" +
+                                                               std::to_string(i) + "}"},
+                             aws::store::stream::AppendOptions{})
+                    .ok());
+    }
+
+    bool checking;
+    {
+        std::unique_lock<std::mutex> l(fs->lock);
+        checking = fs->cv.wait_for(l, std::chrono::seconds{20}, [&fs]() { return fs->checking; });
+    }
+    // The stream can be used while the copy is being checked
+    bool read = false;
+    bool appended = false;
+    if (checking) {
+        read = stream->read(0, aws::store::stream::ReadOptions{}).ok();
+        appended =
+            stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{}).ok();
+    }
+    fs->release();
+    REQUIRE(checking);
+    REQUIRE(read);
+    REQUIRE(appended);
+}
@@ -0,0 +1,205 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <aws/store/filesystem/memoryFileSystem.hpp>
+#include <aws/store/filesystem/posixFileSystem.hpp>
+#include <aws/store/filesystem/shapingFileSystem.hpp>
+#include <aws/store/stream/fileStream.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace aws::store;
+using namespace std::chrono_literals;
+
+SCENARIO("Shaped files wait as the modelled device would", "[fs][shaping]") {
+    std::vector<std::chrono::nanoseconds> delays{};
+    const auto shaped = [&delays](filesystem::ShapingOptions opts) {
+        opts.delay = [&delays](const std::chrono::nanoseconds d) { delays.push_back(d); };
+        return std::make_shared<filesystem::ShapingFileSystem>(std::make_shared<filesystem::MemoryFileSystem>(),
+                                                               std::move(opts));
+    };
+
+    WHEN("Operations have latency") {
+        filesystem::ShapingOptions opts{};
+        opts.write = filesystem::LatencyDistribution{100us, 50us, 0.0, 0us};
+        opts.sync = filesystem::LatencyDistribution{1ms, 0us, 0.25, 20ms};
+        const auto run = [&]() {
+            delays.clear();
+            auto fs = shaped(opts);
+            auto f = std::move(fs->open("file").val());
+            for (int i = 0; i < 100; i++) {
+                REQUIRE(f->append(common::BorrowedSlice{std::string{"data"}}).ok());
+                f->sync();
+            }
+            REQUIRE(fs->delayed() > 100ms);
+            return delays;
+        };
+
+        const auto first = run();
+        THEN("Each operation waits within its distribution") {
+            REQUIRE(first.size() == 200U);
+            size_t stalls = 0U;
+            for (size_t i = 0; i < first.size(); i += 2) {
+                REQUIRE(first[i] >= 100us);
+                REQUIRE(first[i] <= 150us);
+                REQUIRE(((first[i + 1] == 1ms) || (first[i + 1] == 21ms)));
+                stalls += first[i + 1] == 21ms ? 1U : 0U;
+            }
+            REQUIRE(stalls > 5U);
+            REQUIRE(stalls < 50U);
+        }
+        THEN("The same seed gives the same latencies") {
+            REQUIRE(run() == first);
+            opts.seed = 2U;
+            REQUIRE(run() != first);
+        }
+    }
+
+    WHEN("Writes are limited to a rate") {
+        filesystem::ShapingOptions opts{};
+        opts.write_bytes_per_second = 1024U * 1024U;
+        auto fs = shaped(opts);
+        auto f = std::move(fs->open("file").val());
+        const std::string value(64U * 1024U, 'x');
+        for (int i = 0; i < 16; i++) {
+            REQUIRE(f->append(common::BorrowedSlice{value}).ok());
+        }
+
+        THEN("Writing 1MB takes about a second") {
+            // The delays are not slept here, so the device keeps falling further behind
+            REQUIRE(delays.back() > 900ms);
+            REQUIRE(delays.back() <= 1s);
+        }
+    }
+
+    WHEN("The device runs out of space") {
+        filesystem::ShapingOptions opts{};
+        opts.write_budget_bytes = 10U;
+        auto fs = shaped(opts);
+        auto f = std::move(fs->open("file").val());
+
+        THEN("Appends beyond the budget fail") {
+            REQUIRE(f->append(common::BorrowedSlice{std::string{"12345678"}}).ok());
+            REQUIRE(f->append(common::BorrowedSlice{std::string{"123"}}).code == filesystem::FileErrorCode::DiskFull);
+            REQUIRE(f->append(common::BorrowedSlice{std::string{"12"}}).ok());
+            REQUIRE(f->read(0, 10).val().string() == "1234567812");
+        }
+        THEN("The disk can be made full on demand") {
+            fs->setDiskFull(true);
+            REQUIRE(f->append(common::BorrowedSlice{std::string{"1"}}).code == filesystem::FileErrorCode::DiskFull);
+            fs->setDiskFull(false);
+            REQUIRE(f->append(common::BorrowedSlice{std::string{"1"}}).ok());
+        }
+    }
+}
+
+SCENARIO("Shaped files pass appends on unchanged", "[fs][shaping]") {
+    // Counts the calls which reach the wrapped file
+    class CountingFileLike : public test::utils::SpyFileLike {
+      public:
+        size_t appends = 0U;
+        size_t appendvs = 0U;
+
+        using SpyFileLike::SpyFileLike;
+
+        filesystem::FileError append(const common::BorrowedSlice data) override {
+            ++appends;
+            return SpyFileLike::append(data);
+        }
+
+        filesystem::FileError appendv(const common::BorrowedSlice *parts, const size_t part_count) override {
+            ++appendvs;
+            return SpyFileLike::appendv(parts, part_count);
+        }
+    };
+
+    auto memory_fs = std::make_shared<filesystem::MemoryFileSystem>();
+    auto spy_fs = std::make_shared<test::utils::SpyFileSystem>(memory_fs);
+    CountingFileLike *counting = nullptr;
+    spy_fs->when("open", test::utils::SpyFileSystem::OpenType{[&memory_fs, &counting](const std::string &id) {
+                     auto file_or = memory_fs->open(id);
+                     REQUIRE(file_or.ok());
+                     auto file = std::make_unique<CountingFileLike>(std::move(file_or.val()));
+                     counting = file.get();
+                     return common::Expected<std::unique_ptr<filesystem::FileLike>, filesystem::FileError>{
+                         std::move(file)};
+                 }});
+    auto fs = std::make_shared<filesystem::ShapingFileSystem>(spy_fs, filesystem::ShapingOptions{});
+    auto f = std::move(fs->open("file").val());
+    REQUIRE(counting != nullptr);
+
+    REQUIRE(f->append(common::BorrowedSlice{std::string{"one"}}).ok());
+    const std::string two{"two"};
+    const std::string three{"three"};
+    const common::BorrowedSlice parts[] = {common::BorrowedSlice{two}, common::BorrowedSlice{three}};
+    REQUIRE(f->appendv(parts, 2U).ok());
+    REQUIRE(f->appendv(parts, 1U).ok());
+
+    THEN("Single appends reach append and only gathered ones reach appendv") {
+        REQUIRE(counting->appendvs == 1U);
+        REQUIRE(counting->appends == 4U);
+        REQUIRE(f->read(0, 14).val().string() == "onetwothreetwo");
+    }
+}
+
+SCENARIO("Streams report a full shaped disk", "[stream][shaping]") {
+    filesystem::ShapingOptions opts{};
+    opts.write_budget_bytes = 64U * 1024U;
+    auto fs = std::make_shared<filesystem::ShapingFileSystem>(std::make_shared<filesystem::MemoryFileSystem>(),
+                                                              std::move(opts));
+    auto stream = std::move(stream::FileStream::openOrCreate(stream::StreamOptions{
+                                                                 16 * 1024,
+                                                                 10 * 1024 * 1024,
+                                                                 true,
+                                                                 fs,
+                                                                 nullptr,
+                                                                 kv::KVOptions{true, fs, nullptr, "m", 1024},
+                                                             })
+                                .val());
+    const std::string value(1000, 'x');
+    uint64_t appended = 0U;
+    while (true) {
+        auto seq_or = stream->append(common::BorrowedSlice{value}, stream::AppendOptions{false, false});
+        if (!seq_or.ok()) {
+            REQUIRE(seq_or.err().code == stream::StreamErrorCode::DiskFull);
+            break;
+        }
+        ++appended;
+    }
+    REQUIRE(appended > 10U);
+    for (uint64_t i = 0; i < appended; i++) {
+        REQUIRE(stream->read(i, stream::ReadOptions{true, false, 0U}).val().data.string() == value);
+    }
+}
+
+SCENARIO("Synced appends on slow flash", "[.][benchmark][shaping]") {
+    auto temp_dir = test::utils::TempDir();
+    // Roughly an SD card: slow writes, and syncs which now and then stall for much longer
+    filesystem::ShapingOptions opts{};
+    opts.write = filesystem::LatencyDistribution{50us, 50us, 0.0, 0us};
+    opts.sync = filesystem::LatencyDistribution{2ms, 1ms, 0.02, 50ms};
+    opts.write_bytes_per_second = 10U * 1024U * 1024U;
+    auto fs = std::make_shared<filesystem::ShapingFileSystem>(
+        std::make_shared<filesystem::PosixFileSystem>(temp_dir.path()), std::move(opts));
+
+    std::string record;
+    test::utils::random_string(record, 1024);
+    for (const auto batched : {false, true}) {
+        auto stream_opts = stream::StreamOptions{
+            1024 * 1024, 64 * 1024 * 1024, false, fs, nullptr, kv::KVOptions{true, fs, nullptr, "m", 1024},
+        };
+        stream_opts.batched_record_frames = batched;
+        auto stream = std::move(stream::FileStream::openOrCreate(std::move(stream_opts)).val());
+        BENCHMARK(batched ? "Batched frames, sync every 16 records" : "Single records, sync every 16 records") {
+            for (int i = 0; i < 64; i++) {
+                std::ignore = stream->append(common::BorrowedSlice{record}, stream::AppendOptions{i % 16 == 15, true});
+            }
+        };
+    }
+}
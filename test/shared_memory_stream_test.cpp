@@ -0,0 +1,216 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <atomic>
+#include <aws/store/stream/sharedMemoryStream.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::string unique_shm_name() {
+    std::string suffix;
+    aws::store::test::utils::random_string(suffix, 8);
+    std::string name = "store-test-";
+    for (const auto c : suffix) {
+        // Keep the name to characters which are valid for any shared memory object name
+        name.push_back(static_cast<char>('a' + (static_cast<unsigned char>(c) % 26U)));
+    }
+    return name;
+}
+
+namespace {
+// Removes the shared memory object at the end of the test
+struct ShmName {
+    std::string name = unique_shm_name();
+    ~ShmName() {
+        std::ignore = aws::store::stream::SharedMemoryStream::remove(name);
+    }
+};
+} // namespace
+
+SCENARIO("Shared memory streams are shared by everyone who opens the same name", "[shm]") {
+    ShmName shm;
+    auto opts = aws::store::stream::SharedMemoryStreamOptions{shm.name, 64 * 1024, 1024};
+
+    auto producer_or = aws::store::stream::SharedMemoryStream::openOrCreate(opts);
+    REQUIRE(producer_or.ok());
+    auto producer = std::move(producer_or.val());
+
+    // Sizes are chosen by the creator
+    opts.maximum_size_bytes = 1024;
+    auto consumer_or = aws::store::stream::SharedMemoryStream::openOrCreate(opts);
+    REQUIRE(consumer_or.ok());
+    auto consumer = std::move(consumer_or.val());
+
+    for (auto i = 0U; i < 10U; i++) {
+        auto seq_or = producer->append(aws::store::common::BorrowedSlice{"val" + std::to_string(i)},
+                                       aws::store::stream::AppendOptions{});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == i);
+    }
+
+    THEN("Records appended by one are read by the other") {
+        REQUIRE(consumer->firstSequenceNumber() == 0U);
+        REQUIRE(consumer->highestSequenceNumber() == 9U);
+        for (auto i = 0U; i < 10U; i++) {
+            auto record_or = consumer->read(i, aws::store::stream::ReadOptions{});
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().sequence_number == i);
+            REQUIRE(record_or.val().data.string() == "val" + std::to_string(i));
+        }
+        REQUIRE(consumer->read(10, aws::store::stream::ReadOptions{}).err().code ==
+                aws::store::stream::StreamErrorCode::RecordNotFound);
+
+        std::string peeked;
+        REQUIRE(consumer
+                    ->peek(3, aws::store::stream::ReadOptions{},
+                           [&peeked](const aws::store::common::BorrowedSlice d, const int64_t) {
+                               peeked.assign(d.char_data(), d.size());
+                           })
+                    .ok());
+        REQUIRE(peeked == "val3");
+    }
+
+    THEN("Both share sequence numbers when appending") {
+        auto seq_or = consumer->append(aws::store::common::BorrowedSlice{"from consumer"},
+                                       aws::store::stream::AppendOptions{});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == 10U);
+        REQUIRE(producer->highestSequenceNumber() == 10U);
+    }
+
+    THEN("Iterator checkpoints are shared") {
+        auto it = consumer->openOrCreateIterator("ita", aws::store::stream::IteratorOptions{});
+        ++it;
+        auto record_or = *it;
+        REQUIRE(record_or.ok());
+        REQUIRE(record_or.val().checkpoint().ok());
+
+        it = producer->openOrCreateIterator("ita", aws::store::stream::IteratorOptions{});
+        REQUIRE(it.sequence_number == 2U);
+        REQUIRE(producer->deleteIterator("ita").ok());
+        REQUIRE(consumer->deleteIterator("ita").code == aws::store::stream::StreamErrorCode::IteratorNotFound);
+    }
+}
+
+SCENARIO("Shared memory streams evict the oldest records when full", "[shm]") {
+    ShmName shm;
+    auto stream_or = aws::store::stream::SharedMemoryStream::openOrCreate(
+        aws::store::stream::SharedMemoryStreamOptions{shm.name, 4 * 1024, 16});
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+
+    std::string value;
+    aws::store::test::utils::random_string(value, 1000);
+    REQUIRE(stream->append(aws::store::common::BorrowedSlice{std::string(5000, 'a')},
+                           aws::store::stream::AppendOptions{})
+                .err()
+                .code == aws::store::stream::StreamErrorCode::RecordTooLarge);
+
+    for (auto i = 0U; i < 100U; i++) {
+        auto seq_or = stream->append(aws::store::common::BorrowedSlice{value}, aws::store::stream::AppendOptions{});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == i);
+    }
+
+    THEN("Only the newest records are kept") {
+        REQUIRE(stream->highestSequenceNumber() == 99U);
+        REQUIRE(stream->firstSequenceNumber() > 90U);
+        REQUIRE(stream->currentSizeBytes() <= 4U * 1024U);
+        REQUIRE(stream->read(0, aws::store::stream::ReadOptions{}).err().code ==
+                aws::store::stream::StreamErrorCode::RecordNotFound);
+
+        auto record_or = stream->read(0, aws::store::stream::ReadOptions{false, true});
+        REQUIRE(record_or.ok());
+        REQUIRE(record_or.val().sequence_number == stream->firstSequenceNumber());
+        REQUIRE(record_or.val().data.string() == value);
+    }
+
+    THEN("Appends can fail instead of evicting") {
+        auto seq_or =
+            stream->append(aws::store::common::BorrowedSlice{value}, aws::store::stream::AppendOptions{false, false});
+        REQUIRE(seq_or.err().code == aws::store::stream::StreamErrorCode::StreamFull);
+    }
+
+    THEN("Older records can be removed") {
+        REQUIRE(stream->removeOlderRecords(aws::store::stream::timestamp() + 1) > 0U);
+        REQUIRE(stream->currentSizeBytes() == 0U);
+        REQUIRE(stream->firstSequenceNumber() == 100U);
+        auto seq_or = stream->append(aws::store::common::BorrowedSlice{value}, aws::store::stream::AppendOptions{});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == 100U);
+    }
+}
+
+SCENARIO("Shared memory streams reject records which would run off the end of the ring", "[shm]") {
+    ShmName shm;
+    auto stream_or = aws::store::stream::SharedMemoryStream::openOrCreate(
+        aws::store::stream::SharedMemoryStreamOptions{shm.name, 1024, 16});
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+
+    // Each record takes 128 bytes of the ring, so the second one starts 128 bytes in
+    const auto value = std::string(100, 'a');
+    REQUIRE(stream->append(aws::store::common::BorrowedSlice{value}, aws::store::stream::AppendOptions{}).ok());
+    REQUIRE(stream->append(aws::store::common::BorrowedSlice{value}, aws::store::stream::AppendOptions{}).ok());
+
+    // The ring is at the end of the shared memory, and the length is the first field of the record header. Make it
+    // long enough to fit in the ring, but not from where the record starts.
+    const auto path = std::filesystem::path{"/dev/shm"} / shm.name;
+    const auto ring = static_cast<std::streamoff>(std::filesystem::file_size(path)) - 1024;
+    {
+        std::fstream f{path, std::ios::binary | std::ios::in | std::ios::out};
+        const uint32_t length = 1000U;
+        f.seekp(ring + 128);
+        f.write(reinterpret_cast<const char *>(&length), sizeof(length));
+    }
+
+    REQUIRE(stream->read(0, aws::store::stream::ReadOptions{false, false}).ok());
+    REQUIRE(stream->read(1, aws::store::stream::ReadOptions{false, false}).err().code ==
+            aws::store::stream::StreamErrorCode::HeaderDataCorrupted);
+}
+
+SCENARIO("Shared memory stream readers can wait for new records", "[shm]") {
+    ShmName shm;
+    auto opts = aws::store::stream::SharedMemoryStreamOptions{shm.name, 64 * 1024, 1024};
+    auto producer_or = aws::store::stream::SharedMemoryStream::openOrCreate(opts);
+    REQUIRE(producer_or.ok());
+    auto producer = std::move(producer_or.val());
+    auto consumer_or = aws::store::stream::SharedMemoryStream::openOrCreate(opts);
+    REQUIRE(consumer_or.ok());
+    auto consumer = std::move(consumer_or.val());
+
+    REQUIRE_FALSE(consumer->waitForRecord(0, std::chrono::milliseconds{10}));
+
+    std::atomic_bool failed{false};
+    std::thread reader{[&consumer, &failed]() {
+        for (auto i = 0U; i < 200U; i++) {
+            if (!consumer->waitForRecord(i, std::chrono::seconds{10})) {
+                failed = true;
+                return;
+            }
+            auto record_or = consumer->read(i, aws::store::stream::ReadOptions{});
+            if (!record_or.ok() || (record_or.val().data.string() != std::to_string(i))) {
+                failed = true;
+                return;
+            }
+        }
+    }};
+
+    for (auto i = 0U; i < 200U; i++) {
+        REQUIRE(
+            producer->append(aws::store::common::BorrowedSlice{std::to_string(i)}, aws::store::stream::AppendOptions{})
+                .ok());
+        if ((i % 50U) == 0U) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    }
+    reader.join();
+    REQUIRE_FALSE(failed);
+}
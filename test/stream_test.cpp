@@ -2,13 +2,20 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "test_utils.hpp"
+#include <algorithm>
+#include <atomic>
 #include <aws/store/filesystem/posixFileSystem.hpp>
 #include <aws/store/stream/fileStream.hpp>
+#include <aws/store/stream/memoryStream.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <condition_variable>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <thread>
@@ -96,6 +103,273 @@ SCENARIO("Posix filesystem errors", "[fs]") {
     REQUIRE(file_or.err().code == aws::store::filesystem::FileErrorCode::AccessDenied);
 }
 
+SCENARIO("Posix files can be read by many threads at once", "[fs]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    const auto unbuffered = GENERATE(false, true);
+    // Only used by the unbuffered file
+    const auto write_buffer_size = GENERATE(0U, 4096U);
+    std::shared_ptr<aws::store::filesystem::FileSystemInterface> fs =
+        unbuffered
+            ? std::make_shared<aws::store::filesystem::PosixUnbufferedFileSystem>(temp_dir.path(), write_buffer_size)
+            : std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+    auto file_or = fs->open("file");
+    REQUIRE(file_or.ok());
+    auto file = std::move(file_or.val());
+
+    std::string contents;
+    aws::store::test::utils::random_string(contents, 64 * 1024);
+    // Appends which have not been flushed can still be read
+    REQUIRE(file->append(aws::store::common::BorrowedSlice{contents}).ok());
+
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 8; t++) {
+        readers.emplace_back([&file, &contents, &mismatches, t]() {
+            for (uint32_t i = 0; i < 500; i++) {
+                const auto begin = (i * 97U + static_cast<uint32_t>(t) * 1009U) % 60000U;
+                auto read_or = file->read(begin, begin + 4096U);
+                if (!read_or.ok() || read_or.val().string() != contents.substr(begin, 4096U)) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    // Appending while the readers are running does not disturb them
+    for (int i = 0; i < 100; i++) {
+        REQUIRE(file->append(aws::store::common::BorrowedSlice{contents.data(), 128U}).ok());
+    }
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    REQUIRE(mismatches == 0);
+
+    REQUIRE(file->flush().ok());
+    const auto end = static_cast<uint32_t>(contents.size()) + 100U * 128U;
+    auto read_or = file->read(end - 128U, end);
+    REQUIRE(read_or.ok());
+    REQUIRE(read_or.val().string() == contents.substr(0, 128U));
+    read_or = file->read(0, end + 1U);
+    REQUIRE_FALSE(read_or.ok());
+    REQUIRE(read_or.err().code == aws::store::filesystem::FileErrorCode::EndOfFile);
+}
+
+SCENARIO("Buffered appends can be read while they are being written out", "[fs]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::filesystem::PosixUnbufferedFileSystem>(temp_dir.path(), 1024U);
+    auto file_or = fs->open("file");
+    REQUIRE(file_or.ok());
+    auto file = std::move(file_or.val());
+
+    // Every byte is its offset modulo 251, so any read can be checked without sharing the contents
+    constexpr uint32_t total = 4000U * 1000U;
+    std::string contents(total, '\0');
+    for (uint32_t i = 0U; i < total; i++) {
+        contents[i] = static_cast<char>(i % 251U);
+    }
+
+    std::atomic<uint32_t> appended{0U};
+    std::atomic<bool> done{false};
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&file, &contents, &appended, &done, &mismatches, t]() {
+            for (uint32_t i = static_cast<uint32_t>(t); !done.load(); i++) {
+                // Read some of the newest bytes, which straddle the file and its buffer
+                const auto newest = appended.load();
+                if (newest < 1000U) {
+                    continue;
+                }
+                const auto end = newest - ((i * 37U) % 700U);
+                const auto begin = end - 300U;
+                auto read_or = file->read(begin, end);
+                if (!read_or.ok() || read_or.val().string() != contents.substr(begin, 300U)) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (uint32_t offset = 0U; offset < total; offset += 100U) {
+        REQUIRE(file->append(aws::store::common::BorrowedSlice{contents.data() + offset, 100U}).ok());
+        appended.store(offset + 100U);
+    }
+    done.store(true);
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    REQUIRE(mismatches == 0);
+}
+
+SCENARIO("Unbuffered posix files can collect appends in a write buffer", "[fs]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::filesystem::PosixUnbufferedFileSystem>(temp_dir.path(), 1024U);
+    auto file_or = fs->open("file");
+    REQUIRE(file_or.ok());
+    auto file = std::move(file_or.val());
+    const auto on_disk = [&temp_dir]() { return std::filesystem::file_size(temp_dir.path() / "file"); };
+
+    std::string contents;
+    aws::store::test::utils::random_string(contents, 4096);
+    const auto slice = [&contents](uint32_t begin, uint32_t end) {
+        return aws::store::common::BorrowedSlice{contents.data() + begin, end - begin};
+    };
+
+    // Small appends stay in the buffer, and can be read back before they are written
+    REQUIRE(file->append(slice(0, 100)).ok());
+    REQUIRE(file->append(slice(100, 600)).ok());
+    REQUIRE(on_disk() == 0);
+    auto read_or = file->read(50, 600);
+    REQUIRE(read_or.ok());
+    REQUIRE(read_or.val().string() == contents.substr(50, 550));
+
+    // Filling the buffer writes it out
+    REQUIRE(file->append(slice(600, 1200)).ok());
+    REQUIRE(on_disk() == 600);
+    // Reads can span the file and the buffer
+    read_or = file->read(500, 1200);
+    REQUIRE(read_or.ok());
+    REQUIRE(read_or.val().string() == contents.substr(500, 700));
+    read_or = file->read(500, 1201);
+    REQUIRE_FALSE(read_or.ok());
+    REQUIRE(read_or.err().code == aws::store::filesystem::FileErrorCode::EndOfFile);
+
+    // Truncating after a failed append only drops the buffered bytes
+    REQUIRE(file->truncate(1000).ok());
+    REQUIRE(on_disk() == 600);
+    REQUIRE(file->append(slice(1000, 1100)).ok());
+    REQUIRE(file->flush().ok());
+    REQUIRE(on_disk() == 1100);
+
+    // Appends larger than the buffer are written straight away
+    REQUIRE(file->append(slice(1100, 1200)).ok());
+    REQUIRE(file->append(slice(1200, 4096)).ok());
+    REQUIRE(on_disk() == 4096);
+
+    REQUIRE(file->append(slice(0, 10)).ok());
+    REQUIRE(file->writeAt(0, slice(10, 20)).ok());
+    REQUIRE(on_disk() == 4106);
+    read_or = file->read(0, 4106);
+    REQUIRE(read_or.ok());
+    REQUIRE(read_or.val().string() == contents.substr(10, 10) + contents.substr(10) + contents.substr(0, 10));
+
+    // Truncating below what is in the file drops the buffer as well
+    REQUIRE(file->append(slice(0, 10)).ok());
+    REQUIRE(file->truncate(100).ok());
+    REQUIRE(on_disk() == 100);
+    REQUIRE(file->append(slice(0, 10)).ok());
+    file.reset();
+    REQUIRE(on_disk() == 110);
+}
+
+SCENARIO("Posix files append several slices with one call", "[fs]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    const auto unbuffered = GENERATE(false, true);
+    const auto write_buffer_size = GENERATE(0U, 64U);
+    std::shared_ptr<aws::store::filesystem::FileSystemInterface> fs =
+        unbuffered
+            ? std::make_shared<aws::store::filesystem::PosixUnbufferedFileSystem>(temp_dir.path(), write_buffer_size)
+            : std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+    auto file_or = fs->open("file");
+    REQUIRE(file_or.ok());
+    auto file = std::move(file_or.val());
+
+    std::string expected;
+    // Appends which are still buffered come first
+    REQUIRE(file->append(aws::store::common::BorrowedSlice{std::string{"start"}}).ok());
+    expected += "start";
+    for (size_t count : {1U, 3U, 2000U}) {
+        std::vector<std::string> values;
+        std::vector<aws::store::common::BorrowedSlice> parts;
+        for (size_t i = 0; i < count; i++) {
+            values.push_back(std::to_string(i) + (i % 7 == 0 ? std::string{} : std::string(i % 100, 'x')));
+        }
+        for (const auto &v : values) {
+            parts.emplace_back(v);
+            expected += v;
+        }
+        REQUIRE(file->appendv(parts.data(), parts.size()).ok());
+        if (!unbuffered && (count < 2000U)) {
+            // Small parts are buffered by stdio, along with the append before them
+            REQUIRE(std::filesystem::file_size(temp_dir.path() / "file") == 0U);
+        }
+    }
+    REQUIRE(file->flush().ok());
+
+    auto read_or = file->read(0, static_cast<uint32_t>(expected.size()));
+    REQUIRE(read_or.ok());
+    REQUIRE(read_or.val().string() == expected);
+    REQUIRE(std::filesystem::file_size(temp_dir.path() / "file") == expected.size());
+}
+
+SCENARIO("Posix files start writeback while they are appended to", "[fs]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    const auto unbuffered = GENERATE(false, true);
+    // Start writeback after every few appends
+    constexpr uint32_t writeback_interval = 4096U;
+    std::shared_ptr<aws::store::filesystem::FileSystemInterface> fs =
+        unbuffered ? std::make_shared<aws::store::filesystem::PosixUnbufferedFileSystem>(temp_dir.path(), 1024U,
+                                                                                          writeback_interval)
+                   : std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path(), writeback_interval);
+    auto file_or = fs->open("file");
+    REQUIRE(file_or.ok());
+    auto file = std::move(file_or.val());
+
+    std::string value;
+    std::string expected;
+    for (int i = 0; i < 200; i++) {
+        aws::store::test::utils::random_string(value, static_cast<size_t>(1 + (i * 131) % 3000));
+        if (i % 2 == 0) {
+            REQUIRE(file->append(aws::store::common::BorrowedSlice{value}).ok());
+        } else {
+            const auto parts = std::vector<aws::store::common::BorrowedSlice>{aws::store::common::BorrowedSlice{value},
+                                                                              aws::store::common::BorrowedSlice{value}};
+            REQUIRE(file->appendv(parts.data(), parts.size()).ok());
+            expected += value;
+        }
+        expected += value;
+        REQUIRE(file->flush().ok());
+        if (i % 50 == 0) {
+            file->sync();
+        }
+        if (i % 37 == 0) {
+            REQUIRE(file->truncate(static_cast<uint32_t>(expected.size() / 2)).ok());
+            expected.resize(expected.size() / 2);
+        }
+    }
+    file->sync();
+
+    auto read_or = file->read(0, static_cast<uint32_t>(expected.size()));
+    REQUIRE(read_or.ok());
+    REQUIRE(read_or.val().string() == expected);
+    file.reset();
+    REQUIRE(std::filesystem::file_size(temp_dir.path() / "file") == expected.size());
+}
+
+SCENARIO("Posix files read into a caller's buffer", "[fs]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    const auto unbuffered = GENERATE(false, true);
+    std::shared_ptr<aws::store::filesystem::FileSystemInterface> fs =
+        unbuffered ? std::make_shared<aws::store::filesystem::PosixUnbufferedFileSystem>(temp_dir.path(), 1024U)
+                   : std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+    auto file = std::move(fs->open("file").val());
+
+    std::string expected;
+    aws::store::test::utils::random_string(expected, 5000);
+    REQUIRE(file->append(aws::store::common::BorrowedSlice{expected}).ok());
+    // Still in the write buffer, which must be read too
+    const std::string tail{"tail"};
+    REQUIRE(file->append(aws::store::common::BorrowedSlice{tail}).ok());
+    expected += tail;
+
+    std::string out(100, '\0');
+    REQUIRE(file->readInto(4904, &out[0], 100).ok());
+    REQUIRE(out == expected.substr(4904, 100));
+    REQUIRE(file->readInto(0, &out[0], 0).ok());
+
+    // Reading past the end fails without claiming to have read anything
+    const auto e = file->readInto(static_cast<uint32_t>(expected.size()) - 10U, &out[0], 100);
+    REQUIRE(e.code == aws::store::filesystem::FileErrorCode::EndOfFile);
+}
+
 SCENARIO("I cannot create a stream", "[stream]") {
     auto temp_dir = aws::store::test::utils::TempDir();
     auto fs = std::make_shared<aws::store::test::utils::SpyFileSystem>(
@@ -285,6 +559,39 @@ SCENARIO("I can delete an iterator") {
     }
 }
 
+SCENARIO("Iterators can be opened and checkpointed from many threads", "[stream]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+    auto stream_or = open_stream(fs);
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+    REQUIRE(stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{}).ok());
+
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&stream, &failures, t]() {
+            for (int i = 0; i < 50; i++) {
+                const auto id = "it" + std::to_string(t) + "-" + std::to_string(i);
+                std::ignore = stream->openOrCreateIterator(id, aws::store::stream::IteratorOptions{});
+                if (!stream->setCheckpoint(id, 0U).ok() || !stream->deleteIterator(id).ok()) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    // Metrics look at the iterators too
+    for (int i = 0; i < 200; i++) {
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{}).ok());
+        std::ignore = stream->metrics();
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    REQUIRE(failures == 0);
+    REQUIRE(stream->metrics().iterators.empty());
+}
+
 SCENARIO("I can create a stream", "[stream]") {
     auto temp_dir = aws::store::test::utils::TempDir();
     auto fs = std::make_shared<aws::store::test::utils::SpyFileSystem>(
@@ -568,3 +875,746 @@ SCENARIO("Old records can be removed", "[stream]") {
         }
     }
 }
+
+SCENARIO("Memory stream can be snapshotted and restored", "[stream]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = aws::store::filesystem::PosixFileSystem(temp_dir.path());
+    const auto memory_opts = []() {
+        return aws::store::stream::StreamOptions{1024 * 1024, 10 * 1024 * 1024, true, nullptr, stream_logger,
+                                                 aws::store::kv::KVOptions{}};
+    };
+
+    auto stream = aws::store::stream::MemoryStream::openOrCreate(memory_opts());
+    std::vector<std::string> values;
+    // Include values larger than the snapshot I/O size so that they span several reads
+    for (const auto size : {10, 0, 3 * 1024 * 1024, 1000}) {
+        std::string value;
+        aws::store::test::utils::random_string(value, static_cast<size_t>(size));
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{value}, aws::store::stream::AppendOptions{}).ok());
+        values.emplace_back(std::move(value));
+    }
+    REQUIRE(stream->setCheckpoint("ita", 2).ok());
+    REQUIRE(stream->snapshot(fs).ok());
+
+    WHEN("I restore the snapshot into a new stream") {
+        auto restored = aws::store::stream::MemoryStream::openOrCreate(memory_opts());
+        REQUIRE(restored->restore(fs).ok());
+
+        THEN("Records and iterators are restored") {
+            REQUIRE(restored->firstSequenceNumber() == 0U);
+            REQUIRE(restored->highestSequenceNumber() == 3U);
+            REQUIRE(restored->currentSizeBytes() == stream->currentSizeBytes());
+            for (auto i = 0U; i < values.size(); i++) {
+                auto record_or = restored->read(i, aws::store::stream::ReadOptions{});
+                REQUIRE(record_or.ok());
+                REQUIRE(record_or.val().data.string() == values[i]);
+                auto original_or = stream->read(i, aws::store::stream::ReadOptions{});
+                REQUIRE(record_or.val().timestamp == original_or.val().timestamp);
+            }
+            REQUIRE(restored->openOrCreateIterator("ita", aws::store::stream::IteratorOptions{}).sequence_number == 2U);
+
+            auto seq_or =
+                restored->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{});
+            REQUIRE(seq_or.ok());
+            REQUIRE(seq_or.val() == 4U);
+        }
+    }
+
+    WHEN("The snapshot is corrupted") {
+        {
+            std::fstream file(temp_dir.path() / aws::store::stream::DefaultSnapshotIdentifier,
+                              std::ios::in | std::ios::out | std::ios::binary);
+            REQUIRE(file);
+            file.seekp(100);
+            file.put('\xFF');
+        }
+
+        THEN("Restore fails and leaves the stream unchanged") {
+            auto restored = aws::store::stream::MemoryStream::openOrCreate(memory_opts());
+            REQUIRE(restored->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{})
+                        .ok());
+            REQUIRE_FALSE(restored->restore(fs).ok());
+            REQUIRE(restored->highestSequenceNumber() == 0U);
+            REQUIRE(restored->read(0, aws::store::stream::ReadOptions{}).val().data.string() == "val");
+        }
+    }
+
+    WHEN("There is no snapshot") {
+        auto restored = aws::store::stream::MemoryStream::openOrCreate(memory_opts());
+        THEN("Restore fails") {
+            REQUIRE_FALSE(restored->restore(fs, "missing").ok());
+        }
+    }
+}
+
+SCENARIO("File streams can write records in batched frames", "[stream]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::test::utils::SpyFileSystem>(
+        std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path()));
+    const auto open_batched_stream = [&fs]() {
+        return aws::store::stream::FileStream::openOrCreate(aws::store::stream::StreamOptions{
+            1024 * 1024,
+            10 * 1024 * 1024,
+            true,
+            fs,
+            stream_logger,
+            aws::store::kv::KVOptions{true, fs, stream_logger, "m", 1 * 1024},
+            true,
+        });
+    };
+
+    // Start with records in the original format so that segments hold both formats
+    std::vector<std::string> values;
+    auto stream_or = open_stream(fs);
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+    for (auto i = 0; i < 5; i++) {
+        values.emplace_back("val" + std::to_string(i));
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{values.back()}, aws::store::stream::AppendOptions{})
+                    .ok());
+    }
+    stream.reset();
+
+    stream_or = open_batched_stream();
+    REQUIRE(stream_or.ok());
+    stream = std::move(stream_or.val());
+    for (auto i = 0; i < 3000; i++) {
+        std::string value;
+        aws::store::test::utils::random_string(value, static_cast<size_t>((i == 100) ? 10 * 1024 : (i * 7) % 1000));
+        REQUIRE(
+            stream->append(aws::store::common::BorrowedSlice{value}, aws::store::stream::AppendOptions{}).ok());
+        values.emplace_back(std::move(value));
+    }
+
+    const auto check_values = [&values](aws::store::stream::StreamInterface &s) {
+        REQUIRE(s.highestSequenceNumber() == values.size() - 1U);
+        for (auto i = 0U; i < values.size(); i++) {
+            auto record_or = s.read(i, aws::store::stream::ReadOptions{});
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().data.string() == values[i]);
+        }
+
+        auto it = s.openOrCreateIterator("it", aws::store::stream::IteratorOptions{});
+        for (auto i = 0U; i < values.size(); i++, ++it) {
+            auto record_or = *it;
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().sequence_number == i);
+            REQUIRE(record_or.val().data.string() == values[i]);
+        }
+        REQUIRE((*it).err().code == aws::store::stream::StreamErrorCode::RecordNotFound);
+        REQUIRE(s.deleteIterator("it").ok());
+    };
+
+    THEN("Records can be read including those not yet written to the file") {
+        check_values(*stream);
+        REQUIRE(fs->list().val().size() > 2U);
+    }
+
+    WHEN("I reopen the stream") {
+        const auto size = stream->currentSizeBytes();
+        stream.reset();
+
+        THEN("All records are read back from either format") {
+            stream_or = open_batched_stream();
+            REQUIRE(stream_or.ok());
+            stream = std::move(stream_or.val());
+            REQUIRE(stream->currentSizeBytes() == size);
+            check_values(*stream);
+
+            // Reading batched frames does not need the option to be set
+            stream.reset();
+            stream_or = open_stream(fs);
+            REQUIRE(stream_or.ok());
+            check_values(*stream_or.val());
+        }
+    }
+
+    WHEN("A frame is corrupted") {
+        stream.reset();
+        auto files = fs->list().val();
+        std::sort(files.begin(), files.end());
+        const auto first_segment_path = temp_dir.path() / files.front();
+        {
+            std::fstream file(first_segment_path, std::ios::in | std::ios::out | std::ios::binary);
+            REQUIRE(file);
+            file.seekp(static_cast<std::streamoff>(std::filesystem::file_size(first_segment_path) / 2U));
+            file.put('\xFF');
+        }
+
+        THEN("The segment is truncated at that frame on open") {
+            const auto size_before = std::filesystem::file_size(first_segment_path);
+            stream_or = open_batched_stream();
+            REQUIRE(stream_or.ok());
+            stream = std::move(stream_or.val());
+            REQUIRE(std::filesystem::file_size(first_segment_path) < size_before);
+            REQUIRE(std::filesystem::file_size(first_segment_path) > size_before / 4U);
+            REQUIRE(stream->read(0, aws::store::stream::ReadOptions{}).val().data.string() == values[0]);
+            REQUIRE(stream->read(100, aws::store::stream::ReadOptions{}).val().data.string() == values[100]);
+            REQUIRE(stream->highestSequenceNumber() == values.size() - 1U);
+        }
+    }
+
+    WHEN("I append with sync") {
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"synced"}, aws::store::stream::AppendOptions{true})
+                    .ok());
+        values.emplace_back("synced");
+        const auto size = stream->currentSizeBytes();
+
+        THEN("The record is in the file before the stream is closed") {
+            auto files = fs->list().val();
+            std::sort(files.begin(), files.end());
+            std::uintmax_t file_bytes = 0U;
+            for (const auto &f : files) {
+                if (f.rfind(".log") != std::string::npos) {
+                    file_bytes += std::filesystem::file_size(temp_dir.path() / f);
+                }
+            }
+            REQUIRE(file_bytes == size);
+        }
+    }
+}
+
+SCENARIO("Batched records which were acknowledged survive a failed frame write", "[stream]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::test::utils::SpyFileSystem>(
+        std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path()));
+    // The KV store gets its own file system so that the only file the spy opens is the segment
+    auto kv_fs = std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+    const auto open_batched_stream = [&fs, &kv_fs]() {
+        return aws::store::stream::FileStream::openOrCreate(aws::store::stream::StreamOptions{
+            1024 * 1024,
+            10 * 1024 * 1024,
+            true,
+            fs,
+            stream_logger,
+            aws::store::kv::KVOptions{true, kv_fs, stream_logger, "m", 1 * 1024},
+            true,
+        });
+    };
+    aws::store::test::utils::SpyFileLike *segment_file = nullptr;
+    fs->when("open", aws::store::test::utils::SpyFileSystem::OpenType{[&fs, &segment_file](const std::string &id) {
+        auto file_or = aws::store::test::utils::SpyFileLike::create(fs->real->open(id));
+        segment_file = static_cast<aws::store::test::utils::SpyFileLike *>(file_or.val().get());
+        return file_or;
+    }});
+
+    auto stream_or = open_batched_stream();
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+    // These are acknowledged, but are still waiting for their frame to fill up
+    const std::vector<std::string> values{"val0", "val1", "val2"};
+    for (const auto &v : values) {
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{v}, aws::store::stream::AppendOptions{}).ok());
+    }
+    REQUIRE(segment_file != nullptr);
+    segment_file->when("append",
+                       aws::store::test::utils::SpyFileLike::AppendType{[](aws::store::common::BorrowedSlice) {
+                           return aws::store::filesystem::FileError{aws::store::filesystem::FileErrorCode::IOError,
+                                                                    "Injected error"};
+                       }});
+
+    // Only what failed is dropped, and the records before it are written with the next frame
+    const auto check_values = [&values](aws::store::stream::StreamInterface &s, const uint64_t after_seq) {
+        for (auto i = 0U; i < values.size(); i++) {
+            auto record_or = s.read(i, aws::store::stream::ReadOptions{});
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().data.string() == values[i]);
+        }
+        auto record_or = s.read(after_seq, aws::store::stream::ReadOptions{});
+        REQUIRE(record_or.ok());
+        REQUIRE(record_or.val().data.string() == "after");
+        REQUIRE(s.highestSequenceNumber() == after_seq);
+    };
+    const auto append_after_and_check = [&](const uint64_t after_seq) {
+        auto seq_or =
+            stream->append(aws::store::common::BorrowedSlice{"after"}, aws::store::stream::AppendOptions{true});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == after_seq);
+        check_values(*stream, after_seq);
+        stream.reset();
+        stream_or = open_batched_stream();
+        REQUIRE(stream_or.ok());
+        check_values(*stream_or.val(), after_seq);
+    };
+
+    WHEN("The record which fills the frame cannot be written") {
+        const auto big = std::string(5000, 'b');
+        REQUIRE_FALSE(stream->append(aws::store::common::BorrowedSlice{big}, aws::store::stream::AppendOptions{}).ok());
+        // The failed record's sequence number is not reused
+        append_after_and_check(4U);
+    }
+
+    WHEN("A synced record cannot be written") {
+        REQUIRE_FALSE(
+            stream->append(aws::store::common::BorrowedSlice{"synced"}, aws::store::stream::AppendOptions{true}).ok());
+        append_after_and_check(4U);
+    }
+
+    WHEN("A batch of records cannot be written") {
+        const auto r3 = aws::store::stream::OwnedRecord{
+            aws::store::common::OwnedSlice{aws::store::common::BorrowedSlice{"r3"}}, 0, 3U, 0U};
+        const auto r4 = aws::store::stream::OwnedRecord{
+            aws::store::common::OwnedSlice{aws::store::common::BorrowedSlice{"r4"}}, 0, 4U, 0U};
+        REQUIRE_FALSE(stream->appendRecords({&r3, &r4}, aws::store::stream::AppendOptions{true}).ok());
+        // The batch can be tried again from where the stream now ends
+        REQUIRE(stream->highestSequenceNumber() == 2U);
+        append_after_and_check(3U);
+    }
+}
+
+SCENARIO("Records can be written directly into reserved stream memory", "[stream]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::test::utils::SpyFileSystem>(
+        std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path()));
+    auto file_stream_or = open_stream(fs);
+    REQUIRE(file_stream_or.ok());
+    std::shared_ptr<aws::store::stream::StreamInterface> file_stream = file_stream_or.val();
+    file_stream_or.val().reset();
+    const std::shared_ptr<aws::store::stream::StreamInterface> memory_stream =
+        aws::store::stream::MemoryStream::openOrCreate(aws::store::stream::StreamOptions{
+            1024 * 1024, 10 * 1024 * 1024, true, nullptr, stream_logger, aws::store::kv::KVOptions{}});
+
+    for (const auto &stream : {file_stream, memory_stream}) {
+        auto first_or = stream->reserve(5);
+        REQUIRE(first_or.ok());
+        auto second_or = stream->reserve(3);
+        REQUIRE(second_or.ok());
+        auto first = std::move(first_or.val());
+        auto second = std::move(second_or.val());
+        REQUIRE(first.size() == 5U);
+        memcpy(first.data(), "hello", 5);
+        memcpy(second.data(), "abc", 3);
+
+        // Sequence numbers follow the order of commits, not reservations
+        auto seq_or = second.commit(aws::store::stream::AppendOptions{});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == 0U);
+        REQUIRE_FALSE(second.commit(aws::store::stream::AppendOptions{}).ok());
+
+        {
+            auto aborted_or = stream->reserve(10);
+            REQUIRE(aborted_or.ok());
+            memcpy(aborted_or.val().data(), "discarded!", 10);
+        }
+        auto aborted_or = stream->reserve(4);
+        REQUIRE(aborted_or.ok());
+        aborted_or.val().abort();
+        REQUIRE_FALSE(aborted_or.val().commit(aws::store::stream::AppendOptions{}).ok());
+
+        seq_or = first.commit(aws::store::stream::AppendOptions{true});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == 1U);
+        REQUIRE(stream->highestSequenceNumber() == 1U);
+        REQUIRE(stream->read(0, aws::store::stream::ReadOptions{}).val().data.string() == "abc");
+        REQUIRE(stream->read(1, aws::store::stream::ReadOptions{}).val().data.string() == "hello");
+
+        // Reserved records mix with ordinary appends
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"xyz"}, aws::store::stream::AppendOptions{}).ok());
+        REQUIRE(stream->read(2, aws::store::stream::ReadOptions{}).val().data.string() == "xyz");
+
+        auto too_large_or = stream->reserve(20 * 1024 * 1024);
+        if (too_large_or.ok()) {
+            REQUIRE_FALSE(too_large_or.val().commit(aws::store::stream::AppendOptions{}).ok());
+        }
+    }
+
+    WHEN("I reopen the file stream") {
+        file_stream.reset();
+        auto reopened_or = open_stream(fs);
+        REQUIRE(reopened_or.ok());
+
+        THEN("Reserved records were written with valid headers") {
+            auto stream = std::move(reopened_or.val());
+            REQUIRE(stream->highestSequenceNumber() == 2U);
+            REQUIRE(stream->read(0, aws::store::stream::ReadOptions{true}).val().data.string() == "abc");
+            REQUIRE(stream->read(1, aws::store::stream::ReadOptions{true}).val().data.string() == "hello");
+        }
+    }
+}
+
+SCENARIO("Records can be appended from several parts", "[stream]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::test::utils::SpyFileSystem>(
+        std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path()));
+    const bool batched = GENERATE(false, true);
+    const auto open_file_stream = [&fs, batched]() {
+        return aws::store::stream::FileStream::openOrCreate(aws::store::stream::StreamOptions{
+            1024 * 1024,
+            10 * 1024 * 1024,
+            true,
+            fs,
+            stream_logger,
+            aws::store::kv::KVOptions{true, fs, stream_logger, "m", 1 * 1024},
+            batched,
+        });
+    };
+    auto file_stream_or = open_file_stream();
+    REQUIRE(file_stream_or.ok());
+    std::shared_ptr<aws::store::stream::StreamInterface> file_stream = file_stream_or.val();
+    file_stream_or.val().reset();
+    const std::shared_ptr<aws::store::stream::StreamInterface> memory_stream =
+        aws::store::stream::MemoryStream::openOrCreate(aws::store::stream::StreamOptions{
+            1024 * 1024, 10 * 1024 * 1024, true, nullptr, stream_logger, aws::store::kv::KVOptions{}});
+
+    const std::string header{"header:"};
+    std::string body;
+    aws::store::test::utils::random_string(body, 10000);
+    const std::string trailer{":trailer"};
+
+    for (const auto &stream : {file_stream, memory_stream}) {
+        auto seq_or = stream->append({aws::store::common::BorrowedSlice{header}, aws::store::common::BorrowedSlice{},
+                                      aws::store::common::BorrowedSlice{body},
+                                      aws::store::common::BorrowedSlice{trailer}},
+                                     aws::store::stream::AppendOptions{true});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == 0U);
+
+        const aws::store::common::BorrowedSlice parts[] = {aws::store::common::BorrowedSlice{trailer},
+                                                           aws::store::common::BorrowedSlice{header}};
+        seq_or = stream->append(parts, 2U, aws::store::stream::AppendOptions{true});
+        REQUIRE(seq_or.ok());
+        REQUIRE(stream->append(parts, 0U, aws::store::stream::AppendOptions{true}).ok());
+
+        REQUIRE(stream->read(0, aws::store::stream::ReadOptions{}).val().data.string() == header + body + trailer);
+        REQUIRE(stream->read(1, aws::store::stream::ReadOptions{}).val().data.string() == trailer + header);
+        REQUIRE(stream->read(2, aws::store::stream::ReadOptions{}).val().data.size() == 0U);
+    }
+
+    WHEN("I reopen the file stream") {
+        file_stream.reset();
+        auto reopened_or = open_file_stream();
+        REQUIRE(reopened_or.ok());
+
+        THEN("The records pass the CRC check") {
+            auto stream = std::move(reopened_or.val());
+            REQUIRE(stream->highestSequenceNumber() == 2U);
+            REQUIRE(stream->read(0, aws::store::stream::ReadOptions{true}).val().data.string() ==
+                    header + body + trailer);
+            REQUIRE(stream->read(1, aws::store::stream::ReadOptions{true}).val().data.string() == trailer + header);
+        }
+    }
+}
+
+SCENARIO("Large records can be appended and read in chunks", "[stream]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::test::utils::SpyFileSystem>(
+        std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path()));
+    const bool batched = GENERATE(false, true);
+    const auto open_file_stream = [&fs, batched]() {
+        return aws::store::stream::FileStream::openOrCreate(aws::store::stream::StreamOptions{
+            1024 * 1024,
+            10 * 1024 * 1024,
+            true,
+            fs,
+            stream_logger,
+            aws::store::kv::KVOptions{true, fs, stream_logger, "m", 1 * 1024},
+            batched,
+        });
+    };
+    auto file_stream_or = open_file_stream();
+    REQUIRE(file_stream_or.ok());
+    std::shared_ptr<aws::store::stream::StreamInterface> file_stream = file_stream_or.val();
+    file_stream_or.val().reset();
+    const std::shared_ptr<aws::store::stream::StreamInterface> memory_stream =
+        aws::store::stream::MemoryStream::openOrCreate(aws::store::stream::StreamOptions{
+            1024 * 1024, 10 * 1024 * 1024, true, nullptr, stream_logger, aws::store::kv::KVOptions{}});
+
+    std::string large;
+    aws::store::test::utils::random_string(large, 3 * 1024 * 1024 + 17);
+    const auto producer_for = [](const std::string &value) {
+        return [&value, position = size_t{0}](uint8_t *buffer, const uint32_t length) mutable {
+            memcpy(buffer, value.data() + position, length);
+            position += length;
+            return aws::store::stream::StreamError{aws::store::stream::StreamErrorCode::NoError, {}};
+        };
+    };
+    std::string read_back;
+    const aws::store::stream::RecordConsumer consumer = [&read_back](const aws::store::common::BorrowedSlice chunk) {
+        REQUIRE(chunk.size() <= 1000U);
+        read_back.append(chunk.char_data(), chunk.size());
+        return aws::store::stream::StreamError{aws::store::stream::StreamErrorCode::NoError, {}};
+    };
+    std::vector<uint8_t> buffer(1000);
+
+    for (const auto &stream : {file_stream, memory_stream}) {
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"small"}, aws::store::stream::AppendOptions{}).ok());
+        auto seq_or = stream->appendChunked(static_cast<uint32_t>(large.size()), producer_for(large),
+                                            aws::store::stream::AppendOptions{});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == 1U);
+
+        // A producer which fails leaves the stream as it was
+        seq_or = stream->appendChunked(
+            100U * 1024U,
+            [](uint8_t *, const uint32_t) {
+                return aws::store::stream::StreamError{aws::store::stream::StreamErrorCode::InvalidArguments, "no"};
+            },
+            aws::store::stream::AppendOptions{});
+        REQUIRE_FALSE(seq_or.ok());
+        REQUIRE(seq_or.err().code == aws::store::stream::StreamErrorCode::InvalidArguments);
+        REQUIRE(stream->highestSequenceNumber() == 1U);
+
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"after"}, aws::store::stream::AppendOptions{}).ok());
+        REQUIRE(stream->highestSequenceNumber() == 2U);
+
+        read_back.clear();
+        auto metadata_or = stream->readChunked(1, buffer.data(), static_cast<uint32_t>(buffer.size()), consumer,
+                                               aws::store::stream::ReadOptions{});
+        REQUIRE(metadata_or.ok());
+        REQUIRE(metadata_or.val().sequence_number == 1U);
+        REQUIRE(metadata_or.val().length == large.size());
+        REQUIRE(read_back == large);
+
+        read_back.clear();
+        metadata_or = stream->readChunked(0, buffer.data(), static_cast<uint32_t>(buffer.size()), consumer,
+                                          aws::store::stream::ReadOptions{});
+        REQUIRE(metadata_or.ok());
+        REQUIRE(read_back == "small");
+        REQUIRE(stream->read(2, aws::store::stream::ReadOptions{}).val().data.string() == "after");
+    }
+
+    WHEN("I reopen the file stream") {
+        file_stream.reset();
+        auto reopened_or = open_file_stream();
+        REQUIRE(reopened_or.ok());
+        auto stream = std::move(reopened_or.val());
+
+        THEN("The large record passes the CRC check") {
+            REQUIRE(stream->highestSequenceNumber() == 2U);
+            REQUIRE(stream->read(1, aws::store::stream::ReadOptions{true}).val().data.string() == large);
+        }
+    }
+
+    WHEN("The producer and the consumer read from the stream") {
+        const auto read_small = [&file_stream]() {
+            auto record_or = file_stream->read(0, aws::store::stream::ReadOptions{});
+            REQUIRE(record_or.ok());
+            REQUIRE(record_or.val().data.string() == "small");
+        };
+        auto seq_or = file_stream->appendChunked(
+            2000U,
+            [&read_small](uint8_t *buffer, const uint32_t length) {
+                read_small();
+                memset(buffer, 'x', length);
+                return aws::store::stream::StreamError{aws::store::stream::StreamErrorCode::NoError, {}};
+            },
+            aws::store::stream::AppendOptions{});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == 3U);
+
+        THEN("Neither is held up by the stream's lock") {
+            read_back.clear();
+            auto metadata_or = file_stream->readChunked(
+                3, buffer.data(), static_cast<uint32_t>(buffer.size()),
+                [&read_small, &read_back](const aws::store::common::BorrowedSlice chunk) {
+                    read_small();
+                    read_back.append(chunk.char_data(), chunk.size());
+                    return aws::store::stream::StreamError{aws::store::stream::StreamErrorCode::NoError, {}};
+                },
+                aws::store::stream::ReadOptions{true, true});
+            REQUIRE(metadata_or.ok());
+            REQUIRE(read_back == std::string(2000, 'x'));
+        }
+    }
+
+    WHEN("The large record is corrupted") {
+        auto files = fs->list().val();
+        std::sort(files.begin(), files.end());
+        {
+            std::fstream file(temp_dir.path() / files.front(), std::ios::in | std::ios::out | std::ios::binary);
+            REQUIRE(file);
+            file.seekp(1024 * 1024);
+            file.put('\xFF');
+        }
+
+        THEN("The chunked read reports the corruption once the record has been read") {
+            read_back.clear();
+            auto metadata_or = file_stream->readChunked(1, buffer.data(), static_cast<uint32_t>(buffer.size()),
+                                                        consumer, aws::store::stream::ReadOptions{true, true});
+            REQUIRE_FALSE(metadata_or.ok());
+            REQUIRE(metadata_or.err().code == aws::store::stream::StreamErrorCode::RecordDataCorrupted);
+            REQUIRE(read_back.size() == large.size());
+        }
+    }
+}
+
+namespace {
+struct Advice {
+    std::string identifier;
+    aws::store::filesystem::AccessHint hint;
+};
+
+class AdviceRecordingFileLike final : public aws::store::test::utils::SpyFileLike {
+  public:
+    AdviceRecordingFileLike(std::unique_ptr<aws::store::filesystem::FileLike> f, std::string identifier,
+                            std::vector<Advice> &advice)
+        : SpyFileLike(std::move(f)), _identifier(std::move(identifier)), _advice(advice) {
+    }
+
+    void advise(const aws::store::filesystem::AccessHint hint, const uint32_t offset, const uint32_t length) override {
+        _advice.push_back(Advice{_identifier, hint});
+        SpyFileLike::advise(hint, offset, length);
+    }
+
+  private:
+    std::string _identifier;
+    std::vector<Advice> &_advice;
+};
+
+class AdviceRecordingFileSystem final : public aws::store::test::utils::SpyFileSystem {
+  public:
+    std::vector<Advice> advice{};
+
+    using SpyFileSystem::SpyFileSystem;
+
+    aws::store::common::Expected<std::unique_ptr<aws::store::filesystem::FileLike>, aws::store::filesystem::FileError>
+    open(const std::string &identifier) override {
+        auto f_or = real->open(identifier);
+        if (!f_or.ok()) {
+            return std::move(f_or.err());
+        }
+        return {std::make_unique<AdviceRecordingFileLike>(std::move(f_or.val()), identifier, advice)};
+    }
+
+    bool advised(const std::string &identifier, const aws::store::filesystem::AccessHint hint) const {
+        return std::any_of(advice.begin(), advice.end(), [&identifier, hint](const Advice &a) {
+            return a.identifier == identifier && a.hint == hint;
+        });
+    }
+};
+} // namespace
+
+SCENARIO("Records are read without holding the stream's lock", "[stream]") {
+    struct Gate {
+        std::mutex lock{};
+        std::condition_variable cv{};
+        bool reading = false;
+        bool released = false;
+    };
+    // Holds up reads of the large record's data until the gate is released
+    class GatedFileLike : public aws::store::test::utils::SpyFileLike {
+        std::shared_ptr<Gate> _gate;
+
+      public:
+        GatedFileLike(std::unique_ptr<aws::store::filesystem::FileLike> f, std::shared_ptr<Gate> gate)
+            : SpyFileLike(std::move(f)), _gate(std::move(gate)) {
+        }
+
+        aws::store::filesystem::FileError readInto(const uint32_t begin, void *out, const uint32_t length) override {
+            if (length == 5000U) {
+                std::unique_lock<std::mutex> l(_gate->lock);
+                _gate->reading = true;
+                _gate->cv.notify_all();
+                _gate->cv.wait(l, [this]() { return _gate->released; });
+            }
+            return SpyFileLike::readInto(begin, out, length);
+        }
+    };
+    class GatedFileSystem : public aws::store::test::utils::SpyFileSystem {
+        std::shared_ptr<Gate> _gate;
+
+      public:
+        GatedFileSystem(std::shared_ptr<FileSystemInterface> r, std::shared_ptr<Gate> gate)
+            : SpyFileSystem(std::move(r)), _gate(std::move(gate)) {
+        }
+
+        aws::store::common::Expected<std::unique_ptr<aws::store::filesystem::FileLike>,
+                                     aws::store::filesystem::FileError>
+        open(const std::string &identifier) override {
+            auto file_or = real->open(identifier);
+            if (!file_or.ok() || (identifier.rfind(".log") == std::string::npos)) {
+                return file_or;
+            }
+            return {std::make_unique<GatedFileLike>(std::move(file_or.val()), _gate)};
+        }
+    };
+
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto gate = std::make_shared<Gate>();
+    auto fs = std::make_shared<GatedFileSystem>(
+        std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path()), gate);
+    auto stream_or = aws::store::stream::FileStream::openOrCreate(aws::store::stream::StreamOptions{
+        1024 * 1024, 10 * 1024 * 1024, true, fs, stream_logger,
+        aws::store::kv::KVOptions{true, fs, stream_logger, "m", 1 * 1024}});
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+    const std::string large(5000U, 'x');
+    REQUIRE(stream->append(aws::store::common::BorrowedSlice{large}, aws::store::stream::AppendOptions{}).ok());
+
+    bool read = false;
+    std::thread reader{[&stream, &large, &read]() {
+        auto record_or = stream->read(0, aws::store::stream::ReadOptions{});
+        read = record_or.ok() && (record_or.val().data.string() == large);
+    }};
+    bool reading;
+    {
+        std::unique_lock<std::mutex> l(gate->lock);
+        reading = gate->cv.wait_for(l, std::chrono::seconds{20}, [&gate]() { return gate->reading; });
+    }
+    // The stream can be appended to while the record is being read
+    auto appended = std::async(std::launch::async, [&stream]() {
+        return stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{}).ok();
+    });
+    const auto appended_while_reading = appended.wait_for(std::chrono::seconds{20}) == std::future_status::ready;
+    {
+        std::lock_guard<std::mutex> l(gate->lock);
+        gate->released = true;
+        gate->cv.notify_all();
+    }
+    reader.join();
+
+    REQUIRE(reading);
+    REQUIRE(appended_while_reading);
+    REQUIRE(appended.get());
+    REQUIRE(read);
+}
+
+SCENARIO("File streams give the file system hints about how segments are used", "[stream]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<AdviceRecordingFileSystem>(
+        std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path()));
+
+    // Small segments so that the records are spread over several of them
+    auto stream_or = aws::store::stream::FileStream::openOrCreate(aws::store::stream::StreamOptions{
+        16 * 1024, 10 * 1024 * 1024, true, fs, stream_logger,
+        aws::store::kv::KVOptions{true, fs, stream_logger, "m", 1024}});
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+
+    std::string value;
+    aws::store::test::utils::random_string(value, 4 * 1024);
+    for (int i = 0; i < 20; i++) {
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{value}, aws::store::stream::AppendOptions{true}).ok());
+    }
+    auto segments = fs->real->list().val();
+    segments.erase(std::remove_if(segments.begin(), segments.end(),
+                                  [](const std::string &s) { return s.find(".log") == std::string::npos; }),
+                   segments.end());
+    std::sort(segments.begin(), segments.end());
+    REQUIRE(segments.size() > 2U);
+    const auto &first = segments.front();
+    const auto &last = segments.back();
+
+    THEN("Segments are opened for sequential access") {
+        for (const auto &segment : segments) {
+            REQUIRE(fs->advised(segment, aws::store::filesystem::AccessHint::Sequential));
+        }
+    }
+
+    THEN("Records are read ahead") {
+        REQUIRE(stream->read(0, aws::store::stream::ReadOptions{}).ok());
+        REQUIRE(fs->advised(first, aws::store::filesystem::AccessHint::WillNeed));
+    }
+
+    THEN("Segments are only dropped from the cache once every iterator has moved past them") {
+        std::ignore = stream->openOrCreateIterator("a", aws::store::stream::IteratorOptions{});
+        std::ignore = stream->openOrCreateIterator("b", aws::store::stream::IteratorOptions{});
+        REQUIRE(stream->setCheckpoint("a", 19).ok());
+        REQUIRE(!fs->advised(first, aws::store::filesystem::AccessHint::DontNeed));
+
+        REQUIRE(stream->setCheckpoint("b", 19).ok());
+        REQUIRE(fs->advised(first, aws::store::filesystem::AccessHint::DontNeed));
+        // The active segment is kept
+        REQUIRE(!fs->advised(last, aws::store::filesystem::AccessHint::DontNeed));
+    }
+}
@@ -109,6 +109,7 @@ class SpyFileLike : public store::filesystem::FileLike {
     using FlushType = std::function<RemoveMembership<decltype(&FileLike::flush)>::type>;
     using SyncType = std::function<RemoveMembership<decltype(&FileLike::sync)>::type>;
     using TruncateType = std::function<RemoveMembership<decltype(&FileLike::truncate)>::type>;
+    using WriteAtType = std::function<RemoveMembership<decltype(&FileLike::writeAt)>::type>;
 
     static common::Expected<std::unique_ptr<FileLike>, filesystem::FileError>
     create(common::Expected<std::unique_ptr<FileLike>, filesystem::FileError> e) {
@@ -182,6 +183,26 @@ class SpyFileLike : public store::filesystem::FileLike {
         return _real->truncate(s);
     }
 
+    filesystem::FileError writeAt(const uint32_t offset, const common::BorrowedSlice data) override {
+        if (!_mocks.empty() && _mocks.front().first == "writeAt") {
+            const auto mock = _mocks.front();
+            _mocks.pop_front();
+            if (std::holds_alternative<std::any>(mock.second)) {
+                const auto f = std::any_cast<WriteAtType>(std::get<std::any>(mock.second));
+                return f(offset, data);
+            }
+        }
+        return _real->writeAt(offset, data);
+    }
+
+    bool canWriteAt() const noexcept override {
+        return _real->canWriteAt();
+    }
+
+    void advise(const filesystem::AccessHint hint, const uint32_t offset, const uint32_t length) override {
+        _real->advise(hint, offset, length);
+    }
+
     template <typename ret, typename... args> auto when(const std::string &method, std::function<ret(args...)> f) {
         std::ignore = _mocks.emplace_back(method, f);
         return this;
@@ -0,0 +1,210 @@
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "test_utils.hpp"
+#include <algorithm>
+#include <aws/store/filesystem/posixFileSystem.hpp>
+#include <aws/store/stream/tieredStream.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+static auto open_tiered_stream(const std::shared_ptr<aws::store::filesystem::FileSystemInterface> &fs,
+                               const aws::store::stream::TieredStreamOptions &tier_opts,
+                               const bool batched_record_frames = false) {
+    return aws::store::stream::TieredStream::openOrCreate(
+        aws::store::stream::StreamOptions{
+            1024 * 1024,
+            10 * 1024 * 1024,
+            true,
+            fs,
+            {},
+            aws::store::kv::KVOptions{
+                true,
+                fs,
+                {},
+                "m",
+                1 * 1024,
+            },
+            batched_record_frames,
+        },
+        tier_opts);
+}
+
+static bool has_segment_file(const std::shared_ptr<aws::store::filesystem::FileSystemInterface> &fs) {
+    auto files_or = fs->list();
+    REQUIRE(files_or.ok());
+    return std::any_of(files_or.val().begin(), files_or.val().end(),
+                       [](const std::string &f) { return f.rfind(".log") != std::string::npos; });
+}
+
+static uintmax_t segment_file_bytes(const std::shared_ptr<aws::store::filesystem::FileSystemInterface> &fs,
+                                    const std::filesystem::path &dir) {
+    auto files_or = fs->list();
+    REQUIRE(files_or.ok());
+    uintmax_t bytes = 0U;
+    for (const auto &f : files_or.val()) {
+        if (f.rfind(".log") != std::string::npos) {
+            bytes += std::filesystem::file_size(dir / f);
+        }
+    }
+    return bytes;
+}
+
+SCENARIO("Tiered stream keeps sequence numbers across tiers", "[tiered]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+
+    // Keep only a couple of records in memory so that older reads have to come from the file tier
+    auto tier_opts = aws::store::stream::TieredStreamOptions{};
+    tier_opts.memory_size_bytes = 2 * 1024;
+    tier_opts.spill_batch_bytes = 1024;
+
+    auto stream_or = open_tiered_stream(fs, tier_opts);
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+
+    std::vector<std::string> values;
+    std::vector<int64_t> timestamps;
+    for (auto i = 0U; i < 50U; i++) {
+        std::string value;
+        aws::store::test::utils::random_string(value, 1000);
+        auto seq_or = stream->append(aws::store::common::BorrowedSlice{value}, aws::store::stream::AppendOptions{});
+        REQUIRE(seq_or.ok());
+        REQUIRE(seq_or.val() == i);
+        values.emplace_back(std::move(value));
+    }
+    REQUIRE(stream->highestSequenceNumber() == 49U);
+
+    REQUIRE(stream->flush().ok());
+    for (auto i = 0U; i < values.size(); i++) {
+        auto record_or = stream->read(i, aws::store::stream::ReadOptions{});
+        REQUIRE(record_or.ok());
+        REQUIRE(record_or.val().sequence_number == i);
+        REQUIRE(record_or.val().data.string() == values[i]);
+        timestamps.push_back(record_or.val().timestamp);
+    }
+
+    WHEN("I reopen the stream") {
+        stream.reset();
+        stream_or = open_tiered_stream(fs, tier_opts);
+        REQUIRE(stream_or.ok());
+        stream = std::move(stream_or.val());
+
+        THEN("All records are read back from the file tier unchanged") {
+            REQUIRE(stream->firstSequenceNumber() == 0U);
+            REQUIRE(stream->highestSequenceNumber() == 49U);
+            for (auto i = 0U; i < values.size(); i++) {
+                auto record_or = stream->read(i, aws::store::stream::ReadOptions{});
+                REQUIRE(record_or.ok());
+                REQUIRE(record_or.val().data.string() == values[i]);
+                REQUIRE(record_or.val().timestamp == timestamps[i]);
+            }
+
+            AND_THEN("New records continue the sequence") {
+                auto seq_or =
+                    stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{});
+                REQUIRE(seq_or.ok());
+                REQUIRE(seq_or.val() == 50U);
+            }
+        }
+    }
+}
+
+SCENARIO("Tiered stream honors the durability option", "[tiered]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+
+    auto tier_opts = aws::store::stream::TieredStreamOptions{};
+    // Make sure the background spill won't run during the test on its own
+    tier_opts.spill_interval_ms = 60 * 1000;
+
+    WHEN("Durability is memory") {
+        tier_opts.durability = aws::store::stream::Durability::Memory;
+        auto stream_or = open_tiered_stream(fs, tier_opts);
+        REQUIRE(stream_or.ok());
+        auto stream = std::move(stream_or.val());
+
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{}).ok());
+        THEN("The record is only in memory") {
+            REQUIRE_FALSE(has_segment_file(fs));
+            REQUIRE(stream->read(0, aws::store::stream::ReadOptions{}).ok());
+        }
+        THEN("Syncing on append writes through to the file tier") {
+            REQUIRE(stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{true})
+                        .ok());
+            REQUIRE(has_segment_file(fs));
+        }
+    }
+
+    WHEN("Durability is file") {
+        tier_opts.durability = aws::store::stream::Durability::File;
+        auto stream_or = open_tiered_stream(fs, tier_opts);
+        REQUIRE(stream_or.ok());
+        auto stream = std::move(stream_or.val());
+
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{}).ok());
+        THEN("The record is in the file tier when append returns") {
+            REQUIRE(has_segment_file(fs));
+        }
+    }
+
+    WHEN("Durability is file and the file tier batches records into frames") {
+        tier_opts.durability = aws::store::stream::Durability::File;
+        auto stream_or = open_tiered_stream(fs, tier_opts, true);
+        REQUIRE(stream_or.ok());
+        auto stream = std::move(stream_or.val());
+
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{}).ok());
+        THEN("The record's frame is written to the file before append returns") {
+            REQUIRE(segment_file_bytes(fs, temp_dir.path()) > 0U);
+
+            AND_THEN("Flushing writes out the frames of records appended since") {
+                tier_opts.durability = aws::store::stream::Durability::Memory;
+                stream.reset();
+                stream_or = open_tiered_stream(fs, tier_opts, true);
+                REQUIRE(stream_or.ok());
+                stream = std::move(stream_or.val());
+                const auto before = segment_file_bytes(fs, temp_dir.path());
+                REQUIRE(stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{})
+                            .ok());
+                REQUIRE(stream->flush().ok());
+                REQUIRE(segment_file_bytes(fs, temp_dir.path()) > before);
+            }
+        }
+    }
+}
+
+SCENARIO("Tiered stream iterators are persisted", "[tiered]") {
+    auto temp_dir = aws::store::test::utils::TempDir();
+    auto fs = std::make_shared<aws::store::filesystem::PosixFileSystem>(temp_dir.path());
+
+    auto stream_or = open_tiered_stream(fs, aws::store::stream::TieredStreamOptions{});
+    REQUIRE(stream_or.ok());
+    auto stream = std::move(stream_or.val());
+    for (auto i = 0; i < 5; i++) {
+        REQUIRE(stream->append(aws::store::common::BorrowedSlice{"val"}, aws::store::stream::AppendOptions{}).ok());
+    }
+
+    auto it = stream->openOrCreateIterator("ita", aws::store::stream::IteratorOptions{});
+    REQUIRE(it.sequence_number == 0U);
+    ++it;
+    auto record_or = *it;
+    REQUIRE(record_or.ok());
+    REQUIRE(record_or.val().sequence_number == 1U);
+    REQUIRE(record_or.val().checkpoint().ok());
+
+    stream.reset();
+    stream_or = open_tiered_stream(fs, aws::store::stream::TieredStreamOptions{});
+    REQUIRE(stream_or.ok());
+    stream = std::move(stream_or.val());
+
+    it = stream->openOrCreateIterator("ita", aws::store::stream::IteratorOptions{});
+    REQUIRE(it.sequence_number == 2U);
+    record_or = *it;
+    REQUIRE(record_or.ok());
+    REQUIRE(record_or.val().data.string() == "val");
+    REQUIRE(stream->deleteIterator("ita").ok());
+}